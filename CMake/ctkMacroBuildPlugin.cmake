@@ -29,6 +29,8 @@
 #! a shared library using Qt. Additionally, it generates
 #! plugin meta-data by creating a MANIFEST.MF text file
 #! which is embedded in the share library as a Qt resource.
+#! A copy of it is placed next to the library, named like
+#! the library with a ".MF" suffix.
 #!
 #! The following variables can be set in a file named
 #! manifest_headers.cmake, which will then be read by
@@ -313,12 +315,21 @@ macro(ctkMacroBuildPlugin)
 
   # Note: The plugin may be installed in some other location ???
   # Install rules
-# if(MY_LIBRARY_TYPE STREQUAL "SHARED")
-# install(TARGETS ${lib_name}
-# RUNTIME DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT RuntimePlugins
-# LIBRARY DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT RuntimePlugins
-# ARCHIVE DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT Development)
-# endif()
+  if(MY_LIBRARY_TYPE STREQUAL "SHARED" AND NOT MY_TEST_PLUGIN)
+    install(TARGETS ${lib_name}
+      RUNTIME DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT RuntimePlugins
+      LIBRARY DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT RuntimePlugins
+      ARCHIVE DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT Development)
+    # The manifest copy goes next to the installed library as well,
+    # named after the prefix the library is actually built with
+    get_target_property(_plugin_prefix ${lib_name} PREFIX)
+    if(NOT _plugin_prefix)
+      set(_plugin_prefix "${CMAKE_SHARED_LIBRARY_PREFIX}")
+    endif()
+    install(FILES "${CMAKE_CURRENT_BINARY_DIR}/MANIFEST.MF"
+      DESTINATION ${CTK_INSTALL_LIB_DIR} COMPONENT RuntimePlugins
+      RENAME "${_plugin_prefix}${lib_name}${CMAKE_SHARED_LIBRARY_SUFFIX}.MF")
+  endif()
 
   set(my_libs
     ${MY_TARGET_LIBRARIES}
@@ -330,6 +341,13 @@ macro(ctkMacroBuildPlugin)
 
   target_link_libraries(${lib_name} ${my_libs})
 
+  # Copy the manifest next to the plug-in library, the framework can then
+  # install the plug-in without loading the library (see the
+  # org.commontk.pluginfw.storage.resources framework property)
+  add_custom_command(TARGET ${lib_name} POST_BUILD
+    COMMAND ${CMAKE_COMMAND} -E copy "${CMAKE_CURRENT_BINARY_DIR}/MANIFEST.MF" "$<TARGET_FILE:${lib_name}>.MF"
+    )
+
   if(NOT MY_TEST_PLUGIN)
     set(${CMAKE_PROJECT_NAME}_PLUGIN_LIBRARIES ${${CMAKE_PROJECT_NAME}_PLUGIN_LIBRARIES} ${lib_name} CACHE INTERNAL "CTK plugins" FORCE)
   endif()
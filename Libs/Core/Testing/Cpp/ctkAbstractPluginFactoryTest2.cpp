@@ -0,0 +1,200 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+
+// CTK includes
+#include "ctkAbstractPluginFactory.h"
+#include "ctkDummyPlugin.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+//-----------------------------------------------------------------------------
+class ctkDummyPluginFactory : public ctkAbstractPluginFactory<ctkDummyPlugin>
+{
+public:
+  void registerDirectory(const QString& directory)
+  {
+    this->registerAllFileItems(QStringList() << directory);
+  }
+
+  mutable QAtomicInt ValidatedFileCount;
+
+protected:
+  virtual bool validateFile(const QFileInfo& file, QStringList& errorStrings)const
+  {
+    this->ValidatedFileCount.ref();
+    return this->ctkAbstractPluginFactory<ctkDummyPlugin>::validateFile(file, errorStrings);
+  }
+};
+
+//-----------------------------------------------------------------------------
+int ctkAbstractPluginFactoryTest2(int argc, char * argv [])
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc <= 1)
+    {
+    std::cerr << "Missing argument" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QString filePath(argv[1]);
+  QFileInfo file(filePath);
+  while (filePath.contains("$(OutDir)"))
+    {
+    QString debugFilePath = filePath;
+    debugFilePath.replace("$(OutDir)","Debug");
+    if (QFile::exists(QString(debugFilePath)))
+      {
+      file = QFileInfo(debugFilePath);
+      break;
+      }
+    QString releaseFilePath = filePath;
+    releaseFilePath.replace("$(OutDir)","Release");
+    if (QFile::exists(QString(releaseFilePath)))
+      {
+      file = QFileInfo(releaseFilePath);
+      break;
+      }
+    return EXIT_FAILURE;
+    }
+
+  QDir tempDir(QDir::temp().absoluteFilePath("ctkAbstractPluginFactoryTest2"));
+  tempDir.mkpath(tempDir.absolutePath());
+  QString cacheFilePath = tempDir.absoluteFilePath("factory.cache");
+  QFile::remove(cacheFilePath);
+
+  // A library that is not a plugin
+  QFileInfo notAPluginFile(tempDir.absoluteFilePath("ctkNotAPlugin." + file.suffix()));
+  QFile notAPlugin(notAPluginFile.filePath());
+  if (!notAPlugin.open(QIODevice::WriteOnly))
+    {
+    std::cerr << __LINE__ << ": failed to write " << qPrintable(notAPluginFile.filePath()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  notAPlugin.write("not a plugin");
+  notAPlugin.close();
+
+  {
+  ctkDummyPluginFactory pluginFactory;
+  pluginFactory.setVerbose(true);
+  pluginFactory.setDeferredLoading(true);
+  pluginFactory.setCacheFilePath(cacheFilePath);
+
+  QString itemKey = pluginFactory.registerFileItem(QFileInfo("foo/bar.txt"));
+  if (!itemKey.isEmpty())
+    {
+    std::cerr << __LINE__ << ": ctkAbstractPluginFactory::registerFileItem() registered bad file"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  itemKey = pluginFactory.registerFileItem(notAPluginFile);
+  if (!itemKey.isEmpty())
+    {
+    std::cerr << __LINE__ << ": ctkAbstractPluginFactory::registerFileItem() registered a non plugin"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The plugin is registered without being loaded
+  itemKey = pluginFactory.registerFileItem(file);
+  if (itemKey.isEmpty() || pluginFactory.itemKeys().count() != 1)
+    {
+    std::cerr << __LINE__ << ": ctkAbstractPluginFactory::registerFileItem() failed: "
+              << pluginFactory.itemKeys().count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (QPluginLoader(file.filePath()).isLoaded())
+    {
+    std::cerr << __LINE__ << ": deferred plugin loaded at registration" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // ... and loaded on its first instantiation
+  ctkDummyPlugin* plugin = pluginFactory.instantiate(itemKey);
+  if (plugin == 0 || !QPluginLoader(file.filePath()).isLoaded())
+    {
+    std::cerr << __LINE__ << ": ctkAbstractPluginFactory::instantiate() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  pluginFactory.uninstantiate(itemKey);
+
+  if (pluginFactory.ValidatedFileCount != 2 || !QFile::exists(cacheFilePath))
+    {
+    std::cerr << __LINE__ << ": unexpected validations: "
+              << int(pluginFactory.ValidatedFileCount) << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // Unmodified files are not validated again
+  {
+  ctkDummyPluginFactory pluginFactory;
+  pluginFactory.setVerbose(true);
+  pluginFactory.setDeferredLoading(true);
+  pluginFactory.setCacheFilePath(cacheFilePath);
+
+  if (!pluginFactory.registerFileItem(notAPluginFile).isEmpty() ||
+      pluginFactory.registerFileItem(file).isEmpty())
+    {
+    std::cerr << __LINE__ << ": ctkAbstractPluginFactory::registerFileItem() failed with cache"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (pluginFactory.ValidatedFileCount != 0)
+    {
+    std::cerr << __LINE__ << ": cached files validated again: "
+              << int(pluginFactory.ValidatedFileCount) << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // Cold cache: the files of a directory are validated concurrently
+  {
+  for (int i = 0; i < 8; ++i)
+    {
+    QFile::copy(notAPluginFile.filePath(), tempDir.absoluteFilePath(QString("ctkNotAPlugin%1.%2").arg(i).arg(file.suffix())));
+    }
+  QFile::remove(cacheFilePath);
+
+  ctkDummyPluginFactory pluginFactory;
+  pluginFactory.setVerbose(true);
+  pluginFactory.setDeferredLoading(true);
+  pluginFactory.setParallelValidation(true);
+  pluginFactory.setCacheFilePath(cacheFilePath);
+  pluginFactory.registerDirectory(tempDir.absolutePath());
+
+  if (!pluginFactory.itemKeys().isEmpty() || pluginFactory.ValidatedFileCount != 9)
+    {
+    std::cerr << __LINE__ << ": ctkAbstractPluginFactory::registerAllFileItems() failed: "
+              << pluginFactory.itemKeys().count() << " items, "
+              << int(pluginFactory.ValidatedFileCount) << " validations" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -24,6 +24,7 @@
 // Qt includes
 #include <QString>
 #include <QHash>
+#include <QSet>
 #include <QSharedPointer>
 #include <QStringList>
 
@@ -110,6 +111,7 @@ public:
 
   /// \brief Create an instance of the object.
   /// The item corresponding to the key should have been registered before.
+  /// An item registered without being loaded is loaded first, see registerItem().
   virtual BaseClassType * instantiate(const QString& itemKey);
 
   /// \brief Return the instance associated with \a itemKey if any, otherwise
@@ -146,7 +148,20 @@ protected:
 
   /// \brief Call the load method associated with the item.
   /// If succesfully loaded, add it to the internal map.
-  bool registerItem(const QString& key, const QSharedPointer<ctkAbstractFactoryItem<BaseClassType> > & item);
+  /// If \a deferLoad is true, the item is added to the internal map without
+  /// being loaded: it is loaded on its first instantiation and unregistered
+  /// if it fails to load.
+  bool registerItem(const QString& key,
+                    const QSharedPointer<ctkAbstractFactoryItem<BaseClassType> > & item,
+                    bool deferLoad = false);
+
+  /// \brief Load the item if it has been registered with deferLoad.
+  /// Return false if it fails to load, true otherwise.
+  virtual bool loadDeferredItem(const QString& itemKey);
+
+  /// Print the error and warning strings of an item below its status message
+  void displayErrorAndWarningStrings(const QStringList& errorStrings,
+                                     const QStringList& warningStrings);
 
   /// Get a Factory item given its itemKey. Return 0 if any.
   ctkAbstractFactoryItem<BaseClassType> * item(const QString& itemKey)const;
@@ -161,8 +176,12 @@ private:
   ctkAbstractFactory(const ctkAbstractFactory &); /// Not implemented
   void operator=(const ctkAbstractFactory&); /// Not implemented
   */
+  void unregisterItem(const QString& itemKey);
+
   HashType RegisteredItemMap;
   QSharedPointer<HashType> SharedRegisteredItemMap;
+  /// Keys of the registered items that have not been loaded yet
+  QSet<QString> DeferredItemKeys;
 
   bool Verbose;
 };
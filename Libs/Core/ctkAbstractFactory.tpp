@@ -210,6 +210,12 @@ template<typename BaseClassType>
 BaseClassType* ctkAbstractFactory<BaseClassType>::instantiate(const QString& itemKey)
 {
   ctkAbstractFactoryItem<BaseClassType>* _item = this->item(itemKey);
+  if (_item && !this->loadDeferredItem(itemKey))
+    {
+    // Same as a failed registration: the item is not listed anymore
+    this->unregisterItem(itemKey);
+    return 0;
+    }
   BaseClassType* instance = 0;
   bool wasInstantiated = false;
   if (_item)
@@ -224,20 +230,8 @@ BaseClassType* ctkAbstractFactory<BaseClassType>::instantiate(const QString& ite
                                instance ? "OK" : "Failed", this->verbose());
     if (_item)
       {
-      if(!_item->instantiateErrorStrings().isEmpty())
-        {
-        qCritical().nospace() << qPrintable(QString(" ").repeated(2) + QLatin1String("Error(s):\n"))
-                              << qPrintable(QString(" ").repeated(4) +
-                                            _item->instantiateErrorStrings().join(
-                                              QString("\n") + QString(" ").repeated(4)));
-        }
-      if(!_item->instantiateWarningStrings().isEmpty())
-        {
-        qWarning().nospace() << qPrintable(QString(" ").repeated(2) + QLatin1String("Warning(s):\n"))
-                             << qPrintable(QString(" ").repeated(4) +
-                                           _item->instantiateWarningStrings().join(
-                                             QString("\n") + QString(" ").repeated(4)));
-        }
+      this->displayErrorAndWarningStrings(_item->instantiateErrorStrings(),
+                                          _item->instantiateWarningStrings());
       }
     }
   return instance;
@@ -314,10 +308,29 @@ void ctkAbstractFactory<BaseClassType>::displayStatusMessage(
     }
 }
 
+//----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFactory<BaseClassType>::displayErrorAndWarningStrings(
+    const QStringList& errorStrings, const QStringList& warningStrings)
+{
+  if(!errorStrings.isEmpty())
+    {
+    qCritical().nospace() << qPrintable(QString(" ").repeated(2) + QLatin1String("Error(s):\n"))
+                          << qPrintable(QString(" ").repeated(4) +
+                                        errorStrings.join(QString("\n") + QString(" ").repeated(4)));
+    }
+  if(!warningStrings.isEmpty())
+    {
+    qWarning().nospace() << qPrintable(QString(" ").repeated(2) + QLatin1String("Warning(s):\n"))
+                         << qPrintable(QString(" ").repeated(4) +
+                                       warningStrings.join(QString("\n") + QString(" ").repeated(4)));
+    }
+}
+
 //----------------------------------------------------------------------------
 template<typename BaseClassType>
 bool ctkAbstractFactory<BaseClassType>::registerItem(const QString& key,
-  const QSharedPointer<ctkAbstractFactoryItem<BaseClassType> > & _item)
+  const QSharedPointer<ctkAbstractFactoryItem<BaseClassType> > & _item, bool deferLoad)
 {
   // Sanity checks
   if (!_item)
@@ -344,35 +357,67 @@ bool ctkAbstractFactory<BaseClassType>::registerItem(const QString& key,
     return false;
     }
   
-  // Attempt to load it
-  if (!_item->load())
+  // Attempt to load it, unless it is loaded on its first instantiation
+  if (!deferLoad && !_item->load())
     {
     this->displayStatusMessage(QtCriticalMsg, description, "Failed", this->verbose());
-    if(!_item->loadErrorStrings().isEmpty())
-      {
-      qCritical().nospace() << qPrintable(QString(" ").repeated(2) + QLatin1String("Error(s):\n"))
-                            << qPrintable(QString(" ").repeated(4) +
-                                          _item->loadErrorStrings().join(
-                                            QString("\n") + QString(" ").repeated(4)));
-      }
-    if(!_item->loadWarningStrings().isEmpty())
-      {
-      qWarning().nospace() << qPrintable(QString(" ").repeated(2) + QLatin1String("Warning(s):\n"))
-                           << qPrintable(QString(" ").repeated(4) +
-                                         _item->loadWarningStrings().join(
-                                           QString("\n") + QString(" ").repeated(4)));
-      }
+    this->displayErrorAndWarningStrings(_item->loadErrorStrings(), _item->loadWarningStrings());
     return false;
     }
   
   // Store item reference using a QSharedPointer
   this->RegisteredItemMap.insert(key, _item);
   this->SharedRegisteredItemMap.data()->insert(key, _item);
+  if (deferLoad)
+    {
+    this->DeferredItemKeys.insert(key);
+    }
 
-  this->displayStatusMessage(QtDebugMsg, description, "OK", this->verbose());
+  this->displayStatusMessage(QtDebugMsg, description, deferLoad ? "Deferred" : "OK", this->verbose());
   return true;
 }
 
+//----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFactory<BaseClassType>::loadDeferredItem(const QString& itemKey)
+{
+  if (!this->DeferredItemKeys.contains(itemKey))
+    {
+    return true;
+    }
+  this->DeferredItemKeys.remove(itemKey);
+
+  ctkAbstractFactoryItem<BaseClassType>* _item = this->item(itemKey);
+  Q_ASSERT(_item);
+  bool loaded = _item->load();
+  this->displayStatusMessage(loaded ? QtDebugMsg : QtCriticalMsg,
+                             QString("Attempt to load \"%1\"").arg(itemKey),
+                             loaded ? "OK" : "Failed", this->verbose());
+  if (!loaded)
+    {
+    this->displayErrorAndWarningStrings(_item->loadErrorStrings(), _item->loadWarningStrings());
+    }
+  return loaded;
+}
+
+//----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFactory<BaseClassType>::unregisterItem(const QString& itemKey)
+{
+  ConstIterator iter = this->RegisteredItemMap.find(itemKey);
+  if (iter == this->RegisteredItemMap.constEnd())
+    {
+    return;
+    }
+  // Only remove the shared item if it is the one registered by this factory
+  if (this->sharedItem(itemKey) == iter.value().data())
+    {
+    this->SharedRegisteredItemMap.data()->remove(itemKey);
+    }
+  this->DeferredItemKeys.remove(itemKey);
+  this->RegisteredItemMap.remove(itemKey);
+}
+
 //----------------------------------------------------------------------------
 template<typename BaseClassType>
 ctkAbstractFactoryItem<BaseClassType> * ctkAbstractFactory<BaseClassType>::item(const QString& itemKey)const
@@ -45,10 +45,18 @@ private:
 
 //----------------------------------------------------------------------------
 /// \ingroup Core
+/// \brief ctkAbstractFileBasedFactory registers items defined by a file.
+/// <p> By default, the file of an item is loaded when the item is registered.
+/// With deferred loading, the file is only validated at registration (see
+/// validateFile()) and loaded on the first instantiation of the item.
+/// The validation results can be kept in a cache file between sessions:
+/// a file is validated again only if it has been modified since.
 template<typename BaseClassType>
 class ctkAbstractFileBasedFactory : public ctkAbstractFactory<BaseClassType>
 {
 public:
+  ctkAbstractFileBasedFactory();
+
   virtual bool isValidFile(const QFileInfo& file)const;
   QString itemKey(const QFileInfo& file)const;
 
@@ -59,6 +67,26 @@ public:
   /// Get path associated with the library identified by \a key
   virtual QString path(const QString& key);
 
+  /// \brief Load the files of the items on their first instantiation instead
+  /// of when they are registered.
+  /// False by default.
+  void setDeferredLoading(bool value);
+  bool deferredLoading()const;
+
+  /// \brief Validate the files concurrently in registerAllFileItems().
+  /// Only the files missing from the cache, or modified since they were
+  /// cached, are validated. Only used with deferred loading.
+  /// False by default.
+  void setParallelValidation(bool value);
+  bool parallelValidation()const;
+
+  /// \brief File where the validation results are kept between sessions.
+  /// The file is read when set and written when the results change.
+  /// A file that failed to load is not registered again until it is
+  /// modified. Empty by default: the results are not saved.
+  void setCacheFilePath(const QString& filePath);
+  QString cacheFilePath()const;
+
 protected:
   void registerAllFileItems(const QStringList& directories);
 
@@ -68,6 +96,54 @@ protected:
   virtual void initItem(ctkAbstractFactoryItem<BaseClassType>* item);
 
   virtual QString fileNameToKey(const QString& path)const;
+
+  /// \brief Check that the file can be loaded without loading it.
+  /// Called before registering an item with deferred loading. It may be
+  /// called from several threads at once, see setParallelValidation().
+  /// Return false and fill \a errorStrings if the file is not valid.
+  virtual bool validateFile(const QFileInfo& file, QStringList& errorStrings)const;
+
+  /// Record the load failure of the file in the cache
+  virtual bool loadDeferredItem(const QString& itemKey);
+
+private:
+  struct CachedValidation
+  {
+    qint64      TimeStamp;
+    bool        Valid;
+    QStringList ErrorStrings;
+  };
+
+  /// Validate the files from the QtConcurrent threads
+  struct FileValidator
+  {
+    typedef CachedValidation result_type;
+
+    FileValidator(const ctkAbstractFileBasedFactory* factory)
+      : Factory(factory)
+    {}
+    CachedValidation operator()(const QFileInfo& file)const
+    {
+      return this->Factory->validateFileNow(file);
+    }
+
+    const ctkAbstractFileBasedFactory* Factory;
+  };
+
+  static qint64 fileTimeStamp(const QFileInfo& file);
+  CachedValidation validateFileNow(const QFileInfo& file)const;
+  bool isValidationCached(const QFileInfo& file)const;
+  bool validateFileCached(const QFileInfo& file, QStringList& errorStrings);
+
+  void readCache();
+  void writeCache();
+
+  bool DeferredLoading;
+  bool ParallelValidation;
+  QString CacheFilePath;
+  /// Validations by absolute file path
+  QHash<QString, CachedValidation> Cache;
+  bool CacheModified;
 };
 
 #include "ctkAbstractFileBasedFactory.tpp"
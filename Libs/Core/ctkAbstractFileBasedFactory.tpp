@@ -22,10 +22,14 @@
 #define __ctkAbstractFileBasedFactory_tpp
 
 // Qt includes
+#include <QDataStream>
+#include <QDateTime>
 #include <QDirIterator>
+#include <QtConcurrentMap>
 
 // CTK includes
 #include "ctkAbstractFileBasedFactory.h"
+#include "ctkUtils.h"
 
 //----------------------------------------------------------------------------
 // ctkFactoryFileBasedItem methods
@@ -47,6 +51,15 @@ QString ctkAbstractFactoryFileBasedItem<BaseClassType>::path()const
 //----------------------------------------------------------------------------
 // ctkAbstractFileBasedFactory methods
 
+//----------------------------------------------------------------------------
+template<typename BaseClassType>
+ctkAbstractFileBasedFactory<BaseClassType>::ctkAbstractFileBasedFactory()
+{
+  this->DeferredLoading = false;
+  this->ParallelValidation = false;
+  this->CacheModified = false;
+}
+
 //----------------------------------------------------------------------------
 template<typename BaseClassType>
 QString ctkAbstractFileBasedFactory<BaseClassType>::path(const QString& key)
@@ -61,6 +74,7 @@ QString ctkAbstractFileBasedFactory<BaseClassType>::path(const QString& key)
 template<typename BaseClassType>
 void ctkAbstractFileBasedFactory<BaseClassType>::registerAllFileItems(const QStringList& directories)
 {
+  QList<QFileInfo> files;
   // Process one path at a time
   foreach (QString path, directories)
     {
@@ -80,9 +94,34 @@ void ctkAbstractFileBasedFactory<BaseClassType>::registerAllFileItems(const QStr
         {
         continue;
         }
-      this->registerFileItem(fileInfo);
+      files << fileInfo;
+      }
+    }
+
+  if (this->DeferredLoading && this->ParallelValidation)
+    {
+    QList<QFileInfo> filesToValidate;
+    foreach (const QFileInfo& fileInfo, files)
+      {
+      if (!this->isValidationCached(fileInfo))
+        {
+        filesToValidate << fileInfo;
+        }
+      }
+    QList<CachedValidation> validations =
+      QtConcurrent::blockingMapped<QList<CachedValidation> >(filesToValidate, FileValidator(this));
+    for (int i = 0; i < filesToValidate.size(); ++i)
+      {
+      this->Cache.insert(filesToValidate[i].absoluteFilePath(), validations[i]);
+      this->CacheModified = true;
       }
     }
+
+  foreach (const QFileInfo& fileInfo, files)
+    {
+    this->registerFileItem(this->itemKey(fileInfo), fileInfo);
+    }
+  this->writeCache();
 }
 
 //-----------------------------------------------------------------------------
@@ -100,6 +139,7 @@ QString ctkAbstractFileBasedFactory<BaseClassType>
 {
   QString key = this->itemKey(fileInfo);
   bool registered = this->registerFileItem(key, fileInfo);
+  this->writeCache();
   return registered ? key : QString();
 }
 
@@ -120,6 +160,13 @@ bool ctkAbstractFileBasedFactory<BaseClassType>
                                "Already registered in other factory", this->verbose());
     return false;
     }
+  QStringList errorStrings;
+  if (this->DeferredLoading && !this->validateFileCached(fileInfo, errorStrings))
+    {
+    this->displayStatusMessage(QtCriticalMsg, description, "Failed", this->verbose());
+    this->displayErrorAndWarningStrings(errorStrings, QStringList());
+    return false;
+    }
   QSharedPointer<ctkAbstractFactoryItem<BaseClassType> >
     itemToRegister(this->createFactoryFileBasedItem());
   if (itemToRegister.isNull())
@@ -131,7 +178,7 @@ bool ctkAbstractFileBasedFactory<BaseClassType>
   dynamic_cast<ctkAbstractFactoryFileBasedItem<BaseClassType>*>(itemToRegister.data())
     ->setPath(fileInfo.filePath());
   this->initItem(itemToRegister.data());
-  return this->registerItem(key, itemToRegister);
+  return this->registerItem(key, itemToRegister, this->DeferredLoading);
 }
 
 //-----------------------------------------------------------------------------
@@ -166,4 +213,197 @@ QString ctkAbstractFileBasedFactory<BaseClassType>
   return QFileInfo(fileName).baseName();
 }
 
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFileBasedFactory<BaseClassType>
+::validateFile(const QFileInfo& fileInfo, QStringList& errorStrings)const
+{
+  if (!fileInfo.isReadable())
+    {
+    errorStrings << QString("Failed to read file: %1").arg(fileInfo.filePath());
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFileBasedFactory<BaseClassType>
+::loadDeferredItem(const QString& itemKey)
+{
+  ctkAbstractFactoryFileBasedItem<BaseClassType>* _item =
+      dynamic_cast<ctkAbstractFactoryFileBasedItem<BaseClassType>*>(this->item(itemKey));
+  if (this->ctkAbstractFactory<BaseClassType>::loadDeferredItem(itemKey))
+    {
+    return true;
+    }
+  if (!_item)
+    {
+    return false;
+    }
+  // Don't register the file again until it is modified
+  QFileInfo fileInfo(_item->path());
+  CachedValidation validation;
+  validation.TimeStamp = fileTimeStamp(fileInfo);
+  validation.Valid = false;
+  validation.ErrorStrings = _item->loadErrorStrings();
+  this->Cache.insert(fileInfo.absoluteFilePath(), validation);
+  this->CacheModified = true;
+  this->writeCache();
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+typename ctkAbstractFileBasedFactory<BaseClassType>::CachedValidation
+ctkAbstractFileBasedFactory<BaseClassType>::validateFileNow(const QFileInfo& fileInfo)const
+{
+  CachedValidation validation;
+  validation.TimeStamp = fileTimeStamp(fileInfo);
+  validation.Valid = this->validateFile(fileInfo, validation.ErrorStrings);
+  return validation;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+qint64 ctkAbstractFileBasedFactory<BaseClassType>::fileTimeStamp(const QFileInfo& fileInfo)
+{
+  // QDateTime::toMSecsSinceEpoch() requires Qt 4.7
+  return ctk::msecsTo(QDateTime::fromTime_t(0), fileInfo.lastModified());
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFileBasedFactory<BaseClassType>
+::isValidationCached(const QFileInfo& fileInfo)const
+{
+  typename QHash<QString, CachedValidation>::const_iterator iter =
+    this->Cache.find(fileInfo.absoluteFilePath());
+  return iter != this->Cache.constEnd() &&
+    iter.value().TimeStamp == fileTimeStamp(fileInfo);
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFileBasedFactory<BaseClassType>
+::validateFileCached(const QFileInfo& fileInfo, QStringList& errorStrings)
+{
+  if (!fileInfo.exists())
+    {
+    errorStrings << QString("File not found: %1").arg(fileInfo.filePath());
+    return false;
+    }
+  if (!this->isValidationCached(fileInfo))
+    {
+    this->Cache.insert(fileInfo.absoluteFilePath(), this->validateFileNow(fileInfo));
+    this->CacheModified = true;
+    }
+  const CachedValidation& validation = this->Cache[fileInfo.absoluteFilePath()];
+  errorStrings << validation.ErrorStrings;
+  return validation.Valid;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFileBasedFactory<BaseClassType>::readCache()
+{
+  this->Cache.clear();
+  this->CacheModified = false;
+  QFile file(this->CacheFilePath);
+  if (this->CacheFilePath.isEmpty() || !file.open(QIODevice::ReadOnly))
+    {
+    return;
+    }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_4_6);
+  quint32 version = 0;
+  quint32 count = 0;
+  stream >> version >> count;
+  if (version != 1)
+    {
+    return;
+    }
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+    QString filePath;
+    CachedValidation validation;
+    stream >> filePath >> validation.TimeStamp >> validation.Valid >> validation.ErrorStrings;
+    if (stream.status() == QDataStream::Ok)
+      {
+      this->Cache.insert(filePath, validation);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFileBasedFactory<BaseClassType>::writeCache()
+{
+  if (!this->CacheModified || this->CacheFilePath.isEmpty())
+    {
+    return;
+    }
+  QFile file(this->CacheFilePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+    this->displayStatusMessage(QtWarningMsg,
+                               QString("Attempt to write \"%1\"").arg(this->CacheFilePath),
+                               "Failed", this->verbose());
+    return;
+    }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_4_6);
+  stream << quint32(1) << quint32(this->Cache.size());
+  typename QHash<QString, CachedValidation>::const_iterator iter;
+  for (iter = this->Cache.constBegin(); iter != this->Cache.constEnd(); ++iter)
+    {
+    stream << iter.key() << iter.value().TimeStamp << iter.value().Valid
+           << iter.value().ErrorStrings;
+    }
+  this->CacheModified = false;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFileBasedFactory<BaseClassType>::setDeferredLoading(bool value)
+{
+  this->DeferredLoading = value;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFileBasedFactory<BaseClassType>::deferredLoading()const
+{
+  return this->DeferredLoading;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFileBasedFactory<BaseClassType>::setParallelValidation(bool value)
+{
+  this->ParallelValidation = value;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractFileBasedFactory<BaseClassType>::parallelValidation()const
+{
+  return this->ParallelValidation;
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+void ctkAbstractFileBasedFactory<BaseClassType>::setCacheFilePath(const QString& filePath)
+{
+  this->CacheFilePath = filePath;
+  this->readCache();
+}
+
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+QString ctkAbstractFileBasedFactory<BaseClassType>::cacheFilePath()const
+{
+  return this->CacheFilePath;
+}
+
 #endif
@@ -52,6 +52,11 @@ class ctkAbstractPluginFactory : public ctkAbstractFileBasedFactory<BaseClassTyp
 protected:
   virtual bool isValidFile(const QFileInfo& file)const;
   virtual ctkAbstractFactoryItem<BaseClassType>* createFactoryFileBasedItem();
+
+  /// Check, without loading it, that the file contains the verification data
+  /// of a plugin built against a compatible Qt version. It is the first
+  /// check done by QPluginLoader when loading a plugin.
+  virtual bool validateFile(const QFileInfo& file, QStringList& errorStrings)const;
 };
 
 #include "ctkAbstractPluginFactory.tpp"
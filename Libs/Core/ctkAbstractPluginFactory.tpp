@@ -28,6 +28,7 @@
 // QT includes
 #include <QPluginLoader>
 #include <QDebug>
+#include <QFile>
 
 //----------------------------------------------------------------------------
 // ctkFactoryPluginItem methods
@@ -112,4 +113,63 @@ bool ctkAbstractPluginFactory<BaseClassType>
     QLibrary::isLibrary(fileInfo.fileName());
 }
 
+//-----------------------------------------------------------------------------
+template<typename BaseClassType>
+bool ctkAbstractPluginFactory<BaseClassType>
+::validateFile(const QFileInfo& fileInfo, QStringList& errorStrings)const
+{
+  if (!this->ctkAbstractFileBasedFactory<BaseClassType>::validateFile(fileInfo, errorStrings))
+    {
+    return false;
+    }
+  QFile file(fileInfo.filePath());
+  if (!file.open(QIODevice::ReadOnly))
+    {
+    errorStrings << QString("Failed to open plugin %1: %2").arg(fileInfo.filePath()).arg(file.errorString());
+    return false;
+    }
+  QByteArray data;
+  uchar* mappedData = file.size() > 0 ? file.map(0, file.size()) : 0;
+  if (mappedData)
+    {
+    data = QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData), file.size());
+    }
+  else
+    {
+    data = file.readAll();
+    }
+
+  // Written by Q_EXPORT_PLUGIN2:
+  // "pattern=QT_PLUGIN_VERIFICATION_DATA\nversion=4.x.y\ndebug=...\nbuildkey=..."
+  // The pattern is concatenated at runtime to not be found in the binaries
+  // using this factory.
+  const QByteArray pattern = QByteArray("pattern=QT_PLUGIN_VERIFICATION_DATA") + "\nversion=";
+  int versionPos = data.lastIndexOf(pattern);
+  int versionEnd = -1;
+  if (versionPos >= 0)
+    {
+    versionPos += pattern.size();
+    versionEnd = data.indexOf('\n', versionPos);
+    }
+  if (versionEnd < 0)
+    {
+    errorStrings << QString("%1 is not a Qt plugin").arg(fileInfo.filePath());
+    return false;
+    }
+  QByteArray pluginQtVersionString = data.mid(versionPos, versionEnd - versionPos);
+  QList<QByteArray> version = pluginQtVersionString.split('.');
+  int pluginQtVersion = version.size() != 3 ? 0 :
+    (version[0].toInt() << 16) | (version[1].toInt() << 8) | version[2].toInt();
+  // Same rule as QPluginLoader: same major version, minor version not newer
+  if ((pluginQtVersion & 0xff0000) != (QT_VERSION & 0xff0000) ||
+      (pluginQtVersion & 0x00ff00) > (QT_VERSION & 0x00ff00))
+    {
+    errorStrings << QString("Plugin %1 uses an incompatible Qt library (%2)")
+                    .arg(fileInfo.filePath())
+                    .arg(QString(pluginQtVersionString));
+    return false;
+    }
+  return true;
+}
+
 #endif
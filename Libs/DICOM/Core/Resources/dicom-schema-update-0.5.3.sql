@@ -0,0 +1,14 @@
+-- 
+-- Update of a 0.5.3 database schema to 0.5.4 that keeps the existing rows
+-- 
+-- Note: run by ctkDICOMDatabase::updateSchemaIfNeeded, the last statement
+--       must set the Version the schema is updated to
+-- ;
+
+CREATE INDEX IF NOT EXISTS 'PatientsIDIndex' ON 'Patients' ('PatientID');
+CREATE INDEX IF NOT EXISTS 'PatientsNameIndex' ON 'Patients' ('PatientsName');
+CREATE INDEX IF NOT EXISTS 'StudiesDateIndex' ON 'Studies' ('StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesAccessionNumberIndex' ON 'Studies' ('AccessionNumber');
+CREATE INDEX IF NOT EXISTS 'SeriesModalityIndex' ON 'Series' ('Modality');
+
+UPDATE 'SchemaInfo' SET Version = '0.5.4';
@@ -0,0 +1,34 @@
+-- 
+-- Update of a 0.5.4 database schema to 0.5.5 that keeps the existing rows
+-- 
+-- Note: run by ctkDICOMDatabase::updateSchemaIfNeeded, the last statement
+--       must set the Version the schema is updated to
+-- ;
+
+CREATE TABLE 'SeriesSummary' (
+  'SeriesInstanceUID' VARCHAR(64) NOT NULL ,
+  'StudyInstanceUID' VARCHAR(64) NOT NULL ,
+  'InstanceCount' INT NOT NULL DEFAULT 0 ,
+  'LastModified' VARCHAR(20) NULL ,
+  PRIMARY KEY ('SeriesInstanceUID') );
+CREATE TABLE 'StudySummary' (
+  'StudyInstanceUID' VARCHAR(64) NOT NULL ,
+  'SeriesCount' INT NOT NULL DEFAULT 0 ,
+  'InstanceCount' INT NOT NULL DEFAULT 0 ,
+  'LastModified' VARCHAR(20) NULL ,
+  PRIMARY KEY ('StudyInstanceUID') );
+CREATE INDEX IF NOT EXISTS 'SeriesSummaryStudyIndex' ON 'SeriesSummary' ('StudyInstanceUID');
+
+INSERT INTO 'SeriesSummary'
+  SELECT Series.SeriesInstanceUID, Series.StudyInstanceUID,
+         COUNT(Images.SOPInstanceUID), MAX(Images.InsertTimestamp)
+  FROM Series LEFT JOIN Images ON Images.SeriesInstanceUID = Series.SeriesInstanceUID
+  GROUP BY Series.SeriesInstanceUID;
+INSERT INTO 'StudySummary'
+  SELECT Studies.StudyInstanceUID,
+         COUNT(SeriesSummary.SeriesInstanceUID), IFNULL(SUM(SeriesSummary.InstanceCount), 0),
+         MAX(SeriesSummary.LastModified)
+  FROM Studies LEFT JOIN SeriesSummary ON SeriesSummary.StudyInstanceUID = Studies.StudyInstanceUID
+  GROUP BY Studies.StudyInstanceUID;
+
+UPDATE 'SchemaInfo' SET Version = '0.5.5';
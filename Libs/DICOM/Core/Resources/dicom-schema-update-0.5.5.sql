@@ -0,0 +1,11 @@
+-- 
+-- Update of a 0.5.5 database schema to 0.5.6 that keeps the existing rows
+-- 
+-- Note: run by ctkDICOMDatabase::updateSchemaIfNeeded, the last statement
+--       must set the Version the schema is updated to
+-- Note: the size of the files inserted before the update is unknown (NULL)
+-- ;
+
+ALTER TABLE 'Images' ADD COLUMN 'FileSize' INT NULL;
+
+UPDATE 'SchemaInfo' SET Version = '0.5.6';
@@ -6,6 +6,12 @@
 --       commands per QSqlQuery::exec call!
 -- Note: be sure to update ctkDICOMDatabase and SchemaInfo Version 
 --       whenever you make a change to this schema
+-- Note: changes that keep the existing rows valid (e.g. new indexes) can be
+--       applied in place by a dicom-schema-update-<previous version>.sql
+--       script instead of re-inserting all the files
+-- Note: SeriesSummary and StudySummary are maintained by ctkDICOMDatabase
+--       when inserting and removing, so that browsing does not need to
+--       count the Images rows
 -- ;
 
 DROP TABLE IF EXISTS 'SchemaInfo' ;
@@ -14,20 +20,29 @@ DROP TABLE IF EXISTS 'Patients' ;
 DROP TABLE IF EXISTS 'Series' ;
 DROP TABLE IF EXISTS 'Studies' ;
 DROP TABLE IF EXISTS 'Directories' ;
+DROP TABLE IF EXISTS 'SeriesSummary' ;
+DROP TABLE IF EXISTS 'StudySummary' ;
 
 DROP INDEX IF EXISTS 'ImagesFilenameIndex' ;
 DROP INDEX IF EXISTS 'ImagesSeriesIndex' ;
 DROP INDEX IF EXISTS 'SeriesStudyIndex' ;
 DROP INDEX IF EXISTS 'StudiesPatientIndex' ;
+DROP INDEX IF EXISTS 'PatientsIDIndex' ;
+DROP INDEX IF EXISTS 'PatientsNameIndex' ;
+DROP INDEX IF EXISTS 'StudiesDateIndex' ;
+DROP INDEX IF EXISTS 'StudiesAccessionNumberIndex' ;
+DROP INDEX IF EXISTS 'SeriesModalityIndex' ;
+DROP INDEX IF EXISTS 'SeriesSummaryStudyIndex' ;
 
 CREATE TABLE 'SchemaInfo' ( 'Version' VARCHAR(1024) NOT NULL );
-INSERT INTO 'SchemaInfo' VALUES('0.5.3');
+INSERT INTO 'SchemaInfo' VALUES('0.5.6');
 
 CREATE TABLE 'Images' (
   'SOPInstanceUID' VARCHAR(64) NOT NULL,
   'Filename' VARCHAR(1024) NOT NULL ,
   'SeriesInstanceUID' VARCHAR(64) NOT NULL ,
   'InsertTimestamp' VARCHAR(20) NOT NULL ,
+  'FileSize' INT NULL ,
   PRIMARY KEY ('SOPInstanceUID') );
 CREATE TABLE 'Patients' (
   'UID' INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -72,6 +87,25 @@ CREATE UNIQUE INDEX IF NOT EXISTS 'ImagesFilenameIndex' ON 'Images' ('Filename')
 CREATE INDEX IF NOT EXISTS 'ImagesSeriesIndex' ON 'Images' ('SeriesInstanceUID');
 CREATE INDEX IF NOT EXISTS 'SeriesStudyIndex' ON 'Series' ('StudyInstanceUID');
 CREATE INDEX IF NOT EXISTS 'StudiesPatientIndex' ON 'Studies' ('PatientsUID');
+CREATE INDEX IF NOT EXISTS 'PatientsIDIndex' ON 'Patients' ('PatientID');
+CREATE INDEX IF NOT EXISTS 'PatientsNameIndex' ON 'Patients' ('PatientsName');
+CREATE INDEX IF NOT EXISTS 'StudiesDateIndex' ON 'Studies' ('StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesAccessionNumberIndex' ON 'Studies' ('AccessionNumber');
+CREATE INDEX IF NOT EXISTS 'SeriesModalityIndex' ON 'Series' ('Modality');
+
+CREATE TABLE 'SeriesSummary' (
+  'SeriesInstanceUID' VARCHAR(64) NOT NULL ,
+  'StudyInstanceUID' VARCHAR(64) NOT NULL ,
+  'InstanceCount' INT NOT NULL DEFAULT 0 ,
+  'LastModified' VARCHAR(20) NULL ,
+  PRIMARY KEY ('SeriesInstanceUID') );
+CREATE TABLE 'StudySummary' (
+  'StudyInstanceUID' VARCHAR(64) NOT NULL ,
+  'SeriesCount' INT NOT NULL DEFAULT 0 ,
+  'InstanceCount' INT NOT NULL DEFAULT 0 ,
+  'LastModified' VARCHAR(20) NULL ,
+  PRIMARY KEY ('StudyInstanceUID') );
+CREATE INDEX IF NOT EXISTS 'SeriesSummaryStudyIndex' ON 'SeriesSummary' ('StudyInstanceUID');
 
 CREATE TABLE 'Directories' (
   'Dirname' VARCHAR(1024) ,
@@ -142,6 +142,37 @@ int ctkDICOMDatabaseTest4( int argc, char * argv [] )
     return EXIT_FAILURE;
     }
 
+  //
+  // Test the batched tag cache access
+  //
+  QStringList instanceUIDs;
+  instanceUIDs << instanceUID << instanceUID << "1.2.3.4";
+  QStringList tags;
+  tags << tag << badTag << tag;
+  QStringList cachedTags = database.cachedTags(instanceUIDs, tags);
+  if (cachedTags.count() != 3
+      || cachedTags[0] != knownSeriesDescription
+      || cachedTags[1] != QString("__TAG_NOT_IN_INSTANCE__")
+      || cachedTags[2] != QString(""))
+    {
+    std::cerr << "ctkDICOMDatabase: cachedTags returned wrong values" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList values;
+  values << "first" << "" << "third";
+  if (!database.cacheTags(instanceUIDs, tags, values))
+    {
+    std::cerr << "ctkDICOMDatabase: could not cache tags" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (database.cachedTag("1.2.3.4", tag) != QString("third")
+      || database.cachedTags(instanceUIDs, tags)[0] != QString("first"))
+    {
+    std::cerr << "ctkDICOMDatabase: cacheTags did not update the cache" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   database.closeDatabase();
 
   std::cerr << "Database is in " << databaseDirectory.path().toStdString() << std::endl;
@@ -0,0 +1,128 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMItem.h"
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+
+int ctkDICOMDatabaseTest5( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 3)
+    {
+    std::cerr << "ctkDICOMDatabaseTest5: missing dicom filePath arguments";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList dicomFilePaths;
+  dicomFilePaths << argv[1] << argv[2];
+
+  ctkDICOMDatabase database;
+  QDir databaseDirectory = QDir::temp();
+  databaseDirectory.remove("ctkDICOMDatabase.sql");
+  databaseDirectory.remove("ctkDICOMTagCache.sql");
+
+  QFileInfo databaseFile(databaseDirectory, QString("database.test"));
+  database.openDatabase(databaseFile.absoluteFilePath());
+
+  if (!database.initializeDatabase())
+    {
+    std::cerr << "ctkDICOMDatabase::initializeDatabase() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Insert both files in a single batch
+  //
+  QList<ctkDICOMItem*> datasets;
+  foreach(const QString& dicomFilePath, dicomFilePaths)
+    {
+    ctkDICOMItem* dataset = new ctkDICOMItem;
+    dataset->InitializeFromFile(dicomFilePath);
+    datasets << dataset;
+    }
+  // uninitialized datasets must be skipped
+  datasets << new ctkDICOMItem;
+  QStringList filePaths = dicomFilePaths;
+  filePaths << QString("invalid.dcm");
+
+  database.insertBatch(datasets, filePaths, false, false);
+  qDeleteAll(datasets);
+
+  if (database.isInInsertBatch())
+    {
+    std::cerr << "ctkDICOMDatabase::insertBatch() did not end its batch" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (database.allFiles().count() != 2)
+    {
+    std::cerr << "ctkDICOMDatabase::insertBatch() inserted "
+              << database.allFiles().count() << " files instead of 2" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  foreach(const QString& dicomFilePath, dicomFilePaths)
+    {
+    if (database.instanceForFile(dicomFilePath).isEmpty())
+      {
+      std::cerr << "ctkDICOMDatabase::insertBatch() did not insert "
+                << qPrintable(dicomFilePath) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //
+  // Nested batches are committed by the outermost one
+  //
+  database.initializeDatabase();
+  database.beginInsertBatch(1);
+  database.beginInsertBatch();
+  database.insert(dicomFilePaths[0], false, false);
+  database.endInsertBatch();
+  if (!database.isInInsertBatch())
+    {
+    std::cerr << "ctkDICOMDatabase: nested endInsertBatch() ended the outer batch" << std::endl;
+    return EXIT_FAILURE;
+    }
+  database.insert(dicomFilePaths[1], false, false);
+  database.endInsertBatch();
+
+  if (database.patients().count() != 1 || database.allFiles().count() != 2)
+    {
+    std::cerr << "ctkDICOMDatabase: batched inserts are not in the database" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  database.closeDatabase();
+
+  return EXIT_SUCCESS;
+}
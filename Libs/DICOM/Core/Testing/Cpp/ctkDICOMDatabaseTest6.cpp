@@ -0,0 +1,251 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QSqlQuery>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Returns the detail column of the plan SQLite chooses for \a statement
+QStringList queryPlan(const QSqlDatabase& database, const QString& statement)
+{
+  QSqlQuery query(database);
+  QStringList plan;
+  if (!query.exec("EXPLAIN QUERY PLAN " + statement))
+    {
+    return plan;
+    }
+  while (query.next())
+    {
+    plan << query.value(3).toString();
+    }
+  return plan;
+}
+
+//------------------------------------------------------------------------------
+bool usesIndex(const QSqlDatabase& database, const QString& statement, const QString& index)
+{
+  QStringList plan = queryPlan(database, statement);
+  foreach(const QString& step, plan)
+    {
+    if (step.contains(index))
+      {
+      return true;
+      }
+    }
+  std::cerr << "Query plan of \"" << qPrintable(statement)
+            << "\" does not use " << qPrintable(index) << ":" << std::endl;
+  foreach(const QString& step, plan)
+    {
+    std::cerr << "  " << qPrintable(step) << std::endl;
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool checkQueryPlans(const QSqlDatabase& database)
+{
+  // browser lookups
+  return usesIndex(database, "SELECT UID FROM Patients WHERE PatientID = 'x'", "PatientsIDIndex")
+    && usesIndex(database, "SELECT UID FROM Patients WHERE PatientsName = 'x'", "PatientsNameIndex")
+    && usesIndex(database, "SELECT StudyInstanceUID FROM Studies WHERE StudyDate BETWEEN '20000101' AND '20001231'", "StudiesDateIndex")
+    && usesIndex(database, "SELECT StudyInstanceUID FROM Studies WHERE AccessionNumber = 'x'", "StudiesAccessionNumberIndex")
+    && usesIndex(database, "SELECT SeriesInstanceUID FROM Series WHERE Modality = 'MR'", "SeriesModalityIndex")
+    && usesIndex(database, "SELECT SeriesInstanceUID FROM Series WHERE StudyInstanceUID = 'x'", "SeriesStudyIndex")
+    && usesIndex(database, "SELECT Filename FROM Images WHERE SeriesInstanceUID = 'x'", "ImagesSeriesIndex")
+    // ctkDICOMDatabase::cleanup()
+    && usesIndex(database, "DELETE FROM Series WHERE NOT EXISTS ( SELECT 1 FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID )", "ImagesSeriesIndex")
+    && usesIndex(database, "DELETE FROM Studies WHERE NOT EXISTS ( SELECT 1 FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID )", "SeriesStudyIndex")
+    && usesIndex(database, "DELETE FROM Patients WHERE NOT EXISTS ( SELECT 1 FROM Studies WHERE Studies.PatientsUID = Patients.UID )", "StudiesPatientIndex")
+    // ctkDICOMModel
+    && usesIndex(database, "SELECT SeriesInstanceUID, InstanceCount FROM Series LEFT JOIN SeriesSummary USING (SeriesInstanceUID) WHERE Series.StudyInstanceUID = 'x'", "SeriesStudyIndex");
+}
+
+//------------------------------------------------------------------------------
+bool checkCounts(ctkDICOMDatabase& database, int expectedInstanceCount)
+{
+  QStringList patients = database.patients();
+  QStringList studies = patients.count() == 1 ?
+    database.studiesForPatient(patients[0]) : QStringList();
+  QStringList series = studies.count() == 1 ?
+    database.seriesForStudy(studies[0]) : QStringList();
+  if (series.count() != 1)
+    {
+    std::cerr << "ctkDICOMDatabase: expected 1 patient, 1 study and 1 series" << std::endl;
+    return false;
+    }
+  if (database.instanceCountForSeries(series[0]) != expectedInstanceCount ||
+      database.instanceCountForStudy(studies[0]) != expectedInstanceCount ||
+      database.seriesCountForStudy(studies[0]) != 1)
+    {
+    std::cerr << "ctkDICOMDatabase: wrong summary counts: "
+              << database.instanceCountForSeries(series[0]) << " "
+              << database.instanceCountForStudy(studies[0]) << " "
+              << database.seriesCountForStudy(studies[0])
+              << ", expected " << expectedInstanceCount << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabaseTest6( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 3)
+    {
+    std::cerr << "ctkDICOMDatabaseTest6: missing dicom filePath arguments";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMDatabase database;
+  QDir databaseDirectory = QDir::temp();
+  databaseDirectory.remove("ctkDICOMDatabase.sql");
+  databaseDirectory.remove("ctkDICOMTagCache.sql");
+
+  QFileInfo databaseFile(databaseDirectory, QString("database.test"));
+  database.openDatabase(databaseFile.absoluteFilePath());
+
+  if (!database.initializeDatabase())
+    {
+    std::cerr << "ctkDICOMDatabase::initializeDatabase() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!checkQueryPlans(database.database()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  database.insert(argv[1], false, false);
+  database.insert(argv[2], false, false);
+
+  if (!checkCounts(database, 2))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Go back to the previous schema version and check that it is updated
+  // in place, without losing the inserted files
+  //
+  QSqlQuery downgrade(database.database());
+  downgrade.exec("DROP INDEX 'PatientsIDIndex'");
+  downgrade.exec("DROP INDEX 'SeriesModalityIndex'");
+  downgrade.exec("DROP TABLE 'SeriesSummary'");
+  downgrade.exec("DROP TABLE 'StudySummary'");
+  // without the FileSize column
+  downgrade.exec("CREATE TABLE 'ImagesWithoutSize' AS "
+                 "SELECT SOPInstanceUID, Filename, SeriesInstanceUID, InsertTimestamp FROM Images");
+  downgrade.exec("DROP TABLE 'Images'");
+  downgrade.exec("ALTER TABLE 'ImagesWithoutSize' RENAME TO 'Images'");
+  downgrade.exec("CREATE UNIQUE INDEX 'ImagesFilenameIndex' ON 'Images' ('Filename')");
+  downgrade.exec("CREATE INDEX 'ImagesSeriesIndex' ON 'Images' ('SeriesInstanceUID')");
+  downgrade.exec("UPDATE 'SchemaInfo' SET Version = '0.5.3'");
+
+  if (database.schemaVersionLoaded() != "0.5.3")
+    {
+    std::cerr << "ctkDICOMDatabase: could not downgrade the schema" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!database.updateSchemaIfNeeded())
+    {
+    std::cerr << "ctkDICOMDatabase::updateSchemaIfNeeded() did not update the schema" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (database.schemaVersionLoaded() != database.schemaVersion())
+    {
+    std::cerr << "ctkDICOMDatabase::updateSchemaIfNeeded() failed: loaded version is "
+              << qPrintable(database.schemaVersionLoaded()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!checkQueryPlans(database.database()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (database.allFiles().count() != 2)
+    {
+    std::cerr << "ctkDICOMDatabase::updateSchemaIfNeeded() lost files: "
+              << database.allFiles().count() << " left" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the size of the files inserted before the update is unknown
+  QSqlQuery fileSizes(database.database());
+  if (!fileSizes.exec("SELECT FileSize FROM Images WHERE FileSize IS NOT NULL") || fileSizes.next())
+    {
+    std::cerr << "ctkDICOMDatabase::updateSchemaIfNeeded() did not add the FileSize column"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the summaries are computed by the update
+  if (!checkCounts(database, 2))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // and maintained when files are removed
+  if (!database.removeFiles(QStringList() << argv[2]) || !checkCounts(database, 1))
+    {
+    std::cerr << "ctkDICOMDatabase::removeFiles() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Removing the only patient removes everything with a few statements
+  //
+  QStringList patients = database.patients();
+  if (patients.count() != 1 || !database.removePatient(patients[0]))
+    {
+    std::cerr << "ctkDICOMDatabase::removePatient() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QSqlQuery summaries(database.database());
+  summaries.exec("SELECT SeriesInstanceUID FROM SeriesSummary UNION ALL SELECT StudyInstanceUID FROM StudySummary");
+  if (!database.allFiles().isEmpty() || !database.patients().isEmpty() || summaries.next())
+    {
+    std::cerr << "ctkDICOMDatabase::removePatient() left rows behind" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QSet>
+#include <QStringList>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+QString newUID(const char* root)
+{
+  char uid[100];
+  dcmGenerateUniqueIdentifier(uid, root);
+  return QString(uid);
+}
+
+//------------------------------------------------------------------------------
+// Inserts \a count instances of \a dataset in the series \a seriesInstanceUID,
+// the files don't need to exist as they are never read
+void insertInstances(ctkDICOMDatabase& database, ctkDICOMItem& dataset,
+                     const QString& seriesInstanceUID, int count)
+{
+  dataset.SetElementAsString(DCM_SeriesInstanceUID, seriesInstanceUID);
+  for (int i = 0; i < count; ++i)
+    {
+    dataset.SetElementAsString(DCM_SOPInstanceUID, seriesInstanceUID + QString(".%1").arg(i + 1));
+    database.insert(dataset, QString("ctkDICOMDatabaseTest7/%1/%2").arg(seriesInstanceUID).arg(i),
+                    false, false);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool checkCounts(ctkDICOMDatabase& database, int expectedSeries, int expectedFiles,
+                 const char* step)
+{
+  QStringList patients = database.patients();
+  QStringList studies = database.studiesForPatient(patients.value(0));
+  QStringList series = database.seriesForStudy(studies.value(0));
+  int files = database.allFiles().count();
+  if (patients.count() != 1 || studies.count() != 1 ||
+      series.count() != expectedSeries || series.toSet().count() != expectedSeries ||
+      files != expectedFiles)
+    {
+    std::cerr << step << ": found " << patients.count() << " patients, "
+              << studies.count() << " studies, " << series.count() << " series and "
+              << files << " files instead of 1, 1, " << expectedSeries << " and "
+              << expectedFiles << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+int ctkDICOMDatabaseTest7( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMDatabaseTest7: missing dicom filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMDatabase database;
+  database.openDatabase(":memory:", "ctkDICOMDatabaseTest7");
+  if (!database.lastError().isEmpty())
+    {
+    std::cerr << "ctkDICOMDatabase::openDatabase() failed: "
+              << qPrintable(database.lastError()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMItem dataset;
+  dataset.InitializeFromFile(argv[1]);
+  if (!dataset.IsInitialized())
+    {
+    std::cerr << "Failed to read " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The instances of a series share their patient, study and series,
+  // which are found in the insert caches after the first instance
+  const int instanceCount = 50;
+  QString seriesInstanceUID = newUID(SITE_SERIES_UID_ROOT);
+  insertInstances(database, dataset, seriesInstanceUID, instanceCount);
+  if (!checkCounts(database, 1, instanceCount, "Insert of a series"))
+    {
+    return EXIT_FAILURE;
+    }
+  // inserting them again changes nothing
+  insertInstances(database, dataset, seriesInstanceUID, instanceCount);
+  if (!checkCounts(database, 1, instanceCount, "Second insert of a series"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Removing the only series also removes its study and patient, the caches
+  // must forget them for the same files to be inserted again
+  if (!database.removeSeries(seriesInstanceUID) ||
+      !database.patients().isEmpty() || !database.allFiles().isEmpty())
+    {
+    std::cerr << "ctkDICOMDatabase::removeSeries() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  insertInstances(database, dataset, seriesInstanceUID, instanceCount);
+  if (!checkCounts(database, 1, instanceCount, "Insert after removeSeries()"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!database.removePatient(database.patients().value(0)) ||
+      !database.patients().isEmpty() || !database.allFiles().isEmpty())
+    {
+    std::cerr << "ctkDICOMDatabase::removePatient() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  insertInstances(database, dataset, seriesInstanceUID, instanceCount);
+  if (!checkCounts(database, 1, instanceCount, "Insert after removePatient()"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // More series than the caches hold (MaxInsertCacheSize): they are cleared
+  // when full and the forgotten series are found in the database instead
+  const int seriesCount = 10001;
+  QStringList seriesInstanceUIDs;
+  database.beginInsertBatch();
+  for (int i = 0; i < seriesCount; ++i)
+    {
+    seriesInstanceUIDs << newUID(SITE_SERIES_UID_ROOT);
+    insertInstances(database, dataset, seriesInstanceUIDs.last(), 1);
+    }
+  database.endInsertBatch();
+  if (!checkCounts(database, seriesCount + 1, instanceCount + seriesCount,
+                   "Insert of more series than the caches hold"))
+    {
+    return EXIT_FAILURE;
+    }
+  // the first series were forgotten when the cache was cleared
+  insertInstances(database, dataset, seriesInstanceUID, instanceCount);
+  insertInstances(database, dataset, seriesInstanceUIDs.first(), 1);
+  if (!checkCounts(database, seriesCount + 1, instanceCount + seriesCount,
+                   "Insert of series forgotten by the caches"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // the last series is still in the cache until it is removed
+  if (!database.removeSeries(seriesInstanceUIDs.last()))
+    {
+    std::cerr << "ctkDICOMDatabase::removeSeries() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  insertInstances(database, dataset, seriesInstanceUIDs.last(), 1);
+  if (!checkCounts(database, seriesCount + 1, instanceCount + seriesCount,
+                   "Insert of a removed series"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
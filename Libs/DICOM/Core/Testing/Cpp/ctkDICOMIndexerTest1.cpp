@@ -30,9 +30,68 @@
 #include "ctkDICOMDatabase.h"
 #include "ctkDICOMIndexer.h"
 
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
 // STD includes
+#include <cstdlib>
 #include <iostream>
 
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Writes \a count copies of \a image with new SOP instance UIDs into
+// \a directory
+QStringList copyImage(const QString& image, int count, const QDir& directory)
+{
+  QStringList copies;
+  DcmFileFormat fileFormat;
+  if (!fileFormat.loadFile(image.toLatin1().data()).good())
+    {
+    return copies;
+    }
+  for (int i = 0; i < count; ++i)
+    {
+    char instanceUID[100];
+    dcmGenerateUniqueIdentifier(instanceUID, SITE_INSTANCE_UID_ROOT);
+    QString copy = directory.absoluteFilePath(QString("image%1.dcm").arg(i));
+    if (!fileFormat.getDataset()->putAndInsertString(DCM_SOPInstanceUID, instanceUID).good() ||
+        !fileFormat.getMetaInfo()->putAndInsertString(DCM_MediaStorageSOPInstanceUID, instanceUID).good() ||
+        !fileFormat.saveFile(copy.toLatin1().data()).good())
+      {
+      return QStringList();
+      }
+    copies << copy;
+    }
+  return copies;
+}
+
+//------------------------------------------------------------------------------
+// Writes \a image to \a copy with a new SOP instance UID and \a comments,
+// returns the new UID
+QString rewriteImage(const QString& image, const QString& copy, const QString& comments)
+{
+  DcmFileFormat fileFormat;
+  char instanceUID[100];
+  dcmGenerateUniqueIdentifier(instanceUID, SITE_INSTANCE_UID_ROOT);
+  // all in memory before \a image is overwritten
+  if (!fileFormat.loadFile(image.toLatin1().data()).good() ||
+      !fileFormat.loadAllDataIntoMemory().good() ||
+      !fileFormat.getDataset()->putAndInsertString(DCM_SOPInstanceUID, instanceUID).good() ||
+      !fileFormat.getDataset()->putAndInsertString(DCM_ImageComments, comments.toLatin1().data()).good() ||
+      !fileFormat.getMetaInfo()->putAndInsertString(DCM_MediaStorageSOPInstanceUID, instanceUID).good() ||
+      !fileFormat.saveFile(copy.toLatin1().data()).good())
+    {
+    return QString();
+    }
+  return QString(instanceUID);
+}
+
+}
+
 int ctkDICOMIndexerTest1( int argc, char * argv [] )
 {
   QCoreApplication app(argc, argv);
@@ -57,5 +116,116 @@ int ctkDICOMIndexerTest1( int argc, char * argv [] )
   // ensure all concurrent inserts are complete
   indexer.waitForImportFinished();
 
+  if (argc < 2)
+    {
+    return EXIT_SUCCESS;
+    }
+
+  // More files than a batch of the parser threads
+  const int imageCount = 100;
+  QDir imageDirectory(QDir::temp().absoluteFilePath("ctkDICOMIndexerTest1"));
+  imageDirectory.mkpath(imageDirectory.absolutePath());
+  foreach(const QString& file, imageDirectory.entryList(QDir::Files))
+    {
+    imageDirectory.remove(file);
+    }
+  QStringList images = copyImage(argv[1], imageCount, imageDirectory);
+  if (images.count() != imageCount)
+    {
+    std::cerr << "Failed to copy " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Parsed in parallel, every file is inserted
+  {
+  ctkDICOMDatabase parallelDatabase;
+  parallelDatabase.openDatabase(":memory:", "ctkDICOMIndexerTest1");
+  indexer.addListOfFiles(parallelDatabase, images);
+  if (parallelDatabase.allFiles().count() != imageCount ||
+      parallelDatabase.seriesForStudy(parallelDatabase.studiesForPatient(
+        parallelDatabase.patients().value(0)).value(0)).count() != 1)
+    {
+    std::cerr << "ctkDICOMIndexer::addListOfFiles() inserted "
+              << parallelDatabase.allFiles().count() << " files instead of "
+              << imageCount << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // Canceled while the first batch is inserted, the next ones are not
+  {
+  ctkDICOMDatabase canceledDatabase;
+  canceledDatabase.openDatabase(":memory:", "ctkDICOMIndexerTest1Canceled");
+  QObject::connect(&indexer, SIGNAL(indexingFilePath(QString)), &indexer, SLOT(cancel()));
+  indexer.addListOfFiles(canceledDatabase, images);
+  QObject::disconnect(&indexer, SIGNAL(indexingFilePath(QString)), &indexer, SLOT(cancel()));
+  int canceledCount = canceledDatabase.allFiles().count();
+  if (canceledCount == 0 || canceledCount >= imageCount)
+    {
+    std::cerr << "ctkDICOMIndexer::cancel() inserted " << canceledCount
+              << " files out of " << imageCount << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a canceled import doesn't prevent the next one
+  indexer.addListOfFiles(canceledDatabase, images);
+  if (canceledDatabase.allFiles().count() != imageCount)
+    {
+    std::cerr << "ctkDICOMIndexer::addListOfFiles() inserted "
+              << canceledDatabase.allFiles().count() << " files after a cancel instead of "
+              << imageCount << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // Refreshed after files of an indexed directory are modified, added and deleted
+  {
+  QDir refreshDirectory(QDir::temp().absoluteFilePath("ctkDICOMIndexerTest1Refresh"));
+  refreshDirectory.mkpath(refreshDirectory.absolutePath());
+  foreach(const QString& file, refreshDirectory.entryList(QDir::Files))
+    {
+    refreshDirectory.remove(file);
+    }
+  QStringList refreshedImages = copyImage(argv[1], 3, refreshDirectory);
+  ctkDICOMDatabase refreshedDatabase;
+  refreshedDatabase.openDatabase(":memory:", "ctkDICOMIndexerTest1Refresh");
+  indexer.addListOfFiles(refreshedDatabase, refreshedImages);
+  if (refreshedImages.count() != 3 || refreshedDatabase.allFiles().count() != 3)
+    {
+    std::cerr << "ctkDICOMIndexer::addListOfFiles() inserted "
+              << refreshedDatabase.allFiles().count() << " files instead of 3" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // rewritten right after it was inserted, likely within the same second
+  QString modifiedUID = rewriteImage(refreshedImages[0], refreshedImages[0], "modified");
+  QString addedImage = refreshDirectory.absoluteFilePath("added.dcm");
+  QString addedUID = rewriteImage(argv[1], addedImage, "added");
+  refreshDirectory.remove(QFileInfo(refreshedImages[1]).fileName());
+  if (modifiedUID.isEmpty() || addedUID.isEmpty())
+    {
+    std::cerr << "Failed to write the images to refresh" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  indexer.refreshDatabase(refreshedDatabase, refreshDirectory.absolutePath());
+  indexer.waitForImportFinished();
+
+  QStringList refreshedFiles = refreshedDatabase.allFiles();
+  if (refreshedFiles.count() != 3 ||
+      refreshedFiles.contains(refreshedImages[1]) ||
+      !refreshedFiles.contains(refreshedImages[2]) ||
+      refreshedDatabase.fileForInstance(modifiedUID) != refreshedImages[0] ||
+      refreshedDatabase.fileForInstance(addedUID) != addedImage)
+    {
+    std::cerr << "ctkDICOMIndexer::refreshDatabase() failed, the database contains:" << std::endl;
+    foreach(const QString& file, refreshedFiles)
+      {
+      std::cerr << "  " << qPrintable(file) << std::endl;
+      }
+    return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,130 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QTime>
+
+// ctkDICOMCore includes
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcelem.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+// Compares reading complete files with reading headers only, as done when
+// indexing. Pass large (e.g. enhanced multi-frame CT/MR) files to measure
+// the difference on the objects where it matters most.
+int ctkDICOMItemTest2( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMItemTest2: missing dicom filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList dicomFilePaths;
+  for (int i = 1; i < argc; ++i)
+    {
+    dicomFilePaths << argv[i];
+    }
+  const int iterations = 20;
+
+  //
+  // The header contains the same values as the complete file
+  //
+  foreach(const QString& dicomFilePath, dicomFilePaths)
+    {
+    ctkDICOMItem fullDataset;
+    fullDataset.InitializeFromFile(dicomFilePath);
+    ctkDICOMItem headerDataset;
+    headerDataset.InitializeFromFileHeader(dicomFilePath);
+    if (!fullDataset.IsInitialized() || !headerDataset.IsInitialized())
+      {
+      std::cerr << "ctkDICOMItem: could not read " << qPrintable(dicomFilePath) << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (headerDataset.GetSOPInstanceUID() != fullDataset.GetSOPInstanceUID()
+        || headerDataset.GetSeriesInstanceUID() != fullDataset.GetSeriesInstanceUID()
+        || headerDataset.GetElementAsString(DCM_PatientName) != fullDataset.GetElementAsString(DCM_PatientName))
+      {
+      std::cerr << "ctkDICOMItem::InitializeFromFileHeader() returned different values than InitializeFromFile()" << std::endl;
+      return EXIT_FAILURE;
+      }
+    // The pixel data is not read: the parsing stops before it or, with
+    // older DCMTK versions, its value is skipped
+    DcmElement* pixelData = 0;
+    if (!fullDataset.findAndGetElement(DCM_PixelData, pixelData).good())
+      {
+      std::cerr << "ctkDICOMItemTest2: no pixel data in " << qPrintable(dicomFilePath) << std::endl;
+      return EXIT_FAILURE;
+      }
+    pixelData = 0;
+    if (headerDataset.findAndGetElement(DCM_PixelData, pixelData).good()
+        && pixelData->valueLoaded())
+      {
+      std::cerr << "ctkDICOMItem::InitializeFromFileHeader() read the pixel data of "
+                << qPrintable(dicomFilePath) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //
+  // Throughput of both read modes
+  //
+  QTime timer;
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+    {
+    foreach(const QString& dicomFilePath, dicomFilePaths)
+      {
+      ctkDICOMItem dataset;
+      dataset.InitializeFromFile(dicomFilePath);
+      }
+    }
+  int fullElapsed = qMax(1, timer.elapsed());
+
+  timer.restart();
+  for (int i = 0; i < iterations; ++i)
+    {
+    foreach(const QString& dicomFilePath, dicomFilePaths)
+      {
+      ctkDICOMItem dataset;
+      dataset.InitializeFromFileHeader(dicomFilePath);
+      }
+    }
+  int headerElapsed = qMax(1, timer.elapsed());
+
+  const int fileCount = iterations * dicomFilePaths.count();
+  std::cout << "Read " << fileCount << " files" << std::endl;
+  std::cout << "  complete files: " << fullElapsed << " ms ("
+            << (1000. * fileCount / fullElapsed) << " files/s)" << std::endl;
+  std::cout << "  headers only:   " << headerElapsed << " ms ("
+            << (1000. * fileCount / headerElapsed) << " files/s)" << std::endl;
+
+  return EXIT_SUCCESS;
+}
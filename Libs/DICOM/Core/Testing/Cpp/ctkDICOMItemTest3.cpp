@@ -0,0 +1,247 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTextCodec>
+#include <QThread>
+#include <QTime>
+
+// ctkDICOMCore includes
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+struct CharacterSetSample
+{
+  const char* CharacterSet;
+  const char* Raw;
+  QString Expected;
+};
+
+// Person names as found in archives mixing western, unicode and japanese datasets
+QList<CharacterSetSample> characterSetSamples()
+{
+  QList<CharacterSetSample> samples;
+  CharacterSetSample latin1 = { "ISO_IR 100", "M\xfcller^J\xf6rg",
+    QString::fromUtf8("M\xc3\xbcller^J\xc3\xb6rg") };
+  samples << latin1;
+  CharacterSetSample utf8 = { "ISO_IR 192", "\xce\xa9\xce\xbc\xce\xad\xce\xb3\xce\xb1^\xce\x94",
+    QString::fromUtf8("\xce\xa9\xce\xbc\xce\xad\xce\xb3\xce\xb1^\xce\x94") };
+  samples << utf8;
+  // the japanese codecs are plugins in Qt 4, the sample is skipped without them
+  if (QTextCodec::codecForName("ISO-2022-JP"))
+    {
+    CharacterSetSample iso2022 = { "ISO 2022 IR 87", "\x1b$B;3ED\x1b(B^\x1b$BB@O:\x1b(B",
+      QString::fromUtf8("\xe5\xb1\xb1\xe7\x94\xb0^\xe5\xa4\xaa\xe9\x83\x8e") };
+    samples << iso2022;
+    }
+  return samples;
+}
+
+ctkDICOMItem* createItem(const CharacterSetSample& sample)
+{
+  DcmDataset* dataset = new DcmDataset();
+  dataset->putAndInsertString(DCM_SpecificCharacterSet, sample.CharacterSet);
+  dataset->putAndInsertString(DCM_PatientName, sample.Raw);
+  dataset->putAndInsertString(DCM_StudyDescription, sample.Raw);
+  ctkDICOMItem* item = new ctkDICOMItem();
+  item->InitializeFromItem(dataset, true);
+  return item;
+}
+
+// Decodes the string elements of its own items, as an indexing thread does
+class DecodeTask : public QRunnable
+{
+public:
+  DecodeTask(int count, QAtomicInt* failures)
+    : Count(count), Failures(failures)
+  {
+    this->Samples = characterSetSamples();
+    foreach(const CharacterSetSample& sample, this->Samples)
+      {
+      this->Items << createItem(sample);
+      }
+  }
+
+  ~DecodeTask()
+  {
+    qDeleteAll(this->Items);
+  }
+
+  void run()
+  {
+    for (int i = 0; i < this->Count; ++i)
+      {
+      const int index = i % this->Items.count();
+      if (this->Items[index]->GetElementAsString(DCM_PatientName) != this->Samples[index].Expected
+          || this->Items[index]->GetElementAsString(DCM_StudyDescription) != this->Samples[index].Expected)
+        {
+        this->Failures->ref();
+        }
+      }
+  }
+
+private:
+  int Count;
+  QAtomicInt* Failures;
+  QList<CharacterSetSample> Samples;
+  QList<ctkDICOMItem*> Items;
+};
+
+// Reads the headers of files and decodes a few string attributes
+class ScanTask : public QRunnable
+{
+public:
+  ScanTask(const QStringList& files)
+    : Files(files)
+  {
+  }
+
+  void run()
+  {
+    foreach(const QString& file, this->Files)
+      {
+      ctkDICOMItem dataset;
+      dataset.InitializeFromFileHeader(file);
+      if (dataset.IsInitialized())
+        {
+        dataset.GetElementAsString(DCM_PatientName);
+        dataset.GetElementAsString(DCM_StudyDescription);
+        dataset.GetElementAsString(DCM_SeriesDescription);
+        }
+      }
+  }
+
+private:
+  QStringList Files;
+};
+
+int runDecodeTasks(int taskCount, int countPerTask)
+{
+  QAtomicInt failures(0);
+  QThreadPool pool;
+  pool.setMaxThreadCount(taskCount);
+  for (int i = 0; i < taskCount; ++i)
+    {
+    pool.start(new DecodeTask(countPerTask, &failures));
+    }
+  pool.waitForDone();
+  return failures.fetchAndAddOrdered(0);
+}
+
+}
+
+// Decodes string attributes of datasets with different specific character
+// sets from several threads. Pass a directory to additionally measure a
+// header scan of the DICOM files it contains (e.g. 100k files of a mixed archive).
+int ctkDICOMItemTest3( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  //
+  // Each character set is decoded with its own codec
+  //
+  foreach(const CharacterSetSample& sample, characterSetSamples())
+    {
+    QScopedPointer<ctkDICOMItem> item(createItem(sample));
+    if (item->GetElementAsString(DCM_PatientName) != sample.Expected)
+      {
+      std::cerr << "ctkDICOMItem::Decode() failed for " << sample.CharacterSet << ": "
+                << qPrintable(item->GetElementAsString(DCM_PatientName)) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //
+  // Concurrent decoding
+  //
+  const int elementCount = 100000;
+  const int threadCount = qMax(2, QThread::idealThreadCount());
+
+  QTime timer;
+  timer.start();
+  if (runDecodeTasks(1, elementCount) != 0)
+    {
+    std::cerr << "ctkDICOMItem::Decode() failed in a single thread" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int singleElapsed = qMax(1, timer.elapsed());
+
+  timer.restart();
+  if (runDecodeTasks(threadCount, elementCount / threadCount) != 0)
+    {
+    std::cerr << "ctkDICOMItem::Decode() failed in concurrent threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int concurrentElapsed = qMax(1, timer.elapsed());
+
+  std::cout << "Decoded " << elementCount << " items" << std::endl;
+  std::cout << "  1 thread:  " << singleElapsed << " ms" << std::endl;
+  std::cout << "  " << threadCount << " threads: " << concurrentElapsed << " ms" << std::endl;
+
+  //
+  // Header scan of a directory
+  //
+  if (argc > 1)
+    {
+    QStringList files;
+    QDirIterator it(argv[1], QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+      {
+      files << it.next();
+      }
+
+    timer.restart();
+    ScanTask(files).run();
+    singleElapsed = qMax(1, timer.elapsed());
+
+    timer.restart();
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    const int chunkSize = qMax(1, files.count() / threadCount + 1);
+    for (int i = 0; i < files.count(); i += chunkSize)
+      {
+      pool.start(new ScanTask(files.mid(i, chunkSize)));
+      }
+    pool.waitForDone();
+    concurrentElapsed = qMax(1, timer.elapsed());
+
+    std::cout << "Scanned " << files.count() << " file headers" << std::endl;
+    std::cout << "  1 thread:  " << singleElapsed << " ms ("
+              << (1000. * files.count() / singleElapsed) << " files/s)" << std::endl;
+    std::cout << "  " << threadCount << " threads: " << concurrentElapsed << " ms ("
+              << (1000. * files.count() / concurrentElapsed) << " files/s)" << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QTime>
+#include <QVector>
+
+// ctkDICOMCore includes
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+// Keeps the base64 serialization in memory, as a database row would
+class ctkDICOMStoredItem : public ctkDICOMItem
+{
+public:
+  QString Serialization;
+
+protected:
+  virtual QString GetStoredSerialization()
+  {
+    return this->Serialization;
+  }
+  virtual void SetStoredSerialization(QString serializedDataset)
+  {
+    this->Serialization = serializedDataset;
+  }
+};
+
+bool sameValues(const ctkDICOMItem& item, const ctkDICOMItem& reference)
+{
+  return item.GetSOPInstanceUID() == reference.GetSOPInstanceUID()
+    && item.GetElementAsString(DCM_PatientName) == reference.GetElementAsString(DCM_PatientName);
+}
+
+}
+
+// Compares the binary serialization with the base64 one used for database
+// fields: size of the serialized data and round trip time.
+int ctkDICOMItemTest4( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMItemTest4: missing dicom filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int iterations = 50;
+
+  //
+  // A dataset larger than a 1 MB buffer is serialized entirely and
+  // restored byte for byte
+  //
+  {
+  const int columns = 1024;
+  const int rows = 1024;
+  QVector<Uint16> pixels(columns * rows);
+  for (int p = 0; p < pixels.size(); ++p)
+    {
+    pixels[p] = static_cast<Uint16>(p * 31 + p / columns);
+    }
+  DcmDataset* dataset = new DcmDataset;
+  dataset->putAndInsertString(DCM_SOPInstanceUID, "1.2.826.0.1.3680043.2.1125.1.4");
+  dataset->putAndInsertString(DCM_PatientName, "Synthetic^Large");
+  dataset->putAndInsertUint16(DCM_Rows, rows);
+  dataset->putAndInsertUint16(DCM_Columns, columns);
+  dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+  dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), pixels.size());
+
+  ctkDICOMStoredItem largeItem;
+  largeItem.InitializeFromItem(dataset, true);
+  QByteArray largeData = largeItem.SerializeToByteArray();
+  if (largeData.size() <= pixels.size() * static_cast<int>(sizeof(Uint16)))
+    {
+    std::cerr << "ctkDICOMItem::SerializeToByteArray() truncated a large dataset to "
+              << largeData.size() << " bytes" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the restored item is read, so that it is written again instead of
+  // giving the array back
+  ctkDICOMItem restoredItem;
+  restoredItem.DeserializeFromByteArray(largeData);
+  if (!restoredItem.IsInitialized() || !sameValues(restoredItem, largeItem)
+      || restoredItem.SerializeToByteArray() != largeData)
+    {
+    std::cerr << "ctkDICOMItem::DeserializeFromByteArray() restored a different large dataset"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  largeItem.Serialize();
+  ctkDICOMStoredItem restoredBase64Item;
+  restoredBase64Item.Serialization = largeItem.Serialization;
+  restoredBase64Item.Deserialize();
+  if (!restoredBase64Item.IsInitialized()
+      || restoredBase64Item.SerializeToByteArray() != largeData)
+    {
+    std::cerr << "ctkDICOMItem::Deserialize() restored a different large dataset"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  for (int i = 1; i < argc; ++i)
+    {
+    ctkDICOMStoredItem reference;
+    reference.InitializeFromFile(argv[i]);
+    if (!reference.IsInitialized())
+      {
+      std::cerr << "ctkDICOMItem: could not read " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    //
+    // Both serializations restore the same values
+    //
+    QByteArray serializedData = reference.SerializeToByteArray();
+    if (serializedData.isEmpty())
+      {
+      std::cerr << "ctkDICOMItem::SerializeToByteArray() returned no data" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    ctkDICOMItem binaryItem;
+    binaryItem.DeserializeFromByteArray(serializedData);
+    if (!binaryItem.IsInitialized() || !sameValues(binaryItem, reference))
+      {
+      std::cerr << "ctkDICOMItem::DeserializeFromByteArray() restored different values" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    reference.Serialize();
+    ctkDICOMStoredItem base64Item;
+    base64Item.Serialization = reference.Serialization;
+    base64Item.Deserialize();
+    if (!base64Item.IsInitialized() || !sameValues(base64Item, reference))
+      {
+      std::cerr << "ctkDICOMItem::Deserialize() restored different values" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    //
+    // An item that was not accessed gives back its data unchanged
+    //
+    ctkDICOMItem forwardedItem;
+    forwardedItem.DeserializeFromByteArray(serializedData);
+    if (forwardedItem.SerializeToByteArray() != serializedData)
+      {
+      std::cerr << "ctkDICOMItem::SerializeToByteArray() changed the data of an unread item" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    //
+    // Round trip time of both serializations
+    //
+    QTime timer;
+    timer.start();
+    for (int j = 0; j < iterations; ++j)
+      {
+      ctkDICOMItem item;
+      item.DeserializeFromByteArray(reference.SerializeToByteArray());
+      item.GetSOPInstanceUID();
+      }
+    int binaryElapsed = qMax(1, timer.elapsed());
+
+    timer.restart();
+    for (int j = 0; j < iterations; ++j)
+      {
+      reference.Serialize();
+      ctkDICOMStoredItem item;
+      item.Serialization = reference.Serialization;
+      item.Deserialize();
+      item.GetSOPInstanceUID();
+      }
+    int base64Elapsed = qMax(1, timer.elapsed());
+
+    std::cout << argv[i] << std::endl;
+    std::cout << "  binary: " << serializedData.size() << " bytes, "
+              << binaryElapsed << " ms for " << iterations << " round trips" << std::endl;
+    std::cout << "  base64: " << reference.Serialization.size() * sizeof(QChar) << " bytes, "
+              << base64Elapsed << " ms for " << iterations << " round trips" << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QStringList>
+#include <QTimer>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMModel.h"
+#include "ctkModelTester.h"
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Fetch all the children of \a parent, waiting for the asynchronous chunks
+bool fetchAll(ctkDICOMModel& model, const QModelIndex& parent)
+{
+  QEventLoop eventLoop;
+  QObject::connect(&model, SIGNAL(fetchFinished(QModelIndex)), &eventLoop, SLOT(quit()));
+  QTimer timeout;
+  timeout.setSingleShot(true);
+  QObject::connect(&timeout, SIGNAL(timeout()), &eventLoop, SLOT(quit()));
+  while (model.canFetchMore(parent))
+    {
+    int rowCount = model.rowCount(parent);
+    model.fetchMore(parent);
+    if (model.rowCount(parent) != rowCount || !model.canFetchMore(parent))
+      {
+      // fetched synchronously
+      continue;
+      }
+    timeout.start(10000);
+    eventLoop.exec();
+    if (!timeout.isActive())
+      {
+      std::cerr << "Timeout while fetching rows" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+QStringList uids(ctkDICOMModel& model, const QModelIndex& parent)
+{
+  QStringList result;
+  for (int row = 0; row < model.rowCount(parent); ++row)
+    {
+    result << model.data(model.index(row, 0, parent), ctkDICOMModel::UIDRole).toString();
+    }
+  return result;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMModelTest2( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc <= 2)
+    {
+    std::cerr << "Usage: ctkDICOMModelTest2 <scratch.db> <dumpfile.sql>" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMDatabase database( argv[1] );
+  if (!database.initializeDatabase(argv[2]))
+    {
+    std::cerr << "Error when initializing the data base: " << argv[2]
+              << " error: " << database.lastError().toStdString() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMModel syncModel;
+  syncModel.setDatabase(database.database());
+  fetchAll(syncModel, QModelIndex());
+
+  // one row per chunk to go through the keyset pagination
+  ctkModelTester tester;
+  tester.setNestedInserts(true);
+  tester.setThrowOnError(false);
+  ctkDICOMModel asyncModel;
+  asyncModel.setAsynchronousFetch(true);
+  asyncModel.setFetchChunkSize(1);
+  tester.setModel(&asyncModel);
+  asyncModel.setDatabase(database.database());
+
+  // rows are only added by the fetch thread
+  if (!fetchAll(asyncModel, QModelIndex()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  QStringList syncPatients = uids(syncModel, QModelIndex());
+  QStringList asyncPatients = uids(asyncModel, QModelIndex());
+  // both in the default order
+  if (syncPatients.isEmpty() || syncPatients != asyncPatients)
+    {
+    std::cerr << "Asynchronous model has " << asyncPatients.count()
+              << " patients instead of " << syncPatients.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // children of the first patient
+  QModelIndex syncPatient = syncModel.index(0, 0);
+  QModelIndex asyncPatient;
+  for (int row = 0; row < asyncModel.rowCount(); ++row)
+    {
+    QModelIndex index = asyncModel.index(row, 0);
+    if (asyncModel.data(index, ctkDICOMModel::UIDRole) ==
+        syncModel.data(syncPatient, ctkDICOMModel::UIDRole))
+      {
+      asyncPatient = index;
+      }
+    }
+  if (!fetchAll(syncModel, syncPatient) || !fetchAll(asyncModel, asyncPatient) ||
+      uids(syncModel, syncPatient) != uids(asyncModel, asyncPatient))
+    {
+    std::cerr << "Asynchronous model has different studies" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // sorting fetches the rows again, in order (column 3 is the Date)
+  asyncModel.sort(3, Qt::DescendingOrder);
+  if (!fetchAll(asyncModel, QModelIndex()) ||
+      asyncModel.rowCount() != syncPatients.count())
+    {
+    std::cerr << "Sorted asynchronous model has " << asyncModel.rowCount()
+              << " patients instead of " << syncPatients.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int row = 1; row < asyncModel.rowCount(); ++row)
+    {
+    QString previousDate = asyncModel.index(row - 1, 3).data().toString();
+    QString date = asyncModel.index(row, 3).data().toString();
+    if (QString::compare(previousDate, date) < 0)
+      {
+      std::cerr << "Patients are not sorted: " << qPrintable(previousDate)
+                << " before " << qPrintable(date) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // the fetch thread can not read an in-memory database
+  ctkDICOMDatabase memoryDatabase;
+  memoryDatabase.openDatabase(":memory:", "ctkDICOMModelTest2");
+  if (!memoryDatabase.initializeDatabase(argv[2]))
+    {
+    std::cerr << "Error when initializing the in-memory data base" << std::endl;
+    return EXIT_FAILURE;
+    }
+  ctkDICOMModel memoryModel;
+  memoryModel.setAsynchronousFetch(true);
+  memoryModel.setDatabase(memoryDatabase.database());
+  fetchAll(memoryModel, QModelIndex());
+  if (memoryModel.rowCount() != syncPatients.count())
+    {
+    std::cerr << "In-memory asynchronous model has " << memoryModel.rowCount()
+              << " patients instead of " << syncPatients.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -21,6 +21,8 @@
 // Qt includes
 #include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <QStringList>
 #include <QVariant>
 
@@ -29,6 +31,11 @@
 #include "ctkDICOMQuery.h"
 #include "ctkDICOMTester.h"
 
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
 // STD includes
 #include <iostream>
 
@@ -53,9 +60,39 @@ int ctkDICOMQueryTest2( int argc, char * argv [] )
     ctkDICOMQueryTest2PrintUsage();
     return EXIT_FAILURE;
     }
-  tester.storeData(arguments);
+
+  // Copy the images into a second study, so that the series level
+  // queries are shared by several associations
+  QDir tempDir(QDir::temp().absoluteFilePath("ctkDICOMQueryTest2"));
+  tempDir.mkpath(tempDir.absolutePath());
+  char studyUID[100];
+  char seriesUID[100];
+  dcmGenerateUniqueIdentifier(studyUID, SITE_STUDY_UID_ROOT);
+  dcmGenerateUniqueIdentifier(seriesUID, SITE_SERIES_UID_ROOT);
+  QStringList secondStudy;
+  foreach(const QString& image, arguments)
+    {
+    DcmFileFormat fileFormat;
+    char instanceUID[100];
+    dcmGenerateUniqueIdentifier(instanceUID, SITE_INSTANCE_UID_ROOT);
+    QString copy = tempDir.absoluteFilePath(QFileInfo(image).fileName());
+    if (!fileFormat.loadFile(image.toLatin1().data()).good() ||
+        !fileFormat.getDataset()->putAndInsertString(DCM_StudyInstanceUID, studyUID).good() ||
+        !fileFormat.getDataset()->putAndInsertString(DCM_SeriesInstanceUID, seriesUID).good() ||
+        !fileFormat.getDataset()->putAndInsertString(DCM_SOPInstanceUID, instanceUID).good() ||
+        !fileFormat.getMetaInfo()->putAndInsertString(DCM_MediaStorageSOPInstanceUID, instanceUID).good() ||
+        !fileFormat.saveFile(copy.toLatin1().data()).good())
+      {
+      std::cout << "Failed to copy " << qPrintable(image)
+                << " into a second study" << std::endl;
+      return EXIT_FAILURE;
+      }
+    secondStudy << copy;
+    }
+  tester.storeData(arguments + secondStudy);
 
   ctkDICOMDatabase database;
+  database.openDatabase(":memory:");
 
   ctkDICOMQuery query;
   query.setCallingAETitle("CTK_AE");
@@ -69,11 +106,45 @@ int ctkDICOMQueryTest2( int argc, char * argv [] )
     std::cout << "ctkDICOMQuery::query() failed" << std::endl;
     return EXIT_FAILURE;
     }
-  if (query.studyInstanceUIDQueried().count() == 0)
+  if (query.studyInstanceUIDQueried().count() < 2 ||
+      !query.studyInstanceUIDQueried().contains(studyUID))
+    {
+    std::cout << "ctkDICOMQuery::query() failed. "
+              << query.studyInstanceUIDQueried().count()
+              << " study instances retrieved" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // series level queries over several associations must find the same,
+  // for each study
+  ctkDICOMDatabase parallelDatabase;
+  parallelDatabase.openDatabase(":memory:", "ctkDICOMQueryTest2");
+  ctkDICOMQuery parallelQuery;
+  parallelQuery.setCallingAETitle("CTK_AE");
+  parallelQuery.setCalledAETitle("CTK_AE");
+  parallelQuery.setHost("localhost");
+  parallelQuery.setPort(tester.dcmqrscpPort());
+  parallelQuery.setMaximumAssociations(4);
+  if (!parallelQuery.query(parallelDatabase) ||
+      parallelQuery.studyInstanceUIDQueried() != query.studyInstanceUIDQueried())
     {
-    std::cout << "ctkDICOMQuery::query() failed."
-              << "No study instance retrieved" << std::endl;
+    std::cout << "ctkDICOMQuery::query() failed with "
+              << parallelQuery.maximumAssociations() << " associations" << std::endl;
     return EXIT_FAILURE;
     }
+  foreach(const QString& study, query.studyInstanceUIDQueried())
+    {
+    QStringList series = database.seriesForStudy(study);
+    QStringList parallelSeries = parallelDatabase.seriesForStudy(study);
+    qSort(series);
+    qSort(parallelSeries);
+    if (series.isEmpty() || series != parallelSeries)
+      {
+      std::cout << "ctkDICOMQuery::query() found " << parallelSeries.count()
+                << " series instead of " << series.count()
+                << " for study " << qPrintable(study) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,134 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QStringList>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMQuery.h"
+#include "ctkDICOMRetrieveScheduler.h"
+#include "ctkDICOMTester.h"
+
+// STD includes
+#include <iostream>
+
+void ctkDICOMRetrieveTest3PrintUsage()
+{
+  std::cout << " ctkDICOMRetrieveTest3 images" << std::endl;
+}
+
+// Retrieve with parallel associations from a local dcmqrscp
+int ctkDICOMRetrieveTest3( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  ctkDICOMTester tester;
+  tester.startDCMQRSCP();
+
+  QStringList arguments = app.arguments();
+  arguments.pop_front(); // remove application name
+  arguments.pop_front(); // remove test name
+  if (!arguments.count())
+    {
+    ctkDICOMRetrieveTest3PrintUsage();
+    return EXIT_FAILURE;
+    }
+  tester.storeData(arguments);
+
+  ctkDICOMDatabase queryDatabase;
+  ctkDICOMQuery query;
+  query.setCallingAETitle("CTK_AE");
+  query.setCalledAETitle("CTK_AE");
+  query.setHost("localhost");
+  query.setPort(tester.dcmqrscpPort());
+  if (!query.query(queryDatabase) ||
+      query.studyInstanceUIDQueried().count() == 0)
+    {
+    std::cout << "ctkDICOMQuery::query() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QSharedPointer<ctkDICOMDatabase> retrieveDatabase(new ctkDICOMDatabase);
+  retrieveDatabase->openDatabase(":memory:");
+
+  ctkDICOMRetrieveScheduler scheduler;
+  scheduler.setDatabase(retrieveDatabase);
+  scheduler.setMaximumRetries(1);
+
+  QMap<QString, QVariant> parameters;
+  parameters["CallingAETitle"] = "CTK_AE";
+  parameters["AETitle"] = "CTK_AE";
+  parameters["Address"] = "localhost";
+  parameters["Port"] = tester.dcmqrscpPort();
+  parameters["CGET"] = true;
+  scheduler.addServerNode("commontk", parameters, 2);
+  if (scheduler.maximumAssociations("commontk") != 2)
+    {
+    std::cout << "ctkDICOMRetrieveScheduler::addServerNode() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (scheduler.retrieveStudy("unknown", query.studyInstanceUIDQueried()[0]))
+    {
+    std::cout << "ctkDICOMRetrieveScheduler::retrieveStudy() accepted an unknown node"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  foreach(const QString& study, query.studyInstanceUIDQueried())
+    {
+    scheduler.retrieveStudy("commontk", study);
+    }
+  // not on the server, must fail after its retry
+  scheduler.retrieveStudy("commontk", "1.2.3.4.5.6.7.8.9");
+
+  if (!scheduler.waitForFinished(120000))
+    {
+    std::cout << "ctkDICOMRetrieveScheduler::waitForFinished() timed out" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  int studyCount = query.studyInstanceUIDQueried().count();
+  if (scheduler.requestCount() != studyCount + 1 ||
+      scheduler.completedRequestCount() != studyCount ||
+      scheduler.failedRequestCount() != 1)
+    {
+    std::cout << "ctkDICOMRetrieveScheduler failed: "
+              << scheduler.completedRequestCount() << " completed and "
+              << scheduler.failedRequestCount() << " failed of "
+              << scheduler.requestCount() << " requests" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  foreach(const QString& study, query.studyInstanceUIDQueried())
+    {
+    if (retrieveDatabase->seriesForStudy(study).isEmpty())
+      {
+      std::cout << "Study " << qPrintable(study)
+                << " was not inserted in the database" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
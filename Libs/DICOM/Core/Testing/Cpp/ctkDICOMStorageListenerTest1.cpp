@@ -0,0 +1,256 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTime>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMStorageListener.h"
+#include "ctkDICOMTester.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+//------------------------------------------------------------------------------
+int ctkDICOMStorageListenerTest1( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMStorageListenerTest1: missing dicom filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList filePaths;
+  QStringList instanceUIDs;
+  for (int i = 1; i < argc; ++i)
+    {
+    filePaths << QString(argv[i]);
+    DcmFileFormat fileFormat;
+    OFString instanceUID;
+    fileFormat.loadFile(argv[i]);
+    fileFormat.getDataset()->findAndGetOFString(DCM_SOPInstanceUID, instanceUID);
+    instanceUIDs << instanceUID.c_str();
+    }
+
+  QDir databaseDirectory(QDir::temp().filePath("ctkDICOMStorageListenerTest1"));
+  databaseDirectory.mkpath(".");
+  databaseDirectory.remove("ctkDICOMDatabase.sql");
+  databaseDirectory.remove("ctkDICOMTagCache.sql");
+
+  QSharedPointer<ctkDICOMDatabase> database(new ctkDICOMDatabase);
+  database->openDatabase(databaseDirectory.filePath("ctkDICOMDatabase.sql"));
+  if (!database->isOpen())
+    {
+    std::cerr << "ctkDICOMDatabase::openDatabase() failed: "
+              << qPrintable(database->lastError()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMStorageListener listener;
+  if (listener.start())
+    {
+    std::cerr << "ctkDICOMStorageListener::start() must fail without database"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  listener.setDatabase(database);
+  listener.setPort(11114);
+  listener.setMaximumAssociations(2);
+  if (!listener.start() || !listener.isListening())
+    {
+    std::cerr << "ctkDICOMStorageListener::start() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // send half of the files over each of two concurrent associations
+  ctkDICOMTester tester;
+  QStringList arguments;
+  arguments << "-aec" << listener.AETitle() << "-aet" << "CTK_AE"
+            << "localhost" << QString::number(listener.port());
+  int half = (filePaths.count() + 1) / 2;
+  QProcess storeSCU1;
+  QProcess storeSCU2;
+  storeSCU1.start(tester.storeSCUExecutable(), arguments + filePaths.mid(0, half));
+  if (half < filePaths.count())
+    {
+    storeSCU2.start(tester.storeSCUExecutable(), arguments + filePaths.mid(half));
+    }
+  else
+    {
+    storeSCU2.start(tester.storeSCUExecutable(), QStringList() << "--version");
+    }
+  if (!storeSCU1.waitForFinished(60000) || storeSCU1.exitCode() != 0 ||
+      !storeSCU2.waitForFinished(60000) || storeSCU2.exitCode() != 0)
+    {
+    std::cerr << "storescu failed: "
+              << storeSCU1.readAllStandardError().constData()
+              << storeSCU2.readAllStandardError().constData() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  listener.stop();
+  if (listener.isListening() || !listener.flush(60000))
+    {
+    std::cerr << "ctkDICOMStorageListener::stop() or flush() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (listener.receivedObjectCount() != filePaths.count() ||
+      listener.receivedBytes() <= 0 ||
+      listener.objectsPerSecond() <= 0. ||
+      listener.megabytesPerSecond() <= 0.)
+    {
+    std::cerr << "Wrong counters: " << listener.receivedObjectCount() << " objects, "
+              << listener.receivedBytes() << " bytes" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  foreach(const QString& instanceUID, instanceUIDs)
+    {
+    QString fileName = database->fileForInstance(instanceUID);
+    if (fileName.isEmpty() || !QFileInfo(fileName).exists())
+      {
+      std::cerr << "Instance " << qPrintable(instanceUID)
+                << " was not inserted" << std::endl;
+      return EXIT_FAILURE;
+      }
+    DcmFileFormat fileFormat;
+    OFString receivedUID;
+    if (!fileFormat.loadFile(qPrintable(fileName)).good() ||
+        !fileFormat.getDataset()->findAndGetOFString(DCM_SOPInstanceUID, receivedUID).good() ||
+        instanceUID != receivedUID.c_str())
+      {
+      std::cerr << "Cannot read " << qPrintable(fileName) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  listener.resetCounters();
+  if (listener.receivedObjectCount() != 0 || listener.receivedBytes() != 0)
+    {
+    std::cerr << "ctkDICOMStorageListener::resetCounters() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // More objects than can wait to be inserted: the association waits for
+  // this thread to insert them, stop() must do it instead of waiting forever
+  listener.setMaximumPendingCount(2);
+  if (!listener.start())
+    {
+    std::cerr << "ctkDICOMStorageListener::start() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QStringList manyFilePaths;
+  for (int i = 0; i < 4; ++i)
+    {
+    manyFilePaths << filePaths;
+    }
+  QProcess storeSCU3;
+  storeSCU3.start(tester.storeSCUExecutable(), arguments + manyFilePaths);
+  // nothing is inserted while this thread doesn't run its event loop
+  QTime time;
+  time.start();
+  while (listener.receivedObjectCount() <= listener.maximumPendingCount() &&
+         storeSCU3.state() != QProcess::NotRunning && time.elapsed() < 60000)
+    {
+    storeSCU3.waitForFinished(100);
+    }
+  listener.stop();
+  if (!storeSCU3.waitForFinished(60000) || storeSCU3.exitCode() != 0)
+    {
+    std::cerr << "storescu failed: "
+              << storeSCU3.readAllStandardError().constData() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (listener.isListening() || !listener.flush(60000) ||
+      listener.receivedObjectCount() != manyFilePaths.count())
+    {
+    std::cerr << "ctkDICOMStorageListener::stop() with a full queue failed: "
+              << listener.receivedObjectCount() << " objects received instead of "
+              << manyFilePaths.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  foreach(const QString& instanceUID, instanceUIDs)
+    {
+    if (database->fileForInstance(instanceUID).isEmpty())
+      {
+      std::cerr << "Instance " << qPrintable(instanceUID)
+                << " was not inserted" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // An object whose SOP instance UID is not a valid file name is refused,
+  // the following ones are still received
+  const char* invalidUID = "1.2.3/../invalid";
+  QString invalidFilePath = databaseDirectory.filePath("invalid.dcm");
+  {
+  DcmFileFormat fileFormat;
+  if (!fileFormat.loadFile(argv[1]).good() ||
+      !fileFormat.getDataset()->putAndInsertString(DCM_SOPInstanceUID, invalidUID).good() ||
+      !fileFormat.getMetaInfo()->putAndInsertString(DCM_MediaStorageSOPInstanceUID, invalidUID).good() ||
+      !fileFormat.saveFile(qPrintable(invalidFilePath)).good())
+    {
+    std::cerr << "Cannot write " << qPrintable(invalidFilePath) << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+  if (!listener.start())
+    {
+    std::cerr << "ctkDICOMStorageListener::start() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QProcess storeSCU4;
+  storeSCU4.start(tester.storeSCUExecutable(), QStringList() << "--no-halt" << arguments
+                  << invalidFilePath << filePaths[0]);
+  if (!storeSCU4.waitForFinished(60000))
+    {
+    std::cerr << "storescu did not finish" << std::endl;
+    return EXIT_FAILURE;
+    }
+  listener.stop();
+  listener.flush(60000);
+  QDir storageDirectory(listener.storageDirectory());
+  if (listener.receivedObjectCount() != 1 ||
+      !database->fileForInstance(invalidUID).isEmpty() ||
+      storageDirectory.exists("invalid") ||
+      !storageDirectory.entryList(QStringList() << ".incoming.*",
+                                  QDir::Files | QDir::Hidden).isEmpty())
+    {
+    std::cerr << "Object with invalid SOP instance UID was not rejected: "
+              << listener.receivedObjectCount() << " objects received" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
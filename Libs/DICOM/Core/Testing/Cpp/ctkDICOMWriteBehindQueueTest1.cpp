@@ -0,0 +1,208 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QThread>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMWriteBehindQueue.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Queues data sets from another thread than the one of the database
+class ctkDICOMWriteBehindProducer : public QThread
+{
+public:
+  ctkDICOMWriteBehindProducer(ctkDICOMWriteBehindQueue& queue, QList<DcmFileFormat*> files)
+    : Queue(queue), Files(files), Success(true) {}
+  virtual void run()
+    {
+    foreach(DcmFileFormat* file, this->Files)
+      {
+      this->Success = this->Queue.enqueue(file->getDataset()) && this->Success;
+      }
+    }
+  ctkDICOMWriteBehindQueue& Queue;
+  QList<DcmFileFormat*> Files;
+  bool Success;
+};
+
+//------------------------------------------------------------------------------
+// Queue the datasets of \a filePaths and check they end up in \a database
+bool checkWriteBehind(QSharedPointer<ctkDICOMDatabase> database, const QStringList& filePaths,
+                      bool fromOtherThread)
+{
+  ctkDICOMWriteBehindQueue queue;
+  queue.setDatabase(database);
+  QDir spoolDirectory(QDir::temp().filePath("ctkDICOMWriteBehindQueueTest1Spool"));
+  spoolDirectory.mkpath(".");
+  queue.setSpoolDirectory(spoolDirectory.absolutePath());
+  // keep the queue full to exercise the back pressure
+  queue.setMaximumPendingCount(1);
+  queue.setBatchSize(1);
+
+  QStringList instanceUIDs;
+  QList<DcmFileFormat*> files;
+  bool success = true;
+  foreach(const QString& filePath, filePaths)
+    {
+    DcmFileFormat* fileFormat = new DcmFileFormat;
+    files << fileFormat;
+    if (!fileFormat->loadFile(qPrintable(filePath)).good())
+      {
+      std::cerr << "Cannot load " << qPrintable(filePath) << std::endl;
+      success = false;
+      }
+    OFString instanceUID;
+    fileFormat->getDataset()->findAndGetOFString(DCM_SOPInstanceUID, instanceUID);
+    instanceUIDs << instanceUID.c_str();
+    }
+
+  if (fromOtherThread)
+    {
+    // the files are inserted by this thread while it runs its event loop
+    ctkDICOMWriteBehindProducer producer(queue, files);
+    QEventLoop eventLoop;
+    QObject::connect(&producer, SIGNAL(finished()), &eventLoop, SLOT(quit()));
+    producer.start();
+    eventLoop.exec();
+    producer.wait();
+    success = success && producer.Success;
+    }
+  else
+    {
+    // this thread is the one of the database, it inserts when the queue is full
+    foreach(DcmFileFormat* fileFormat, files)
+      {
+      success = queue.enqueue(fileFormat->getDataset()) && success;
+      }
+    }
+  qDeleteAll(files);
+  if (!success)
+    {
+    std::cerr << "ctkDICOMWriteBehindQueue::enqueue() failed" << std::endl;
+    return false;
+    }
+
+  if (!queue.flush(60000) || queue.pendingCount() != 0)
+    {
+    std::cerr << "ctkDICOMWriteBehindQueue::flush() failed: "
+              << queue.pendingCount() << " files pending" << std::endl;
+    return false;
+    }
+
+  if (database->isInMemory())
+    {
+    // the data sets are inserted without their file, which is removed
+    if (!spoolDirectory.entryList(QDir::Files).isEmpty() ||
+        database->studiesForPatient(database->patients().value(0)).isEmpty())
+      {
+      std::cerr << "Spooled files were not inserted and removed: "
+                << qPrintable(spoolDirectory.entryList(QDir::Files).join(" ")) << std::endl;
+      return false;
+      }
+    return true;
+    }
+
+  foreach(const QString& instanceUID, instanceUIDs)
+    {
+    // the database used by the caller sees the files inserted by the queue
+    QString fileName = database->fileForInstance(instanceUID);
+    if (fileName.isEmpty() || !QFileInfo(fileName).exists())
+      {
+      std::cerr << "Instance " << qPrintable(instanceUID)
+                << " was not inserted" << std::endl;
+      return false;
+      }
+    if (!QFileInfo(fileName).absoluteFilePath().startsWith(
+          QFileInfo(database->databaseDirectory()).absoluteFilePath()))
+      {
+      std::cerr << "Instance " << qPrintable(instanceUID)
+                << " was not written to the database directory: "
+                << qPrintable(fileName) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMWriteBehindQueueTest1( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMWriteBehindQueueTest1: missing dicom filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList filePaths;
+  for (int i = 1; i < argc; ++i)
+    {
+    filePaths << QString(argv[i]);
+    }
+
+  QDir databaseDirectory(QDir::temp().filePath("ctkDICOMWriteBehindQueueTest1"));
+  databaseDirectory.mkpath(".");
+  databaseDirectory.remove("ctkDICOMDatabase.sql");
+  databaseDirectory.remove("ctkDICOMTagCache.sql");
+
+  QSharedPointer<ctkDICOMDatabase> database(new ctkDICOMDatabase);
+  database->openDatabase(databaseDirectory.filePath("ctkDICOMDatabase.sql"));
+  if (!database->isOpen())
+    {
+    std::cerr << "ctkDICOMDatabase::openDatabase() failed: "
+              << qPrintable(database->lastError()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkWriteBehind(database, filePaths, false) ||
+      !checkWriteBehind(database, filePaths, true))
+    {
+    return EXIT_FAILURE;
+    }
+
+  QSharedPointer<ctkDICOMDatabase> memoryDatabase(new ctkDICOMDatabase);
+  memoryDatabase->openDatabase(":memory:", "ctkDICOMWriteBehindQueueTest1");
+  if (!checkWriteBehind(memoryDatabase, filePaths, true))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -26,11 +26,16 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
 #include <QSet>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QStringList>
+#include <QThreadPool>
 #include <QVariant>
 
 // ctkDICOM includes
@@ -81,6 +86,14 @@ public:
   void registerCompressionLibraries();
   bool executeScript(const QString script);
   ///
+  /// \brief updates the loaded schema to \a targetVersion without
+  /// re-inserting the files
+  ///
+  /// Runs the Resources/dicom-schema-update-<version>.sql scripts one after
+  /// the other. Returns false if no such path exists, in which case the
+  /// database must be rebuilt with ctkDICOMDatabase::updateSchema().
+  bool updateSchemaInPlace(const QString& targetVersion);
+  ///
   /// \brief runs a query and prints debug output of status
   ///
   bool loggedExec(QSqlQuery& query);
@@ -93,10 +106,34 @@ public:
   void beginTransaction();
   void endTransaction();
 
+  ///
+  /// \brief return a query that has been prepared for \a queryString
+  ///
+  /// The statements run for every inserted dataset are prepared only once
+  /// per database connection and reused afterwards.
+  QSqlQuery& preparedQuery(const QString& queryString);
+  void clearPreparedQueries();
+  QHash<QString, QSqlQuery*> PreparedQueries;
+
+  /// state of the batch started by ctkDICOMDatabase::beginInsertBatch
+  int InsertBatchDepth;
+  int RowsPerTransaction;
+  int RowsInTransaction;
+  /// commits the current transaction once it holds RowsPerTransaction rows
+  void rowInserted();
+
   // dataset must be set always
   // filePath has to be set if this is an import of an actual file
   void insert ( const ctkDICOMItem& ctkDataset, const QString& filePath, bool storeFile = true, bool generateThumbnail = true);
 
+  ///
+  /// \brief removes the images, files and thumbnails of the series matching
+  /// \a seriesCondition, a WHERE clause on Series with one bound value
+  ///
+  /// The rows are removed by a single DELETE followed by
+  /// ctkDICOMDatabase::cleanup(), whatever the number of series.
+  bool removeSeriesWhere(const QString& seriesCondition, const QString& value);
+
   ///
   /// copy the complete list of files to an extra table
   ///
@@ -120,16 +157,41 @@ public:
 
   ctkDICOMAbstractThumbnailGenerator* thumbnailGenerator;
 
+  ///
+  /// \brief render the thumbnail of the DICOM file \a filename to \a thumbnailPath
+  ///
+  /// Only the first frame is decoded and it is scaled down before it is
+  /// handed to the thumbnail generator. Can be called from any thread.
+  bool generateThumbnail(const QString& filename, const QString& thumbnailPath);
+  /// generate the thumbnail now or queue it for the thumbnail threads
+  void requestThumbnail(const QString& sopInstanceUID, const QString& filename,
+                        const QString& thumbnailPath);
+  /// called by the thumbnail threads once a queued thumbnail is written
+  void thumbnailDone(const QString& sopInstanceUID, bool success);
+
+  bool AsynchronousThumbnails;
+  /// largest thumbnail dimension, only changed while no thumbnail is queued
+  int ThumbnailSize;
+  QThreadPool ThumbnailPool;
+  /// SOPInstanceUIDs of the queued thumbnails, guarded by ThumbnailMutex
+  QSet<QString> PendingThumbnails;
+  QMutex ThumbnailMutex;
+
   /// these are for optimizing the import of image sequences
-  /// since most information are identical for all slices
-  QString LastPatientID;
-  QString LastPatientsName;
-  QString LastPatientsBirthDate;
-  QString LastStudyInstanceUID;
-  QString LastSeriesInstanceUID;
-  int LastPatientUID;
-
-  /// resets the variables to new inserts won't be fooled by leftover values
+  /// since most information are identical for all slices.
+  /// They remember the patients (by PatientID, name and birth date),
+  /// studies and series that are known to be in the database, whatever
+  /// the order in which the files are inserted. Each cache holds at most
+  /// MaxInsertCacheSize entries.
+  QCache<QString, int> PatientUIDCache;
+  QSet<QString> KnownStudyInstanceUIDs;
+  QSet<QString> KnownSeriesInstanceUIDs;
+  static const int MaxInsertCacheSize = 10000;
+
+  /// Remember a study or series UID, forgetting all of them when the set is full
+  static void rememberUID(QSet<QString>& knownUIDs, const QString& uid);
+
+  /// resets the caches so new inserts won't be fooled by leftover values
   void resetLastInsertedValues();
 
   /// tagCache table has been checked to exist
@@ -140,11 +202,61 @@ public:
   QSqlDatabase TagCacheDatabase;
   QString TagCacheDatabaseFilename;
   QStringList TagsToPrecache;
-  void precacheTags( const QString sopInstanceUID );
+  /// most recently used tag cache values, in front of the TagCache table.
+  /// Keys are made by tagCacheKey(), values are the ones returned by cachedTag.
+  QCache<QString, QString> RecentlyUsedTags;
+  static const int MaxRecentlyUsedTags = 100000;
+  static QString tagCacheKey(const QString& sopInstanceUID, const QString& tag);
+  /// cache the TagsToPrecache values of \a dataset, which may have been
+  /// read with ctkDICOMItem::InitializeFromFileHeader
+  void precacheTags( const ctkDICOMItem& dataset, const QString sopInstanceUID );
 
   int insertPatient(const ctkDICOMItem& ctkDataset);
-  void insertStudy(const ctkDICOMItem& ctkDataset, int dbPatientID);
-  void insertSeries( const ctkDICOMItem& ctkDataset, QString studyInstanceUID);
+  /// insert the study if needed, returns true if the study is in the database
+  bool insertStudy(const ctkDICOMItem& ctkDataset, int dbPatientID);
+  /// insert the series if needed, returns true if the series is in the database
+  bool insertSeries( const ctkDICOMItem& ctkDataset, QString studyInstanceUID);
+
+  ///
+  /// \brief SeriesSummary and StudySummary maintenance
+  ///
+  /// The summaries are updated incrementally when a study, series or
+  /// instance is inserted and recomputed for the series touched by a
+  /// removal. Databases with an older schema have no summary tables.
+  bool hasSummaryTables();
+  int SummaryTablesState;
+  void studyInserted(const QString& studyInstanceUID);
+  void seriesInserted(const QString& studyInstanceUID, const QString& seriesInstanceUID);
+  void instanceInserted(const QString& studyInstanceUID, const QString& seriesInstanceUID,
+                        const QDateTime& timestamp);
+  void updateSummaries(const QSet<QString>& seriesInstanceUIDs);
+  int summaryCount(const QString& summaryQuery, const QString& countQuery, const QString& uid);
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMThumbnailTask : public QRunnable
+{
+public:
+  ctkDICOMThumbnailTask(ctkDICOMDatabasePrivate* database, const QString& sopInstanceUID,
+                        const QString& filename, const QString& thumbnailPath)
+    : Database(database)
+    , SOPInstanceUID(sopInstanceUID)
+    , Filename(filename)
+    , ThumbnailPath(thumbnailPath)
+  {
+  }
+
+  virtual void run()
+  {
+    bool success = this->Database->generateThumbnail(this->Filename, this->ThumbnailPath);
+    this->Database->thumbnailDone(this->SOPInstanceUID, success);
+  }
+
+private:
+  ctkDICOMDatabasePrivate* Database;
+  QString SOPInstanceUID;
+  QString Filename;
+  QString ThumbnailPath;
 };
 
 //------------------------------------------------------------------------------
@@ -154,20 +266,35 @@ public:
 ctkDICOMDatabasePrivate::ctkDICOMDatabasePrivate(ctkDICOMDatabase& o): q_ptr(&o)
 {
   this->thumbnailGenerator = NULL;
+  this->AsynchronousThumbnails = false;
+  this->ThumbnailSize = 128;
   this->LoggedExecVerbose = false;
   this->TagCacheVerified = false;
+  this->RecentlyUsedTags.setMaxCost(MaxRecentlyUsedTags);
+  this->InsertBatchDepth = 0;
+  this->RowsPerTransaction = 500;
+  this->RowsInTransaction = 0;
+  this->SummaryTablesState = -1;
   this->resetLastInsertedValues();
 }
 
 //------------------------------------------------------------------------------
 void ctkDICOMDatabasePrivate::resetLastInsertedValues()
 {
-  this->LastPatientID = QString("");
-  this->LastPatientsName = QString("");
-  this->LastPatientsBirthDate = QString("");
-  this->LastStudyInstanceUID = QString("");
-  this->LastSeriesInstanceUID = QString("");
-  this->LastPatientUID = -1;
+  this->PatientUIDCache.setMaxCost(MaxInsertCacheSize);
+  this->PatientUIDCache.clear();
+  this->KnownStudyInstanceUIDs.clear();
+  this->KnownSeriesInstanceUIDs.clear();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::rememberUID(QSet<QString>& knownUIDs, const QString& uid)
+{
+  if (knownUIDs.size() >= MaxInsertCacheSize)
+    {
+    knownUIDs.clear();
+    }
+  knownUIDs.insert(uid);
 }
 
 //------------------------------------------------------------------------------
@@ -197,6 +324,78 @@ void ctkDICOMDatabasePrivate::registerCompressionLibraries(){
 //------------------------------------------------------------------------------
 ctkDICOMDatabasePrivate::~ctkDICOMDatabasePrivate()
 {
+  this->ThumbnailPool.waitForDone();
+  this->clearPreparedQueries();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::generateThumbnail(const QString& filename, const QString& thumbnailPath)
+{
+  // The thumbnail only shows the first frame, there is no need to decode
+  // the others of a multi-frame object.
+  DicomImage dcmImage(QDir::toNativeSeparators(filename).toAscii(),
+                      CIF_UsePartialAccessToPixelData, 0, 1);
+  if (dcmImage.getStatus() != EIS_Normal)
+    {
+    return this->thumbnailGenerator->generateThumbnail(&dcmImage, thumbnailPath);
+    }
+
+  // Render the thumbnail from a reduced resolution copy instead of the
+  // full resolution image.
+  const unsigned long thumbnailSize = static_cast<unsigned long>(this->ThumbnailSize);
+  DicomImage* scaledImage = 0;
+  if (dcmImage.getWidth() > thumbnailSize || dcmImage.getHeight() > thumbnailSize)
+    {
+    scaledImage = dcmImage.getWidth() > dcmImage.getHeight() ?
+      dcmImage.createScaledImage(thumbnailSize, 0UL) :
+      dcmImage.createScaledImage(0UL, thumbnailSize);
+    }
+  bool success = this->thumbnailGenerator->generateThumbnail(
+    scaledImage ? scaledImage : &dcmImage, thumbnailPath);
+  delete scaledImage;
+  return success;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::requestThumbnail(const QString& sopInstanceUID,
+                                               const QString& filename,
+                                               const QString& thumbnailPath)
+{
+  Q_Q(ctkDICOMDatabase);
+  if (!this->AsynchronousThumbnails)
+    {
+    if (this->generateThumbnail(filename, thumbnailPath))
+      {
+      emit q->thumbnailReady(sopInstanceUID);
+      }
+    return;
+    }
+
+  QMutexLocker lock(&this->ThumbnailMutex);
+  if (this->PendingThumbnails.contains(sopInstanceUID))
+    {
+    // already queued
+    return;
+    }
+  this->PendingThumbnails.insert(sopInstanceUID);
+  this->ThumbnailPool.start(
+    new ctkDICOMThumbnailTask(this, sopInstanceUID, filename, thumbnailPath));
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::thumbnailDone(const QString& sopInstanceUID, bool success)
+{
+  Q_Q(ctkDICOMDatabase);
+  {
+  QMutexLocker lock(&this->ThumbnailMutex);
+  this->PendingThumbnails.remove(sopInstanceUID);
+  }
+  if (success)
+    {
+    // emitted from a thumbnail thread, receivers living in other threads
+    // get a queued call
+    emit q->thumbnailReady(sopInstanceUID);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -249,6 +448,155 @@ void ctkDICOMDatabasePrivate::endTransaction()
   transaction.exec();
 }
 
+//------------------------------------------------------------------------------
+QSqlQuery& ctkDICOMDatabasePrivate::preparedQuery(const QString& queryString)
+{
+  QSqlQuery* query = this->PreparedQueries.value(queryString, 0);
+  if (!query)
+    {
+    query = new QSqlQuery(this->Database);
+    if (!query->prepare(queryString))
+      {
+      logger.error( "Could not prepare statement: " + queryString
+                    + " Error: " + query->lastError().text() );
+      }
+    this->PreparedQueries.insert(queryString, query);
+    }
+  return *query;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::clearPreparedQueries()
+{
+  qDeleteAll(this->PreparedQueries);
+  this->PreparedQueries.clear();
+  // the schema may change with the statements
+  this->SummaryTablesState = -1;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::hasSummaryTables()
+{
+  if (this->SummaryTablesState < 0)
+    {
+    QStringList tables = this->Database.tables();
+    this->SummaryTablesState =
+      tables.contains("SeriesSummary") && tables.contains("StudySummary") ? 1 : 0;
+    }
+  return this->SummaryTablesState == 1;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::studyInserted(const QString& studyInstanceUID)
+{
+  if (!this->hasSummaryTables())
+    {
+    return;
+    }
+  QSqlQuery& insertSummary = preparedQuery(
+    "INSERT OR REPLACE INTO StudySummary ( 'StudyInstanceUID', 'SeriesCount', 'InstanceCount' ) VALUES ( ?, 0, 0 )" );
+  insertSummary.bindValue( 0, studyInstanceUID );
+  loggedExec(insertSummary);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::seriesInserted(const QString& studyInstanceUID, const QString& seriesInstanceUID)
+{
+  if (!this->hasSummaryTables())
+    {
+    return;
+    }
+  QSqlQuery& insertSummary = preparedQuery(
+    "INSERT OR REPLACE INTO SeriesSummary ( 'SeriesInstanceUID', 'StudyInstanceUID', 'InstanceCount' ) VALUES ( ?, ?, 0 )" );
+  insertSummary.bindValue( 0, seriesInstanceUID );
+  insertSummary.bindValue( 1, studyInstanceUID );
+  loggedExec(insertSummary);
+
+  QSqlQuery& updateStudy = preparedQuery(
+    "UPDATE StudySummary SET SeriesCount = SeriesCount + 1 WHERE StudyInstanceUID = ?" );
+  updateStudy.bindValue( 0, studyInstanceUID );
+  loggedExec(updateStudy);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::instanceInserted(const QString& studyInstanceUID, const QString& seriesInstanceUID,
+                                               const QDateTime& timestamp)
+{
+  if (!this->hasSummaryTables())
+    {
+    return;
+    }
+  QSqlQuery& updateSeries = preparedQuery(
+    "UPDATE SeriesSummary SET InstanceCount = InstanceCount + 1, LastModified = ? WHERE SeriesInstanceUID = ?" );
+  updateSeries.bindValue( 0, timestamp );
+  updateSeries.bindValue( 1, seriesInstanceUID );
+  loggedExec(updateSeries);
+
+  QSqlQuery& updateStudy = preparedQuery(
+    "UPDATE StudySummary SET InstanceCount = InstanceCount + 1, LastModified = ? WHERE StudyInstanceUID = ?" );
+  updateStudy.bindValue( 0, timestamp );
+  updateStudy.bindValue( 1, studyInstanceUID );
+  loggedExec(updateStudy);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::updateSummaries(const QSet<QString>& seriesInstanceUIDs)
+{
+  if (!this->hasSummaryTables() || seriesInstanceUIDs.isEmpty())
+    {
+    return;
+    }
+  // Only the touched series are counted again, each one through the
+  // ImagesSeriesIndex; their studies are then summed from SeriesSummary.
+  QSqlQuery& updateSeries = preparedQuery(
+    "UPDATE SeriesSummary SET "
+    "InstanceCount = ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = SeriesSummary.SeriesInstanceUID ), "
+    "LastModified = ( SELECT MAX(InsertTimestamp) FROM Images WHERE Images.SeriesInstanceUID = SeriesSummary.SeriesInstanceUID ) "
+    "WHERE SeriesInstanceUID = ?" );
+  QSqlQuery& studyForSeries = preparedQuery(
+    "SELECT StudyInstanceUID FROM SeriesSummary WHERE SeriesInstanceUID = ?" );
+  QSet<QString> studyInstanceUIDs;
+  foreach (const QString& seriesInstanceUID, seriesInstanceUIDs)
+    {
+    updateSeries.bindValue( 0, seriesInstanceUID );
+    loggedExec(updateSeries);
+    studyForSeries.bindValue( 0, seriesInstanceUID );
+    loggedExec(studyForSeries);
+    if (studyForSeries.next())
+      {
+      studyInstanceUIDs.insert(studyForSeries.value(0).toString());
+      }
+    studyForSeries.finish();
+    }
+
+  QSqlQuery& updateStudy = preparedQuery(
+    "UPDATE StudySummary SET "
+    "SeriesCount = ( SELECT COUNT(*) FROM SeriesSummary WHERE SeriesSummary.StudyInstanceUID = StudySummary.StudyInstanceUID AND InstanceCount > 0 ), "
+    "InstanceCount = ( SELECT IFNULL(SUM(InstanceCount), 0) FROM SeriesSummary WHERE SeriesSummary.StudyInstanceUID = StudySummary.StudyInstanceUID ), "
+    "LastModified = ( SELECT MAX(LastModified) FROM SeriesSummary WHERE SeriesSummary.StudyInstanceUID = StudySummary.StudyInstanceUID ) "
+    "WHERE StudyInstanceUID = ?" );
+  foreach (const QString& studyInstanceUID, studyInstanceUIDs)
+    {
+    updateStudy.bindValue( 0, studyInstanceUID );
+    loggedExec(updateStudy);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::rowInserted()
+{
+  if (this->InsertBatchDepth == 0)
+    {
+    return;
+    }
+  if (++this->RowsInTransaction >= this->RowsPerTransaction)
+    {
+    this->endTransaction();
+    this->beginTransaction();
+    this->RowsInTransaction = 0;
+    }
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMDatabasePrivate::createBackupFileList()
 {
@@ -270,6 +618,8 @@ void ctkDICOMDatabasePrivate::removeBackupFileList()
 void ctkDICOMDatabase::openDatabase(const QString databaseFile, const QString& connectionName )
 {
   Q_D(ctkDICOMDatabase);
+  d->clearPreparedQueries();
+  d->InsertBatchDepth = 0;
   d->DatabaseFileName = databaseFile;
   d->Database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
   d->Database.setDatabaseName(databaseFile);
@@ -305,6 +655,7 @@ void ctkDICOMDatabase::openDatabase(const QString databaseFile, const QString& c
   QFileInfo fileInfo(d->DatabaseFileName);
   d->TagCacheDatabaseFilename = QString( fileInfo.dir().path() + "/ctkDICOMTagCache.sql" );
   d->TagCacheVerified = false;
+  d->RecentlyUsedTags.clear();
   if ( !this->tagCacheExists() )
     {
     this->initializeTagCache();
@@ -336,6 +687,8 @@ ctkDICOMDatabase::ctkDICOMDatabase(QObject* parent)
 //------------------------------------------------------------------------------
 ctkDICOMDatabase::~ctkDICOMDatabase()
 {
+  // queued thumbnails emit signals on this object
+  this->waitForThumbnails();
 }
 
 //----------------------------------------------------------------------------
@@ -371,6 +724,8 @@ const QSqlDatabase& ctkDICOMDatabase::database() const {
 //------------------------------------------------------------------------------
 void ctkDICOMDatabase::setThumbnailGenerator(ctkDICOMAbstractThumbnailGenerator *generator){
   Q_D(ctkDICOMDatabase);
+  // the queued thumbnails still use the current generator
+  this->waitForThumbnails();
   d->thumbnailGenerator = generator;
 }
 
@@ -380,6 +735,52 @@ ctkDICOMAbstractThumbnailGenerator* ctkDICOMDatabase::thumbnailGenerator(){
   return d->thumbnailGenerator;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::setAsynchronousThumbnails(bool asynchronous)
+{
+  Q_D(ctkDICOMDatabase);
+  if (!asynchronous)
+    {
+    this->waitForThumbnails();
+    }
+  d->AsynchronousThumbnails = asynchronous;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::asynchronousThumbnails() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->AsynchronousThumbnails;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::setThumbnailSize(int size)
+{
+  Q_D(ctkDICOMDatabase);
+  if (size <= 0)
+    {
+    logger.warn("Ignoring invalid thumbnail size " + QString::number(size));
+    return;
+    }
+  // the thumbnail threads read the size
+  this->waitForThumbnails();
+  d->ThumbnailSize = size;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::thumbnailSize() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->ThumbnailSize;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::waitForThumbnails()
+{
+  Q_D(ctkDICOMDatabase);
+  d->ThumbnailPool.waitForDone();
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabasePrivate::executeScript(const QString script) {
   QFile scriptFile(script);
@@ -416,6 +817,40 @@ bool ctkDICOMDatabasePrivate::executeScript(const QString script) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::updateSchemaInPlace(const QString& targetVersion)
+{
+  Q_Q(ctkDICOMDatabase);
+  // the statements prepared for the previous schema are not reused
+  this->clearPreparedQueries();
+  QString version = q->schemaVersionLoaded();
+  while ( !version.isEmpty() && version != targetVersion )
+    {
+    QString updateScript = QString(":/dicom/dicom-schema-update-%1.sql").arg(version);
+    if ( !QFile::exists(updateScript) )
+      {
+      return false;
+      }
+    logger.info("Updating database schema from version " + version);
+    this->beginTransaction();
+    if ( !this->executeScript(updateScript) )
+      {
+      QSqlQuery rollback( this->Database );
+      this->loggedExec( rollback, "ROLLBACK TRANSACTION" );
+      return false;
+      }
+    this->endTransaction();
+    QString updatedVersion = q->schemaVersionLoaded();
+    if ( updatedVersion == version )
+      {
+      logger.error("Schema update script " + updateScript + " did not change the version");
+      return false;
+      }
+    version = updatedVersion;
+    }
+  return version == targetVersion;
+}
+
 //------------------------------------------------------------------------------
 QStringList ctkDICOMDatabasePrivate::filenames(QString table)
 {
@@ -437,6 +872,7 @@ bool ctkDICOMDatabase::initializeDatabase(const char* sqlFileName)
   Q_D(ctkDICOMDatabase);
 
   d->resetLastInsertedValues();
+  d->clearPreparedQueries();
 
   // remove any existing schema info - this handles the case where an
   // old schema should be loaded for testing.
@@ -474,14 +910,22 @@ QString ctkDICOMDatabase::schemaVersion()
   //   so that the ctkDICOMDatabasePrivate::filenames method
   //   still works.
   //
-  return QString("0.5.3");
+  return QString("0.5.6");
 };
 
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::updateSchemaIfNeeded(const char* schemaFile)
 {
+  Q_D(ctkDICOMDatabase);
   if ( schemaVersionLoaded() != schemaVersion() )
     {
+    if ( QString(schemaFile) == ":/dicom/dicom-schema.sql"
+         && d->updateSchemaInPlace(this->schemaVersion()) )
+      {
+      emit schemaUpdateStarted(0);
+      emit schemaUpdated();
+      return true;
+      }
     return this->updateSchema(schemaFile);
     }
   else
@@ -509,6 +953,7 @@ bool ctkDICOMDatabase::updateSchema(const char* schemaFile)
   emit schemaUpdateStarted(allFiles.length());
 
   int progressValue = 0;
+  this->beginInsertBatch();
   foreach(QString file, allFiles)
   {
     emit schemaUpdateProgress(progressValue);
@@ -519,6 +964,7 @@ bool ctkDICOMDatabase::updateSchema(const char* schemaFile)
 
     progressValue++;
   }
+  this->endInsertBatch();
   // TODO: check better that everything is ok
   d->removeBackupFileList();
   emit schemaUpdated();
@@ -531,6 +977,12 @@ bool ctkDICOMDatabase::updateSchema(const char* schemaFile)
 void ctkDICOMDatabase::closeDatabase()
 {
   Q_D(ctkDICOMDatabase);
+  if (d->InsertBatchDepth > 0)
+    {
+    d->InsertBatchDepth = 0;
+    d->endTransaction();
+    }
+  d->clearPreparedQueries();
   d->Database.close();
   d->TagCacheDatabase.close();
 }
@@ -586,6 +1038,47 @@ QStringList ctkDICOMDatabase::seriesForStudy(QString studyUID)
   return( result );
 }
 
+//------------------------------------------------------------------------------
+int ctkDICOMDatabasePrivate::summaryCount(const QString& summaryQuery, const QString& countQuery, const QString& uid)
+{
+  // databases with an older schema are counted the slow way
+  QSqlQuery query(this->Database);
+  query.prepare( this->hasSummaryTables() ? summaryQuery : countQuery );
+  query.bindValue( 0, uid );
+  query.exec();
+  return query.next() ? query.value(0).toInt() : 0;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::instanceCountForSeries(QString seriesUID)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->summaryCount(
+    "SELECT InstanceCount FROM SeriesSummary WHERE SeriesInstanceUID=?",
+    "SELECT COUNT(*) FROM Images WHERE SeriesInstanceUID=?",
+    seriesUID);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::seriesCountForStudy(QString studyUID)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->summaryCount(
+    "SELECT SeriesCount FROM StudySummary WHERE StudyInstanceUID=?",
+    "SELECT COUNT(*) FROM Series WHERE StudyInstanceUID=?",
+    studyUID);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::instanceCountForStudy(QString studyUID)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->summaryCount(
+    "SELECT InstanceCount FROM StudySummary WHERE StudyInstanceUID=?",
+    "SELECT COUNT(*) FROM Images JOIN Series ON Images.SeriesInstanceUID = Series.SeriesInstanceUID WHERE StudyInstanceUID=?",
+    studyUID);
+}
+
 //------------------------------------------------------------------------------
 QStringList ctkDICOMDatabase::filesForSeries(QString seriesUID)
 {
@@ -813,11 +1306,19 @@ QString ctkDICOMDatabase::fileValue(const QString fileName, const unsigned short
     return value;
     }
 
-  ctkDICOMItem dataset;
-  dataset.InitializeFromFile(fileName);
-
   DcmTagKey tagKey(group, element);
 
+  // only read the bulk data if the requested element is not in the header
+  ctkDICOMItem dataset;
+  if (tagKey < DCM_PixelData)
+    {
+    dataset.InitializeFromFileHeader(fileName);
+    }
+  else
+    {
+    dataset.InitializeFromFile(fileName);
+    }
+
   value = dataset.GetAllElementValuesAsString(tagKey);
   this->cacheTag(sopInstanceUID, tag, value);
   return( value );
@@ -859,12 +1360,27 @@ void ctkDICOMDatabase::insert( DcmItem *item, bool storeFile, bool generateThumb
   ctkDataset.InitializeFromItem(item, false /* do not take ownership */);
   this->insert(ctkDataset,storeFile,generateThumbnail);
 }
+
+//------------------------------------------------------------------------------
 void ctkDICOMDatabase::insert( const ctkDICOMItem& ctkDataset, bool storeFile, bool generateThumbnail)
 {
   Q_D(ctkDICOMDatabase);
   d->insert(ctkDataset, QString(), storeFile, generateThumbnail);
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::insert( const ctkDICOMItem& ctkDataset, const QString& filePath,
+                               bool storeFile, bool generateThumbnail)
+{
+  Q_D(ctkDICOMDatabase);
+  if ( !ctkDataset.IsInitialized() )
+    {
+      logger.warn(QString("Could not read DICOM file:") + filePath);
+      return;
+    }
+  d->insert(ctkDataset, filePath, storeFile, generateThumbnail);
+}
+
 
 //------------------------------------------------------------------------------
 void ctkDICOMDatabase::insert ( const QString& filePath, bool storeFile, bool generateThumbnail, bool createHierarchy, const QString& destinationDirectoryName)
@@ -887,7 +1403,7 @@ void ctkDICOMDatabase::insert ( const QString& filePath, bool storeFile, bool ge
   DcmFileFormat fileformat;
   ctkDICOMItem ctkDataset;
 
-  ctkDataset.InitializeFromFile(filePath);
+  ctkDataset.InitializeFromFileHeader(filePath);
   if ( ctkDataset.IsInitialized() )
     {
       d->insert( ctkDataset, filePath, storeFile, generateThumbnail );
@@ -909,8 +1425,7 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMItem& ctkDataset)
   QString patientsName(ctkDataset.GetElementAsString(DCM_PatientName) );
   QString patientsBirthDate(ctkDataset.GetElementAsString(DCM_PatientBirthDate) );
 
-  QSqlQuery checkPatientExistsQuery(Database);
-  checkPatientExistsQuery.prepare ( "SELECT * FROM Patients WHERE PatientID = ? AND PatientsName = ?" );
+  QSqlQuery& checkPatientExistsQuery = preparedQuery( "SELECT UID FROM Patients WHERE PatientID = ? AND PatientsName = ?" );
   checkPatientExistsQuery.bindValue ( 0, patientID );
   checkPatientExistsQuery.bindValue ( 1, patientsName );
   loggedExec(checkPatientExistsQuery);
@@ -918,7 +1433,8 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMItem& ctkDataset)
   if (checkPatientExistsQuery.next())
     {
       // we found him
-      dbPatientID = checkPatientExistsQuery.value(checkPatientExistsQuery.record().indexOf("UID")).toInt();
+      dbPatientID = checkPatientExistsQuery.value(0).toInt();
+      checkPatientExistsQuery.finish();
       qDebug() << "Found patient in the database as UId: " << dbPatientID;
     }
   else
@@ -930,8 +1446,7 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMItem& ctkDataset)
       QString patientsAge(ctkDataset.GetElementAsString(DCM_PatientAge) );
       QString patientComments(ctkDataset.GetElementAsString(DCM_PatientComments) );
 
-      QSqlQuery insertPatientStatement ( Database );
-      insertPatientStatement.prepare ( "INSERT INTO Patients ('UID', 'PatientsName', 'PatientID', 'PatientsBirthDate', 'PatientsBirthTime', 'PatientsSex', 'PatientsAge', 'PatientsComments' ) values ( NULL, ?, ?, ?, ?, ?, ?, ? )" );
+      QSqlQuery& insertPatientStatement = preparedQuery( "INSERT INTO Patients ('UID', 'PatientsName', 'PatientID', 'PatientsBirthDate', 'PatientsBirthTime', 'PatientsSex', 'PatientsAge', 'PatientsComments' ) values ( NULL, ?, ?, ?, ?, ?, ?, ? )" );
       insertPatientStatement.bindValue ( 0, patientsName );
       insertPatientStatement.bindValue ( 1, patientID );
       insertPatientStatement.bindValue ( 2, QDate::fromString ( patientsBirthDate, "yyyyMMdd" ) );
@@ -940,6 +1455,7 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMItem& ctkDataset)
       // TODO: shift patient's age to study,
       // since this is not a patient level attribute in images
       // insertPatientStatement.bindValue ( 5, patientsAge );
+      insertPatientStatement.bindValue ( 5, QVariant(QVariant::String) );
       insertPatientStatement.bindValue ( 6, patientComments );
       loggedExec(insertPatientStatement);
       dbPatientID = insertPatientStatement.lastInsertId().toInt();
@@ -950,14 +1466,15 @@ int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMItem& ctkDataset)
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMItem& ctkDataset, int dbPatientID)
+bool ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMItem& ctkDataset, int dbPatientID)
 {
   QString studyInstanceUID(ctkDataset.GetElementAsString(DCM_StudyInstanceUID) );
-  QSqlQuery checkStudyExistsQuery (Database);
-  checkStudyExistsQuery.prepare ( "SELECT * FROM Studies WHERE StudyInstanceUID = ?" );
+  QSqlQuery& checkStudyExistsQuery = preparedQuery( "SELECT StudyInstanceUID FROM Studies WHERE StudyInstanceUID = ?" );
   checkStudyExistsQuery.bindValue ( 0, studyInstanceUID );
   checkStudyExistsQuery.exec();
-  if(!checkStudyExistsQuery.next())
+  bool studyExists = checkStudyExistsQuery.next();
+  checkStudyExistsQuery.finish();
+  if(!studyExists)
     {
       qDebug() << "Need to insert new study: " << studyInstanceUID;
 
@@ -971,8 +1488,7 @@ void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMItem& ctkDataset, int db
       QString referringPhysician(ctkDataset.GetElementAsString(DCM_ReferringPhysicianName) );
       QString studyDescription(ctkDataset.GetElementAsString(DCM_StudyDescription) );
 
-      QSqlQuery insertStudyStatement ( Database );
-      insertStudyStatement.prepare ( "INSERT INTO Studies ( 'StudyInstanceUID', 'PatientsUID', 'StudyID', 'StudyDate', 'StudyTime', 'AccessionNumber', 'ModalitiesInStudy', 'InstitutionName', 'ReferringPhysician', 'PerformingPhysiciansName', 'StudyDescription' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
+      QSqlQuery& insertStudyStatement = preparedQuery( "INSERT INTO Studies ( 'StudyInstanceUID', 'PatientsUID', 'StudyID', 'StudyDate', 'StudyTime', 'AccessionNumber', 'ModalitiesInStudy', 'InstitutionName', 'ReferringPhysician', 'PerformingPhysiciansName', 'StudyDescription' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
       insertStudyStatement.bindValue ( 0, studyInstanceUID );
       insertStudyStatement.bindValue ( 1, dbPatientID );
       insertStudyStatement.bindValue ( 2, studyID );
@@ -987,28 +1503,27 @@ void ctkDICOMDatabasePrivate::insertStudy(const ctkDICOMItem& ctkDataset, int db
       if ( !insertStudyStatement.exec() )
         {
           logger.error ( "Error executing statament: " + insertStudyStatement.lastQuery() + " Error: " + insertStudyStatement.lastError().text() );
+          return false;
         }
-      else
-        {
-          LastStudyInstanceUID = studyInstanceUID;
-        }
+      this->studyInserted(studyInstanceUID);
     }
   else
     {
     qDebug() << "Used existing study: " << studyInstanceUID;
     }
+  return true;
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMItem& ctkDataset, QString studyInstanceUID)
+bool ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMItem& ctkDataset, QString studyInstanceUID)
 {
   QString seriesInstanceUID(ctkDataset.GetElementAsString(DCM_SeriesInstanceUID) );
-  QSqlQuery checkSeriesExistsQuery (Database);
-  checkSeriesExistsQuery.prepare ( "SELECT * FROM Series WHERE SeriesInstanceUID = ?" );
+  QSqlQuery& checkSeriesExistsQuery = preparedQuery( "SELECT SeriesInstanceUID FROM Series WHERE SeriesInstanceUID = ?" );
   checkSeriesExistsQuery.bindValue ( 0, seriesInstanceUID );
-  logger.warn ( "Statement: " + checkSeriesExistsQuery.lastQuery() );
   checkSeriesExistsQuery.exec();
-  if(!checkSeriesExistsQuery.next())
+  bool seriesExists = checkSeriesExistsQuery.next();
+  checkSeriesExistsQuery.finish();
+  if(!seriesExists)
     {
       qDebug() << "Need to insert new series: " << seriesInstanceUID;
 
@@ -1025,8 +1540,7 @@ void ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMItem& ctkDataset, QStri
       long echoNumber(ctkDataset.GetElementAsInteger(DCM_EchoNumbers) );
       long temporalPosition(ctkDataset.GetElementAsInteger(DCM_TemporalPositionIdentifier) );
 
-      QSqlQuery insertSeriesStatement ( Database );
-      insertSeriesStatement.prepare ( "INSERT INTO Series ( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDate', 'SeriesTime', 'SeriesDescription', 'Modality', 'BodyPartExamined', 'FrameOfReferenceUID', 'AcquisitionNumber', 'ContrastAgent', 'ScanningSequence', 'EchoNumber', 'TemporalPosition' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
+      QSqlQuery& insertSeriesStatement = preparedQuery( "INSERT INTO Series ( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDate', 'SeriesTime', 'SeriesDescription', 'Modality', 'BodyPartExamined', 'FrameOfReferenceUID', 'AcquisitionNumber', 'ContrastAgent', 'ScanningSequence', 'EchoNumber', 'TemporalPosition' ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
       insertSeriesStatement.bindValue ( 0, seriesInstanceUID );
       insertSeriesStatement.bindValue ( 1, studyInstanceUID );
       insertSeriesStatement.bindValue ( 2, static_cast<int>(seriesNumber) );
@@ -1046,17 +1560,15 @@ void ctkDICOMDatabasePrivate::insertSeries(const ctkDICOMItem& ctkDataset, QStri
           logger.error ( "Error executing statament: "
                          + insertSeriesStatement.lastQuery()
                          + " Error: " + insertSeriesStatement.lastError().text() );
-          LastSeriesInstanceUID = "";
-        }
-      else
-        {
-          LastSeriesInstanceUID = seriesInstanceUID;
+          return false;
         }
+      this->seriesInserted(studyInstanceUID, seriesInstanceUID);
     }
   else
     {
     qDebug() << "Used existing series: " << seriesInstanceUID;
     }
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1074,26 +1586,52 @@ const QStringList ctkDICOMDatabase::tagsToPrecache()
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMDatabasePrivate::precacheTags( const QString sopInstanceUID )
+void ctkDICOMDatabasePrivate::precacheTags( const ctkDICOMItem& headerDataset, const QString sopInstanceUID )
 {
   Q_Q(ctkDICOMDatabase);
 
-  ctkDICOMItem dataset;
-  QString fileName = q->fileForInstance(sopInstanceUID);
-  dataset.InitializeFromFile(fileName);
+  if (this->TagsToPrecache.isEmpty())
+    {
+    return;
+    }
 
-  this->beginTransaction();
+  // The inserted dataset may only contain the elements before the pixel
+  // data, read the whole file only if elements after it are requested.
+  const ctkDICOMItem* dataset = &headerDataset;
+  ctkDICOMItem fullDataset;
+  foreach (const QString &tag, this->TagsToPrecache)
+    {
+    unsigned short group, element;
+    q->tagToGroupElement(tag, group, element);
+    if (!(DcmTagKey(group, element) < DCM_PixelData))
+      {
+      QString fileName = q->fileForInstance(sopInstanceUID);
+      fullDataset.InitializeFromFile(fileName);
+      if (fullDataset.IsInitialized())
+        {
+        dataset = &fullDataset;
+        }
+      break;
+      }
+    }
 
+  QStringList sopInstanceUIDs;
+  QStringList values;
   foreach (const QString &tag, this->TagsToPrecache)
     {
     unsigned short group, element;
     q->tagToGroupElement(tag, group, element);
     DcmTagKey tagKey(group, element);
-    QString value = dataset.GetAllElementValuesAsString(tagKey);
-    q->cacheTag(sopInstanceUID, tag, value);
+    sopInstanceUIDs << sopInstanceUID;
+    values << dataset->GetAllElementValuesAsString(tagKey);
     }
+  q->cacheTags(sopInstanceUIDs, this->TagsToPrecache, values);
+}
 
-  this->endTransaction();
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabasePrivate::tagCacheKey(const QString& sopInstanceUID, const QString& tag)
+{
+  return sopInstanceUID + "|" + tag;
 }
 
 //------------------------------------------------------------------------------
@@ -1113,9 +1651,8 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
   
   QString sopInstanceUID ( ctkDataset.GetElementAsString(DCM_SOPInstanceUID) );
 
-  QSqlQuery fileExists ( Database );
-  fileExists.prepare("SELECT InsertTimestamp,Filename FROM Images WHERE SOPInstanceUID == :sopInstanceUID");
-  fileExists.bindValue(":sopInstanceUID",sopInstanceUID);
+  QSqlQuery& fileExists = preparedQuery("SELECT InsertTimestamp,Filename FROM Images WHERE SOPInstanceUID == ?");
+  fileExists.bindValue(0,sopInstanceUID);
   {
   bool success = fileExists.exec();
   if (!success)
@@ -1125,9 +1662,11 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
     }
   }
 
-  QString databaseFilename(fileExists.value(1).toString());
+  bool instanceExists = fileExists.next();
+  QString databaseFilename(instanceExists ? fileExists.value(1).toString() : QString());
   QDateTime fileLastModified(QFileInfo(databaseFilename).lastModified());
   QDateTime databaseInsertTimestamp(QDateTime::fromString(fileExists.value(0).toString(),Qt::ISODate));
+  fileExists.finish();
 
   qDebug() << "inserting filePath: " << filePath;
   if (databaseFilename == "")
@@ -1139,7 +1678,7 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
       qDebug() << "database filename for " << sopInstanceUID << " is: " << databaseFilename;
       qDebug() << "modified date is: " << fileLastModified;
       qDebug() << "db insert date is: " << databaseInsertTimestamp;
-      if ( fileExists.next() && fileLastModified < databaseInsertTimestamp )
+      if ( fileLastModified < databaseInsertTimestamp )
         {
           logger.debug ( "File " + databaseFilename + " already added" );
           return;
@@ -1210,20 +1749,22 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
   //The dbPatientID  is a unique number within the database,
   //generated by the sqlite autoincrement
   //The patientID  is the (non-unique) DICOM patient id
-  int dbPatientID = LastPatientUID;
+  int dbPatientID = -1;
 
   if ( patientID != "" && patientsName != "" )
     {
-      //Speed up: Check if patient is the same as in last file;
+      //Speed up: Check if patient is already known;
       // very probable, as all images belonging to a study have the same patient
       QString patientsBirthDate(ctkDataset.GetElementAsString(DCM_PatientBirthDate) );
-      if ( LastPatientID != patientID
-           || LastPatientsBirthDate != patientsBirthDate
-           || LastPatientsName != patientsName )
-        {  QString seriesInstanceUID(ctkDataset.GetElementAsString(DCM_SeriesInstanceUID) );
-
-          qDebug() << "This looks like a different patient from last insert: " << patientID;
-          // Ok, something is different from last insert, let's insert him if he's not
+      QString patientKey = patientID + "\\" + patientsName + "\\" + patientsBirthDate;
+      if ( int* cachedPatientUID = PatientUIDCache.object(patientKey) )
+        {
+          dbPatientID = *cachedPatientUID;
+        }
+      else
+        {
+          qDebug() << "This looks like a patient not known yet: " << patientID;
+          // Ok, we have not seen this patient yet, let's insert him if he's not
           // already in the db.
 
           dbPatientID = insertPatient( ctkDataset );
@@ -1231,28 +1772,34 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
           // let users of this class track when things happen
           emit q->patientAdded(dbPatientID, patientID, patientsName, patientsBirthDate);
 
-          /// keep this for the next image
-          LastPatientUID = dbPatientID;
-          LastPatientID = patientID;
-          LastPatientsBirthDate = patientsBirthDate;
-          LastPatientsName = patientsName;
+          /// keep this for the next images
+          if ( dbPatientID > 0 )
+            {
+              PatientUIDCache.insert(patientKey, new int(dbPatientID));
+            }
         }
 
       qDebug() << "Going to insert this instance with dbPatientID: " << dbPatientID;
 
       // Patient is in now. Let's continue with the study
 
-      if ( studyInstanceUID != "" && LastStudyInstanceUID != studyInstanceUID )
+      if ( studyInstanceUID != "" && !KnownStudyInstanceUIDs.contains(studyInstanceUID) )
         {
-          insertStudy(ctkDataset,dbPatientID);
+          if ( insertStudy(ctkDataset,dbPatientID) )
+            {
+              rememberUID(KnownStudyInstanceUIDs, studyInstanceUID);
+            }
 
           // let users of this class track when things happen
           emit q->studyAdded(studyInstanceUID);
         }
 
-      if ( seriesInstanceUID != "" && seriesInstanceUID != LastSeriesInstanceUID )
+      if ( seriesInstanceUID != "" && !KnownSeriesInstanceUIDs.contains(seriesInstanceUID) )
         {
-          insertSeries(ctkDataset, studyInstanceUID);
+          if ( insertSeries(ctkDataset, studyInstanceUID) )
+            {
+              rememberUID(KnownSeriesInstanceUIDs, seriesInstanceUID);
+            }
 
           // let users of this class track when things happen
           emit q->seriesAdded(seriesInstanceUID);
@@ -1261,22 +1808,31 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
       //
       if ( !filename.isEmpty() && !seriesInstanceUID.isEmpty() )
         {
-          QSqlQuery checkImageExistsQuery (Database);
-          checkImageExistsQuery.prepare ( "SELECT * FROM Images WHERE Filename = ?" );
+          QSqlQuery& checkImageExistsQuery = preparedQuery( "SELECT Filename FROM Images WHERE Filename = ?" );
           checkImageExistsQuery.bindValue ( 0, filename );
           checkImageExistsQuery.exec();
-          if(!checkImageExistsQuery.next())
+          bool imageExists = checkImageExistsQuery.next();
+          checkImageExistsQuery.finish();
+          if(!imageExists)
             {
-              QSqlQuery insertImageStatement ( Database );
-              insertImageStatement.prepare ( "INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ? )" );
+              QSqlQuery& insertImageStatement = preparedQuery( "INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'SeriesInstanceUID', 'InsertTimestamp', 'FileSize' ) VALUES ( ?, ?, ?, ?, ? )" );
               insertImageStatement.bindValue ( 0, sopInstanceUID );
               insertImageStatement.bindValue ( 1, filename );
               insertImageStatement.bindValue ( 2, seriesInstanceUID );
-              insertImageStatement.bindValue ( 3, QDateTime::currentDateTime() );
-              insertImageStatement.exec();
+              QDateTime insertTimestamp = QDateTime::currentDateTime();
+              insertImageStatement.bindValue ( 3, insertTimestamp );
+              // lets ctkDICOMIndexer::refreshDatabase detect files rewritten
+              // within the second they were inserted
+              QFileInfo fileInfo( filename );
+              insertImageStatement.bindValue ( 4, fileInfo.exists() ?
+                                               QVariant( fileInfo.size() ) : QVariant( QVariant::LongLong ) );
+              if ( insertImageStatement.exec() )
+                {
+                  this->instanceInserted(studyInstanceUID, seriesInstanceUID, insertTimestamp);
+                }
 
               // insert was needed, so cache any application-requested tags
-              this->precacheTags(sopInstanceUID);
+              this->precacheTags(ctkDataset, sopInstanceUID);
 
               // let users of this class track when things happen
               emit q->instanceAdded(sopInstanceUID);
@@ -1295,8 +1851,7 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
                 && (thumbnailInfo.lastModified() > QFileInfo(filename).lastModified())))
             {
               QDir(q->databaseDirectory() + "/thumbs/").mkpath(studySeriesDirectory);
-              DicomImage dcmImage(QDir::toNativeSeparators(filename).toAscii());
-              thumbnailGenerator->generateThumbnail(&dcmImage, thumbnailPath);
+              this->requestThumbnail(sopInstanceUID, filename, thumbnailPath);
             }
         }
 
@@ -1304,6 +1859,8 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
         {
           emit q->databaseChanged();
         }
+
+      this->rowInserted();
     }
   else
     {
@@ -1311,6 +1868,70 @@ void ctkDICOMDatabasePrivate::insert( const ctkDICOMItem& ctkDataset, const QStr
     }
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::beginInsertBatch(int rowsPerTransaction)
+{
+  Q_D(ctkDICOMDatabase);
+  if (d->InsertBatchDepth++ > 0)
+    {
+    // nested batch, already in a transaction
+    return;
+    }
+  d->RowsPerTransaction = qMax(1, rowsPerTransaction);
+  d->RowsInTransaction = 0;
+  d->beginTransaction();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::endInsertBatch()
+{
+  Q_D(ctkDICOMDatabase);
+  if (d->InsertBatchDepth == 0)
+    {
+    logger.warn("endInsertBatch called without matching beginInsertBatch");
+    return;
+    }
+  if (--d->InsertBatchDepth > 0)
+    {
+    return;
+    }
+  d->endTransaction();
+  d->RowsInTransaction = 0;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::isInInsertBatch() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->InsertBatchDepth > 0;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::insertBatch(const QList<ctkDICOMItem*>& datasets, const QStringList& filePaths,
+                                   bool storeFile, bool generateThumbnail)
+{
+  Q_D(ctkDICOMDatabase);
+  if (!filePaths.isEmpty() && filePaths.size() != datasets.size())
+    {
+    logger.error("insertBatch: the number of file paths does not match the number of datasets");
+    return;
+    }
+
+  this->beginInsertBatch();
+  for (int i = 0; i < datasets.size(); ++i)
+    {
+    const ctkDICOMItem* dataset = datasets[i];
+    QString filePath = filePaths.isEmpty() ? QString() : filePaths[i];
+    if (!dataset || !dataset->IsInitialized())
+      {
+      logger.warn(QString("Skipping uninitialized dataset ") + filePath);
+      continue;
+      }
+    d->insert(*dataset, filePath, storeFile, generateThumbnail);
+    }
+  this->endInsertBatch();
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::fileExistsAndUpToDate(const QString& filePath)
 {
@@ -1333,6 +1954,39 @@ bool ctkDICOMDatabase::fileExistsAndUpToDate(const QString& filePath)
 }
 
 
+//------------------------------------------------------------------------------
+QMap<QString, QDateTime> ctkDICOMDatabase::insertTimestampsForFiles(const QString& directory,
+                                                                    QMap<QString, qint64>* fileSizes)
+{
+  Q_D(ctkDICOMDatabase);
+  QMap<QString, QDateTime> result;
+
+  // A range on the Filename index instead of LIKE, which cannot use it:
+  // '0' is the character following '/'.
+  QString prefix = directory;
+  if (!prefix.endsWith("/"))
+    {
+    prefix += "/";
+    }
+  QString upperBound = prefix.left(prefix.length() - 1) + "0";
+
+  QSqlQuery query(d->Database);
+  query.prepare("SELECT Filename, InsertTimestamp, FileSize FROM Images WHERE Filename >= ? AND Filename < ?");
+  query.bindValue(0, prefix);
+  query.bindValue(1, upperBound);
+  d->loggedExec(query);
+  while (query.next())
+    {
+    result.insert(query.value(0).toString(),
+                  QDateTime::fromString(query.value(1).toString(), Qt::ISODate));
+    if (fileSizes && !query.value(2).isNull())
+      {
+      fileSizes->insert(query.value(0).toString(), query.value(2).toLongLong());
+      }
+    }
+  return result;
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::isOpen() const
 {
@@ -1348,14 +2002,16 @@ bool ctkDICOMDatabase::isInMemory() const
 }
 
 //------------------------------------------------------------------------------
-bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
+bool ctkDICOMDatabasePrivate::removeSeriesWhere(const QString& seriesCondition, const QString& value)
 {
-  Q_D(ctkDICOMDatabase);
+  Q_Q(ctkDICOMDatabase);
 
-  // get all images from series
-  QSqlQuery fileExists ( d->Database );
-  fileExists.prepare("SELECT Filename, SOPInstanceUID, StudyInstanceUID FROM Images,Series WHERE Series.SeriesInstanceUID = Images.SeriesInstanceUID AND Images.SeriesInstanceUID = :seriesID");
-  fileExists.bindValue(":seriesID",seriesInstanceUID);
+  // get all images from the matching series
+  QSqlQuery fileExists ( this->Database );
+  fileExists.prepare("SELECT Filename, SOPInstanceUID, Series.StudyInstanceUID, Series.SeriesInstanceUID "
+                     "FROM Images JOIN Series ON Series.SeriesInstanceUID = Images.SeriesInstanceUID "
+                     "WHERE " + seriesCondition);
+  fileExists.bindValue(0, value);
   bool success = fileExists.exec();
   if (!success)
     {
@@ -1364,34 +2020,40 @@ bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
     }
 
   QList< QPair<QString,QString> > removeList;
+  QSet<QString> removedSeries;
   while ( fileExists.next() )
     {
-      QString dbFilePath = fileExists.value(fileExists.record().indexOf("Filename")).toString();
-      QString sopInstanceUID = fileExists.value(fileExists.record().indexOf("SOPInstanceUID")).toString();
-      QString studyInstanceUID = fileExists.value(fileExists.record().indexOf("StudyInstanceUID")).toString();
+      QString dbFilePath = fileExists.value(0).toString();
+      QString sopInstanceUID = fileExists.value(1).toString();
+      QString studyInstanceUID = fileExists.value(2).toString();
+      QString seriesInstanceUID = fileExists.value(3).toString();
       QString internalFilePath = studyInstanceUID + "/" + seriesInstanceUID + "/" + sopInstanceUID;
       removeList << qMakePair(dbFilePath,internalFilePath);
+      removedSeries.insert(seriesInstanceUID);
     }
 
-  QSqlQuery fileRemove ( d->Database );
-  fileRemove.prepare("DELETE FROM Images WHERE SeriesInstanceUID == :seriesID");
-  fileRemove.bindValue(":seriesID",seriesInstanceUID);
-  logger.debug("SQLITE: removing seriesInstanceUID " + seriesInstanceUID);
+  QSqlQuery fileRemove ( this->Database );
+  fileRemove.prepare("DELETE FROM Images WHERE SeriesInstanceUID IN "
+                     "( SELECT SeriesInstanceUID FROM Series WHERE " + seriesCondition + " )");
+  fileRemove.bindValue(0, value);
+  logger.debug("SQLITE: removing images of series where " + seriesCondition + " with " + value);
   success = fileRemove.exec();
   if (!success)
     {
-      logger.error("SQLITE ERROR: could not remove seriesInstanceUID " + seriesInstanceUID);
+      logger.error("SQLITE ERROR: could not remove images of series where " + seriesCondition + " with " + value);
       logger.error("SQLITE ERROR: " + fileRemove.lastError().driverText());
     }
+  this->updateSummaries(removedSeries);
 
+  QString databaseDirectory = q->databaseDirectory();
   QPair<QString,QString> fileToRemove;
   foreach (fileToRemove, removeList)
     {
       QString dbFilePath = fileToRemove.first;
-      QString thumbnailToRemove = databaseDirectory() + "/thumbs/" + fileToRemove.second + ".png";
+      QString thumbnailToRemove = databaseDirectory + "/thumbs/" + fileToRemove.second + ".png";
 
       // check that the file is below our internal storage
-      if (dbFilePath.startsWith( databaseDirectory() + "/dicom/"))
+      if (dbFilePath.startsWith( databaseDirectory + "/dicom/"))
         {
           if (!dbFilePath.endsWith(fileToRemove.second))
             {
@@ -1417,76 +2079,108 @@ bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
         }
     }
 
-  this->cleanup();
+  q->cleanup();
 
-  d->resetLastInsertedValues();
-
-  return true;
+  return success;
 }
 
 //------------------------------------------------------------------------------
-bool ctkDICOMDatabase::cleanup()
+bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
 {
   Q_D(ctkDICOMDatabase);
-  QSqlQuery seriesCleanup ( d->Database );
-  seriesCleanup.exec("DELETE FROM Series WHERE ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID ) = 0;");
-  seriesCleanup.exec("DELETE FROM Studies WHERE ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID ) = 0;");
-  seriesCleanup.exec("DELETE FROM Patients WHERE ( SELECT COUNT(*) FROM Studies WHERE Studies.PatientsUID = Patients.UID ) = 0;");
-  return true;
+  return d->removeSeriesWhere("Series.SeriesInstanceUID = ?", seriesInstanceUID);
 }
 
 //------------------------------------------------------------------------------
-bool ctkDICOMDatabase::removeStudy(const QString& studyInstanceUID)
+bool ctkDICOMDatabase::removeFiles(const QStringList& filePaths)
 {
   Q_D(ctkDICOMDatabase);
 
-  QSqlQuery seriesForStudy( d->Database );
-  seriesForStudy.prepare("SELECT SeriesInstanceUID FROM Series WHERE StudyInstanceUID = :studyID");
-  seriesForStudy.bindValue(":studyID", studyInstanceUID);
-  bool success = seriesForStudy.exec();
-  if (!success)
+  d->beginTransaction();
+  QSqlQuery seriesForFile ( d->Database );
+  seriesForFile.prepare("SELECT SeriesInstanceUID FROM Images WHERE Filename = ?");
+  QSqlQuery fileRemove ( d->Database );
+  fileRemove.prepare("DELETE FROM Images WHERE Filename = ?");
+  QSet<QString> touchedSeries;
+  bool success = true;
+  foreach (const QString& filePath, filePaths)
+    {
+    seriesForFile.bindValue(0, filePath);
+    d->loggedExec(seriesForFile);
+    if (seriesForFile.next())
+      {
+      touchedSeries.insert(seriesForFile.value(0).toString());
+      }
+    seriesForFile.finish();
+    fileRemove.bindValue(0, filePath);
+    if (!d->loggedExec(fileRemove))
+      {
+      success = false;
+      break;
+      }
+    }
+  if (success)
     {
-      logger.error("SQLITE ERROR: " + seriesForStudy.lastError().driverText());
-      return false;
+    d->updateSummaries(touchedSeries);
+    d->endTransaction();
     }
-  bool result = true;
-  while ( seriesForStudy.next() )
+  else
     {
-      QString seriesInstanceUID = seriesForStudy.value(seriesForStudy.record().indexOf("SeriesInstanceUID")).toString();
-      if ( ! this->removeSeries(seriesInstanceUID) )
-        {
-          result = false;
-        }
+    QSqlQuery rollback ( d->Database );
+    d->loggedExec(rollback, "ROLLBACK TRANSACTION");
+    logger.error("SQLITE ERROR: could not remove files");
+    return false;
     }
-  d->resetLastInsertedValues();
-  return result;
+
+  this->cleanup();
+  return true;
 }
 
 //------------------------------------------------------------------------------
-bool ctkDICOMDatabase::removePatient(const QString& patientID)
+bool ctkDICOMDatabase::cleanup()
 {
   Q_D(ctkDICOMDatabase);
-
-  QSqlQuery studiesForPatient( d->Database );
-  studiesForPatient.prepare("SELECT StudyInstanceUID FROM Studies WHERE PatientsUID = :patientsID");
-  studiesForPatient.bindValue(":patientsID", patientID);
-  bool success = studiesForPatient.exec();
-  if (!success)
+  // one pass per table instead of counting the children of every row;
+  // NOT EXISTS rather than NOT IN, which matches nothing once the
+  // subquery returns a NULL
+  bool inTransaction = d->InsertBatchDepth > 0;
+  if (!inTransaction)
     {
-      logger.error("SQLITE ERROR: " + studiesForPatient.lastError().driverText());
-      return false;
+    d->beginTransaction();
     }
-  bool result = true;
-  while ( studiesForPatient.next() )
+  QSqlQuery seriesCleanup ( d->Database );
+  bool success =
+    d->loggedExec(seriesCleanup, "DELETE FROM Series WHERE NOT EXISTS ( SELECT 1 FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID );")
+    && d->loggedExec(seriesCleanup, "DELETE FROM Studies WHERE NOT EXISTS ( SELECT 1 FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID );")
+    && d->loggedExec(seriesCleanup, "DELETE FROM Patients WHERE NOT EXISTS ( SELECT 1 FROM Studies WHERE Studies.PatientsUID = Patients.UID );");
+  if (success && d->hasSummaryTables())
     {
-      QString studyInstanceUID = studiesForPatient.value(studiesForPatient.record().indexOf("StudyInstanceUID")).toString();
-      if ( ! this->removeStudy(studyInstanceUID) )
-        {
-          result = false;
-        }
+    success =
+      d->loggedExec(seriesCleanup, "DELETE FROM SeriesSummary WHERE NOT EXISTS ( SELECT 1 FROM Series WHERE Series.SeriesInstanceUID = SeriesSummary.SeriesInstanceUID );")
+      && d->loggedExec(seriesCleanup, "DELETE FROM StudySummary WHERE NOT EXISTS ( SELECT 1 FROM Studies WHERE Studies.StudyInstanceUID = StudySummary.StudyInstanceUID );");
     }
+  if (!inTransaction)
+    {
+    d->endTransaction();
+    }
+  // removed studies and patients must not be found in the insert caches
   d->resetLastInsertedValues();
-  return result;
+  return success;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::removeStudy(const QString& studyInstanceUID)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->removeSeriesWhere("Series.StudyInstanceUID = ?", studyInstanceUID);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::removePatient(const QString& patientID)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->removeSeriesWhere("Series.StudyInstanceUID IN "
+                              "( SELECT StudyInstanceUID FROM Studies WHERE PatientsUID = ? )", patientID);
 }
 
 ///
@@ -1551,6 +2245,8 @@ bool ctkDICOMDatabase::initializeTagCache()
     d->loggedExec(dropCacheTable);
     }
 
+  d->RecentlyUsedTags.clear();
+
   // now create a table
   qDebug() << "TagCacheDatabase adding table\n";
   QSqlQuery createCacheTable( d->TagCacheDatabase );
@@ -1576,6 +2272,11 @@ QString ctkDICOMDatabase::cachedTag(const QString sopInstanceUID, const QString
       return( "" );
       }
     }
+  QString key = d->tagCacheKey(sopInstanceUID, tag);
+  if (QString* recentlyUsed = d->RecentlyUsedTags.object(key))
+    {
+    return( *recentlyUsed );
+    }
   QSqlQuery selectValue( d->TagCacheDatabase );
   selectValue.prepare( "SELECT Value FROM TagCache WHERE SOPInstanceUID = :sopInstanceUID AND Tag = :tag" );
   selectValue.bindValue(":sopInstanceUID",sopInstanceUID);
@@ -1589,6 +2290,94 @@ QString ctkDICOMDatabase::cachedTag(const QString sopInstanceUID, const QString
       {
       result = ValueIsEmptyString;
       }
+    d->RecentlyUsedTags.insert(key, new QString(result));
+    }
+  return( result );
+}
+
+//------------------------------------------------------------------------------
+QStringList ctkDICOMDatabase::cachedTags(const QStringList& sopInstanceUIDs, const QStringList& tags)
+{
+  Q_D(ctkDICOMDatabase);
+  QStringList result;
+  if (sopInstanceUIDs.size() != tags.size())
+    {
+    logger.error("cachedTags: the number of instances does not match the number of tags");
+    return result;
+    }
+  if ( !this->tagCacheExists() )
+    {
+    if ( !this->initializeTagCache() )
+      {
+      for (int i = 0; i < tags.size(); ++i)
+        {
+        result << QString("");
+        }
+      return( result );
+      }
+    }
+
+  // first look into the recently used values, remember where the others go
+  QHash<QString, QList<int> > missingPositions;
+  QSet<QString> missingInstances;
+  for (int i = 0; i < sopInstanceUIDs.size(); ++i)
+    {
+    QString key = d->tagCacheKey(sopInstanceUIDs[i], tags[i]);
+    if (QString* recentlyUsed = d->RecentlyUsedTags.object(key))
+      {
+      result << *recentlyUsed;
+      }
+    else
+      {
+      result << QString("");
+      missingPositions[key] << i;
+      missingInstances.insert(sopInstanceUIDs[i]);
+      }
+    }
+  if (missingPositions.isEmpty())
+    {
+    return( result );
+    }
+
+  // then fetch the other ones, a chunk of instances per query
+  // (SQLite allows at most 999 bound values per statement)
+  const int chunkSize = 500;
+  QStringList instances = missingInstances.toList();
+  for (int start = 0; start < instances.size(); start += chunkSize)
+    {
+    QStringList chunk = instances.mid(start, chunkSize);
+    QStringList placeholders;
+    for (int i = 0; i < chunk.size(); ++i)
+      {
+      placeholders << "?";
+      }
+    QSqlQuery selectValues( d->TagCacheDatabase );
+    selectValues.prepare( QString("SELECT SOPInstanceUID, Tag, Value FROM TagCache WHERE SOPInstanceUID IN (%1)")
+                          .arg(placeholders.join(",")) );
+    for (int i = 0; i < chunk.size(); ++i)
+      {
+      selectValues.bindValue(i, chunk[i]);
+      }
+    d->loggedExec(selectValues);
+    while (selectValues.next())
+      {
+      QString key = d->tagCacheKey(selectValues.value(0).toString(), selectValues.value(1).toString());
+      QHash<QString, QList<int> >::const_iterator positions = missingPositions.find(key);
+      if (positions == missingPositions.end())
+        {
+        continue;
+        }
+      QString value = selectValues.value(2).toString();
+      if (value == QString(""))
+        {
+        value = ValueIsEmptyString;
+        }
+      foreach (int position, positions.value())
+        {
+        result[position] = value;
+        }
+      d->RecentlyUsedTags.insert(key, new QString(value));
+      }
     }
   return( result );
 }
@@ -1614,5 +2403,63 @@ bool ctkDICOMDatabase::cacheTag(const QString sopInstanceUID, const QString tag,
   insertTag.bindValue(":sopInstanceUID",sopInstanceUID);
   insertTag.bindValue(":tag",tag);
   insertTag.bindValue(":value",valueToInsert);
-  return d->loggedExec(insertTag);
+  bool success = d->loggedExec(insertTag);
+  if (success)
+    {
+    d->RecentlyUsedTags.insert(d->tagCacheKey(sopInstanceUID, tag), new QString(valueToInsert));
+    }
+  return success;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::cacheTags(const QStringList& sopInstanceUIDs, const QStringList& tags, const QStringList& values)
+{
+  Q_D(ctkDICOMDatabase);
+  if (sopInstanceUIDs.size() != tags.size() || tags.size() != values.size())
+    {
+    logger.error("cacheTags: the numbers of instances, tags and values do not match");
+    return false;
+    }
+  if ( !this->tagCacheExists() )
+    {
+    if ( !this->initializeTagCache() )
+      {
+      return false;
+      }
+    }
+
+  // the tag cache lives in its own database, so the transaction must not
+  // be opened on the main connection which may be in an insert batch
+  d->TagCacheDatabase.transaction();
+  QSqlQuery insertTag( d->TagCacheDatabase );
+  insertTag.prepare( "INSERT OR REPLACE INTO TagCache VALUES(?, ?, ?)" );
+  bool success = true;
+  for (int i = 0; i < sopInstanceUIDs.size(); ++i)
+    {
+    QString valueToInsert(values[i]);
+    if (valueToInsert == "")
+      {
+      valueToInsert = TagNotInInstance;
+      }
+    insertTag.bindValue(0, sopInstanceUIDs[i]);
+    insertTag.bindValue(1, tags[i]);
+    insertTag.bindValue(2, valueToInsert);
+    if (!d->loggedExec(insertTag))
+      {
+      success = false;
+      break;
+      }
+    d->RecentlyUsedTags.insert(d->tagCacheKey(sopInstanceUIDs[i], tags[i]), new QString(valueToInsert));
+    }
+  if (success)
+    {
+    d->TagCacheDatabase.commit();
+    }
+  else
+    {
+    d->TagCacheDatabase.rollback();
+    // the recently used values may not match the table anymore
+    d->RecentlyUsedTags.clear();
+    }
+  return success;
 }
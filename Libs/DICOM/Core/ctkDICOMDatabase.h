@@ -24,6 +24,8 @@
 // Qt includes
 #include <QObject>
 #include <QStringList>
+#include <QMap>
+#include <QDateTime>
 #include <QSqlDatabase>
 
 #include "ctkDICOMItem.h"
@@ -57,6 +59,8 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMDatabase : public QObject
   Q_PROPERTY(QString lastError READ lastError)
   Q_PROPERTY(QString databaseFilename READ databaseFilename)
   Q_PROPERTY(QStringList tagsToPrecache READ tagsToPrecache WRITE setTagsToPrecache)
+  Q_PROPERTY(bool asynchronousThumbnails READ asynchronousThumbnails WRITE setAsynchronousThumbnails)
+  Q_PROPERTY(int thumbnailSize READ thumbnailSize WRITE setThumbnailSize)
 
 public:
   explicit ctkDICOMDatabase(QObject *parent = 0);
@@ -92,6 +96,29 @@ public:
   /// get thumbnail genrator object
   ctkDICOMAbstractThumbnailGenerator* thumbnailGenerator();
 
+  ///
+  /// \brief generate thumbnails in background threads
+  ///
+  /// If enabled, insert() only queues the thumbnail of an instance and
+  /// returns before it is rendered; thumbnailReady() is emitted once the
+  /// thumbnail file has been written. An instance is queued at most once
+  /// at a time. Disabled by default.
+  /// \note The thumbnail generator must be usable from other threads.
+  void setAsynchronousThumbnails(bool asynchronous);
+  bool asynchronousThumbnails() const;
+
+  ///
+  /// \brief largest width or height of the generated thumbnails, in pixels
+  ///
+  /// Images are scaled down to this size before being handed to the
+  /// thumbnail generator. 128 by default.
+  void setThumbnailSize(int size);
+  int thumbnailSize() const;
+
+  ///
+  /// Block until all queued thumbnails have been generated.
+  Q_INVOKABLE void waitForThumbnails();
+
   ///
   /// open the SQLite database in @param databaseFile . If the file does not
   /// exist, a new database is created and initialized with the
@@ -118,6 +145,9 @@ public:
 
   /// updates the database schema only if the versions don't match
   /// Returns true if schema was updated
+  /// When an update script exists for the loaded version of the default
+  /// schema (e.g. new indexes), it is applied in place; otherwise all the
+  /// files are re-inserted as in updateSchema().
   Q_INVOKABLE bool updateSchemaIfNeeded(const char* schemaFile = ":/dicom/dicom-schema.sql");
 
   /// returns the schema version needed by the current version of this code
@@ -137,6 +167,14 @@ public:
   Q_INVOKABLE QString instanceForFile (const QString fileName);
   Q_INVOKABLE QDateTime insertDateTimeForInstance (const QString fileName);
 
+  ///
+  /// \brief counts read from the SeriesSummary and StudySummary tables
+  /// The summaries are kept up to date by the insert and remove methods,
+  /// so these don't need to count the Images rows.
+  Q_INVOKABLE int instanceCountForSeries (const QString seriesUID);
+  Q_INVOKABLE int seriesCountForStudy (const QString studyUID);
+  Q_INVOKABLE int instanceCountForStudy (const QString studyUID);
+
   Q_INVOKABLE QStringList allFiles ();
   ///
   /// \brief load the header from a file and allow access to elements
@@ -186,14 +224,50 @@ public:
                             bool createHierarchy = true,
                             const QString& destinationDirectoryName = QString() );
 
+  /// Insert a dataset that has already been read from \a filePath, e.g. by
+  /// one of the parser threads of ctkDICOMIndexer. This behaves like
+  /// insert(filePath, ...) but does not read the file a second time.
+  /// \warning Must be called from the thread that opened the database.
+  void insert ( const ctkDICOMItem& ctkDataset, const QString& filePath,
+                bool storeFile, bool generateThumbnail);
+
+  ///
+  /// \brief Group the following inserts into transactions.
+  ///
+  /// Until endInsertBatch() is called, inserted datasets are committed
+  /// every \a rowsPerTransaction datasets instead of one by one. Batches
+  /// can be nested, only the outermost one opens and commits transactions.
+  /// \sa insertBatch()
+  Q_INVOKABLE void beginInsertBatch(int rowsPerTransaction = 500);
+  /// Commit the pending inserts of the batch started by beginInsertBatch().
+  Q_INVOKABLE void endInsertBatch();
+  /// Returns true between beginInsertBatch() and endInsertBatch().
+  bool isInInsertBatch() const;
+
+  /// Insert a list of datasets within a single batch.
+  /// @param datasets The datasets to insert, null or uninitialized ones are skipped.
+  /// @param filePaths The files the datasets were read from, either empty or
+  ///                  of the same length as \a datasets.
+  void insertBatch(const QList<ctkDICOMItem*>& datasets, const QStringList& filePaths = QStringList(),
+                   bool storeFile = true, bool generateThumbnail = true);
+
   /// Check if file is already in database and up-to-date
   bool fileExistsAndUpToDate(const QString& filePath);
 
+  /// Returns the insert timestamp of each file in the database located
+  /// below \a directory, using a single query. If \a fileSizes is not null,
+  /// it receives the size the files had when they were inserted, when known.
+  QMap<QString, QDateTime> insertTimestampsForFiles(const QString& directory,
+                                                    QMap<QString, qint64>* fileSizes = 0);
+
   /// remove the series from the database, including images and
   /// thumbnails
   Q_INVOKABLE bool removeSeries(const QString& seriesInstanceUID);
   Q_INVOKABLE bool removeStudy(const QString& studyInstanceUID);
   Q_INVOKABLE bool removePatient(const QString& patientID);
+  /// remove the images of the given files from the database in a single
+  /// transaction. The files themselves are left untouched.
+  Q_INVOKABLE bool removeFiles(const QStringList& filePaths);
   bool cleanup();
 
   ///
@@ -222,6 +296,9 @@ public:
   /// @param key A group,element tag in zero-filled hex
   /// @Returns empty string if element for uid is missing from cache
   ///
+  /// Recently used values are additionally kept in memory, so repeated
+  /// lookups of the same instance tags do not query the database.
+  ///
   /// Lightweight check of tag cache existence (once db check per runtime)
   Q_INVOKABLE bool tagCacheExists ();
   /// Create a tagCache in the current database.  Delete the existing one if it exists.
@@ -230,6 +307,14 @@ public:
   Q_INVOKABLE QString cachedTag (const QString sopInstanceUID, const QString tag);
   /// Insert an instance tag's value into to the cache
   Q_INVOKABLE bool cacheTag (const QString sopInstanceUID, const QString tag, const QString value);
+  /// Return the cached values of many instance tags at once.
+  /// The i-th value belongs to sopInstanceUIDs[i] and tags[i], both lists
+  /// must have the same length. Values not in the cache are empty strings.
+  Q_INVOKABLE QStringList cachedTags (const QStringList& sopInstanceUIDs, const QStringList& tags);
+  /// Insert many instance tag values into the cache within one transaction.
+  /// The i-th value belongs to sopInstanceUIDs[i] and tags[i].
+  /// Returns false and leaves the cache unchanged if any insert failed.
+  Q_INVOKABLE bool cacheTags (const QStringList& sopInstanceUIDs, const QStringList& tags, const QStringList& values);
 
 
 Q_SIGNALS:
@@ -250,6 +335,9 @@ Q_SIGNALS:
   /// instanceAdded arguments:
   ///  - instanceUID (unique)
   void instanceAdded(QString);
+  /// thumbnailReady arguments:
+  ///  - instanceUID of the instance whose thumbnail file has been written
+  void thumbnailReady(QString);
   /// Indicates that an in-memory database has been updated
   void databaseChanged();
   /// Indicates that the schema is about to be updated and how many files will be processed
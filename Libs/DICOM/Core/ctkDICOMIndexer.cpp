@@ -24,19 +24,25 @@
 #include <QSqlError>
 #include <QVariant>
 #include <QDate>
+#include <QDateTime>
+#include <QMap>
 #include <QStringList>
 #include <QSet>
 #include <QFile>
+#include <QDir>
 #include <QDirIterator>
 #include <QFileInfo>
 #include <QDebug>
 #include <QPixmap>
+#include <QRunnable>
+#include <QThread>
 
 // ctkDICOM includes
 #include "ctkLogger.h"
 #include "ctkDICOMIndexer.h"
 #include "ctkDICOMIndexer_p.h"
 #include "ctkDICOMDatabase.h"
+#include "ctkDICOMItem.h"
 
 // DCMTK includes
 #include <dcmtk/dcmdata/dcfilefo.h>
@@ -56,17 +62,165 @@ static ctkLogger logger("org.commontk.dicom.DICOMIndexer" );
 //------------------------------------------------------------------------------
 
 
+//------------------------------------------------------------------------------
+class ctkDICOMIndexerParserTask : public QRunnable
+{
+public:
+  ctkDICOMIndexerParserTask(ctkDICOMIndexerPrivate* indexer, const QString& filePath)
+    : Indexer(indexer), FilePath(filePath)
+  {
+  }
+
+  virtual void run()
+  {
+    this->Indexer->parseFile(this->FilePath);
+  }
+
+private:
+  ctkDICOMIndexerPrivate* Indexer;
+  QString FilePath;
+};
+
 //------------------------------------------------------------------------------
 // ctkDICOMIndexerPrivate methods
 
 //------------------------------------------------------------------------------
-ctkDICOMIndexerPrivate::ctkDICOMIndexerPrivate(ctkDICOMIndexer& o) : q_ptr(&o), Canceled(false)
+ctkDICOMIndexerPrivate::ctkDICOMIndexerPrivate(ctkDICOMIndexer& o)
+  : q_ptr(&o)
+  , Canceled(false)
+  , MaxQueueSize(256)
+  , BatchSize(64)
+  , Importing(false)
 {
+  this->ParserPool.setMaxThreadCount(QThread::idealThreadCount());
 }
 
 //------------------------------------------------------------------------------
 ctkDICOMIndexerPrivate::~ctkDICOMIndexerPrivate()
 {
+  {
+  QMutexLocker lock(&this->QueueMutex);
+  this->Canceled = true;
+  this->QueueNotFull.wakeAll();
+  }
+  this->ParserPool.waitForDone();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerPrivate::parseFile(const QString& filePath)
+{
+  {
+  QMutexLocker lock(&this->QueueMutex);
+  if (this->Canceled)
+    {
+    return;
+    }
+  }
+
+  QSharedPointer<ctkDICOMItem> dataset(new ctkDICOMItem);
+  dataset->InitializeFromFileHeader(filePath);
+
+  QMutexLocker lock(&this->QueueMutex);
+  while (this->ParsedFiles.size() >= this->MaxQueueSize && !this->Canceled)
+    {
+    this->QueueNotFull.wait(&this->QueueMutex);
+    }
+  if (this->Canceled)
+    {
+    return;
+    }
+  this->ParsedFiles.enqueue(ParsedFile(filePath, dataset));
+  this->QueueNotEmpty.wakeOne();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMIndexerPrivate::takeParsedFiles(QList<ParsedFile>& parsedFiles, int maxCount)
+{
+  QMutexLocker lock(&this->QueueMutex);
+  while (this->ParsedFiles.isEmpty() && !this->Canceled)
+    {
+    this->QueueNotEmpty.wait(&this->QueueMutex);
+    }
+  if (this->Canceled)
+    {
+    return false;
+    }
+  while (!this->ParsedFiles.isEmpty() && parsedFiles.size() < maxCount)
+    {
+    parsedFiles << this->ParsedFiles.dequeue();
+    }
+  this->QueueNotFull.wakeAll();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerPrivate::indexFiles(ctkDICOMDatabase& database,
+                                        const QStringList& filesToIndex,
+                                        int fileCount, bool storeFile)
+{
+  Q_Q(ctkDICOMIndexer);
+
+  // reset before the import is visible, a cancel() issued once the import
+  // has started must not be lost
+  {
+  QMutexLocker lock(&this->QueueMutex);
+  this->Canceled = false;
+  this->ParsedFiles.clear();
+  }
+  this->setImporting(true);
+
+  // Headers are parsed in parallel by the parser threads while this
+  // thread acts as the single writer that inserts the results into the
+  // database. The database connection belongs to this thread, so it is
+  // never used from the parser threads.
+  foreach(const QString& filePath, filesToIndex)
+  {
+    this->ParserPool.start(new ctkDICOMIndexerParserTask(this, filePath));
+  }
+
+  int CurrentFileIndex = fileCount - filesToIndex.size();
+  database.beginInsertBatch();
+  while (CurrentFileIndex < fileCount)
+  {
+    QList<ParsedFile> parsedFiles;
+    if (!this->takeParsedFiles(parsedFiles, this->BatchSize))
+      {
+      break;
+      }
+    foreach(const ParsedFile& parsedFile, parsedFiles)
+    {
+      int percent = ( 100 * CurrentFileIndex ) / fileCount;
+      emit q->progress(percent);
+      emit q->indexingFilePath(parsedFile.first);
+      database.insert(*parsedFile.second, parsedFile.first, storeFile, true);
+      CurrentFileIndex++;
+    }
+  }
+  database.endInsertBatch();
+
+  {
+  QMutexLocker lock(&this->QueueMutex);
+  this->QueueNotFull.wakeAll();
+  }
+  this->ParserPool.waitForDone();
+  {
+  QMutexLocker lock(&this->QueueMutex);
+  this->ParsedFiles.clear();
+  }
+  this->setImporting(false);
+
+  emit q->indexingComplete();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerPrivate::setImporting(bool importing)
+{
+  QMutexLocker lock(&this->ImportMutex);
+  this->Importing = importing;
+  if (!importing)
+    {
+    this->ImportFinished.wakeAll();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -131,21 +285,25 @@ void ctkDICOMIndexer::addListOfFiles(ctkDICOMDatabase& ctkDICOMDatabase,
                                      const QString& destinationDirectoryName)
 {
   Q_D(ctkDICOMIndexer);
-  d->Canceled = false;
-  int CurrentFileIndex = 0;
-  foreach(QString filePath, listOfFiles)
+  if (!destinationDirectoryName.isEmpty())
   {
-    int percent = ( 100 * CurrentFileIndex ) / listOfFiles.size();
-    emit this->progress(percent);
-    this->addFile(ctkDICOMDatabase, filePath, destinationDirectoryName);
-    CurrentFileIndex++;
+    logger.warn("Ignoring destinationDirectoryName parameter, just taking it as indication we should copy!");
+  }
 
-    if( d->Canceled )
-      {
-      break;
-      }
+  // Skip the files that are already known, there is no need to parse them.
+  QStringList filesToIndex;
+  foreach(const QString& filePath, listOfFiles)
+  {
+    if (ctkDICOMDatabase.fileExistsAndUpToDate(filePath))
+    {
+      logger.debug( "File " + filePath + " already added.");
+      continue;
+    }
+    filesToIndex << filePath;
   }
-  emit this->indexingComplete();
+
+  d->indexFiles(ctkDICOMDatabase, filesToIndex, listOfFiles.size(),
+                !destinationDirectoryName.isEmpty());
 }
 
 //------------------------------------------------------------------------------
@@ -218,53 +376,102 @@ void ctkDICOMIndexer::addDicomdir(ctkDICOMDatabase& ctkDICOMDatabase,
 //------------------------------------------------------------------------------
 void ctkDICOMIndexer::refreshDatabase(ctkDICOMDatabase& dicomDatabase, const QString& directoryName)
 {
-  Q_UNUSED(dicomDatabase);
-  Q_UNUSED(directoryName);
-  /*
-   * Probably this should go to the database class as well
-   * Or we have to extend the interface to make possible what we do here
-   * without using SQL directly
-
-  /// get all filenames from the database
-  QSqlQuery allFilesQuery(dicomDatabase.database());
-  QStringList databaseFileNames;
-  QStringList filesToRemove;
-  this->loggedExec(allFilesQuery, "SELECT Filename from Images;");
+  Q_D(ctkDICOMIndexer);
+  if (directoryName.isEmpty() || !QDir(directoryName).exists())
+    {
+    logger.warn("Cannot refresh the database from missing directory " + directoryName);
+    return;
+    }
+
+  // The database and QDirIterator paths are compared as absolute clean
+  // paths, whatever the form of directoryName.
+  QString directoryPath = QDir::cleanPath(QFileInfo(directoryName).absoluteFilePath());
+
+  // what the database knows about the directory, fetched in a single query;
+  // rows inserted with the given form of the directory are looked up too
+  QMap<QString, qint64> storedSizes;
+  QMap<QString, QDateTime> storedTimestamps =
+    dicomDatabase.insertTimestampsForFiles(directoryPath, &storedSizes);
+  if (QDir::cleanPath(directoryName) != directoryPath)
+    {
+    storedTimestamps.unite(dicomDatabase.insertTimestampsForFiles(directoryName, &storedSizes));
+    }
+  // by normalized path: the stored file name and its insert time
+  QMap<QString, QPair<QString, QDateTime> > insertTimestamps;
+  QMap<QString, QDateTime>::const_iterator stored;
+  for (stored = storedTimestamps.constBegin(); stored != storedTimestamps.constEnd(); ++stored)
+    {
+    insertTimestamps.insert(QDir::cleanPath(QFileInfo(stored.key()).absoluteFilePath()),
+                            qMakePair(stored.key(), stored.value()));
+    }
 
-  while (allFilesQuery.next())
+  // scan the directory tree once and compare with the database
+  QStringList filesToIndex;
+  QStringList filesToRemove;
+  int fileCount = 0;
+  QDirIterator it(directoryPath, QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext())
     {
-    QString fileName = allFilesQuery.value(0).toString();
-    databaseFileNames.append(fileName);
-    if (! QFile::exists(fileName) )
+    QString filePath = QDir::cleanPath(it.next());
+    ++fileCount;
+    QMap<QString, QPair<QString, QDateTime> >::iterator known = insertTimestamps.find(filePath);
+    if (known == insertTimestamps.end())
+      {
+      filesToIndex << filePath;
+      continue;
+      }
+    // The insert timestamps are stored with a precision of one second:
+    // a file is changed if it was modified during a later second, or
+    // if its size differs when it was rewritten within the same second.
+    QDateTime lastModified = it.fileInfo().lastModified();
+    lastModified = lastModified.addMSecs(-lastModified.time().msec());
+    QDateTime insertTimestamp = known.value().second;
+    insertTimestamp = insertTimestamp.addMSecs(-insertTimestamp.time().msec());
+    QMap<QString, qint64>::const_iterator storedSize = storedSizes.constFind(known.value().first);
+    if (lastModified > insertTimestamp ||
+        (storedSize != storedSizes.constEnd() && storedSize.value() != it.fileInfo().size()))
       {
-      filesToRemove.append(fileName);
+      // changed since it was inserted, the old row has to go first
+      filesToIndex << filePath;
+      filesToRemove << known.value().first;
       }
+    insertTimestamps.erase(known);
     }
-
-  QSet<QString> filesytemFiles;
-  QDirIterator dirIt(directoryName);
-  while (dirIt.hasNext())
+  // the remaining files do not exist anymore
+  QMap<QString, QPair<QString, QDateTime> >::const_iterator missing;
+  for (missing = insertTimestamps.constBegin(); missing != insertTimestamps.constEnd(); ++missing)
     {
-    filesytemFiles.insert(dirIt.next());
+    filesToRemove << missing.value().first;
     }
 
-  // TODO: it looks like this function was never finished...
-  //
-  // I guess the next step is to remove all filesToRemove from the database
-  // and also to add filesystemFiles into the database tables
-  */
-  }
+  logger.debug(QString("Refreshing %1: %2 files to index, %3 to remove")
+               .arg(directoryName).arg(filesToIndex.size()).arg(filesToRemove.size()));
+
+  if (!filesToRemove.isEmpty())
+    {
+    dicomDatabase.removeFiles(filesToRemove);
+    }
+  emit foundFilesToIndex(filesToIndex.size());
+  d->indexFiles(dicomDatabase, filesToIndex, fileCount, false);
+}
 
 //------------------------------------------------------------------------------
 void ctkDICOMIndexer::waitForImportFinished()
 {
-  // No-op - this had been used when the indexing was multi-threaded,
-  // and has only been retained for API compatibility.
+  Q_D(ctkDICOMIndexer);
+  QMutexLocker lock(&d->ImportMutex);
+  while (d->Importing)
+    {
+    d->ImportFinished.wait(&d->ImportMutex);
+    }
 }
 
 //----------------------------------------------------------------------------
 void ctkDICOMIndexer::cancel()
 {
   Q_D(ctkDICOMIndexer);
+  QMutexLocker lock(&d->QueueMutex);
   d->Canceled = true;
+  d->QueueNotEmpty.wakeAll();
+  d->QueueNotFull.wakeAll();
 }
@@ -66,6 +66,8 @@ public:
   ///
   /// Scan the directory using Dcmtk and populate the database with all the
   /// DICOM images accordingly.
+  /// The headers are read in parallel by a pool of parser threads, the
+  /// calling thread inserts the parsed datasets into the database.
   ///
   Q_INVOKABLE void addListOfFiles(ctkDICOMDatabase& database, const QStringList& listOfFiles,
                     const QString& destinationDirectoryName = "");
@@ -80,13 +82,21 @@ public:
   Q_INVOKABLE void addFile(ctkDICOMDatabase& database, const QString filePath,
                     const QString& destinationDirectoryName = "");
 
+  ///
+  /// \brief Brings the database up to date with the files below directoryName.
+  ///
+  /// The directory tree is scanned once and compared with the files the
+  /// database knows in that directory. Only new files and files modified
+  /// since they were inserted are indexed again; the files that do not
+  /// exist anymore are removed from the database in one transaction.
+  ///
   Q_INVOKABLE void refreshDatabase(ctkDICOMDatabase& database, const QString& directoryName);
 
   ///
-  /// \brief Deprecated - no op.
-  /// \deprecated
-  /// Previously ensured that the QFuture threads have all finished indexing
-  /// before returning control.
+  /// \brief Block until the running import has finished.
+  ///
+  /// Returns immediately if no import is running. This is useful when
+  /// addListOfFiles() has been invoked from a different thread.
   ///
   Q_INVOKABLE void waitForImportFinished();
 
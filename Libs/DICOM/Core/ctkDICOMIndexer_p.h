@@ -21,10 +21,18 @@
 #ifndef CTKDICOMINDEXERPRIVATE_H
 #define CTKDICOMINDEXERPRIVATE_H
 
+#include <QMutex>
 #include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QWaitCondition>
 
 #include "ctkDICOMIndexer.h"
 
+class ctkDICOMItem;
+
 //------------------------------------------------------------------------------
 class ctkDICOMIndexerPrivate : public QObject
 {
@@ -39,9 +47,48 @@ public:
   ctkDICOMIndexerPrivate(ctkDICOMIndexer&);
   ~ctkDICOMIndexerPrivate();
 
+  /// A file path together with the dataset parsed from it. The dataset
+  /// is not initialized if the file could not be read.
+  typedef QPair<QString, QSharedPointer<ctkDICOMItem> > ParsedFile;
+
+  /// Called from the parser threads: read the header of \a filePath and
+  /// queue the result for the writer. Blocks while the queue is full.
+  void parseFile(const QString& filePath);
+
+  /// Called from the writer: wait for parsed files and move at most
+  /// \a maxCount of them into \a parsedFiles.
+  /// Returns false if indexing was canceled.
+  bool takeParsedFiles(QList<ParsedFile>& parsedFiles, int maxCount);
+
+  /// Parse \a filesToIndex with the parser threads and insert them into
+  /// \a database from the calling thread. \a fileCount is the total number
+  /// of files the progress is reported for, it includes the skipped ones.
+  void indexFiles(ctkDICOMDatabase& database, const QStringList& filesToIndex,
+                  int fileCount, bool storeFile);
+
+  void setImporting(bool importing);
+
 public:
   ctkDICOMAbstractThumbnailGenerator* thumbnailGenerator;
   bool                    Canceled;
+
+  /// Parser threads reading DICOM headers
+  QThreadPool             ParserPool;
+
+  /// Parsed files waiting to be written to the database. The queue is
+  /// bounded by MaxQueueSize to keep the memory use of large imports low.
+  QQueue<ParsedFile>      ParsedFiles;
+  int                     MaxQueueSize;
+  QMutex                  QueueMutex;
+  QWaitCondition          QueueNotEmpty;
+  QWaitCondition          QueueNotFull;
+
+  /// Number of parsed files handed to the database in one go
+  int                     BatchSize;
+
+  bool                    Importing;
+  QMutex                  ImportMutex;
+  QWaitCondition          ImportFinished;
 };
 
 
@@ -28,11 +28,95 @@
 #include <stdexcept>
 
 
+/// Maps the "specific character set" values to the Qt codecs. The codecs
+/// are resolved once per character set for the whole application and
+/// QTextCodec::toUnicode() keeps no state between calls, so items can
+/// decode their strings from any thread.
+class ctkDICOMCharacterSetRegistry
+{
+  public:
+
+    ctkDICOMCharacterSetRegistry();
+
+    /// Returns NULL for unknown character sets, which are decoded as Latin1.
+    QTextCodec* codecForCharacterSet(const QString& characterSet);
+
+  private:
+
+    QHash<QString, QString> m_QtEncodingNamesForDICOMEncodingNames; // read-only after construction
+
+    QMutex m_Mutex;
+    QHash<QString, QTextCodec*> m_Codecs;
+};
+
+ctkDICOMCharacterSetRegistry::ctkDICOMCharacterSetRegistry()
+{
+  // Map of encoding names that might be named in DICOM files.
+  // For each encoding we store the name that Qt uses for the same encoding.
+  // This is because there is not yet a standard naming scheme but lots of aliases
+  // out in the real world: e.g. http://www.openi18n.org/subgroups/sa/locnameguide/final/CodesetAliasTable.html
+
+                                                //    DICOM        Qt
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 6", "UTF-8"); // actually ASCII, but ok
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 100", "ISO-8859-1");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 101", "ISO-8859-2");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 109", "ISO-8859-3");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 110", "ISO-8859-4");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 144", "ISO-8859-5");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 127", "ISO-8859-6");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 126", "ISO-8859-7");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 138", "ISO-8859-8");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 148", "ISO-8859-9");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 179", "ISO-8859-13");
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 192", "UTF-8");
+  // japanese
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 13", "ISO 2022-JP"); // Single byte charset, JIS X 0201: Katakana, Romaji
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 87", "ISO 2022-JP"); // Multi byte charset, JIS X 0208: Kanji, Kanji set
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 159", "ISO 2022-JP");
+  // korean
+  m_QtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 149", "EUC-KR"); // Multi byte charset, KS X 1001: Hangul, Hanja
+
+  // use all names that Qt knows by itself
+  foreach( QByteArray c, QTextCodec::availableCodecs() )
+  {
+    m_QtEncodingNamesForDICOMEncodingNames.insert( c.constData(), c.constData() );
+  }
+}
+
+QTextCodec* ctkDICOMCharacterSetRegistry::codecForCharacterSet(const QString& characterSet)
+{
+  if ( !m_QtEncodingNamesForDICOMEncodingNames.contains(characterSet) )
+  {
+    std::cerr << "DICOM dataset contains some encoding that we never thought we would see(" << characterSet.toStdString() << "). Using default encoding." << std::endl;
+    return NULL;
+  }
+
+  QString encodingName( m_QtEncodingNamesForDICOMEncodingNames[characterSet] );
+  QMutexLocker locker(&m_Mutex);
+  QHash<QString, QTextCodec*>::const_iterator it = m_Codecs.constFind( encodingName );
+  if ( it != m_Codecs.constEnd() )
+  {
+    return it.value();
+  }
+
+  QTextCodec* codec = QTextCodec::codecForName( encodingName.toAscii() );
+  if (!codec)
+  {
+    std::cerr << "Could not create QTextCodec object for '" << encodingName.toStdString() << "'. Using default encoding instead." << std::endl;
+  }
+  m_Codecs.insert( encodingName, codec );
+  return codec;
+}
+
+Q_GLOBAL_STATIC(ctkDICOMCharacterSetRegistry, ctkDICOMCharacterSets)
+
+
 class ctkDICOMItemPrivate
 {
   public:
 
-    ctkDICOMItemPrivate() : m_DcmItem(0), m_TakeOwnership(true) {}
+    ctkDICOMItemPrivate() : m_DcmItem(0), m_TakeOwnership(true), m_Codec(0),
+      m_DeserializationMutex(QMutex::Recursive), m_Deserializing(false) {}
 
     QString m_SpecificCharacterSet;
 
@@ -41,6 +125,15 @@ class ctkDICOMItemPrivate
 
     DcmItem* m_DcmItem;
     bool m_TakeOwnership;
+
+    /// Codec of m_SpecificCharacterSet, NULL to decode as Latin1
+    QTextCodec* m_Codec;
+
+    /// Binary serialization given to DeserializeFromByteArray(), parsed on first access
+    QByteArray m_SerializedData;
+    mutable QAtomicInt m_DeserializationPending;
+    mutable QMutex m_DeserializationMutex;
+    bool m_Deserializing;
 };
 
 
@@ -68,6 +161,13 @@ void ctkDICOMItem::InitializeFromItem(DcmItem *dataset, bool takeOwnership)
 {
   Q_D(ctkDICOMItem);
 
+  if (!d->m_Deserializing)
+  {
+    // replaces a serialization that has not been parsed yet
+    d->m_DeserializationPending.fetchAndStoreOrdered(0);
+    d->m_SerializedData.clear();
+  }
+
   if(d->m_DcmItem != dataset)
   {
     if (d->m_TakeOwnership)
@@ -88,6 +188,7 @@ void ctkDICOMItem::InitializeFromItem(DcmItem *dataset, bool takeOwnership)
       if ( CheckCondition( dataset->findAndGetOFString(DCM_SpecificCharacterSet, encoding) ) )
       {
         d->m_SpecificCharacterSet = encoding.c_str();
+        d->m_Codec = ctkDICOMCharacterSets()->codecForCharacterSet(d->m_SpecificCharacterSet);
       }
       }
       if (d->m_SpecificCharacterSet.isEmpty())
@@ -128,42 +229,76 @@ void ctkDICOMItem::InitializeFromFile(const QString& filename,
   InitializeFromItem(dataset, true);
 }
 
-void ctkDICOMItem::Serialize()
+void ctkDICOMItem::InitializeFromFileHeader(const QString& filename, const DcmTagKey& stopTag)
 {
-  Q_D(ctkDICOMItem);
-  EnsureDcmDataSetIsInitialized();
+  DcmDataset *dataset;
 
-  // store content of current DcmDataset (our parent) as QByteArray into m_ctkDICOMItem
-  Uint32 buffersize = 1024*1024; // reserve 1MB
-  char* writebuffer = new char[buffersize];
+  DcmFileFormat fileformat;
+#if PACKAGE_VERSION_NUMBER >= 362
+  OFCondition status = fileformat.loadFileUntilTag(filename.toAscii().data(),
+    EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_autoDetect, stopTag);
+#else
+  // Values longer than maxReadLength are skipped instead of being read,
+  // which keeps the pixel data out of memory.
+  Q_UNUSED(stopTag);
+  const Uint32 maxReadLength = 4096;
+  OFCondition status = fileformat.loadFile(filename.toAscii().data(),
+    EXS_Unknown, EGL_noChange, maxReadLength, ERM_autoDetect);
+#endif
+  dataset = fileformat.getAndRemoveDataset();
 
-  // write into buffer
-  DcmOutputBufferStream dcmbuffer(writebuffer, buffersize);
-  d->m_DcmItem->transferInit();
-  OFCondition condition = d->m_DcmItem->write(dcmbuffer, EXS_LittleEndianImplicit, EET_UndefinedLength, NULL );
-  d->m_DcmItem->transferEnd();
-  if ( condition.bad() )
+  if (!status.good())
   {
-    std::cerr << "Could not DcmDataset::write(..): " << condition.text() << std::endl;
+    qDebug() << "Could not load " << filename << "\nDCMTK says: " << status.text();
+    delete dataset;
+    return;
   }
 
-  // get written contents of buffer
-  offile_off_t datasetsize = 0;
-  void* readbuffer = NULL;
-  dcmbuffer.flushBuffer(readbuffer, datasetsize);
+  InitializeFromItem(dataset, true);
+}
 
-  //std::cerr << "** " << (void*)this << " ctkDICOMItem: Serializing Dataset into " << datasetsize << " bytes" << std::endl;
+void ctkDICOMItem::Serialize()
+{
+  // base64 prevents errors from encoding conversions of string database fields
+  this->SetStoredSerialization( QString::fromAscii( this->SerializeToByteArray().toBase64() ) );
+}
 
-  // construct Qt type from that contents
-  QByteArray qtArray = QByteArray::fromRawData( static_cast<const char*>(readbuffer), datasetsize );
-  //std::cerr << "** Buffer size: " << qtArray.size() << std::endl;
-  QString stringbuffer = QString::fromAscii(qtArray.toBase64());
+QByteArray ctkDICOMItem::SerializeToByteArray() const
+{
+  Q_D(const ctkDICOMItem);
+  {
+    QMutexLocker locker(&d->m_DeserializationMutex);
+    if ( d->m_DeserializationPending.fetchAndAddOrdered(0) )
+    {
+      // not parsed, hence not modified since DeserializeFromByteArray()
+      return d->m_SerializedData;
+    }
+  }
+  EnsureDcmDataSetIsInitialized();
 
-  //std::cerr << "** String of size " << stringbuffer.size() << " looks like this:\n" << stringbuffer.toStdString() << std::endl << std::endl;
+  // The dataset is written in chunks into a growing array, DCMTK asks to
+  // flush the buffer stream each time it is full.
+  QByteArray serializedData;
+  char writebuffer[64 * 1024];
+  DcmOutputBufferStream dcmbuffer(writebuffer, sizeof(writebuffer));
+  d->m_DcmItem->transferInit();
+  OFCondition condition = EC_StreamNotifyClient;
+  while ( condition == EC_StreamNotifyClient )
+  {
+    condition = d->m_DcmItem->write(dcmbuffer, EXS_LittleEndianImplicit, EET_UndefinedLength, NULL );
 
-  this->SetStoredSerialization( stringbuffer );
+    void* readbuffer = NULL;
+    offile_off_t length = 0;
+    dcmbuffer.flushBuffer(readbuffer, length);
+    serializedData.append( static_cast<const char*>(readbuffer), static_cast<int>(length) );
+  }
+  d->m_DcmItem->transferEnd();
+  if ( condition.bad() )
+  {
+    std::cerr << "Could not DcmDataset::write(..): " << condition.text() << std::endl;
+  }
 
-  delete[] writebuffer;
+  return serializedData;
 }
 
 void ctkDICOMItem::MarkForInitialization()
@@ -174,15 +309,38 @@ void ctkDICOMItem::MarkForInitialization()
 bool ctkDICOMItem::IsInitialized() const
 {
   Q_D(const ctkDICOMItem);
-  return d->m_DICOMDataSetInitialized;
+  return d->m_DICOMDataSetInitialized || d->m_DeserializationPending.fetchAndAddOrdered(0);
 }
 void ctkDICOMItem::EnsureDcmDataSetIsInitialized() const
 {
+  this->EnsureSerializationIsRead();
   if ( ! this->IsInitialized() )
   {
       throw std::logic_error("Calling methods on uninitialized ctkDICOMItem");
   }
-  // const_cast<ctkDICOMItem*>(this)->Deserialize();
+}
+
+void ctkDICOMItem::EnsureSerializationIsRead() const
+{
+  Q_D(const ctkDICOMItem);
+  if ( !d->m_DeserializationPending.fetchAndAddOrdered(0) )
+  {
+    return;
+  }
+
+  // Other threads wait until the dataset is read. The mutex is recursive
+  // because InitializeFromItem() calls methods that end up here again.
+  QMutexLocker locker(&d->m_DeserializationMutex);
+  if ( d->m_DeserializationPending.fetchAndAddOrdered(0) && !d->m_Deserializing )
+  {
+    ctkDICOMItemPrivate* mutableD = const_cast<ctkDICOMItemPrivate*>(d);
+    QByteArray serializedData = mutableD->m_SerializedData;
+    mutableD->m_Deserializing = true;
+    const_cast<ctkDICOMItem*>(this)->ReadSerializedData(serializedData);
+    mutableD->m_SerializedData.clear();
+    mutableD->m_Deserializing = false;
+    d->m_DeserializationPending.fetchAndStoreOrdered(0);
+  }
 }
 
 void ctkDICOMItem::Deserialize()
@@ -192,8 +350,7 @@ void ctkDICOMItem::Deserialize()
   // construct a DcmDataset from it
   // calls InitializeData(DcmDataset*)
 
-  // this method can be called both from sub-classes when they get the InitializeData signal from the persistence framework
-  // and from EnsureDcmDataSetIsInitialized() when a GetElement.. or SetElement.. method is called.
+  // this method can be called from sub-classes when they get the InitializeData signal from the persistence framework.
 
   if (d->m_DICOMDataSetInitialized) return; // only need to do this once
 
@@ -204,24 +361,35 @@ void ctkDICOMItem::Deserialize()
     return; // TODO nicer: hold three states: newly created / loaded but not initialized / restored from DB
   }
 
+  this->DeserializeFromByteArray( QByteArray::fromBase64( stringbuffer.toAscii() ) );
+}
 
-  //std::cerr << "** " << (void*)this << " ctkDICOMItem: Deserialize Dataset from string of size " << stringbuffer.size() << "\n" << stringbuffer.toStdString() << std::endl;
+void ctkDICOMItem::DeserializeFromByteArray(const QByteArray& serializedData)
+{
+  Q_D(ctkDICOMItem);
+  QMutexLocker locker(&d->m_DeserializationMutex);
+  d->m_SerializedData = serializedData;
+  d->m_DeserializationPending.fetchAndStoreOrdered(1);
+}
 
-  QByteArray qtArray = QByteArray::fromBase64( stringbuffer.toAscii() );
-  //std::cerr << "** " << (void*)this << " ctkDICOMItem: Deserialize Dataset from byte array of size " << qtArray.size() << std::endl;
+void ctkDICOMItem::ReadSerializedData(const QByteArray& serializedData)
+{
+  Q_D(ctkDICOMItem);
 
   DcmInputBufferStream dcmbuffer;
-  dcmbuffer.setBuffer( qtArray.data(), qtArray.size() );
-  //std::cerr << "** Buffer state: " << dcmbuffer.status().code() << " " <<  dcmbuffer.good() << " " << dcmbuffer.eos() << " tell " << dcmbuffer.tell() << " avail " << dcmbuffer.avail() << std::endl;
+  dcmbuffer.setBuffer( serializedData.constData(), serializedData.size() );
+  dcmbuffer.setEos();
 
-  DcmDataset dataset;
-  dataset.transferInit();
-  //std::cerr << "** Dataset state: " << dataset.transferState() << std::endl << std::endl;
-  OFCondition condition = dataset.read( dcmbuffer, EXS_LittleEndianImplicit );
-  dataset.transferEnd();
+  DcmDataset* dataset = new DcmDataset();
+  dataset->transferInit();
+  OFCondition condition = dataset->read( dcmbuffer, EXS_LittleEndianImplicit );
+  dataset->transferEnd();
 
   // do this in all cases, even when reading reported an error
-  this->InitializeFromItem(&dataset);
+  d->m_DICOMDataSetInitialized = false;
+  d->m_SpecificCharacterSet.clear();
+  d->m_Codec = 0;
+  this->InitializeFromItem(dataset, true);
 
   if ( condition.bad() )
   {
@@ -233,16 +401,16 @@ void ctkDICOMItem::Deserialize()
               << " tell " << dcmbuffer.tell()
               << " avail " << dcmbuffer.avail() << std::endl;
     std::cerr << "** Dataset state: "
-              << static_cast<int>(dataset.transferState()) << std::endl;
+              << static_cast<int>(dataset->transferState()) << std::endl;
     std::cerr << "Could not DcmDataset::read(..): "
               << condition.text() << std::endl;
-    //throw std::invalid_argument( std::string("Could not DcmDataset::read(..): ") + condition.text() );
   }
 }
 
 DcmItem& ctkDICOMItem::GetDcmItem() const
 {
   const Q_D(ctkDICOMItem);
+  this->EnsureSerializationIsRead();
   return *d->m_DcmItem;
 }
 
@@ -273,6 +441,7 @@ bool ctkDICOMItem::CheckCondition(const OFCondition& condition)
 bool ctkDICOMItem::CopyElement( DcmDataset* dataset, const DcmTagKey& tag, int type )
 {
   Q_D(ctkDICOMItem);
+  this->EnsureSerializationIsRead();
   switch (type)
   {
     case 0x1:
@@ -336,87 +505,20 @@ bool ctkDICOMItem::CopyElement( DcmDataset* dataset, const DcmTagKey& tag, int t
 QString ctkDICOMItem::Decode( const DcmTag& tag, const OFString& raw ) const
 {
   Q_D(const ctkDICOMItem);
-  // decode for types LO, LT, PN, SH, ST, UT
-  QString vr = TagVR(tag);
-  if ( !d->m_SpecificCharacterSet.isEmpty()
-    && (vr == "LO" ||
-        vr == "LT" ||
-        vr == "PN" ||
-        vr == "SH" ||
-        vr == "ST" ||
-        vr == "UT" ) )
-  {
-    //std::cout << "Decode from encoding " << d->m_SpecificCharacterSet.toStdString() << std::endl;
-    static QMap<QString, QTextDecoder*> decoders;
-    static QMap<QString, QString> qtEncodingNamesForDICOMEncodingNames;
-
-    if (qtEncodingNamesForDICOMEncodingNames.isEmpty())
-    {
-      // runs only once and fills up a map of encoding names that might be named in DICOM files.
-      // for each encoding we store the name that Qt uses for the same encoding.
-      // This is because there is not yet a standard naming scheme but lots of aliases
-      // out in the real world: e.g. http://www.openi18n.org/subgroups/sa/locnameguide/final/CodesetAliasTable.html
-
-                                              //    DICOM        Qt
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 6", "UTF-8"); // actually ASCII, but ok
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 100", "ISO-8859-1");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 101", "ISO-8859-2");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 109", "ISO-8859-3");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 110", "ISO-8859-4");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 144", "ISO-8859-5");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 127", "ISO-8859-6");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 126", "ISO-8859-7");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 138", "ISO-8859-8");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 148", "ISO-8859-9");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 179", "ISO-8859-13");
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO_IR 192", "UTF-8");
-      // japanese
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 13", "ISO 2022-JP"); // Single byte charset, JIS X 0201: Katakana, Romaji
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 87", "ISO 2022-JP"); // Multi byte charset, JIS X 0208: Kanji, Kanji set
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 159", "ISO 2022-JP");
-      // korean
-      qtEncodingNamesForDICOMEncodingNames.insert("ISO 2022 IR 149", "EUC-KR"); // Multi byte charset, KS X 1001: Hangul, Hanja
-
-      // use all names that Qt knows by itself
-      foreach( QByteArray c, QTextCodec::availableCodecs() )
-      {
-        qtEncodingNamesForDICOMEncodingNames.insert( c.constData(), c.constData() );
-      }
-
-    }
-
-    if ( qtEncodingNamesForDICOMEncodingNames.contains(d->m_SpecificCharacterSet) )
-    {
-      QString encodingName( qtEncodingNamesForDICOMEncodingNames[d->m_SpecificCharacterSet] );
-      if ( !decoders.contains( encodingName ) )
-      {
-        QTextCodec* codec = QTextCodec::codecForName( encodingName.toAscii() );
-        if (!codec)
-        {
-          std::cerr << "Could not create QTextCodec object for '" << encodingName.toStdString() << "'. Using default encoding instead." << std::endl;
-          decoders.insert( encodingName, QTextCodec::codecForCStrings()->makeDecoder() ); // uses Latin1
-        }
-        else
-        {
-          // initialize a QTextDecoder for given encoding
-          decoders.insert( encodingName, codec->makeDecoder() );
-          // We are responsible for deleting the QTextDecoder objects
-          // created by makeDecoder(). BUT as these objects are stored
-          // in a static map that lives until application end AND
-          // nothing application relevant happens during their
-          // destruction, we just let them be destructed by C++ on
-          // application exit.
-          // Any potential leaks that are found by this behavior can
-          // be suppressed.
-        }
-      }
-
-      //std::cout << "Decode '" <<  raw.c_str() << "' to '" << decoders[encodingName]->toUnicode( raw.c_str() ).toLocal8Bit().constData() << "'" << std::endl;
-      return decoders[encodingName]->toUnicode( raw.c_str() );
-    }
-    else
+  if ( d->m_Codec )
+  {
+    // decode for types LO, LT, PN, SH, ST, UT
+    switch ( tag.getEVR() )
     {
-      std::cerr << "DICOM dataset contains some encoding that we never thought we would see(" << d->m_SpecificCharacterSet.toStdString() << "). Using default encoding." << std::endl;
+      case EVR_LO:
+      case EVR_LT:
+      case EVR_PN:
+      case EVR_SH:
+      case EVR_ST:
+      case EVR_UT:
+        return d->m_Codec->toUnicode( raw.c_str() );
+      default:
+        break;
     }
   }
 
@@ -984,6 +1086,7 @@ void ctkDICOMItem::SetStoredSerialization(QString serializedDataset)
 bool ctkDICOMItem::SaveToFile(const QString& filePath) const
 {
   Q_D(const ctkDICOMItem);
+  this->EnsureSerializationIsRead();
 
   if (! dynamic_cast<DcmDataset*>(d->m_DcmItem) )
   {
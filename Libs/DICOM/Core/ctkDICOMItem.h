@@ -59,6 +59,9 @@ class ctkDICOMItemPrivate;
 ///  A subclass could possibly want to store the internal DcmDataset.
 ///  For this purpose, the internal DcmDataset is serialized into a memory buffer using DcmDataset::write(..). This buffer
 ///  is stored in a base64 encoded string. For deserialization we decode the string and use DcmDataset::read(..).
+///
+///  To pass items between threads or processes, SerializeToByteArray() gives the same buffer without base64 encoding
+///  and DeserializeFromByteArray() restores it. The dataset is only read when it is first accessed.
 class ctkDICOMItem;
 
 typedef ctkDICOMItem ctkDICOMItem;
@@ -93,6 +96,18 @@ public:
                     const Uint32 maxReadLength = DCM_MaxReadLength,
                     const E_FileReadMode readMode = ERM_autoDetect);
 
+    ///
+    /// \brief For initialization from the header of a file only.
+    ///
+    /// Parsing stops before the first element with a tag greater or equal
+    /// to \a stopTag, (7FE0,0010) Pixel Data by default, so the bulk data of
+    /// large (e.g. multi-frame) objects is neither read nor kept in memory.
+    /// This is meant for indexing, where only a few header attributes are needed.
+    /// \note With DCMTK versions that cannot stop parsing at a tag, the file
+    /// is parsed completely but long element values are not loaded.
+    virtual void InitializeFromFileHeader(const QString& filename,
+                    const DcmTagKey& stopTag = DcmTagKey(0x7fe0, 0x0010));
+
 
 
     /// \brief Save dataset to file
@@ -114,6 +129,20 @@ public:
     /// the internal DcmDataset is created using DcmDataset::read(..).
     void Deserialize();
 
+    /// \brief Binary serialization of the internal DcmDataset.
+    ///
+    /// The dataset is written with DcmDataset::write(..) in implicit little endian into
+    /// an array that grows as needed. The array is implicitly shared, so it can be passed
+    /// around without copying. If the item was restored by DeserializeFromByteArray() and
+    /// has not been accessed since, the given array is returned as is.
+    QByteArray SerializeToByteArray() const;
+
+    /// \brief Restore the object from the binary serialization of SerializeToByteArray().
+    ///
+    /// The internal DcmDataset is only created, using DcmDataset::read(..), when
+    /// the item is first accessed. That access can happen from any thread.
+    void DeserializeFromByteArray(const QByteArray& serializedData);
+
 
     /// \brief To be called from InitializeData, flags status as dirty.
     ///
@@ -148,6 +177,7 @@ public:
     /// Short Text (ST), Unlimited Text (UT) should be interpreted as encoded with a special set.
     ///
     /// See implementation for details.
+    /// The codec is looked up once when the item is initialized, so items can be decoded concurrently from several threads.
     QString Decode(const DcmTag& tag, const OFString& raw) const;
 
     /// \brief creates an OFString from the QtString
@@ -258,6 +288,12 @@ protected:
 
 private:
   Q_DECLARE_PRIVATE(ctkDICOMItem);
+
+  /// Read the dataset given to DeserializeFromByteArray() if this was not done yet.
+  void EnsureSerializationIsRead() const;
+
+  /// Create the internal DcmDataset from a binary serialization.
+  void ReadSerializedData(const QByteArray& serializedData);
 };
 
 #endif
@@ -28,54 +28,21 @@
 
 #include <QTime>
 #include <QDebug>
+#include <QUuid>
 
 // dcmtk includes
 #include "dcvrpn.h"
 
 // ctkDICOMCore includes
 #include "ctkDICOMModel.h"
+#include "ctkDICOMModel_p.h"
 #include "ctkLogger.h"
 
 static ctkLogger logger ( "org.commontk.dicom.DICOMModel" );
-struct Node;
 
 Q_DECLARE_METATYPE(Qt::CheckState);
 Q_DECLARE_METATYPE(QStringList);
 
-//------------------------------------------------------------------------------
-class ctkDICOMModelPrivate
-{
-  Q_DECLARE_PUBLIC(ctkDICOMModel);
-protected:
-  ctkDICOMModel* const q_ptr;
-
-public:
-  ctkDICOMModelPrivate(ctkDICOMModel&);
-  virtual ~ctkDICOMModelPrivate();
-  void init();
-
-  void fetch(const QModelIndex& indexValue, int limit);
-  Node* createNode(int row, const QModelIndex& parentValue)const;
-  Node* nodeFromIndex(const QModelIndex& indexValue)const;
-  //QModelIndexList indexListFromNode(const Node* node)const;
-  //QModelIndexList modelIndexList(Node* node = 0)const;
-  //int childrenCount(Node* node = 0)const;
-  // move it in the Node struct
-  QVariant value(Node* parentValue, int row, int field)const;
-  QVariant value(const QModelIndex& indexValue, int row, int field)const;
-  QString  generateQuery(const QString& fields, const QString& table, const QString& conditions = QString())const;
-  void updateQueries(Node* node)const;
-
-  Node*        RootNode;
-  QSqlDatabase DataBase;
-  QList<QMap<int, QVariant> > Headers;
-  QString      Sort;
-  QMap<QString, QVariant> SearchParameters;
-
-  ctkDICOMModel::IndexType StartLevel;
-  ctkDICOMModel::IndexType EndLevel;
-};
-
 //------------------------------------------------------------------------------
 // 1 node per row
 // TBD: should probably use the QStandardItems instead.
@@ -94,6 +61,16 @@ struct Node
   QVector<Node*>                  Children;
   int                             Row;
   QSqlQuery                       Query;
+  /// asynchronous fetching only: the parts of the query, completed by
+  /// keysetQuery(), the names of the columns and the rows fetched so far
+  QString                         QueryFields;
+  QString                         QueryTable;
+  QString                         QueryCondition;
+  /// rowid of the queried table, fetched as the last column to break the
+  /// ties of the sort column
+  QString                         QueryKey;
+  QStringList                     FieldNames;
+  QList<QVariantList>             Rows;
   QString                         UID;
   int                             RowCount;
   bool                            AtEnd;
@@ -105,6 +82,13 @@ struct Node
 ctkDICOMModelPrivate::ctkDICOMModelPrivate(ctkDICOMModel& o):q_ptr(&o)
 {
   this->RootNode     = 0;
+  this->HasSummaryTables = false;
+  this->SortOrder = Qt::AscendingOrder;
+  this->AsynchronousFetch = false;
+  this->FetchInThread = false;
+  this->FetchChunkSize = 256;
+  this->Fetcher = 0;
+  this->LastRequestId = 0;
   this->StartLevel = ctkDICOMModel::RootType;
   this->EndLevel = ctkDICOMModel::ImageType;
 }
@@ -112,6 +96,7 @@ ctkDICOMModelPrivate::ctkDICOMModelPrivate(ctkDICOMModel& o):q_ptr(&o)
 //------------------------------------------------------------------------------
 ctkDICOMModelPrivate::~ctkDICOMModelPrivate()
 {
+  this->stopFetcher();
   delete this->RootNode;
   this->RootNode = 0;
 }
@@ -119,6 +104,8 @@ ctkDICOMModelPrivate::~ctkDICOMModelPrivate()
 //------------------------------------------------------------------------------
 void ctkDICOMModelPrivate::init()
 {
+  qRegisterMetaType<ctkDICOMModelRows>("ctkDICOMModelRows");
+
   QMap<int, QVariant> data;
   data[Qt::DisplayRole] = QString("Name");
   this->Headers << data;
@@ -276,6 +263,12 @@ QVariant ctkDICOMModelPrivate::value(Node* parentNode, int row, int column) cons
     return QVariant();
     }
 
+  if (this->FetchInThread)
+    {
+    const QVariantList& rowValues = parentNode->Rows[row];
+    return column < rowValues.size() ? rowValues[column] : QVariant();
+    }
+
   if (!parentNode->Query.seek(row))
     {
     qDebug() << parentNode->Query.lastError();
@@ -287,6 +280,16 @@ QVariant ctkDICOMModelPrivate::value(Node* parentNode, int row, int column) cons
   return res;
 }
 
+//------------------------------------------------------------------------------
+int ctkDICOMModelPrivate::field(Node* parentNode, const QString& columnName) const
+{
+  if (this->FetchInThread)
+    {
+    return parentNode->FieldNames.indexOf(columnName);
+    }
+  return parentNode->Query.record().indexOf(columnName);
+}
+
 //------------------------------------------------------------------------------
 QString ctkDICOMModelPrivate::generateQuery(const QString& fields, const QString& table, const QString& conditions)const
 {
@@ -307,7 +310,8 @@ QString ctkDICOMModelPrivate::generateQuery(const QString& fields, const QString
 void ctkDICOMModelPrivate::updateQueries(Node* node)const
 {
   // are you kidding me, it should be virtualized here :-)
-  QString query;
+  QString fields;
+  QString table;
   QString condition;
   switch(node->Type)
     {
@@ -319,8 +323,9 @@ void ctkDICOMModelPrivate::updateQueries(Node* node)const
       if(this->SearchParameters["Name"].toString() != ""){
         condition.append("PatientsName LIKE \"%" + this->SearchParameters["Name"].toString() + "%\"");
       }
-      query = this->generateQuery("UID as UID, PatientsName as Name, PatientsAge as Age, PatientsBirthDate as Date, PatientID as \"Subject ID\"","Patients", condition);
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Root: query is: " + query );
+      fields = "UID as UID, PatientsName as Name, PatientsAge as Age, PatientsBirthDate as Date, PatientID as \"Subject ID\"";
+      table = "Patients";
+      node->QueryKey = "Patients.rowid";
       break;
     case ctkDICOMModel::PatientType:
       //query = QString("SELECT  FROM Studies WHERE PatientsUID='%1'").arg(node->UID);
@@ -338,8 +343,19 @@ void ctkDICOMModelPrivate::updateQueries(Node* node)const
           condition.append(" ( StudyDate BETWEEN \'" + QDate::fromString(this->SearchParameters["StartDate"].toString(), "yyyyMMdd").toString("yyyy-MM-dd")
                            + "\' AND \'" + QDate::fromString(this->SearchParameters["EndDate"].toString(), "yyyyMMdd").toString("yyyy-MM-dd") + "\' ) AND ");
         }
-      query = this->generateQuery("StudyInstanceUID as UID, StudyDescription as Name, ModalitiesInStudy as Scan, StudyDate as Date, AccessionNumber as Number, InstitutionName as Institution, ReferringPhysician as Referrer, PerformingPhysiciansName as Performer", "Studies", condition + QString("PatientsUID='%1'").arg(node->UID));
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Patient: query is: " + query );
+      if (this->HasSummaryTables)
+        {
+        // number of series, from the summary instead of counting the rows
+        fields = "StudyInstanceUID as UID, StudyDescription as Name, ModalitiesInStudy as Scan, StudyDate as Date, AccessionNumber as Number, InstitutionName as Institution, ReferringPhysician as Referrer, PerformingPhysiciansName as Performer, SeriesCount as Count";
+        table = "Studies LEFT JOIN StudySummary USING (StudyInstanceUID)";
+        }
+      else
+        {
+        fields = "StudyInstanceUID as UID, StudyDescription as Name, ModalitiesInStudy as Scan, StudyDate as Date, AccessionNumber as Number, InstitutionName as Institution, ReferringPhysician as Referrer, PerformingPhysiciansName as Performer";
+        table = "Studies";
+        }
+      condition += QString("PatientsUID='%1'").arg(node->UID);
+      node->QueryKey = "Studies.rowid";
       break;
     case ctkDICOMModel::StudyType:
       //query = QString("SELECT SeriesInstanceUID as UID, SeriesDescription as Name, BodyPartExamined as Scan, SeriesDate as Date, AcquisitionNumber as Number FROM Series WHERE StudyInstanceUID='%1'").arg(node->UID);
@@ -347,8 +363,19 @@ void ctkDICOMModelPrivate::updateQueries(Node* node)const
         {
         condition.append("SeriesDescription LIKE \"%" + this->SearchParameters["Series"].toString() + "%\"" + " AND ");
         }
-      query = this->generateQuery("SeriesInstanceUID as UID, SeriesDescription as Name, Modality as Age, SeriesNumber as Scan, BodyPartExamined as \"Subject ID\", SeriesDate as Date, AcquisitionNumber as Number","Series",condition + QString("StudyInstanceUID='%1'").arg(node->UID));
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Study: query is: " + query );
+      if (this->HasSummaryTables)
+        {
+        // number of instances, from the summary instead of counting the rows
+        fields = "SeriesInstanceUID as UID, SeriesDescription as Name, Modality as Age, SeriesNumber as Scan, BodyPartExamined as \"Subject ID\", SeriesDate as Date, AcquisitionNumber as Number, InstanceCount as Count";
+        table = "Series LEFT JOIN SeriesSummary USING (SeriesInstanceUID)";
+        }
+      else
+        {
+        fields = "SeriesInstanceUID as UID, SeriesDescription as Name, Modality as Age, SeriesNumber as Scan, BodyPartExamined as \"Subject ID\", SeriesDate as Date, AcquisitionNumber as Number";
+        table = "Series";
+        }
+      condition += QString("Series.StudyInstanceUID='%1'").arg(node->UID);
+      node->QueryKey = "Series.rowid";
       break;
     case ctkDICOMModel::SeriesType:
       if(this->SearchParameters["ID"].toString() != "")
@@ -356,13 +383,29 @@ void ctkDICOMModelPrivate::updateQueries(Node* node)const
         condition.append("SOPInstanceUID LIKE \"%" + this->SearchParameters["ID"].toString() + "%\"" + " AND ");
         }
       //query = QString("SELECT Filename as UID, Filename as Name, SeriesInstanceUID as Date FROM Images WHERE SeriesInstanceUID='%1'").arg(node->UID);
-      query = this->generateQuery("SOPInstanceUID as UID, Filename as Name, SeriesInstanceUID as Date", "Images", condition + QString("SeriesInstanceUID='%1'").arg(node->UID));
-      logger.debug ( "ctkDICOMModelPrivate::updateQueries for Series: query is: " + query );
+      fields = "SOPInstanceUID as UID, Filename as Name, SeriesInstanceUID as Date";
+      table = "Images";
+      condition += QString("SeriesInstanceUID='%1'").arg(node->UID);
+      node->QueryKey = "Images.rowid";
       break;
     case ctkDICOMModel::ImageType:
       break;
     }
-  node->Query = QSqlQuery(query, this->DataBase);
+  if (fields.isEmpty())
+    {
+    // images have no children
+    }
+  else if (this->FetchInThread)
+    {
+    // rows are fetched in the fetch thread, never here
+    node->QueryFields = fields;
+    node->QueryTable = table;
+    node->QueryCondition = condition;
+    }
+  else
+    {
+    node->Query = QSqlQuery(this->generateQuery(fields, table, condition), this->DataBase);
+    }
   foreach(Node* child, node->Children)
     {
     this->updateQueries(child);
@@ -378,6 +421,11 @@ void ctkDICOMModelPrivate::fetch(const QModelIndex& indexValue, int limit)
     {
     return;
     }
+  if (this->FetchInThread)
+    {
+    this->requestRows(node);
+    return;
+    }
   node->Fetching = true;
 
   int newRowCount;
@@ -421,6 +469,261 @@ void ctkDICOMModelPrivate::fetch(const QModelIndex& indexValue, int limit)
 
 
 
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::startFetcher()
+{
+  this->stopFetcher();
+  if (!this->AsynchronousFetch || !this->DataBase.isValid())
+    {
+    return;
+    }
+  QString databaseName = this->DataBase.databaseName();
+  if (databaseName.isEmpty() || databaseName == ":memory:")
+    {
+    // a cloned connection would open another, empty, in-memory database
+    logger.warn("In-memory databases can not be read from the fetch thread,"
+                " the rows are fetched synchronously.");
+    return;
+    }
+  this->FetchInThread = true;
+  this->Fetcher = new ctkDICOMModelFetcher(this->DataBase);
+  this->Fetcher->moveToThread(&this->FetchThread);
+  QObject::connect(this, SIGNAL(fetchRequested(int,QString,QVariantList)),
+                   this->Fetcher, SLOT(fetch(int,QString,QVariantList)));
+  QObject::connect(this->Fetcher, SIGNAL(rowsFetched(int,QStringList,ctkDICOMModelRows)),
+                   this, SLOT(onRowsFetched(int,QStringList,ctkDICOMModelRows)));
+  this->FetchThread.start();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::stopFetcher()
+{
+  this->clearPendingFetches();
+  this->FetchInThread = false;
+  if (!this->Fetcher)
+    {
+    return;
+    }
+  // the connection must be closed by the thread that opened it
+  QMetaObject::invokeMethod(this->Fetcher, "closeConnection", Qt::BlockingQueuedConnection);
+  this->FetchThread.quit();
+  this->FetchThread.wait();
+  delete this->Fetcher;
+  this->Fetcher = 0;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::clearPendingFetches()
+{
+  // results of the pending requests are ignored when they arrive
+  this->PendingFetches.clear();
+}
+
+//------------------------------------------------------------------------------
+// Expression of the column named \a alias in the \a fields of a node query,
+// e.g. "StudyDescription" for "Name". Empty if there is no such column.
+static QString columnExpression(const QString& fields, const QString& alias)
+{
+  if (alias.isEmpty())
+    {
+    return QString();
+    }
+  foreach(const QString& field, fields.split(','))
+    {
+    if (field.section(" as ", 1).trimmed().remove('"') == alias)
+      {
+      return field.section(" as ", 0, 0).trimmed();
+      }
+    }
+  return QString();
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMModelPrivate::keysetQuery(Node* node, QVariantList& bindValues)const
+{
+  // compare the table column itself so that its index can be used
+  QString sortColumn = columnExpression(node->QueryFields, this->SortColumn);
+  // without sort column, the rows come in rowid order like the rows of the
+  // synchronous query
+  bool ascending = sortColumn.isEmpty() || this->SortOrder == Qt::AscendingOrder;
+  QString order = ascending ? "ASC" : "DESC";
+  QString after = ascending ? ">" : "<";
+  const QString& key = node->QueryKey;
+
+  QString conditions = node->QueryCondition;
+  if (!node->Rows.isEmpty())
+    {
+    // continue right after the last fetched row
+    const QVariantList& lastRow = node->Rows.last();
+    QVariant lastKey = lastRow.value(node->FieldNames.indexOf("RowKey"));
+    QString keyset;
+    if (sortColumn.isEmpty())
+      {
+      keyset = QString("%1 %2 ?").arg(key, after);
+      bindValues << lastKey;
+      }
+    else
+      {
+      // NULL sorts first in ascending order and last in descending order
+      QVariant lastValue = lastRow.value(node->FieldNames.indexOf(this->SortColumn));
+      if (lastValue.isNull())
+        {
+        keyset = QString("( %1 IS NULL AND %2 %3 ? )").arg(sortColumn, key, after);
+        if (ascending)
+          {
+          keyset = QString("( %1 OR %2 IS NOT NULL )").arg(keyset, sortColumn);
+          }
+        bindValues << lastKey;
+        }
+      else
+        {
+        keyset = QString("%1 %2 ? OR ( %1 = ? AND %3 %2 ? )").arg(sortColumn, after, key);
+        if (!ascending)
+          {
+          keyset += QString(" OR %1 IS NULL").arg(sortColumn);
+          }
+        keyset = QString("( %1 )").arg(keyset);
+        bindValues << lastValue << lastValue << lastKey;
+        }
+      }
+    conditions = conditions.isEmpty() ? keyset :
+      QString("( ") + conditions + QString(" ) AND ") + keyset;
+    }
+
+  QString query = QString("SELECT %1, %2 as RowKey FROM %3")
+    .arg(node->QueryFields, key, node->QueryTable);
+  if (!conditions.isEmpty())
+    {
+    query += QString(" WHERE ") + conditions;
+    }
+  if (sortColumn.isEmpty())
+    {
+    query += QString(" ORDER BY %1 %2").arg(key, order);
+    }
+  else
+    {
+    query += QString(" ORDER BY %1 %2, %3 %2").arg(sortColumn, order, key);
+    }
+  query += QString(" LIMIT %1").arg(this->FetchChunkSize);
+  return query;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::requestRows(Node* node)
+{
+  if (node->QueryFields.isEmpty())
+    {
+    // images have no children
+    node->AtEnd = true;
+    }
+  if (!this->Fetcher || node->Fetching || node->AtEnd)
+    {
+    return;
+    }
+  node->Fetching = true;
+  QVariantList bindValues;
+  QString query = this->keysetQuery(node, bindValues);
+  int requestId = ++this->LastRequestId;
+  this->PendingFetches.insert(requestId, node);
+  logger.debug ( "ctkDICOMModelPrivate::requestRows: query is: " + query );
+  emit fetchRequested(requestId, query, bindValues);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelPrivate::onRowsFetched(int requestId, const QStringList& fieldNames,
+                                         const ctkDICOMModelRows& rows)
+{
+  Q_Q(ctkDICOMModel);
+  Node* node = this->PendingFetches.take(requestId);
+  if (!node)
+    {
+    // the node has been deleted by a reset or a sort
+    return;
+    }
+  node->Fetching = false;
+  node->FieldNames = fieldNames;
+  node->AtEnd = rows.size() < this->FetchChunkSize;
+  QModelIndex nodeIndex = (node == this->RootNode) ?
+    QModelIndex() : q->createIndex(node->Row, 0, node);
+  if (!rows.isEmpty())
+    {
+    q->beginInsertRows(nodeIndex, node->RowCount, node->RowCount + rows.size() - 1);
+    node->Rows << rows;
+    node->RowCount = node->Rows.size();
+    q->endInsertRows();
+    }
+  emit q->fetchFinished(nodeIndex);
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMModelFetcher::ctkDICOMModelFetcher(const QSqlDatabase& database)
+  : Source(database)
+{
+  this->ConnectionName = QString("ctkDICOMModelFetcher") + QUuid::createUuid().toString();
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMModelFetcher::~ctkDICOMModelFetcher()
+{
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelFetcher::fetch(int requestId, const QString& queryString, const QVariantList& bindValues)
+{
+  if (!this->Connection.isOpen())
+    {
+    this->Connection = QSqlDatabase::cloneDatabase(this->Source, this->ConnectionName);
+    if (!this->Connection.open())
+      {
+      logger.error("Could not open the database in the fetch thread: "
+                   + this->Connection.lastError().text());
+      }
+    }
+  QStringList fieldNames;
+  ctkDICOMModelRows rows;
+  QSqlQuery query(this->Connection);
+  query.setForwardOnly(true);
+  query.prepare(queryString);
+  for (int i = 0; i < bindValues.size(); ++i)
+    {
+    query.bindValue(i, bindValues[i]);
+    }
+  if (query.exec())
+    {
+    QSqlRecord record = query.record();
+    for (int i = 0; i < record.count(); ++i)
+      {
+      fieldNames << record.fieldName(i);
+      }
+    while (query.next())
+      {
+      QVariantList row;
+      for (int i = 0; i < record.count(); ++i)
+        {
+        row << query.value(i);
+        }
+      rows << row;
+      }
+    }
+  else
+    {
+    logger.error("ctkDICOMModelFetcher: " + query.lastError().text());
+    }
+  emit rowsFetched(requestId, fieldNames, rows);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModelFetcher::closeConnection()
+{
+  if (!this->Connection.isValid())
+    {
+    return;
+    }
+  this->Connection.close();
+  this->Connection = QSqlDatabase();
+  QSqlDatabase::removeDatabase(this->ConnectionName);
+}
+
 //------------------------------------------------------------------------------
 ctkDICOMModel::ctkDICOMModel(QObject* parentObject)
   : Superclass(parentObject)
@@ -465,6 +768,14 @@ QVariant ctkDICOMModel::data ( const QModelIndex & dataIndex, int role ) const
     Node* node = d->nodeFromIndex(dataIndex);
     return node ? node->Type : 0;
     }
+  else if ( role == CountRole )
+    {
+    // not a column: the "Count" field is only in the study and series records
+    QModelIndex parentIndex = this->parent(dataIndex);
+    Node* parentNode = d->nodeFromIndex(parentIndex);
+    int field = parentNode ? d->field(parentNode, "Count") : -1;
+    return field < 0 ? QVariant() : d->value(parentIndex, dataIndex.row(), field);
+    }
   else if ( dataIndex.column() == 0 && role == Qt::CheckStateRole)
     {
     Node* node = d->nodeFromIndex(dataIndex);
@@ -492,7 +803,7 @@ QVariant ctkDICOMModel::data ( const QModelIndex & dataIndex, int role ) const
     const_cast<ctkDICOMModelPrivate *>(d)->fetch(dataIndex, dataIndex.row());
     }
   QString columnName = d->Headers[dataIndex.column()][Qt::DisplayRole].toString();
-  int field = parentNode->Query.record().indexOf(columnName);
+  int field = d->field(parentNode, columnName);
   if (field < 0)
     {
     // Not all the columns are in the record, it's ok to have no field here.
@@ -564,7 +875,7 @@ void ctkDICOMModel::fetchMore ( const QModelIndex & parentValue )
 {
   Q_D(ctkDICOMModel);
   Node* node = d->nodeFromIndex(parentValue);
-  d->fetch(parentValue, qMax(node->RowCount, 0) + 256);
+  d->fetch(parentValue, qMax(node->RowCount, 0) + d->FetchChunkSize);
 }
 
 //------------------------------------------------------------------------------
@@ -608,6 +919,11 @@ bool ctkDICOMModel::hasChildren ( const QModelIndex & parentIndex ) const
 
   // It's not because we don't have row that we don't have children, maybe it
   // just means that the children haven't been fetched yet
+  if (node->RowCount == 0 && !node->AtEnd && d->FetchInThread)
+    {
+    // unknown until the rows are fetched
+    return true;
+    }
   if (node->RowCount == 0 && !node->AtEnd)
     {
     // We don't want to fetch the data because we don't want to add children
@@ -846,6 +1162,9 @@ void ctkDICOMModel::setDatabase(const QSqlDatabase &db)
 
   this->beginResetModel();
   d->DataBase = db;
+  d->HasSummaryTables = d->DataBase.tables().contains("SeriesSummary")
+    && d->DataBase.tables().contains("StudySummary");
+  d->startFetcher();
 
   delete d->RootNode;
   d->RootNode = 0;
@@ -861,6 +1180,12 @@ void ctkDICOMModel::setDatabase(const QSqlDatabase &db)
 
   this->endResetModel();
 
+  if (d->FetchInThread)
+    {
+    d->fetch(QModelIndex(), d->FetchChunkSize);
+    return;
+    }
+
   // TODO, use hasQuerySize everywhere, not only in setDataBase()
   bool hasQuerySize = d->RootNode->Query.driver()->hasFeature(QSqlDriver::QuerySize);
   if (hasQuerySize && d->RootNode->Query.size() > 0)
@@ -882,6 +1207,9 @@ void ctkDICOMModel::setDatabase(const QSqlDatabase &db,const QMap<QString, QVari
   this->beginResetModel();
   d->DataBase = db;
   d->SearchParameters = parameters;
+  d->HasSummaryTables = d->DataBase.tables().contains("SeriesSummary")
+    && d->DataBase.tables().contains("StudySummary");
+  d->startFetcher();
 
   delete d->RootNode;
   d->RootNode = 0;
@@ -897,6 +1225,12 @@ void ctkDICOMModel::setDatabase(const QSqlDatabase &db,const QMap<QString, QVari
 
   this->endResetModel();
 
+  if (d->FetchInThread)
+    {
+    d->fetch(QModelIndex(), d->FetchChunkSize);
+    return;
+    }
+
   // TODO, use hasQuerySize everywhere, not only in setDataBase()
   bool hasQuerySize = d->RootNode->Query.driver()->hasFeature(QSqlDriver::QuerySize);
   if (hasQuerySize && d->RootNode->Query.size() > 0)
@@ -924,6 +1258,34 @@ void ctkDICOMModel::setEndLevel(ctkDICOMModel::IndexType level)
   d->EndLevel = level;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMModel::asynchronousFetch()const
+{
+  Q_D(const ctkDICOMModel);
+  return d->AsynchronousFetch;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModel::setAsynchronousFetch(bool asynchronous)
+{
+  Q_D(ctkDICOMModel);
+  d->AsynchronousFetch = asynchronous;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMModel::fetchChunkSize()const
+{
+  Q_D(const ctkDICOMModel);
+  return d->FetchChunkSize;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMModel::setFetchChunkSize(int chunkSize)
+{
+  Q_D(ctkDICOMModel);
+  d->FetchChunkSize = qMax(1, chunkSize);
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMModel::reset()
 {
@@ -952,14 +1314,23 @@ void ctkDICOMModel::sort(int column, Qt::SortOrder order)
   emit layoutChanged();
   */
   this->beginResetModel();
+  d->clearPendingFetches();
   delete d->RootNode;
   d->RootNode = 0;
+  d->SortColumn = d->Headers[column][Qt::DisplayRole].toString();
+  d->SortOrder = order;
   d->Sort = QString("\"%1\" %2")
-    .arg(d->Headers[column][Qt::DisplayRole].toString())
+    .arg(d->SortColumn)
     .arg(order == Qt::AscendingOrder ? "ASC" : "DESC");
   d->RootNode = d->createNode(-1, QModelIndex());
 
   this->endResetModel();
+
+  if (d->FetchInThread)
+    {
+    // the first chunk, in the new order
+    d->fetch(QModelIndex(), d->FetchChunkSize);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -41,11 +41,22 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMModel
   Q_ENUMS(IndexType)
   /// startLevel contains the hierarchy depth the model contains
   Q_PROPERTY(IndexType endLevel READ endLevel WRITE setEndLevel);
+  /// Run the queries in a separate thread with its own database connection.
+  /// Rows are then added by chunks of fetchChunkSize as they come, after
+  /// fetchMore() or sort() return. Set it before setDatabase().
+  /// In-memory databases are always fetched synchronously.
+  /// False by default.
+  Q_PROPERTY(bool asynchronousFetch READ asynchronousFetch WRITE setAsynchronousFetch);
+  /// Number of rows added by each fetchMore(), 256 by default.
+  Q_PROPERTY(int fetchChunkSize READ fetchChunkSize WRITE setFetchChunkSize);
 public:
 
   enum {
     UIDRole = Qt::UserRole,
-    TypeRole
+    TypeRole,
+    /// Number of series of a study or of instances of a series, read from
+    /// the database summaries; invalid for the other rows
+    CountRole
   };
 
   enum IndexType{
@@ -66,6 +77,12 @@ public:
   ctkDICOMModel::IndexType endLevel()const;
   void setEndLevel(ctkDICOMModel::IndexType level);
 
+  bool asynchronousFetch()const;
+  void setAsynchronousFetch(bool asynchronous);
+
+  int fetchChunkSize()const;
+  void setFetchChunkSize(int chunkSize);
+
   virtual bool canFetchMore ( const QModelIndex & parent ) const;
   virtual int columnCount ( const QModelIndex & parent = QModelIndex() ) const;
   virtual QVariant data ( const QModelIndex & index, int role = Qt::DisplayRole ) const;
@@ -84,6 +101,12 @@ public:
   virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
 public Q_SLOTS:
   virtual void reset();
+
+Q_SIGNALS:
+  /// Emitted in asynchronous mode when the rows requested for \a parent have
+  /// been added, even if there were none.
+  void fetchFinished(const QModelIndex& parent);
+
 protected:
   QScopedPointer<ctkDICOMModelPrivate> d_ptr;
 
@@ -0,0 +1,139 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMModel_p_h
+#define __ctkDICOMModel_p_h
+
+// Qt includes
+#include <QMap>
+#include <QMetaType>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QThread>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMModel.h"
+
+struct Node;
+
+typedef QList<QVariantList> ctkDICOMModelRows;
+Q_DECLARE_METATYPE(ctkDICOMModelRows)
+
+//------------------------------------------------------------------------------
+/// \internal
+/// Runs the node queries of an asynchronous ctkDICOMModel. It lives in the
+/// fetch thread and uses its own connection to the database, opened from
+/// that thread.
+class ctkDICOMModelFetcher : public QObject
+{
+  Q_OBJECT
+public:
+  ctkDICOMModelFetcher(const QSqlDatabase& database);
+  virtual ~ctkDICOMModelFetcher();
+
+public Q_SLOTS:
+  void fetch(int requestId, const QString& query, const QVariantList& bindValues);
+  void closeConnection();
+
+Q_SIGNALS:
+  void rowsFetched(int requestId, const QStringList& fieldNames, const ctkDICOMModelRows& rows);
+
+private:
+  QSqlDatabase Source;
+  QSqlDatabase Connection;
+  QString      ConnectionName;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMModelPrivate : public QObject
+{
+  Q_OBJECT
+  Q_DECLARE_PUBLIC(ctkDICOMModel);
+protected:
+  ctkDICOMModel* const q_ptr;
+
+public:
+  ctkDICOMModelPrivate(ctkDICOMModel&);
+  virtual ~ctkDICOMModelPrivate();
+  void init();
+
+  void fetch(const QModelIndex& indexValue, int limit);
+  Node* createNode(int row, const QModelIndex& parentValue)const;
+  Node* nodeFromIndex(const QModelIndex& indexValue)const;
+  //QModelIndexList indexListFromNode(const Node* node)const;
+  //QModelIndexList modelIndexList(Node* node = 0)const;
+  //int childrenCount(Node* node = 0)const;
+  // move it in the Node struct
+  QVariant value(Node* parentValue, int row, int field)const;
+  QVariant value(const QModelIndex& indexValue, int row, int field)const;
+  /// index of the column \a columnName in the rows of \a parentNode, -1 if
+  /// the column is not part of the node query
+  int field(Node* parentNode, const QString& columnName)const;
+  QString  generateQuery(const QString& fields, const QString& table, const QString& conditions = QString())const;
+  void updateQueries(Node* node)const;
+
+  ///
+  /// \brief asynchronous fetching
+  ///
+  /// The fetcher runs in FetchThread. Each fetchMore requests the next
+  /// FetchChunkSize rows after the last fetched row (keyset pagination on
+  /// the sort column and the rowid), so the cost of a chunk does not depend
+  /// on how many rows are already fetched.
+  void startFetcher();
+  void stopFetcher();
+  void requestRows(Node* node);
+  QString keysetQuery(Node* node, QVariantList& bindValues)const;
+  /// forget the requests of the nodes that are about to be deleted
+  void clearPendingFetches();
+
+  Node*        RootNode;
+  QSqlDatabase DataBase;
+  QList<QMap<int, QVariant> > Headers;
+  QString      Sort;
+  QString      SortColumn;
+  Qt::SortOrder SortOrder;
+  QMap<QString, QVariant> SearchParameters;
+  /// the database has the SeriesSummary and StudySummary tables that
+  /// provide the Count column
+  bool         HasSummaryTables;
+
+  bool                  AsynchronousFetch;
+  /// AsynchronousFetch is on and the fetcher could be started: false for
+  /// in-memory databases, which the fetch thread can not share
+  bool                  FetchInThread;
+  int                   FetchChunkSize;
+  QThread               FetchThread;
+  ctkDICOMModelFetcher* Fetcher;
+  QMap<int, Node*>      PendingFetches;
+  int                   LastRequestId;
+
+  ctkDICOMModel::IndexType StartLevel;
+  ctkDICOMModel::IndexType EndLevel;
+
+public Q_SLOTS:
+  void onRowsFetched(int requestId, const QStringList& fieldNames, const ctkDICOMModelRows& rows);
+
+Q_SIGNALS:
+  void fetchRequested(int requestId, const QString& query, const QVariantList& bindValues);
+};
+
+#endif
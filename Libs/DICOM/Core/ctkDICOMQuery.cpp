@@ -29,6 +29,14 @@
 #include <QDirIterator>
 #include <QFileInfo>
 #include <QDebug>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QQueue>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
 
 // ctkDICOMCore includes
 #include "ctkDICOMQuery.h"
@@ -97,7 +105,45 @@ public:
   DcmDataset*             Query;
   QStringList             StudyInstanceUIDList;
   QList<DcmDataset*>      StudyDatasetList;
-  bool                    Canceled;
+  QAtomicInt              Canceled;
+  int                     MaximumAssociations;
+
+  /// Open an association like the one of the study level query
+  bool openAssociation(ctkDICOMQuerySCUPrivate& scu);
+
+  /// Run by the series query threads: take the studies from
+  /// PendingStudies and send a series level C-FIND for each, on the
+  /// association of \a scu, until there is no study left.
+  void querySeries(ctkDICOMQuerySCUPrivate& scu);
+
+  /// Series level C-FIND of a study, passed from the query threads to
+  /// the thread inserting the results into the database
+  struct SeriesResult
+    {
+    QString            StudyInstanceUID;
+    QList<DcmDataset*> Datasets;
+    bool               Success;
+    };
+  /// The studies to query series for, with the study level datasets
+  QQueue<QPair<QString, DcmDataset*> > PendingStudies;
+  QList<SeriesResult>     SeriesResults;
+  int                     ActiveSeriesQueries;
+  QMutex                  SeriesMutex;
+  QWaitCondition          SeriesResultsReady;
+};
+
+//------------------------------------------------------------------------------
+// Series level C-FIND thread, with its own association unless it is given
+// one
+class ctkDICOMQuerySeriesWorker : public QRunnable
+{
+public:
+  ctkDICOMQuerySeriesWorker(ctkDICOMQueryPrivate* query, ctkDICOMQuerySCUPrivate* scu)
+    : Query(query), SCU(scu) {}
+  virtual void run();
+protected:
+  ctkDICOMQueryPrivate*    Query;
+  ctkDICOMQuerySCUPrivate* SCU;
 };
 
 //------------------------------------------------------------------------------
@@ -108,8 +154,10 @@ ctkDICOMQueryPrivate::ctkDICOMQueryPrivate()
 {
   this->Query = new DcmDataset();
   this->Port = 0;
-  this->Canceled = false;
+  this->Canceled = 0;
   this->PreferCGET = false;
+  this->MaximumAssociations = 1;
+  this->ActiveSeriesQueries = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -125,6 +173,98 @@ void ctkDICOMQueryPrivate::addStudyInstanceUIDAndDataset( const QString& s, DcmD
   this->StudyDatasetList.append ( dataset );
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMQueryPrivate::openAssociation(ctkDICOMQuerySCUPrivate& scu)
+{
+  scu.setAETitle ( OFString(this->CallingAETitle.toStdString().c_str()) );
+  scu.setPeerAETitle ( OFString(this->CalledAETitle.toStdString().c_str()) );
+  scu.setPeerHostName ( OFString(this->Host.toStdString().c_str()) );
+  scu.setPeerPort ( this->Port );
+
+  OFList<OFString> transferSyntaxes;
+  transferSyntaxes.push_back ( UID_LittleEndianExplicitTransferSyntax );
+  transferSyntaxes.push_back ( UID_BigEndianExplicitTransferSyntax );
+  transferSyntaxes.push_back ( UID_LittleEndianImplicitTransferSyntax );
+  scu.addPresentationContext ( UID_FINDStudyRootQueryRetrieveInformationModel, transferSyntaxes );
+  if ( !scu.initNetwork().good() )
+    {
+    logger.error( "Error initializing the network" );
+    return false;
+    }
+  OFCondition result = scu.negotiateAssociation();
+  if (result.bad())
+    {
+    logger.error( "Error negotiating the association: " + QString(result.text()) );
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQueryPrivate::querySeries(ctkDICOMQuerySCUPrivate& scu)
+{
+  T_ASC_PresentationContextID presentationContext =
+    scu.findPresentationContextID ( UID_FINDStudyRootQueryRetrieveInformationModel, "");
+  // each thread fills the study of its own copy of the series query
+  DcmDataset query(*this->Query);
+  QMutexLocker locker(&this->SeriesMutex);
+  while (this->Canceled == 0 && !this->PendingStudies.isEmpty())
+    {
+    QPair<QString, DcmDataset*> study = this->PendingStudies.dequeue();
+    locker.unlock();
+
+    OFString patientName, patientID;
+    study.second->findAndGetOFStringArray(DCM_PatientName, patientName);
+    study.second->findAndGetOFStringArray(DCM_PatientID, patientID);
+
+    query.putAndInsertString ( DCM_StudyInstanceUID, study.first.toStdString().c_str() );
+    OFList<QRResponse *> responses;
+    SeriesResult result;
+    result.StudyInstanceUID = study.first;
+    result.Success = scu.sendFINDRequest ( presentationContext, &query, &responses ).good();
+    for ( OFIterator<QRResponse*> it = responses.begin(); it != responses.end(); it++ )
+      {
+      DcmDataset *dataset = (*it)->m_dataset;
+      if ( dataset != NULL && result.Success )
+        {
+        // add the patient elements not provided for the series level query
+        dataset->putAndInsertOFStringArray( DCM_PatientName, patientName );
+        dataset->putAndInsertOFStringArray( DCM_PatientID, patientID );
+        result.Datasets << dataset;
+        (*it)->m_dataset = NULL;
+        }
+      delete *it;
+      }
+
+    locker.relock();
+    this->SeriesResults << result;
+    this->SeriesResultsReady.wakeAll();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQuerySeriesWorker::run()
+{
+  if (this->SCU)
+    {
+    this->Query->querySeries(*this->SCU);
+    }
+  else
+    {
+    ctkDICOMQuerySCUPrivate scu;
+    scu.query = this->Query->SCU.query;
+    // if the association fails, the other threads query the studies
+    if (this->Query->openAssociation(scu))
+      {
+      this->Query->querySeries(scu);
+      scu.closeAssociation ( DCMSCU_RELEASE_ASSOCIATION );
+      }
+    }
+  QMutexLocker locker(&this->Query->SeriesMutex);
+  --this->Query->ActiveSeriesQueries;
+  this->Query->SeriesResultsReady.wakeAll();
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMQuery methods
 
@@ -213,6 +353,20 @@ bool ctkDICOMQuery::preferCGET()const
   return d->PreferCGET;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMQuery::setMaximumAssociations ( int associations )
+{
+  Q_D(ctkDICOMQuery);
+  d->MaximumAssociations = qMax(1, associations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMQuery::maximumAssociations()const
+{
+  Q_D(const ctkDICOMQuery);
+  return d->MaximumAssociations;
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMQuery::setFilters( const QMap<QString,QVariant>& filters )
 {
@@ -257,42 +411,17 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
     emit progress("DB not open in Query");
     }
   emit progress(0);
-  if (d->Canceled) {return false;}
+  if (d->Canceled != 0) {return false;}
 
   d->StudyInstanceUIDList.clear();
-  d->SCU.setAETitle ( OFString(this->callingAETitle().toStdString().c_str()) );
-  d->SCU.setPeerAETitle ( OFString(this->calledAETitle().toStdString().c_str()) );
-  d->SCU.setPeerHostName ( OFString(this->host().toStdString().c_str()) );
-  d->SCU.setPeerPort ( this->port() );
-
-  logger.error ( "Setting Transfer Syntaxes" );
-  emit progress("Setting Transfer Syntaxes");
-  emit progress(10);
-  if (d->Canceled) {return false;}
-
-  OFList<OFString> transferSyntaxes;
-  transferSyntaxes.push_back ( UID_LittleEndianExplicitTransferSyntax );
-  transferSyntaxes.push_back ( UID_BigEndianExplicitTransferSyntax );
-  transferSyntaxes.push_back ( UID_LittleEndianImplicitTransferSyntax );
-
-  d->SCU.addPresentationContext ( UID_FINDStudyRootQueryRetrieveInformationModel, transferSyntaxes );
-  // d->SCU.addPresentationContext ( UID_VerificationSOPClass, transferSyntaxes );
-  if ( !d->SCU.initNetwork().good() )
-    {
-    logger.error( "Error initializing the network" );
-    emit progress("Error initializing the network");
-    emit progress(100);
-    return false;
-    }
+  d->StudyDatasetList.clear();
   logger.debug ( "Negotiating Association" );
   emit progress("Negotiating Association");
   emit progress(20);
-  if (d->Canceled) {return false;}
+  if (d->Canceled != 0) {return false;}
 
-  OFCondition result = d->SCU.negotiateAssociation();
-  if (result.bad())
+  if ( !d->openAssociation(d->SCU) )
     {
-    logger.error( "Error negotiating the association: " + QString(result.text()) );
     emit progress("Error negotiating the association");
     emit progress(100);
     return false;
@@ -378,7 +507,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
     logger.debug("Query on study date " + dateRange);
     }
   emit progress(30);
-  if (d->Canceled) {return false;}
+  if (d->Canceled != 0) {return false;}
 
   OFList<QRResponse *> responses;
 
@@ -396,7 +525,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
     emit progress("Found useful presentation context");
     }
   emit progress(40);
-  if (d->Canceled) {return false;}
+  if (d->Canceled != 0) {return false;}
 
   OFCondition status = d->SCU.sendFINDRequest ( presentationContext, d->Query, &responses );
   if ( !status.good() )
@@ -410,8 +539,10 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
   logger.debug ( "Find succeded");
   emit progress("Find succeded");
   emit progress(50);
-  if (d->Canceled) {return false;}
+  if (d->Canceled != 0) {return false;}
 
+  // all the studies are inserted in one transaction
+  database.beginInsertBatch();
   for ( OFIterator<QRResponse*> it = responses.begin(); it != responses.end(); it++ )
     {
     DcmDataset *dataset = (*it)->m_dataset;
@@ -423,9 +554,18 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
       d->addStudyInstanceUIDAndDataset ( StudyInstanceUID.c_str(), dataset );
       emit progress(QString("Processing: ") + QString(StudyInstanceUID.c_str()));
       emit progress(50);
-      if (d->Canceled) {return false;}
+      if (d->Canceled != 0)
+        {
+        database.endInsertBatch();
+        return false;
+        }
       }
     }
+  database.endInsertBatch();
+  foreach ( const QString& StudyInstanceUID, d->StudyInstanceUIDList )
+    {
+    emit studyFound(StudyInstanceUID);
+    }
 
   /* Only ask for series attributes now. This requires kicking out the rest of former query. */
   d->Query->clear();
@@ -440,55 +580,88 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
   /* Add user-defined filters */
   d->Query->putAndInsertOFStringArray(DCM_SeriesDescription, seriesDescription.toLatin1().data());
 
-  // Now search each within each Study that was identified
+  // Now search each within each Study that was identified. The series
+  // level queries are sent from MaximumAssociations threads; the first one
+  // uses the association of the study level query. This thread inserts
+  // the results while the next studies are queried.
   d->Query->putAndInsertString ( DCM_QueryRetrieveLevel, "SERIES" );
-  float progressRatio = 25. / d->StudyInstanceUIDList.count();
-  int i = 0; 
-
+  d->PendingStudies.clear();
+  d->SeriesResults.clear();
   QListIterator<DcmDataset*> datasetIterator(d->StudyDatasetList);
   foreach ( QString StudyInstanceUID, d->StudyInstanceUIDList )
     {
-    DcmDataset *studyDataset = datasetIterator.next();
-    DcmElement *patientName, *patientID;
-    studyDataset->findAndGetElement(DCM_PatientName, patientName);
-    studyDataset->findAndGetElement(DCM_PatientID, patientID);
+    d->PendingStudies.enqueue(qMakePair(StudyInstanceUID, datasetIterator.next()));
+    }
+  int studyCount = d->StudyInstanceUIDList.count();
+  int threadCount = qMin(d->MaximumAssociations, qMax(1, studyCount));
+  d->ActiveSeriesQueries = threadCount;
+  QThreadPool seriesQueryPool;
+  seriesQueryPool.setMaxThreadCount(threadCount);
+  for (int thread = 0; thread < threadCount; ++thread)
+    {
+    seriesQueryPool.start(new ctkDICOMQuerySeriesWorker(d, thread == 0 ? &d->SCU : 0));
+    }
 
-    logger.debug ( "Starting Series C-FIND for Study: " + StudyInstanceUID );
-    emit progress(QString("Starting Series C-FIND for Study: ") + StudyInstanceUID);
-    emit progress(50 + (progressRatio * i++));
-    if (d->Canceled) {return false;}
+  int studiesDone = 0;
+  forever
+    {
+    QList<ctkDICOMQueryPrivate::SeriesResult> results;
+    {
+    QMutexLocker locker(&d->SeriesMutex);
+    while (d->SeriesResults.isEmpty() && d->ActiveSeriesQueries > 0)
+      {
+      d->SeriesResultsReady.wait(&d->SeriesMutex);
+      }
+    results = d->SeriesResults;
+    d->SeriesResults.clear();
+    }
+    if (results.isEmpty())
+      {
+      break;
+      }
 
-    d->Query->putAndInsertString ( DCM_StudyInstanceUID, StudyInstanceUID.toStdString().c_str() );
-    OFList<QRResponse *> responses;
-    status = d->SCU.sendFINDRequest ( presentationContext, d->Query, &responses );
-    if ( status.good() )
+    // insert everything received since the last time in one transaction
+    database.beginInsertBatch();
+    foreach ( const ctkDICOMQueryPrivate::SeriesResult& result, results )
       {
-      for ( OFIterator<QRResponse*> it = responses.begin(); it != responses.end(); it++ )
+      foreach ( DcmDataset* dataset, result.Datasets )
         {
-        DcmDataset *dataset = (*it)->m_dataset;
-        if ( dataset != NULL )
-          {
-          // add the patient elements not provided for the series level query
-          dataset->insert( patientName, true );
-          dataset->insert( patientID, true );
-          // insert series dataset 
-          database.insert ( dataset, false /* do not store */, false /* no thumbnail */ );
-          }
+        database.insert ( dataset, false /* do not store */, false /* no thumbnail */ );
         }
-      logger.debug ( "Find succeded on Series level for Study: " + StudyInstanceUID );
-      emit progress(QString("Find succeded on Series level for Study: ") + StudyInstanceUID);
-      emit progress(50 + (progressRatio * i++));
-      if (d->Canceled) {return false;}
       }
-    else
+    database.endInsertBatch();
+
+    foreach ( const ctkDICOMQueryPrivate::SeriesResult& result, results )
       {
-      logger.error ( "Find on Series level failed for Study: " + StudyInstanceUID );
-      emit progress(QString("Find on Series level failed for Study: ") + StudyInstanceUID);
+      if ( result.Success )
+        {
+        logger.debug ( "Find succeded on Series level for Study: " + result.StudyInstanceUID );
+        emit progress(QString("Find succeded on Series level for Study: ") + result.StudyInstanceUID);
+        }
+      else
+        {
+        logger.error ( "Find on Series level failed for Study: " + result.StudyInstanceUID );
+        emit progress(QString("Find on Series level failed for Study: ") + result.StudyInstanceUID);
+        }
+      foreach ( DcmDataset* dataset, result.Datasets )
+        {
+        OFString SeriesInstanceUID;
+        dataset->findAndGetOFString ( DCM_SeriesInstanceUID, SeriesInstanceUID );
+        emit seriesFound(result.StudyInstanceUID, QString(SeriesInstanceUID.c_str()));
+        delete dataset;
+        }
+      emit progress(50 + (49 * ++studiesDone) / studyCount);
       }
-    emit progress(50 + (progressRatio * i++));
-    if (d->Canceled) {return false;}
     }
+  seriesQueryPool.waitForDone();
+
   d->SCU.closeAssociation ( DCMSCU_RELEASE_ASSOCIATION );
+  if (d->Canceled != 0) {return false;}
+  if (studiesDone < studyCount)
+    {
+    logger.error ( QString("Series level queries failed for %1 studies")
+                   .arg(studyCount - studiesDone) );
+    }
   emit progress(100);
   return true;
 }
@@ -497,5 +670,5 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database )
 void ctkDICOMQuery::cancel()
 {
   Q_D(ctkDICOMQuery);
-  d->Canceled = true;
+  d->Canceled = 1;
 }
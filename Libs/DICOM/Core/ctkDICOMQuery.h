@@ -44,6 +44,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMQuery : public QObject
   Q_PROPERTY(QString host READ host WRITE setHost);
   Q_PROPERTY(int port READ port WRITE setPort);
   Q_PROPERTY(bool preferCGET READ preferCGET WRITE setPreferCGET);
+  Q_PROPERTY(int maximumAssociations READ maximumAssociations WRITE setMaximumAssociations);
 
 public:
   explicit ctkDICOMQuery(QObject* parent = 0);
@@ -68,6 +69,11 @@ public:
   /// false by default
   void setPreferCGET ( bool preferCGET );
   bool preferCGET()const;
+  /// Number of associations used in parallel for the series level queries
+  /// of query(), one per study found. With 1 (default), the series are
+  /// queried on the association of the study level query.
+  void setMaximumAssociations ( int associations );
+  int maximumAssociations()const;
 
   /// Query a remote DICOM Image Store SCP
   /// You must at least set the host and port before calling query()
@@ -111,8 +117,15 @@ Q_SIGNALS:
   /// Signal is emitted inside the query() function when finished with value 
   /// true for success or false for error
   void done(const bool& error);
+  /// Signal is emitted inside the query() function for each study found,
+  /// once the study is in the database
+  void studyFound(const QString& studyInstanceUID);
+  /// Signal is emitted inside the query() function for each series found,
+  /// once the series is in the database
+  void seriesFound(const QString& studyInstanceUID, const QString& seriesInstanceUID);
 
 public Q_SLOTS:
+  /// Stop the query, can be called from any thread
   void cancel();
 
 protected:
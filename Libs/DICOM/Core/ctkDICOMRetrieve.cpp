@@ -21,9 +21,11 @@
 #include <stdexcept>
 
 // Qt includes
+#include <QAtomicInt>
 
 // ctkDICOMCore includes
 #include "ctkDICOMRetrieve.h"
+#include "ctkDICOMWriteBehindQueue.h"
 #include "ctkLogger.h"
 
 // DCMTK includes
@@ -56,9 +58,12 @@ class ctkDICOMRetrieveSCUPrivate : public DcmSCU
 {
 public:
   ctkDICOMRetrieve *retrieve;
+  /// set if the received data sets are inserted with write-behind
+  ctkDICOMWriteBehindQueue *writeBehindQueue;
   ctkDICOMRetrieveSCUPrivate()
     {
     this->retrieve = 0;
+    this->writeBehindQueue = 0;
     };
   ~ctkDICOMRetrieveSCUPrivate() {};
 
@@ -94,6 +99,17 @@ public:
         emit this->retrieve->progress("Got STORE request for " + qInstanceUID);
         emit this->retrieve->progress(0);
         continueCGETSession = !this->retrieve->wasCanceled();
+        if (this->writeBehindQueue)
+          {
+          // only write the file, the database insert happens later
+          if (!this->writeBehindQueue->enqueue(incomingObject))
+            {
+            cStoreReturnStatus = STATUS_STORE_Refused_OutOfResources;
+            return EC_IllegalCall;
+            }
+          cStoreReturnStatus = STATUS_Success;
+          return EC_Normal;
+          }
         if (this->retrieve && this->retrieve->database())
           {
           this->retrieve->database()->insert(incomingObject);
@@ -125,6 +141,19 @@ public:
       //return false;
       return EC_IllegalCall;
     };
+
+  // called when a data set received via CGET has been written to the
+  // storage directory
+  virtual void notifyInstanceStored(const OFString& filename,
+                                    const OFString& sopClassUID,
+                                    const OFString& sopInstanceUID) const
+    {
+      this->DcmSCU::notifyInstanceStored(filename, sopClassUID, sopInstanceUID);
+      if (this->retrieve)
+        {
+        emit this->retrieve->instanceStored(QString(filename.c_str()));
+        }
+    };
 };
 
 
@@ -141,13 +170,17 @@ public:
   ~ctkDICOMRetrievePrivate();
   /// Keep the currently negotiated connection to the 
   /// peer host open unless the connection parameters change
-  bool          WasCanceled;
+  /// set by cancel(), possibly from another thread than the retrieve
+  QAtomicInt    WasCanceled;
   bool          KeepAssociationOpen;
   bool          ConnectionParamsChanged;
   bool          LastRetrieveType;
   QSharedPointer<ctkDICOMDatabase> Database;
   ctkDICOMRetrieveSCUPrivate        SCU;
+  QScopedPointer<ctkDICOMWriteBehindQueue> WriteBehindQueue;
   QString MoveDestinationAETitle;
+  int CompletedSubOperations;
+  int FailedSubOperations;
   // do the retrieve, handling both series and study retrieves
   enum RetrieveType { RetrieveNone, RetrieveSeries, RetrieveStudy };
   bool initializeSCU(const QString& studyInstanceUID,
@@ -157,6 +190,8 @@ public:
   bool move ( const QString& studyInstanceUID,
                   const QString& seriesInstanceUID,
                   const RetrieveType retrieveType );
+  /// give the write-behind queue the current database
+  void updateWriteBehindQueue();
   bool get ( const QString& studyInstanceUID,
                   const QString& seriesInstanceUID,
                   const RetrieveType retrieveType );
@@ -170,10 +205,12 @@ ctkDICOMRetrievePrivate::ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj)
   : q_ptr(&obj)
 {
   this->Database = QSharedPointer<ctkDICOMDatabase> (0);
-  this->WasCanceled = false;
+  this->WasCanceled = 0;
   this->KeepAssociationOpen = true;
   this->ConnectionParamsChanged = false;
   this->LastRetrieveType = RetrieveNone;
+  this->CompletedSubOperations = 0;
+  this->FailedSubOperations = 0;
 
   // Register the JPEG libraries in case we need them
   // (registration only happens once, so it's okay to call repeatedly)
@@ -213,6 +250,22 @@ ctkDICOMRetrievePrivate::~ctkDICOMRetrievePrivate()
     }
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMRetrievePrivate::updateWriteBehindQueue()
+{
+  if (this->WriteBehindQueue)
+    {
+    this->WriteBehindQueue->setDatabase(this->Database);
+    if (!this->SCU.getStorageDir().empty())
+      {
+      // a single spool directory for the data sets the database does not keep
+      this->WriteBehindQueue->setSpoolDirectory(QString(this->SCU.getStorageDir().c_str()));
+      }
+    }
+  this->SCU.writeBehindQueue = (this->WriteBehindQueue && this->Database) ?
+    this->WriteBehindQueue.data() : 0;
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMRetrievePrivate::initializeSCU( const QString& studyInstanceUID,
                                          const QString& seriesInstanceUID,
@@ -245,6 +298,8 @@ bool ctkDICOMRetrievePrivate::initializeSCU( const QString& studyInstanceUID,
     }
 
   this->ConnectionParamsChanged = false;
+  this->CompletedSubOperations = 0;
+  this->FailedSubOperations = 0;
   // Setup query about what to be received from the PACS
   logger.debug ( "Setting Retrieve Parameters" );
   if ( retrieveType == RetrieveSeries )
@@ -364,6 +419,8 @@ bool ctkDICOMRetrievePrivate::move ( const QString& studyInstanceUID,
     {
     it++;
     }
+  this->CompletedSubOperations = (*it)->m_numberOfCompletedSubops;
+  this->FailedSubOperations = (*it)->m_numberOfFailedSubops;
   logger.debug ( "MOVE responses report for study: " + studyInstanceUID +"\n"
     + QString::number(static_cast<unsigned int>((*it)->m_numberOfCompletedSubops))
         + " images transferred, and\n"
@@ -485,6 +542,8 @@ bool ctkDICOMRetrievePrivate::get ( const QString& studyInstanceUID,
     {
     it++;
     }
+  this->CompletedSubOperations = (*it)->m_numberOfCompletedSubops;
+  this->FailedSubOperations = (*it)->m_numberOfFailedSubops;
   logger.debug ( "GET responses report for study: " + studyInstanceUID +"\n"
     + QString::number(static_cast<unsigned int>((*it)->m_numberOfCompletedSubops))
         + " images transferred, and\n"
@@ -611,6 +670,7 @@ void ctkDICOMRetrieve::setDatabase(ctkDICOMDatabase& dicomDatabase)
 {
   Q_D(ctkDICOMRetrieve);
   d->Database = QSharedPointer<ctkDICOMDatabase>(&dicomDatabase);
+  d->updateWriteBehindQueue();
 }
 
 //------------------------------------------------------------------------------
@@ -618,6 +678,7 @@ void ctkDICOMRetrieve::setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabas
 {
   Q_D(ctkDICOMRetrieve);
   d->Database = dicomDatabase;
+  d->updateWriteBehindQueue();
 }
 
 //------------------------------------------------------------------------------
@@ -627,6 +688,62 @@ QSharedPointer<ctkDICOMDatabase> ctkDICOMRetrieve::database()const
   return d->Database;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::setStorageDirectory(const QString& directory)
+{
+  Q_D(ctkDICOMRetrieve);
+  d->SCU.setStorageDir(QDir::toNativeSeparators(directory).toStdString().c_str());
+  d->updateWriteBehindQueue();
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMRetrieve::storageDirectory()const
+{
+  Q_D(const ctkDICOMRetrieve);
+  return QString(d->SCU.getStorageDir().c_str());
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::setWriteBehind(bool writeBehind)
+{
+  Q_D(ctkDICOMRetrieve);
+  if (writeBehind == !d->WriteBehindQueue.isNull())
+    {
+    return;
+    }
+  // the queue inserts its pending files when it is deleted
+  d->WriteBehindQueue.reset(writeBehind ? new ctkDICOMWriteBehindQueue : 0);
+  d->updateWriteBehindQueue();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieve::writeBehind()const
+{
+  Q_D(const ctkDICOMRetrieve);
+  return !d->WriteBehindQueue.isNull();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieve::flush(int msecs)
+{
+  Q_D(ctkDICOMRetrieve);
+  return d->WriteBehindQueue ? d->WriteBehindQueue->flush(msecs) : true;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieve::completedSubOperations()const
+{
+  Q_D(const ctkDICOMRetrieve);
+  return d->CompletedSubOperations;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieve::failedSubOperations()const
+{
+  Q_D(const ctkDICOMRetrieve);
+  return d->FailedSubOperations;
+}
+
 //------------------------------------------------------------------------------
 void ctkDICOMRetrieve::setKeepAssociationOpen(const bool keepOpen)
 {
@@ -644,14 +761,14 @@ bool ctkDICOMRetrieve::keepAssociationOpen()
 void ctkDICOMRetrieve::setWasCanceled(const bool wasCanceled)
 {
   Q_D(ctkDICOMRetrieve);
-  d->WasCanceled = wasCanceled;
+  d->WasCanceled = wasCanceled ? 1 : 0;
 }
 
 //------------------------------------------------------------------------------
 bool ctkDICOMRetrieve::wasCanceled()
 {
   Q_D(const ctkDICOMRetrieve);
-  return d->WasCanceled;
+  return d->WasCanceled != 0;
 }
 
 //------------------------------------------------------------------------------
@@ -712,6 +829,6 @@ bool ctkDICOMRetrieve::getSeries(const QString& studyInstanceUID,
 void ctkDICOMRetrieve::cancel()
 {
   Q_D(ctkDICOMRetrieve);
-  d->WasCanceled = true;
+  d->WasCanceled = 1;
 }
 
@@ -45,6 +45,8 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMRetrieve : public QObject
   Q_PROPERTY(QString moveDestinationAETitle READ moveDestinationAETitle WRITE setMoveDestinationAETitle);
   Q_PROPERTY(bool keepAssociationOpen READ keepAssociationOpen WRITE setKeepAssociationOpen);
   Q_PROPERTY(bool wasCanceled READ wasCanceled WRITE setWasCanceled);
+  Q_PROPERTY(QString storageDirectory READ storageDirectory WRITE setStorageDirectory);
+  Q_PROPERTY(bool writeBehind READ writeBehind WRITE setWriteBehind);
 
 public:
   explicit ctkDICOMRetrieve(QObject* parent = 0);
@@ -83,6 +85,31 @@ public:
   Q_INVOKABLE void setDatabase(ctkDICOMDatabase& dicomDatabase);
   void setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase);
   Q_INVOKABLE QSharedPointer<ctkDICOMDatabase> database()const;
+  /// directory where the data sets obtained via get are written to when
+  /// no database is set. instanceStored() is emitted for each file.
+  /// With write-behind, it is also the spool directory of the data sets
+  /// an in-memory database does not keep.
+  Q_INVOKABLE void setStorageDirectory(const QString& directory);
+  Q_INVOKABLE QString storageDirectory()const;
+
+  /// If enabled, the data sets obtained via get are written to the
+  /// database directory and acknowledged right away, and inserted into the
+  /// database in batches by a ctkDICOMWriteBehindQueue, from the thread of
+  /// the database, instead of while the association waits. It only
+  /// unblocks the association if the retrieve runs in another thread than
+  /// the database. Call flush() to wait for the inserts.
+  /// (default false)
+  Q_INVOKABLE void setWriteBehind(bool writeBehind);
+  Q_INVOKABLE bool writeBehind()const;
+  /// Block until the data sets received with write-behind are inserted
+  /// into the database. Returns false if \a msecs elapsed first, a
+  /// negative value waits without timeout.
+  Q_INVOKABLE bool flush(int msecs = -1);
+
+  /// Sub-operation counts reported by the last response of the last
+  /// move or get request (0 if the server did not report them)
+  Q_INVOKABLE int completedSubOperations()const;
+  Q_INVOKABLE int failedSubOperations()const;
 
 public Q_SLOTS:
   /// Use CMOVE to ask peer host to store data to move destination
@@ -95,7 +122,7 @@ public Q_SLOTS:
                        const QString& seriesInstanceUID );
   /// Use CGET to ask peer host to store data to us
   Q_INVOKABLE bool getStudy( const QString& studyInstanceUID );
-  /// Cancel the current operation
+  /// Cancel the current operation. It can be called from any thread.
   Q_INVOKABLE void cancel();
 
 Q_SIGNALS:
@@ -113,6 +140,9 @@ Q_SIGNALS:
   /// Signal is emitted inside the retrieve() function when finished with value 
   /// true for success or false for error
   void done(const bool& error);
+  /// Signal is emitted when a data set obtained via get has been written
+  /// to \a filePath in the storage directory (only if no database is set)
+  void instanceStored(const QString& filePath);
 
 protected:
   QScopedPointer<ctkDICOMRetrievePrivate> d_ptr;
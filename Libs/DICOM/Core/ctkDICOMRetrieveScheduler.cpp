@@ -0,0 +1,483 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDir>
+#include <QEventLoop>
+#include <QMutexLocker>
+#include <QTime>
+#include <QTimer>
+
+// ctkDICOMCore includes
+#include "ctkDICOMRetrieve.h"
+#include "ctkDICOMRetrieveScheduler.h"
+#include "ctkDICOMRetrieveScheduler_p.h"
+#include "ctkLogger.h"
+
+// STD includes
+#include <climits>
+
+static ctkLogger logger("org.commontk.dicom.DICOMRetrieveScheduler");
+
+//------------------------------------------------------------------------------
+// ctkDICOMRetrieveWorker methods
+
+//------------------------------------------------------------------------------
+ctkDICOMRetrieveWorker::ctkDICOMRetrieveWorker(ctkDICOMRetrieveSchedulerPrivate* scheduler,
+                                               const QString& serverNode)
+  : Scheduler(scheduler)
+  , ServerNode(serverNode)
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMRetrieve* ctkDICOMRetrieveWorker::createRetrieve()const
+{
+  ctkDICOMRetrieve* retrieve = new ctkDICOMRetrieve;
+  retrieve->setKeepAssociationOpen(true);
+  // The database is not thread-safe: the data sets are written to the spool
+  // directory and inserted from the thread of the database.
+  {
+  QMutexLocker locker(&this->Scheduler->Mutex);
+  retrieve->setStorageDirectory(this->Scheduler->SpoolDirectory);
+  }
+  // blocks the worker while the queue is full
+  QObject::connect(retrieve, SIGNAL(instanceStored(QString)),
+                   &this->Scheduler->WriteBehindQueue, SLOT(enqueueSpooledFile(QString)),
+                   Qt::DirectConnection);
+  QObject::connect(retrieve, SIGNAL(progress(QString)),
+                   this->Scheduler, SLOT(onProgress(QString)),
+                   Qt::QueuedConnection);
+  this->Scheduler->addActiveRetrieve(retrieve);
+  return retrieve;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveWorker::run()
+{
+  QScopedPointer<ctkDICOMRetrieve> retrieve;
+  ctkDICOMRetrieveRequest request;
+  QMap<QString, QVariant> parameters;
+  while (this->Scheduler->takeRequest(this->ServerNode, request, parameters))
+    {
+    if (!retrieve)
+      {
+      retrieve.reset(this->createRetrieve());
+      }
+    // the setters only reset the association if a parameter changed
+    retrieve->setCallingAETitle(parameters["CallingAETitle"].toString());
+    retrieve->setCalledAETitle(parameters["AETitle"].toString());
+    retrieve->setHost(parameters["Address"].toString());
+    retrieve->setPort(parameters["Port"].toInt());
+    retrieve->setMoveDestinationAETitle(parameters["StorageAETitle"].toString());
+
+    bool cget = parameters["CGET"].toBool();
+    bool success = false;
+    if (request.SeriesInstanceUID.isEmpty())
+      {
+      success = cget ? retrieve->getStudy(request.StudyInstanceUID)
+                     : retrieve->moveStudy(request.StudyInstanceUID);
+      }
+    else
+      {
+      success = cget ? retrieve->getSeries(request.StudyInstanceUID, request.SeriesInstanceUID)
+                     : retrieve->moveSeries(request.StudyInstanceUID, request.SeriesInstanceUID);
+      }
+    bool canceled = retrieve->wasCanceled();
+    success = success && !canceled && retrieve->failedSubOperations() == 0;
+    this->Scheduler->requestDone(request, success, canceled);
+    if (!success)
+      {
+      // the association may be unusable, use a new one for the next request
+      this->Scheduler->removeActiveRetrieve(retrieve.data());
+      retrieve.reset();
+      }
+    }
+  if (retrieve)
+    {
+    this->Scheduler->removeActiveRetrieve(retrieve.data());
+    }
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMRetrieveSchedulerPrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMRetrieveSchedulerPrivate::ctkDICOMRetrieveSchedulerPrivate(ctkDICOMRetrieveScheduler& obj)
+  : q_ptr(&obj)
+{
+  this->SpoolDirectory = QDir::temp().filePath("ctkDICOMRetrieveScheduler");
+  this->MaximumRetries = 2;
+  this->Canceled = false;
+  this->RequestCount = 0;
+  this->CompletedRequestCount = 0;
+  this->FailedRequestCount = 0;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMRetrieveSchedulerPrivate::~ctkDICOMRetrieveSchedulerPrivate()
+{
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieveSchedulerPrivate::enqueue(const ctkDICOMRetrieveRequest& request)
+{
+  QMutexLocker locker(&this->Mutex);
+  if (!this->Nodes.contains(request.ServerNode))
+    {
+    logger.error("Cannot retrieve from unknown server node " + request.ServerNode);
+    return false;
+    }
+  if (this->CompletedRequestCount + this->FailedRequestCount == this->RequestCount)
+    {
+    // the scheduler is idle, start counting again
+    this->RequestCount = 0;
+    this->CompletedRequestCount = 0;
+    this->FailedRequestCount = 0;
+    QDir().mkpath(this->SpoolDirectory);
+    }
+  this->Canceled = false;
+  ++this->RequestCount;
+
+  ctkDICOMRetrieveServerNode& node = this->Nodes[request.ServerNode];
+  node.Queue.append(request);
+  if (node.ActiveAssociations < node.MaximumAssociations)
+    {
+    ++node.ActiveAssociations;
+    this->ThreadPool.start(new ctkDICOMRetrieveWorker(this, request.ServerNode));
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieveSchedulerPrivate::takeRequest(const QString& serverNode,
+                                                   ctkDICOMRetrieveRequest& request,
+                                                   QMap<QString, QVariant>& parameters)
+{
+  QMutexLocker locker(&this->Mutex);
+  ctkDICOMRetrieveServerNode& node = this->Nodes[serverNode];
+  if (this->Canceled || node.Queue.isEmpty() ||
+      node.ActiveAssociations > node.MaximumAssociations)
+    {
+    --node.ActiveAssociations;
+    return false;
+    }
+  request = node.Queue.takeFirst();
+  ++request.Attempts;
+  parameters = node.Parameters;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveSchedulerPrivate::requestDone(const ctkDICOMRetrieveRequest& request,
+                                                   bool success, bool canceled)
+{
+  if (!success && !canceled)
+    {
+    QMutexLocker locker(&this->Mutex);
+    if (!this->Canceled && request.Attempts <= this->MaximumRetries)
+      {
+      logger.warn(QString("Retrieving study %1 %2 from %3 failed, trying again")
+                  .arg(request.StudyInstanceUID).arg(request.SeriesInstanceUID)
+                  .arg(request.ServerNode));
+      // at the end of the queue, a transient failure is less likely to
+      // fail the request again right away
+      this->Nodes[request.ServerNode].Queue.append(request);
+      return;
+      }
+    }
+  QMetaObject::invokeMethod(this, "onRequestFinished", Qt::QueuedConnection,
+                            Q_ARG(QString, request.ServerNode),
+                            Q_ARG(QString, request.StudyInstanceUID),
+                            Q_ARG(QString, request.SeriesInstanceUID),
+                            Q_ARG(bool, success));
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveSchedulerPrivate::addActiveRetrieve(ctkDICOMRetrieve* retrieve)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->ActiveRetrieves.insert(retrieve);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveSchedulerPrivate::removeActiveRetrieve(ctkDICOMRetrieve* retrieve)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->ActiveRetrieves.remove(retrieve);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveSchedulerPrivate::onRequestFinished(const QString& serverNode,
+                                                         const QString& studyInstanceUID,
+                                                         const QString& seriesInstanceUID,
+                                                         bool success)
+{
+  Q_Q(ctkDICOMRetrieveScheduler);
+  if (success)
+    {
+    ++this->CompletedRequestCount;
+    }
+  else
+    {
+    logger.error(QString("Retrieving study %1 %2 from %3 failed")
+                 .arg(studyInstanceUID).arg(seriesInstanceUID).arg(serverNode));
+    ++this->FailedRequestCount;
+    }
+  emit q->requestFinished(serverNode, studyInstanceUID, seriesInstanceUID, success);
+
+  int done = this->CompletedRequestCount + this->FailedRequestCount;
+  emit q->progress(this->RequestCount ? 100 * done / this->RequestCount : 100);
+  if (done >= this->RequestCount)
+    {
+    emit q->finished();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveSchedulerPrivate::onProgress(const QString& message)
+{
+  Q_Q(ctkDICOMRetrieveScheduler);
+  emit q->progress(message);
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMRetrieveScheduler methods
+
+//------------------------------------------------------------------------------
+ctkDICOMRetrieveScheduler::ctkDICOMRetrieveScheduler(QObject* parentObject)
+  : QObject(parentObject)
+  , d_ptr(new ctkDICOMRetrieveSchedulerPrivate(*this))
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMRetrieveScheduler::~ctkDICOMRetrieveScheduler()
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  this->cancel();
+  // the workers must not wait for this thread to insert their files
+  d->WriteBehindQueue.setMaximumPendingCount(INT_MAX);
+  d->ThreadPool.waitForDone();
+  d->WriteBehindQueue.flush();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveScheduler::setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  d->Database = dicomDatabase;
+  d->WriteBehindQueue.setDatabase(dicomDatabase);
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMDatabase> ctkDICOMRetrieveScheduler::database()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  return d->Database;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveScheduler::addServerNode(const QString& name,
+                                              const QMap<QString, QVariant>& parameters,
+                                              int maximumAssociations)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  ctkDICOMRetrieveServerNode& node = d->Nodes[name];
+  node.Parameters = parameters;
+  node.MaximumAssociations = qMax(1, maximumAssociations);
+
+  int threadCount = 0;
+  foreach(const ctkDICOMRetrieveServerNode& serverNode, d->Nodes)
+    {
+    threadCount += serverNode.MaximumAssociations;
+    }
+  d->ThreadPool.setMaxThreadCount(threadCount);
+}
+
+//------------------------------------------------------------------------------
+QStringList ctkDICOMRetrieveScheduler::serverNodes()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  return d->Nodes.keys();
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieveScheduler::maximumAssociations(const QString& serverNode)const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  return d->Nodes.value(serverNode).MaximumAssociations;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveScheduler::setMaximumRetries(int retries)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  d->MaximumRetries = qMax(0, retries);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieveScheduler::maximumRetries()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  return d->MaximumRetries;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveScheduler::setSpoolDirectory(const QString& directory)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  d->SpoolDirectory = directory;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMRetrieveScheduler::spoolDirectory()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  QMutexLocker locker(&d->Mutex);
+  return d->SpoolDirectory;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieveScheduler::requestCount()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  return d->RequestCount;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieveScheduler::completedRequestCount()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  return d->CompletedRequestCount;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieveScheduler::failedRequestCount()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  return d->FailedRequestCount;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieveScheduler::isRunning()const
+{
+  Q_D(const ctkDICOMRetrieveScheduler);
+  return d->CompletedRequestCount + d->FailedRequestCount < d->RequestCount;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieveScheduler::waitForFinished(int msecs)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  QTime time;
+  time.start();
+  if (this->isRunning())
+    {
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(this, SIGNAL(finished()), &loop, SLOT(quit()));
+    QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    if (msecs >= 0)
+      {
+      timer.start(msecs);
+      }
+    loop.exec();
+    if (this->isRunning())
+      {
+      return false;
+      }
+    }
+  // the data sets received last may not be inserted yet
+  return d->WriteBehindQueue.flush(msecs < 0 ? -1 : qMax(msecs - time.elapsed(), 0));
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieveScheduler::retrieveStudy(const QString& serverNode,
+                                              const QString& studyInstanceUID)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  if (studyInstanceUID.isEmpty())
+    {
+    logger.error("Cannot retrieve study: Study Instance UID empty.");
+    return false;
+    }
+  ctkDICOMRetrieveRequest request;
+  request.ServerNode = serverNode;
+  request.StudyInstanceUID = studyInstanceUID;
+  return d->enqueue(request);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMRetrieveScheduler::retrieveSeries(const QString& serverNode,
+                                               const QString& studyInstanceUID,
+                                               const QString& seriesInstanceUID)
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  if (studyInstanceUID.isEmpty() || seriesInstanceUID.isEmpty())
+    {
+    logger.error("Cannot retrieve series: Either Study or Series Instance UID empty.");
+    return false;
+    }
+  ctkDICOMRetrieveRequest request;
+  request.ServerNode = serverNode;
+  request.StudyInstanceUID = studyInstanceUID;
+  request.SeriesInstanceUID = seriesInstanceUID;
+  return d->enqueue(request);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieveScheduler::cancel()
+{
+  Q_D(ctkDICOMRetrieveScheduler);
+  int dropped = 0;
+  {
+  QMutexLocker locker(&d->Mutex);
+  d->Canceled = true;
+  QMap<QString, ctkDICOMRetrieveServerNode>::iterator it;
+  for (it = d->Nodes.begin(); it != d->Nodes.end(); ++it)
+    {
+    dropped += it->Queue.count();
+    it->Queue.clear();
+    }
+  foreach(ctkDICOMRetrieve* retrieve, d->ActiveRetrieves)
+    {
+    retrieve->cancel();
+    }
+  }
+  if (dropped == 0)
+    {
+    return;
+    }
+  // the dropped requests are not reported by requestFinished()
+  d->RequestCount -= dropped;
+  if (!this->isRunning())
+    {
+    emit this->progress(100);
+    emit this->finished();
+    }
+}
@@ -0,0 +1,140 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMRetrieveScheduler_h
+#define __ctkDICOMRetrieveScheduler_h
+
+// Qt includes
+#include <QMap>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVariant>
+
+#include "ctkDICOMCoreExport.h"
+
+// CTK Core includes
+#include "ctkDICOMDatabase.h"
+
+class ctkDICOMRetrieveSchedulerPrivate;
+
+/// \ingroup DICOM_Core
+///
+/// \brief Retrieve studies and series from several PACS nodes over
+/// parallel associations.
+///
+/// Requests are queued per server node and served by up to
+/// maximumAssociations() worker threads per node, each of them driving its
+/// own association with a ctkDICOMRetrieve. A request that fails, or for
+/// which the server reports failed sub-operations, is queued again until
+/// it has been tried maximumRetries() + 1 times.
+///
+/// Data sets received via C-GET are written to the spool directory by the
+/// workers and inserted into the database by a ctkDICOMWriteBehindQueue,
+/// from the thread of the database, so the database is never accessed from
+/// the worker threads. The spooled files are removed once inserted. The
+/// database thread must therefore run an event loop (see waitForFinished()).
+class CTK_DICOM_CORE_EXPORT ctkDICOMRetrieveScheduler : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(int maximumRetries READ maximumRetries WRITE setMaximumRetries)
+  Q_PROPERTY(QString spoolDirectory READ spoolDirectory WRITE setSpoolDirectory)
+  Q_PROPERTY(int requestCount READ requestCount)
+  Q_PROPERTY(int completedRequestCount READ completedRequestCount)
+  Q_PROPERTY(int failedRequestCount READ failedRequestCount)
+
+public:
+  explicit ctkDICOMRetrieveScheduler(QObject* parent = 0);
+  virtual ~ctkDICOMRetrieveScheduler();
+
+  /// where to insert the data sets obtained via get
+  void setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase);
+  Q_INVOKABLE QSharedPointer<ctkDICOMDatabase> database()const;
+
+  ///
+  /// Register the server node \a name. The parameters use the keys of
+  /// ctkDICOMServerNodeWidget: "CallingAETitle", "AETitle", "Address",
+  /// "Port", "StorageAETitle" (the move destination) and "CGET" (retrieve
+  /// with C-GET instead of C-MOVE).
+  /// At most \a maximumAssociations requests are served in parallel for
+  /// this node. Registering an existing node updates its parameters, they
+  /// are used by the associations opened afterwards.
+  Q_INVOKABLE void addServerNode(const QString& name,
+                                 const QMap<QString, QVariant>& parameters,
+                                 int maximumAssociations = 4);
+  Q_INVOKABLE QStringList serverNodes()const;
+  Q_INVOKABLE int maximumAssociations(const QString& serverNode)const;
+
+  /// Number of times a failed request is tried again (default 2)
+  void setMaximumRetries(int retries);
+  int maximumRetries()const;
+
+  /// Directory where the workers write the data sets received via get
+  /// before they are inserted into the database. Default is
+  /// "ctkDICOMRetrieveScheduler" in the temporary directory.
+  void setSpoolDirectory(const QString& directory);
+  QString spoolDirectory()const;
+
+  /// Number of requests queued since the last time the scheduler was idle
+  int requestCount()const;
+  /// Number of those requests that succeeded
+  int completedRequestCount()const;
+  /// Number of those requests that failed after all their retries
+  int failedRequestCount()const;
+  /// Returns true while requests are queued or being retrieved
+  Q_INVOKABLE bool isRunning()const;
+
+  /// Block until all the queued requests are finished, while processing
+  /// the events of the calling thread. Returns false if \a msecs elapsed
+  /// first. A negative value waits without timeout.
+  Q_INVOKABLE bool waitForFinished(int msecs = -1);
+
+public Q_SLOTS:
+  /// Queue the retrieval of a study from \a serverNode. Returns false if
+  /// the node is unknown.
+  bool retrieveStudy(const QString& serverNode, const QString& studyInstanceUID);
+  /// Queue the retrieval of a series from \a serverNode. Returns false if
+  /// the node is unknown.
+  bool retrieveSeries(const QString& serverNode, const QString& studyInstanceUID,
+                      const QString& seriesInstanceUID);
+  /// Drop the queued requests and cancel the running ones
+  void cancel();
+
+Q_SIGNALS:
+  /// Aggregate progress of the queued requests, from 0 to 100
+  void progress(int progress);
+  /// Progress messages of the running requests
+  void progress(const QString& message);
+  /// Emitted when a request is done, after its retries if it failed.
+  /// \a seriesInstanceUID is empty for study requests.
+  void requestFinished(const QString& serverNode, const QString& studyInstanceUID,
+                       const QString& seriesInstanceUID, bool success);
+  /// Emitted when there is no request left to process
+  void finished();
+
+protected:
+  QScopedPointer<ctkDICOMRetrieveSchedulerPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMRetrieveScheduler);
+  Q_DISABLE_COPY(ctkDICOMRetrieveScheduler);
+};
+
+#endif
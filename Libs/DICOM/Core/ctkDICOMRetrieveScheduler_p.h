@@ -0,0 +1,129 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMRetrieveScheduler_p_h
+#define __ctkDICOMRetrieveScheduler_p_h
+
+// Qt includes
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+// ctkDICOMCore includes
+#include "ctkDICOMRetrieveScheduler.h"
+#include "ctkDICOMWriteBehindQueue.h"
+
+class ctkDICOMRetrieve;
+
+//------------------------------------------------------------------------------
+/// \internal
+struct ctkDICOMRetrieveRequest
+{
+  ctkDICOMRetrieveRequest() : Attempts(0) {}
+  QString ServerNode;
+  QString StudyInstanceUID;
+  QString SeriesInstanceUID;
+  int     Attempts;
+};
+
+//------------------------------------------------------------------------------
+/// \internal
+struct ctkDICOMRetrieveServerNode
+{
+  ctkDICOMRetrieveServerNode() : MaximumAssociations(1), ActiveAssociations(0) {}
+  QMap<QString, QVariant>        Parameters;
+  int                            MaximumAssociations;
+  int                            ActiveAssociations;
+  QList<ctkDICOMRetrieveRequest> Queue;
+};
+
+//------------------------------------------------------------------------------
+/// \internal
+/// Drives one association to a server node: it takes the requests of its
+/// node from the shared queue until the queue is empty.
+class ctkDICOMRetrieveWorker : public QRunnable
+{
+public:
+  ctkDICOMRetrieveWorker(ctkDICOMRetrieveSchedulerPrivate* scheduler,
+                         const QString& serverNode);
+  virtual void run();
+
+protected:
+  ctkDICOMRetrieve* createRetrieve()const;
+
+  ctkDICOMRetrieveSchedulerPrivate* Scheduler;
+  QString ServerNode;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMRetrieveSchedulerPrivate : public QObject
+{
+  Q_OBJECT
+  Q_DECLARE_PUBLIC(ctkDICOMRetrieveScheduler);
+protected:
+  ctkDICOMRetrieveScheduler* const q_ptr;
+
+public:
+  ctkDICOMRetrieveSchedulerPrivate(ctkDICOMRetrieveScheduler& obj);
+  virtual ~ctkDICOMRetrieveSchedulerPrivate();
+
+  /// Queue \a request and start a worker for its node if the node has
+  /// fewer associations than allowed. Must be called with Mutex unlocked.
+  bool enqueue(const ctkDICOMRetrieveRequest& request);
+
+  /// Called from the workers, thread-safe
+  bool takeRequest(const QString& serverNode, ctkDICOMRetrieveRequest& request,
+                   QMap<QString, QVariant>& parameters);
+  /// Queue \a request again unless it succeeded, was canceled or has no
+  /// retry left, otherwise report it to the scheduler thread.
+  void requestDone(const ctkDICOMRetrieveRequest& request, bool success, bool canceled);
+  void addActiveRetrieve(ctkDICOMRetrieve* retrieve);
+  void removeActiveRetrieve(ctkDICOMRetrieve* retrieve);
+
+  QSharedPointer<ctkDICOMDatabase> Database;
+  /// inserts the spooled files from the thread of the database
+  ctkDICOMWriteBehindQueue WriteBehindQueue;
+  QString SpoolDirectory;
+  int     MaximumRetries;
+
+  /// protects Nodes, ActiveRetrieves and Canceled
+  mutable QMutex Mutex;
+  QMap<QString, ctkDICOMRetrieveServerNode> Nodes;
+  QSet<ctkDICOMRetrieve*> ActiveRetrieves;
+  bool Canceled;
+
+  /// only accessed from the scheduler thread
+  int RequestCount;
+  int CompletedRequestCount;
+  int FailedRequestCount;
+
+  QThreadPool ThreadPool;
+
+public Q_SLOTS:
+  void onRequestFinished(const QString& serverNode, const QString& studyInstanceUID,
+                         const QString& seriesInstanceUID, bool success);
+  void onProgress(const QString& message);
+};
+
+#endif
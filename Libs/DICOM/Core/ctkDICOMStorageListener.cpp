@@ -0,0 +1,642 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTime>
+#include <QWaitCondition>
+
+// ctkDICOMCore includes
+#include "ctkDICOMStorageListener.h"
+#include "ctkDICOMWriteBehindQueue.h"
+#include "ctkLogger.h"
+
+// DCMTK includes
+#include <dcmtk/dcmnet/assoc.h>
+#include <dcmtk/dcmnet/dimse.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/ofstd/ofcond.h>
+
+static ctkLogger logger("org.commontk.dicom.DICOMStorageListener");
+
+class ctkDICOMStorageListenerPrivate;
+
+//------------------------------------------------------------------------------
+// Accepts the associations and hands them to the association threads
+class ctkDICOMStorageListenerThread : public QThread
+{
+public:
+  ctkDICOMStorageListenerThread(ctkDICOMStorageListenerPrivate* listener)
+    : Listener(listener) {}
+protected:
+  virtual void run();
+  ctkDICOMStorageListenerPrivate* Listener;
+};
+
+//------------------------------------------------------------------------------
+// Serves one association
+class ctkDICOMStorageAssociation : public QRunnable
+{
+public:
+  ctkDICOMStorageAssociation(ctkDICOMStorageListenerPrivate* listener,
+                             T_ASC_Association* association)
+    : Listener(listener), Association(association) {}
+  virtual void run();
+protected:
+  bool negotiate();
+  /// Stream the object of \a request into a temporary file of the
+  /// storage directory, renamed after its SOP instance UID once complete.
+  /// Objects with a malformed UID are answered with a failure status.
+  void store(T_ASC_PresentationContextID presentationContext,
+             T_DIMSE_C_StoreRQ* request);
+
+  ctkDICOMStorageListenerPrivate* Listener;
+  T_ASC_Association*              Association;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMStorageListenerPrivate
+{
+  Q_DECLARE_PUBLIC(ctkDICOMStorageListener);
+protected:
+  ctkDICOMStorageListener* const q_ptr;
+
+public:
+  ctkDICOMStorageListenerPrivate(ctkDICOMStorageListener& obj);
+
+  /// Called from the association threads, thread-safe
+  void associationAccepted(const QString& callingAETitle);
+  void objectStored(const QString& filePath, qint64 bytes);
+  void associationFinished();
+
+  QSharedPointer<ctkDICOMDatabase> Database;
+  ctkDICOMWriteBehindQueue WriteBehindQueue;
+
+  QString AETitle;
+  int     Port;
+  int     MaximumAssociations;
+  QString StorageDirectory;
+
+  T_ASC_Network*                 Network;
+  ctkDICOMStorageListenerThread* ListenerThread;
+  QThreadPool                    AssociationPool;
+  /// set to stop the listening and association threads
+  QAtomicInt                     Stopping;
+  /// makes the names of the files being received unique
+  QAtomicInt                     TemporaryFileCount;
+
+  /// protects the counters and ActiveAssociations
+  mutable QMutex Mutex;
+  int            ActiveAssociations;
+  /// woken up when an association ends
+  QWaitCondition AssociationFinished;
+  qint64         ObjectCount;
+  qint64         ByteCount;
+  QTime          CountersTime;
+};
+
+//------------------------------------------------------------------------------
+// ctkDICOMStorageListenerThread methods
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListenerThread::run()
+{
+  while (this->Listener->Stopping == 0)
+    {
+    T_ASC_Association* association = 0;
+    // wake up every second to check whether the listener is stopped
+    OFCondition cond = ASC_receiveAssociation(this->Listener->Network, &association,
+                                              ASC_DEFAULTMAXPDU, NULL, NULL, OFFalse,
+                                              DUL_NOBLOCK, 1);
+    if (cond == DUL_NOASSOCIATIONREQUEST)
+      {
+      continue;
+      }
+    if (cond.bad())
+      {
+      logger.error(QString("Receiving association failed: ") + cond.text());
+      if (association)
+        {
+        ASC_dropAssociation(association);
+        ASC_destroyAssociation(&association);
+        }
+      continue;
+      }
+
+    bool accept = false;
+    {
+    QMutexLocker locker(&this->Listener->Mutex);
+    if (this->Listener->ActiveAssociations < this->Listener->MaximumAssociations)
+      {
+      ++this->Listener->ActiveAssociations;
+      accept = true;
+      }
+    }
+    if (!accept)
+      {
+      logger.warn("Too many associations, rejecting association");
+      T_ASC_RejectParameters rejection =
+        {
+        ASC_RESULT_REJECTEDTRANSIENT,
+        ASC_SOURCE_SERVICEPROVIDER_PRESENTATION_RELATED,
+        ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED
+        };
+      ASC_rejectAssociation(association, &rejection);
+      ASC_dropAssociation(association);
+      ASC_destroyAssociation(&association);
+      continue;
+      }
+    this->Listener->AssociationPool.start(
+      new ctkDICOMStorageAssociation(this->Listener, association));
+    }
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMStorageAssociation methods
+
+namespace
+{
+struct StoreProgressData
+{
+  qint64 Bytes;
+  bool   Reject;
+};
+
+//------------------------------------------------------------------------------
+// Records the size of the received object and fails the rejected ones
+void storeProgress(void* callbackData, T_DIMSE_StoreProgress* progress,
+                   T_DIMSE_C_StoreRQ* /*request*/, char* /*imageFileName*/,
+                   DcmDataset** /*imageDataSet*/, T_DIMSE_C_StoreRSP* response,
+                   DcmDataset** /*statusDetail*/)
+{
+  if (progress->state == DIMSE_StoreEnd)
+    {
+    StoreProgressData* data = static_cast<StoreProgressData*>(callbackData);
+    data->Bytes = progress->progressBytes;
+    if (data->Reject)
+      {
+      response->DimseStatus = STATUS_STORE_Error_CannotUnderstand;
+      }
+    }
+}
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMStorageAssociation::negotiate()
+{
+  const char* transferSyntaxes[] =
+    {
+    UID_LittleEndianExplicitTransferSyntax,
+    UID_BigEndianExplicitTransferSyntax,
+    UID_LittleEndianImplicitTransferSyntax,
+    UID_JPEGProcess14SV1TransferSyntax,
+    UID_JPEGProcess1TransferSyntax,
+    UID_JPEGProcess2_4TransferSyntax,
+    UID_JPEG2000LosslessOnlyTransferSyntax,
+    UID_JPEG2000TransferSyntax,
+    UID_RLELosslessTransferSyntax,
+    UID_DeflatedExplicitVRLittleEndianTransferSyntax
+    };
+  int transferSyntaxCount = sizeof(transferSyntaxes) / sizeof(transferSyntaxes[0]);
+  const char* verification[] = { UID_VerificationSOPClass };
+
+  OFCondition cond = ASC_acceptContextsWithPreferredTransferSyntaxes(
+    this->Association->params, verification, 1, transferSyntaxes, transferSyntaxCount);
+  if (cond.good())
+    {
+    cond = ASC_acceptContextsWithPreferredTransferSyntaxes(
+      this->Association->params, dcmAllStorageSOPClassUIDs, numberOfAllDcmStorageSOPClassUIDs,
+      transferSyntaxes, transferSyntaxCount);
+    }
+  if (cond.good())
+    {
+    cond = ASC_setAPTitles(this->Association->params, NULL, NULL,
+                           this->Listener->AETitle.toLatin1().constData());
+    }
+  if (cond.good())
+    {
+    cond = ASC_acknowledgeAssociation(this->Association);
+    }
+  if (cond.bad())
+    {
+    logger.error(QString("Accepting association failed: ") + cond.text());
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageAssociation::run()
+{
+  if (this->negotiate())
+    {
+    this->Listener->associationAccepted(
+      QString(this->Association->params->DULparams.callingAPTitle));
+
+    bool aborted = false;
+    while (!aborted)
+      {
+      T_DIMSE_Message message;
+      T_ASC_PresentationContextID presentationContext;
+      OFCondition cond = DIMSE_receiveCommand(this->Association, DIMSE_NONBLOCKING, 1,
+                                              &presentationContext, &message, NULL);
+      if (cond == DIMSE_NODATAAVAILABLE)
+        {
+        if (this->Listener->Stopping != 0)
+          {
+          ASC_abortAssociation(this->Association);
+          aborted = true;
+          }
+        continue;
+        }
+      if (cond == DUL_PEERREQUESTEDRELEASE)
+        {
+        ASC_acknowledgeRelease(this->Association);
+        break;
+        }
+      if (cond.bad())
+        {
+        if (cond != DUL_PEERABORTEDASSOCIATION)
+          {
+          logger.error(QString("Receiving command failed: ") + cond.text());
+          ASC_abortAssociation(this->Association);
+          }
+        break;
+        }
+      switch (message.CommandField)
+        {
+        case DIMSE_C_ECHO_RQ:
+          DIMSE_sendEchoResponse(this->Association, presentationContext,
+                                 &message.msg.CEchoRQ, STATUS_Success, NULL);
+          break;
+        case DIMSE_C_STORE_RQ:
+          this->store(presentationContext, &message.msg.CStoreRQ);
+          break;
+        default:
+          logger.error(QString("Unsupported command 0x%1, aborting association")
+                       .arg(static_cast<unsigned>(message.CommandField), 0, 16));
+          ASC_abortAssociation(this->Association);
+          aborted = true;
+          break;
+        }
+      }
+    }
+  ASC_dropSCPAssociation(this->Association);
+  ASC_destroyAssociation(&this->Association);
+  this->Listener->associationFinished();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageAssociation::store(T_ASC_PresentationContextID presentationContext,
+                                       T_DIMSE_C_StoreRQ* request)
+{
+  QString instanceUID(request->AffectedSOPInstanceUID);
+  QDir storageDirectory(this->Listener->StorageDirectory);
+  // the UID is used as file name, it must not be able to name another file
+  StoreProgressData progressData;
+  progressData.Bytes = 0;
+  progressData.Reject = !QRegExp("[0-9.]{1,64}").exactMatch(instanceUID);
+  QString temporaryFilePath = storageDirectory.filePath(
+    QString(".incoming.%1.%2.tmp")
+    .arg(QCoreApplication::applicationPid())
+    .arg(this->Listener->TemporaryFileCount.fetchAndAddOrdered(1)));
+  // the object is written to the file while it is received
+  OFCondition cond = DIMSE_storeProvider(this->Association, presentationContext, request,
+                                         QDir::toNativeSeparators(temporaryFilePath).toLocal8Bit().constData(),
+                                         OFTrue /* meta header */, NULL,
+                                         storeProgress, &progressData, DIMSE_BLOCKING, 0);
+  if (progressData.Reject)
+    {
+    logger.error("Rejected object with invalid SOP instance UID " + instanceUID);
+    QFile::remove(temporaryFilePath);
+    return;
+    }
+  if (cond.bad())
+    {
+    logger.error("Storing " + instanceUID + " failed: " + cond.text());
+    QFile::remove(temporaryFilePath);
+    return;
+    }
+  // a complete object replaces the one previously received, if any
+  QString filePath = storageDirectory.filePath(instanceUID);
+  QFile::remove(filePath);
+  if (!QFile::rename(temporaryFilePath, filePath))
+    {
+    logger.error("Cannot rename " + temporaryFilePath + " into " + filePath);
+    QFile::remove(temporaryFilePath);
+    return;
+    }
+  this->Listener->objectStored(filePath, progressData.Bytes);
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMStorageListenerPrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMStorageListenerPrivate::ctkDICOMStorageListenerPrivate(ctkDICOMStorageListener& obj)
+  : q_ptr(&obj)
+{
+  this->AETitle = "CTKSTORE";
+  this->Port = 11112;
+  this->MaximumAssociations = 4;
+  this->Network = 0;
+  this->ListenerThread = 0;
+  this->Stopping = 0;
+  this->TemporaryFileCount = 0;
+  this->ActiveAssociations = 0;
+  this->ObjectCount = 0;
+  this->ByteCount = 0;
+  this->CountersTime.start();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListenerPrivate::associationAccepted(const QString& callingAETitle)
+{
+  Q_Q(ctkDICOMStorageListener);
+  emit q->associationAccepted(callingAETitle);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListenerPrivate::objectStored(const QString& filePath, qint64 bytes)
+{
+  Q_Q(ctkDICOMStorageListener);
+  {
+  QMutexLocker locker(&this->Mutex);
+  ++this->ObjectCount;
+  this->ByteCount += bytes;
+  }
+  emit q->objectReceived(filePath);
+  // blocks while too many files wait to be inserted, which slows the
+  // sender down instead of using more memory
+  this->WriteBehindQueue.enqueueFile(filePath);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListenerPrivate::associationFinished()
+{
+  QMutexLocker locker(&this->Mutex);
+  --this->ActiveAssociations;
+  this->AssociationFinished.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMStorageListener methods
+
+//------------------------------------------------------------------------------
+ctkDICOMStorageListener::ctkDICOMStorageListener(QObject* parentObject)
+  : QObject(parentObject)
+  , d_ptr(new ctkDICOMStorageListenerPrivate(*this))
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMStorageListener::~ctkDICOMStorageListener()
+{
+  this->stop();
+  this->flush();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::setDatabase(QSharedPointer<ctkDICOMDatabase> database)
+{
+  Q_D(ctkDICOMStorageListener);
+  d->Database = database;
+  d->WriteBehindQueue.setDatabase(database);
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMDatabase> ctkDICOMStorageListener::database()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  return d->Database;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::setAETitle(const QString& aeTitle)
+{
+  Q_D(ctkDICOMStorageListener);
+  d->AETitle = aeTitle;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMStorageListener::AETitle()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  return d->AETitle;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::setPort(int port)
+{
+  Q_D(ctkDICOMStorageListener);
+  d->Port = port;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMStorageListener::port()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  return d->Port;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::setMaximumAssociations(int associations)
+{
+  Q_D(ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  d->MaximumAssociations = qMax(1, associations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMStorageListener::maximumAssociations()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  return d->MaximumAssociations;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::setMaximumPendingCount(int count)
+{
+  Q_D(ctkDICOMStorageListener);
+  d->WriteBehindQueue.setMaximumPendingCount(count);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMStorageListener::maximumPendingCount()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  return d->WriteBehindQueue.maximumPendingCount();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::setStorageDirectory(const QString& directory)
+{
+  Q_D(ctkDICOMStorageListener);
+  d->StorageDirectory = directory;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMStorageListener::storageDirectory()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  if (d->StorageDirectory.isEmpty() && d->Database)
+    {
+    return QDir(d->Database->databaseDirectory()).filePath("incoming");
+    }
+  return d->StorageDirectory;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMStorageListener::start()
+{
+  Q_D(ctkDICOMStorageListener);
+  if (d->ListenerThread)
+    {
+    return true;
+    }
+  if (!d->Database || d->Database->isInMemory())
+    {
+    logger.error("Cannot listen: a database file must be set");
+    return false;
+    }
+  d->StorageDirectory = this->storageDirectory();
+  if (!QDir().mkpath(d->StorageDirectory))
+    {
+    logger.error("Cannot create storage directory " + d->StorageDirectory);
+    return false;
+    }
+
+  OFCondition cond = ASC_initializeNetwork(NET_ACCEPTOR, d->Port, 30, &d->Network);
+  if (cond.bad())
+    {
+    logger.error(QString("Cannot listen on port %1: %2").arg(d->Port).arg(cond.text()));
+    d->Network = 0;
+    return false;
+    }
+
+  d->AssociationPool.setMaxThreadCount(d->MaximumAssociations);
+  this->resetCounters();
+  d->Stopping = 0;
+  d->ListenerThread = new ctkDICOMStorageListenerThread(d);
+  d->ListenerThread->start();
+  logger.info(QString("Listening on port %1 as %2").arg(d->Port).arg(d->AETitle));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::stop()
+{
+  Q_D(ctkDICOMStorageListener);
+  if (!d->ListenerThread)
+    {
+    return;
+    }
+  d->Stopping = 1;
+  d->ListenerThread->wait();
+  delete d->ListenerThread;
+  d->ListenerThread = 0;
+  // The associations block while the write-behind queue is full, which
+  // may wait for this thread to insert the files: insert while waiting.
+  {
+  QMutexLocker locker(&d->Mutex);
+  while (d->ActiveAssociations > 0)
+    {
+    locker.unlock();
+    d->WriteBehindQueue.flush(0);
+    locker.relock();
+    if (d->ActiveAssociations > 0)
+      {
+      d->AssociationFinished.wait(&d->Mutex, 100);
+      }
+    }
+  }
+  d->AssociationPool.waitForDone();
+  ASC_dropNetwork(&d->Network);
+  d->Network = 0;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMStorageListener::isListening()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  return d->ListenerThread != 0;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMStorageListener::flush(int msecs)
+{
+  Q_D(ctkDICOMStorageListener);
+  return d->WriteBehindQueue.flush(msecs);
+}
+
+//------------------------------------------------------------------------------
+qint64 ctkDICOMStorageListener::receivedObjectCount()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  return d->ObjectCount;
+}
+
+//------------------------------------------------------------------------------
+qint64 ctkDICOMStorageListener::receivedBytes()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  return d->ByteCount;
+}
+
+//------------------------------------------------------------------------------
+double ctkDICOMStorageListener::objectsPerSecond()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  double seconds = qMax(1, d->CountersTime.elapsed()) / 1000.;
+  return d->ObjectCount / seconds;
+}
+
+//------------------------------------------------------------------------------
+double ctkDICOMStorageListener::megabytesPerSecond()const
+{
+  Q_D(const ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  double seconds = qMax(1, d->CountersTime.elapsed()) / 1000.;
+  return d->ByteCount / (1024. * 1024.) / seconds;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMStorageListener::resetCounters()
+{
+  Q_D(ctkDICOMStorageListener);
+  QMutexLocker locker(&d->Mutex);
+  d->ObjectCount = 0;
+  d->ByteCount = 0;
+  d->CountersTime.restart();
+}
@@ -0,0 +1,130 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMStorageListener_h
+#define __ctkDICOMStorageListener_h
+
+// Qt includes
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+#include "ctkDICOMCoreExport.h"
+
+// CTK Core includes
+#include "ctkDICOMDatabase.h"
+
+class ctkDICOMStorageListenerPrivate;
+
+/// \ingroup DICOM_Core
+///
+/// \brief In-process Storage SCP that inserts the received objects into a
+/// database.
+///
+/// start() listens on port() for associations. Each association is
+/// served by a thread of a pool of maximumAssociations() threads; the
+/// associations coming while all the threads are busy are rejected. The
+/// objects of C-STORE requests are streamed into temporary files of the
+/// storage directory as they are received, without being loaded in
+/// memory, then renamed after their SOP instance UID; the requests whose
+/// UID is not made of 1 to 64 digits and dots are answered with a
+/// failure status. The files are inserted into the database in batches by a
+/// ctkDICOMWriteBehindQueue. C-ECHO requests are answered as well.
+///
+/// The files are inserted through another connection to the database
+/// file: in-memory databases are not supported.
+class CTK_DICOM_CORE_EXPORT ctkDICOMStorageListener : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(QString AETitle READ AETitle WRITE setAETitle)
+  Q_PROPERTY(int port READ port WRITE setPort)
+  Q_PROPERTY(int maximumAssociations READ maximumAssociations WRITE setMaximumAssociations)
+  Q_PROPERTY(int maximumPendingCount READ maximumPendingCount WRITE setMaximumPendingCount)
+  Q_PROPERTY(QString storageDirectory READ storageDirectory WRITE setStorageDirectory)
+  Q_PROPERTY(bool listening READ isListening)
+
+public:
+  explicit ctkDICOMStorageListener(QObject* parent = 0);
+  /// Stops listening and inserts the pending files
+  virtual ~ctkDICOMStorageListener();
+
+  /// Database the received objects are inserted into
+  void setDatabase(QSharedPointer<ctkDICOMDatabase> database);
+  QSharedPointer<ctkDICOMDatabase> database()const;
+
+  /// AE title used to respond to the associations ("CTKSTORE" by default)
+  void setAETitle(const QString& aeTitle);
+  QString AETitle()const;
+  /// [0, 65535] port to listen on (11112 by default)
+  void setPort(int port);
+  int port()const;
+  /// Number of associations served in parallel (4 by default)
+  void setMaximumAssociations(int associations);
+  int maximumAssociations()const;
+  /// Number of received files waiting to be inserted beyond which the
+  /// associations wait (256 by default)
+  /// \sa ctkDICOMWriteBehindQueue::setMaximumPendingCount()
+  void setMaximumPendingCount(int count);
+  int maximumPendingCount()const;
+  /// Directory the received objects are written to, they are inserted
+  /// into the database where they are. By default, "incoming" in the
+  /// database directory.
+  void setStorageDirectory(const QString& directory);
+  QString storageDirectory()const;
+
+  /// Start listening. Returns false if the port cannot be opened or if no
+  /// database file is set. The properties must not be changed while
+  /// listening.
+  Q_INVOKABLE bool start();
+  /// Stop accepting associations and wait for the running ones to end,
+  /// inserting the received files meanwhile when called from the thread of
+  /// the database. The received files may still be waiting to be inserted,
+  /// see flush().
+  Q_INVOKABLE void stop();
+  bool isListening()const;
+
+  /// Block until the received files are inserted into the database.
+  /// Returns false if \a msecs elapsed first, a negative value waits
+  /// without timeout.
+  Q_INVOKABLE bool flush(int msecs = -1);
+
+  /// Throughput counters, since start() or resetCounters()
+  qint64 receivedObjectCount()const;
+  qint64 receivedBytes()const;
+  double objectsPerSecond()const;
+  double megabytesPerSecond()const;
+  Q_INVOKABLE void resetCounters();
+
+Q_SIGNALS:
+  /// Emitted from the association threads when an object has been
+  /// written to \a filePath, before it is inserted into the database
+  void objectReceived(const QString& filePath);
+  /// Emitted from the association threads for each accepted association
+  void associationAccepted(const QString& callingAETitle);
+
+protected:
+  QScopedPointer<ctkDICOMStorageListenerPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMStorageListener);
+  Q_DISABLE_COPY(ctkDICOMStorageListener);
+};
+
+#endif
@@ -0,0 +1,404 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTime>
+
+// ctkDICOMCore includes
+#include "ctkDICOMItem.h"
+#include "ctkDICOMWriteBehindQueue.h"
+#include "ctkDICOMWriteBehindQueue_p.h"
+#include "ctkLogger.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/ofstd/ofcond.h>
+#include <dcmtk/ofstd/ofstring.h>
+
+static ctkLogger logger("org.commontk.dicom.DICOMWriteBehindQueue");
+
+//------------------------------------------------------------------------------
+// ctkDICOMWriteBehindInserter methods
+
+//------------------------------------------------------------------------------
+ctkDICOMWriteBehindInserter::ctkDICOMWriteBehindInserter(ctkDICOMWriteBehindQueuePrivate* queue)
+  : Queue(queue)
+{
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindInserter::detach()
+{
+  QMutexLocker locker(&this->Mutex);
+  this->Queue = 0;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindInserter::insertNextBatch()
+{
+  QMutexLocker locker(&this->Mutex);
+  if (this->Queue)
+    {
+    this->Queue->insertNextBatch();
+    }
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMWriteBehindQueuePrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMWriteBehindQueuePrivate::ctkDICOMWriteBehindQueuePrivate(ctkDICOMWriteBehindQueue& obj)
+  : q_ptr(&obj)
+{
+  this->InMemory = false;
+  this->SpoolDirectory = QDir::temp().filePath("ctkDICOMWriteBehindQueue");
+  this->MaximumPendingCount = 256;
+  this->BatchSize = 64;
+  this->InsertingCount = 0;
+  this->InsertPosted = false;
+  this->Inserter = 0;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMWriteBehindQueuePrivate::filePath(DcmDataset* dataset)const
+{
+  OFString studyInstanceUID;
+  OFString seriesInstanceUID;
+  OFString sopInstanceUID;
+  dataset->findAndGetOFString(DCM_StudyInstanceUID, studyInstanceUID);
+  dataset->findAndGetOFString(DCM_SeriesInstanceUID, seriesInstanceUID);
+  dataset->findAndGetOFString(DCM_SOPInstanceUID, sopInstanceUID);
+  if (sopInstanceUID.empty())
+    {
+    return QString();
+    }
+  QMutexLocker locker(&this->Mutex);
+  QDir directory(this->SpoolDirectory);
+  if (!this->InMemory && !studyInstanceUID.empty() && !seriesInstanceUID.empty())
+    {
+    // same layout as the files stored by ctkDICOMDatabase::insert(), so
+    // the file does not need to be copied again
+    directory = QDir(this->DatabaseDirectory + "/dicom/" + studyInstanceUID.c_str() +
+                     "/" + seriesInstanceUID.c_str());
+    }
+  directory.mkpath(".");
+  return directory.filePath(sopInstanceUID.c_str());
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMWriteBehindQueuePrivate::isDatabaseThread()const
+{
+  return this->Database && this->Database->thread() == QThread::currentThread();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueuePrivate::enqueue(const QString& filePath, bool spooled)
+{
+  QMutexLocker locker(&this->Mutex);
+  if (!this->Database)
+    {
+    logger.error("Cannot queue " + filePath + ": no database");
+    return;
+    }
+  this->waitForRoom(locker);
+  this->PendingFiles.enqueue(filePath);
+  if (spooled)
+    {
+    this->SpooledFiles.insert(filePath);
+    }
+  this->postInsert();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueuePrivate::waitForRoom(QMutexLocker& locker)
+{
+  while (this->PendingFiles.count() >= this->MaximumPendingCount)
+    {
+    if (!this->isDatabaseThread())
+      {
+      this->NotFull.wait(locker.mutex());
+      continue;
+      }
+    // nobody else can insert while this thread is waiting
+    locker.unlock();
+    this->insertNextBatch();
+    locker.relock();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueuePrivate::postInsert()
+{
+  if (this->InsertPosted || this->PendingFiles.isEmpty() || !this->Inserter)
+    {
+    return;
+    }
+  this->InsertPosted = true;
+  QMetaObject::invokeMethod(this->Inserter, "insertNextBatch", Qt::QueuedConnection);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMWriteBehindQueuePrivate::insertNextBatch()
+{
+  Q_Q(ctkDICOMWriteBehindQueue);
+  QStringList filePaths;
+  QSet<QString> spooledFiles;
+  QSharedPointer<ctkDICOMDatabase> database;
+  {
+  QMutexLocker locker(&this->Mutex);
+  this->InsertPosted = false;
+  while (!this->PendingFiles.isEmpty() && filePaths.count() < this->BatchSize)
+    {
+    QString filePath = this->PendingFiles.dequeue();
+    if (this->SpooledFiles.remove(filePath))
+      {
+      spooledFiles.insert(filePath);
+      }
+    filePaths << filePath;
+    }
+  this->InsertingCount += filePaths.count();
+  this->NotFull.wakeAll();
+  database = this->Database;
+  }
+  if (filePaths.isEmpty())
+    {
+    return false;
+    }
+
+  database->beginInsertBatch(filePaths.count());
+  foreach(const QString& filePath, filePaths)
+    {
+    if (!spooledFiles.contains(filePath))
+      {
+      // the file already is at its place in the database directory
+      database->insert(filePath, false, true);
+      continue;
+      }
+    if (database->isInMemory())
+      {
+      // like a data set inserted without write-behind, no file is kept
+      ctkDICOMItem dataset;
+      dataset.InitializeFromFileHeader(filePath);
+      database->insert(dataset, false, false);
+      }
+    else
+      {
+      // the database makes its own copy
+      database->insert(filePath, true, true);
+      }
+    QFile::remove(filePath);
+    }
+  database->endInsertBatch();
+
+  {
+  QMutexLocker locker(&this->Mutex);
+  this->InsertingCount -= filePaths.count();
+  if (this->PendingFiles.isEmpty() && this->InsertingCount == 0)
+    {
+    this->Flushed.wakeAll();
+    }
+  // one batch per event, the thread of the database stays responsive
+  this->postInsert();
+  }
+  emit q->filesInserted(filePaths);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMWriteBehindQueue methods
+
+//------------------------------------------------------------------------------
+ctkDICOMWriteBehindQueue::ctkDICOMWriteBehindQueue(QObject* parentObject)
+  : QObject(parentObject)
+  , d_ptr(new ctkDICOMWriteBehindQueuePrivate(*this))
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMWriteBehindQueue::~ctkDICOMWriteBehindQueue()
+{
+  this->setDatabase(QSharedPointer<ctkDICOMDatabase>());
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueue::setDatabase(QSharedPointer<ctkDICOMDatabase> database)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  if (database == d->Database)
+    {
+    return;
+    }
+  this->flush();
+  if (d->Inserter)
+    {
+    d->Inserter->detach();
+    d->Inserter->deleteLater();
+    d->Inserter = 0;
+    }
+  QMutexLocker locker(&d->Mutex);
+  d->Database = database;
+  d->DatabaseDirectory = database ? database->databaseDirectory() : QString();
+  d->InMemory = database && database->isInMemory();
+  if (database)
+    {
+    d->Inserter = new ctkDICOMWriteBehindInserter(d);
+    d->Inserter->moveToThread(database->thread());
+    }
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMDatabase> ctkDICOMWriteBehindQueue::database()const
+{
+  Q_D(const ctkDICOMWriteBehindQueue);
+  return d->Database;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueue::setMaximumPendingCount(int count)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  d->MaximumPendingCount = qMax(1, count);
+  d->NotFull.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMWriteBehindQueue::maximumPendingCount()const
+{
+  Q_D(const ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  return d->MaximumPendingCount;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueue::setBatchSize(int size)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  d->BatchSize = qMax(1, size);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMWriteBehindQueue::batchSize()const
+{
+  Q_D(const ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  return d->BatchSize;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMWriteBehindQueue::pendingCount()const
+{
+  Q_D(const ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  return d->PendingFiles.count() + d->InsertingCount;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueue::setSpoolDirectory(const QString& directory)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  d->SpoolDirectory = directory;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMWriteBehindQueue::spoolDirectory()const
+{
+  Q_D(const ctkDICOMWriteBehindQueue);
+  QMutexLocker locker(&d->Mutex);
+  return d->SpoolDirectory;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMWriteBehindQueue::enqueue(DcmDataset* dataset)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  if (!dataset || !d->Database)
+    {
+    return false;
+    }
+  QString filePath = d->filePath(dataset);
+  if (filePath.isEmpty())
+    {
+    logger.error("Cannot store data set without SOP Instance UID");
+    return false;
+    }
+  DcmFileFormat fileFormat(dataset);
+  OFCondition status = fileFormat.saveFile(qPrintable(QDir::toNativeSeparators(filePath)));
+  if (!status.good())
+    {
+    logger.error("Error saving file: " + filePath + ": " + status.text());
+    return false;
+    }
+  // written to the spool directory if the database does not keep files
+  d->enqueue(filePath, d->InMemory);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueue::enqueueFile(const QString& filePath)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  d->enqueue(filePath, false);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMWriteBehindQueue::enqueueSpooledFile(const QString& filePath)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  d->enqueue(filePath, true);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMWriteBehindQueue::flush(int msecs)
+{
+  Q_D(ctkDICOMWriteBehindQueue);
+  if (d->isDatabaseThread())
+    {
+    while (d->insertNextBatch())
+      {
+      }
+    return true;
+    }
+  QMutexLocker locker(&d->Mutex);
+  QTime time;
+  time.start();
+  while (!d->PendingFiles.isEmpty() || d->InsertingCount > 0)
+    {
+    if (msecs < 0)
+      {
+      d->Flushed.wait(&d->Mutex);
+      continue;
+      }
+    int remaining = msecs - time.elapsed();
+    if (remaining <= 0 || !d->Flushed.wait(&d->Mutex, remaining))
+      {
+      return d->PendingFiles.isEmpty() && d->InsertingCount == 0;
+      }
+    }
+  return true;
+}
@@ -0,0 +1,122 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMWriteBehindQueue_h
+#define __ctkDICOMWriteBehindQueue_h
+
+// Qt includes
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include "ctkDICOMCoreExport.h"
+
+// CTK Core includes
+#include "ctkDICOMDatabase.h"
+
+class DcmDataset;
+class ctkDICOMWriteBehindQueuePrivate;
+
+/// \ingroup DICOM_Core
+///
+/// \brief Insert received data sets into a database in batches.
+///
+/// enqueue() writes a data set to its final location in the database
+/// directory and returns. The files are then inserted through the database
+/// object itself, batchSize() files per transaction, by calls queued to the
+/// thread of the database. The database therefore emits its usual signals
+/// and keeps its caches up to date, and it is never accessed from another
+/// thread than its own. That thread must run an event loop, or call flush().
+///
+/// At most maximumPendingCount() files wait to be inserted. enqueue()
+/// blocks while the queue is full. When it is called from the thread of the
+/// database, it inserts a batch instead. Only file names are queued, the
+/// data sets themselves are not kept in memory.
+///
+/// An in-memory database does not store files: the data sets are written
+/// to spoolDirectory(), inserted from there and the files are removed.
+class CTK_DICOM_CORE_EXPORT ctkDICOMWriteBehindQueue : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(int maximumPendingCount READ maximumPendingCount WRITE setMaximumPendingCount)
+  Q_PROPERTY(int batchSize READ batchSize WRITE setBatchSize)
+  Q_PROPERTY(int pendingCount READ pendingCount)
+  Q_PROPERTY(QString spoolDirectory READ spoolDirectory WRITE setSpoolDirectory)
+
+public:
+  explicit ctkDICOMWriteBehindQueue(QObject* parent = 0);
+  /// Inserts the pending files before returning
+  virtual ~ctkDICOMWriteBehindQueue();
+
+  /// Database to insert the data sets into. The pending files of the
+  /// previous database are inserted first.
+  void setDatabase(QSharedPointer<ctkDICOMDatabase> database);
+  QSharedPointer<ctkDICOMDatabase> database()const;
+
+  /// Maximum number of files waiting to be inserted (default 256)
+  void setMaximumPendingCount(int count);
+  int maximumPendingCount()const;
+
+  /// Number of files inserted in one transaction (default 64)
+  void setBatchSize(int size);
+  int batchSize()const;
+
+  /// Number of files queued and not inserted yet
+  int pendingCount()const;
+
+  /// Directory where enqueue() writes the data sets that the database does
+  /// not store itself. Default is "ctkDICOMWriteBehindQueue" in the
+  /// temporary directory.
+  void setSpoolDirectory(const QString& directory);
+  QString spoolDirectory()const;
+
+  /// Write \a dataset to the database directory and queue it.
+  /// Thread-safe, blocks while the queue is full.
+  /// Returns false if the data set could not be written.
+  bool enqueue(DcmDataset* dataset);
+
+  /// Queue a file that is already on disk, it is inserted where it is.
+  /// Thread-safe, blocks while the queue is full.
+  Q_INVOKABLE void enqueueFile(const QString& filePath);
+
+  /// Block until all the queued files are inserted. Returns false if
+  /// \a msecs elapsed first, a negative value waits without timeout.
+  /// From the thread of the database, the files are inserted right away.
+  Q_INVOKABLE bool flush(int msecs = -1);
+
+public Q_SLOTS:
+  /// Queue a file written to a spool directory, e.g. by a ctkDICOMRetrieve
+  /// storage directory. The database stores its own copy and the file is
+  /// removed once inserted. Thread-safe, blocks while the queue is full.
+  void enqueueSpooledFile(const QString& filePath);
+
+Q_SIGNALS:
+  /// Emitted from the thread of the database after each committed batch
+  void filesInserted(const QStringList& filePaths);
+
+protected:
+  QScopedPointer<ctkDICOMWriteBehindQueuePrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMWriteBehindQueue);
+  Q_DISABLE_COPY(ctkDICOMWriteBehindQueue);
+};
+
+#endif
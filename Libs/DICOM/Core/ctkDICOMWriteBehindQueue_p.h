@@ -0,0 +1,112 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMWriteBehindQueue_p_h
+#define __ctkDICOMWriteBehindQueue_p_h
+
+// Qt includes
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QWaitCondition>
+
+// ctkDICOMCore includes
+#include "ctkDICOMWriteBehindQueue.h"
+
+class DcmDataset;
+class QMutexLocker;
+class ctkDICOMWriteBehindQueuePrivate;
+
+//------------------------------------------------------------------------------
+/// \internal
+/// Lives in the thread of the database and inserts the queued files when
+/// the calls posted by the queue are processed.
+class ctkDICOMWriteBehindInserter : public QObject
+{
+  Q_OBJECT
+public:
+  ctkDICOMWriteBehindInserter(ctkDICOMWriteBehindQueuePrivate* queue);
+
+  /// Called when the queue is deleted: wait for the running batch and
+  /// ignore the calls that are still posted
+  void detach();
+
+public Q_SLOTS:
+  void insertNextBatch();
+
+protected:
+  QMutex Mutex;
+  ctkDICOMWriteBehindQueuePrivate* Queue;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMWriteBehindQueuePrivate
+{
+  Q_DECLARE_PUBLIC(ctkDICOMWriteBehindQueue);
+protected:
+  ctkDICOMWriteBehindQueue* const q_ptr;
+
+public:
+  ctkDICOMWriteBehindQueuePrivate(ctkDICOMWriteBehindQueue& obj);
+
+  /// Where \a dataset is written before being inserted
+  QString filePath(DcmDataset* dataset)const;
+
+  /// Returns true if called from the thread of the database
+  bool isDatabaseThread()const;
+  /// Queue \a filePath, removed after its insert if \a spooled.
+  /// Thread-safe, blocks while the queue is full.
+  void enqueue(const QString& filePath, bool spooled);
+  /// Wait until the queue is not full. From the thread of the database,
+  /// insert a batch instead of waiting.
+  void waitForRoom(QMutexLocker& locker);
+  /// Post an insert to the thread of the database unless one is pending.
+  /// Must be called with Mutex locked.
+  void postInsert();
+
+  /// Insert the next BatchSize queued files, from the thread of the
+  /// database. Returns false if there was none.
+  bool insertNextBatch();
+
+  QSharedPointer<ctkDICOMDatabase> Database;
+  QString DatabaseDirectory;
+  bool    InMemory;
+  QString SpoolDirectory;
+
+  int     MaximumPendingCount;
+  int     BatchSize;
+
+  /// protects the members below
+  mutable QMutex   Mutex;
+  QQueue<QString>  PendingFiles;
+  /// the queued files to remove once inserted
+  QSet<QString>    SpooledFiles;
+  /// files taken from PendingFiles but not committed yet
+  int              InsertingCount;
+  /// an insert is posted to the Inserter and not processed yet
+  bool             InsertPosted;
+  QWaitCondition   NotFull;
+  QWaitCondition   Flushed;
+
+  ctkDICOMWriteBehindInserter* Inserter;
+};
+
+#endif
@@ -263,6 +263,9 @@ ctkDICOMBrowser::ctkDICOMBrowser(QWidget* _parent):Superclass(_parent),
   connect(d->DICOMDatabase.data(), SIGNAL(studyAdded(QString)), this, SLOT(onStudyAdded(QString)));
   connect(d->DICOMDatabase.data(), SIGNAL(seriesAdded(QString)), this, SLOT(onSeriesAdded(QString)));
   connect(d->DICOMDatabase.data(), SIGNAL(instanceAdded(QString)), this, SLOT(onInstanceAdded(QString)));
+  // thumbnails generated after the insert, see ctkDICOMDatabase::asynchronousThumbnails
+  connect(d->DICOMDatabase.data(), SIGNAL(thumbnailReady(QString)),
+          d->ThumbnailsWidget, SLOT(onThumbnailReady(QString)));
 
   // Treeview signals
   connect(d->TreeView, SIGNAL(collapsed(QModelIndex)), this, SLOT(onTreeCollapsed(QModelIndex)));
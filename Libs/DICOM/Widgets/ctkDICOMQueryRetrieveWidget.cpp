@@ -37,6 +37,7 @@
 #include "ctkDICOMModel.h"
 #include "ctkDICOMQuery.h"
 #include "ctkDICOMRetrieve.h"
+#include "ctkDICOMRetrieveScheduler.h"
 
 // ctkDICOMWidgets includes
 #include "ctkDICOMQueryRetrieveWidget.h"
@@ -61,6 +62,8 @@ public:
   QMap<QString, ctkDICOMQuery*>     QueriesByServer;
   QMap<QString, ctkDICOMQuery*>     QueriesByStudyUID;
   QMap<QString, ctkDICOMRetrieve*>  RetrievalsByStudyUID;
+  /// server node of the studies that failed to be retrieved
+  QMap<QString, QString>            FailedRetrievalsByStudyUID;
   ctkDICOMDatabase                  QueryResultDatabase;
   QSharedPointer<ctkDICOMDatabase>  RetrieveDatabase;
   ctkDICOMModel                     Model;
@@ -277,99 +280,92 @@ void ctkDICOMQueryRetrieveWidget::retrieve()
     }
 
   QMap<QString,QVariant> serverParameters = d->ServerNodeWidget->parameters();
-  ctkDICOMRetrieve *retrieve = new ctkDICOMRetrieve;
-  // only start new association if connection parameters change
-  retrieve->setKeepAssociationOpen(true);
-  // pull from GUI
-  retrieve->setMoveDestinationAETitle( serverParameters["StorageAETitle"].toString() );
-
-  // do the rerieval for each selected series
-  // that is selected in the tree view
+  // the studies are retrieved in parallel, over several associations per
+  // server node
+  ctkDICOMRetrieveScheduler scheduler;
+  scheduler.setDatabase( d->RetrieveDatabase );
+
+  // do the retrieval for each study shown to the user
+  // TODO: check the model item to see if it is checked
+  // for now, assume all studies queried and shown to the user will be retrieved
   foreach( QString studyUID, d->QueriesByStudyUID.keys() )
     {
-    if(d->UseProgressDialog)
-      {
-      if (progress.wasCanceled())
-        {
-        break;
-        }
-      progressLabel->setText(QString(tr("Retrieving:\n%1")).arg(studyUID));
-      this->updateRetrieveProgress(0);
-      }
-
     // Get information which server we want to get the study from and prepare request accordingly
     ctkDICOMQuery *query = d->QueriesByStudyUID[studyUID];
-    retrieve->setDatabase( d->RetrieveDatabase );
-    retrieve->setCallingAETitle( query->callingAETitle() );
-    retrieve->setCalledAETitle( query->calledAETitle() );
-    retrieve->setPort( query->port() );
-    retrieve->setHost( query->host() );
-    // TODO: check the model item to see if it is checked
-    // for now, assume all studies queried and shown to the user will be retrieved
-    logger.debug("About to retrieve " + studyUID + " from " + d->QueriesByStudyUID[studyUID]->host());
-    logger.info ( "Starting to retrieve" );
-
-    if(d->UseProgressDialog)
-      {
-      connect(&progress, SIGNAL(canceled()), retrieve, SLOT(cancel()));
-      connect(retrieve, SIGNAL(progress(QString)),
-              progressLabel, SLOT(setText(QString)));
-      connect(retrieve, SIGNAL(progress(int)),
-              this, SLOT(updateRetrieveProgress(int)));
-      }
-    try
+    QString serverNode = QString("%1@%2:%3")
+      .arg(query->calledAETitle()).arg(query->host()).arg(query->port());
+    if (!scheduler.serverNodes().contains(serverNode))
       {
-      // perform the retrieve
-      if ( query->preferCGET() )
-        {
-        retrieve->getStudy ( studyUID );
-        }
-      else
-        {
-        retrieve->moveStudy ( studyUID );
-        }
+      QMap<QString, QVariant> nodeParameters;
+      nodeParameters["CallingAETitle"] = query->callingAETitle();
+      nodeParameters["AETitle"] = query->calledAETitle();
+      nodeParameters["Address"] = query->host();
+      nodeParameters["Port"] = query->port();
+      // pull from GUI
+      nodeParameters["StorageAETitle"] = serverParameters["StorageAETitle"];
+      nodeParameters["CGET"] = query->preferCGET();
+      scheduler.addServerNode(serverNode, nodeParameters);
       }
-    catch (std::exception e)
+    logger.debug("About to retrieve " + studyUID + " from " + query->host());
+    scheduler.retrieveStudy(serverNode, studyUID);
+    }
+
+  if(d->UseProgressDialog)
+    {
+    progressLabel->setText(QString(tr("Retrieving %1 studies")).arg(scheduler.requestCount()));
+    progress.setMaximum(100);
+    this->updateRetrieveProgress(0);
+    connect(&progress, SIGNAL(canceled()), &scheduler, SLOT(cancel()));
+    connect(&scheduler, SIGNAL(progress(QString)),
+            progressLabel, SLOT(setText(QString)));
+    connect(&scheduler, SIGNAL(progress(int)),
+            this, SLOT(updateRetrieveProgress(int)));
+    }
+  connect(&scheduler, SIGNAL(requestFinished(QString,QString,QString,bool)),
+          this, SLOT(onRetrieveFinished(QString,QString,QString,bool)));
+  logger.info ( "Starting to retrieve" );
+  d->FailedRetrievalsByStudyUID.clear();
+  scheduler.waitForFinished();
+
+  // the scheduler already retried the failed studies, let the user decide
+  // whether to keep trying
+  while(d->UseProgressDialog && !progress.wasCanceled() &&
+        !d->FailedRetrievalsByStudyUID.isEmpty())
+    {
+    logger.error ( "Retrieve failed" );
+    if ( QMessageBox::question ( this,
+          tr("Query Retrieve"),
+          QString(tr("Retrieve failed for %1 of %2 studies.  Keep trying?"))
+            .arg(d->FailedRetrievalsByStudyUID.count()).arg(scheduler.requestCount()),
+          QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
       {
-      logger.error ( "Retrieve failed" );
-      if(d->UseProgressDialog)
-        {
-        if ( QMessageBox::question ( this, 
-              tr("Query Retrieve"), tr("Retrieve failed.  Keep trying?"),
-              QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
-          {
-          continue;
-          }
-        else
-          {
-          break;
-          }
-        }
+      break;
       }
-
-    if(d->UseProgressDialog)
+    QMap<QString, QString> failedRetrievals = d->FailedRetrievalsByStudyUID;
+    d->FailedRetrievalsByStudyUID.clear();
+    foreach( QString studyUID, failedRetrievals.keys() )
       {
-      disconnect(retrieve, SIGNAL(progress(QString)),
-              progressLabel, SLOT(setText(QString)));
-      disconnect(retrieve, SIGNAL(progress(int)),
-              this, SLOT(updateRetrieveProgress(int)));
-      disconnect(&progress, SIGNAL(canceled()), retrieve, SLOT(cancel()));
+      scheduler.retrieveStudy(failedRetrievals[studyUID], studyUID);
       }
-    logger.info ( "Retrieve success" );
+    scheduler.waitForFinished();
     }
 
   if(d->UseProgressDialog)
     {
     QString message(tr("Retrieve Process Finished"));
-    if (retrieve->wasCanceled())
+    if (progress.wasCanceled())
       {
       message = tr("Retrieve Process Canceled");
       }
+    else if (scheduler.failedRequestCount())
+      {
+      message = QString(tr("Retrieve Process Finished, %1 of %2 studies failed"))
+        .arg(scheduler.failedRequestCount()).arg(scheduler.requestCount());
+      }
     QMessageBox::information ( this, tr("Query Retrieve"), message );
     }
   emit studiesRetrieved(d->RetrievalsByStudyUID.keys());
 
-  delete retrieve;
   d->ProgressDialog = 0;
 }
 
@@ -411,6 +407,20 @@ void ctkDICOMQueryRetrieveWidget::onQueryProgressChanged(int value)
   QApplication::processEvents();
 }
 
+//----------------------------------------------------------------------------
+void ctkDICOMQueryRetrieveWidget::onRetrieveFinished(const QString& serverNode,
+                                                     const QString& studyInstanceUID,
+                                                     const QString& seriesInstanceUID,
+                                                     bool success)
+{
+  Q_D(ctkDICOMQueryRetrieveWidget);
+  Q_UNUSED(seriesInstanceUID);
+  if (!success)
+    {
+    d->FailedRetrievalsByStudyUID[studyInstanceUID] = serverNode;
+    }
+}
+
 //----------------------------------------------------------------------------
 void ctkDICOMQueryRetrieveWidget::updateRetrieveProgress(int value)
 {
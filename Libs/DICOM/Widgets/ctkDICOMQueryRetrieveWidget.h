@@ -69,6 +69,8 @@ Q_SIGNALS:
 protected Q_SLOTS:
   void onQueryProgressChanged(int value);
   void updateRetrieveProgress(int value);
+  void onRetrieveFinished(const QString& serverNode, const QString& studyInstanceUID,
+                          const QString& seriesInstanceUID, bool success);
 
 protected:
   QScopedPointer<ctkDICOMQueryRetrieveWidgetPrivate> d_ptr;
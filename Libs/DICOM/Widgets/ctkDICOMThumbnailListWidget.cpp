@@ -29,6 +29,8 @@
 #include <QPixmap>
 #include <QPushButton>
 #include <QResizeEvent>
+#include <QSet>
+#include <QTimer>
 
 // ctk includes
 #include "ctkLogger.h"
@@ -67,7 +69,11 @@ public:
   ctkDICOMThumbnailListWidgetPrivate(ctkDICOMThumbnailListWidget* parent);
 
   QString DatabaseDirectory;
-  QModelIndex CurrentSelectedModel;
+  QPersistentModelIndex CurrentSelectedModel;
+  /// SOPInstanceUIDs of the listed images without a thumbnail file yet
+  QSet<QString> MissingThumbnails;
+  /// Coalesces the refreshes when many thumbnails become ready at once
+  QTimer RefreshTimer;
 
   void addThumbnailWidget(const QModelIndex &imageIndex, const QModelIndex& sourceIndex, const QString& text);
 
@@ -188,6 +194,8 @@ void ctkDICOMThumbnailListWidgetPrivate
                           model->data(imageIndex, ctkDICOMModel::UIDRole).toString() + ".png";
   if(!QFileInfo(thumbnailPath).exists())
     {
+    // it may still be generated, see onThumbnailReady()
+    this->MissingThumbnails.insert(model->data(imageIndex, ctkDICOMModel::UIDRole).toString());
     return;
     }
   ctkThumbnailLabel* widget = new ctkThumbnailLabel(this->ScrollAreaContentWidget);
@@ -216,7 +224,10 @@ void ctkDICOMThumbnailListWidgetPrivate
 ctkDICOMThumbnailListWidget::ctkDICOMThumbnailListWidget(QWidget* _parent)
   : Superclass(new ctkDICOMThumbnailListWidgetPrivate(this), _parent)
 {
-
+  Q_D(ctkDICOMThumbnailListWidget);
+  d->RefreshTimer.setSingleShot(true);
+  d->RefreshTimer.setInterval(200);
+  connect(&d->RefreshTimer, SIGNAL(timeout()), this, SLOT(refreshThumbnails()));
 }
 
 //----------------------------------------------------------------------------
@@ -273,6 +284,7 @@ void ctkDICOMThumbnailListWidget::addThumbnails(const QModelIndex &index)
   Q_D(ctkDICOMThumbnailListWidget);
 
   this->clearThumbnails();
+  d->MissingThumbnails.clear();
 
   ctkDICOMModel* model = const_cast<ctkDICOMModel*>(qobject_cast<const ctkDICOMModel*>(index.model()));
 
@@ -298,3 +310,26 @@ void ctkDICOMThumbnailListWidget::addThumbnails(const QModelIndex &index)
 
   this->setCurrentThumbnail(0);
 }
+
+//----------------------------------------------------------------------------
+void ctkDICOMThumbnailListWidget::onThumbnailReady(const QString& sopInstanceUID)
+{
+  Q_D(ctkDICOMThumbnailListWidget);
+  if (d->MissingThumbnails.contains(sopInstanceUID))
+    {
+    d->RefreshTimer.start();
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMThumbnailListWidget::refreshThumbnails()
+{
+  Q_D(ctkDICOMThumbnailListWidget);
+  if (!d->CurrentSelectedModel.isValid())
+    {
+    return;
+    }
+  int currentThumbnail = this->currentThumbnail();
+  this->addThumbnails(d->CurrentSelectedModel);
+  this->setCurrentThumbnail(currentThumbnail);
+}
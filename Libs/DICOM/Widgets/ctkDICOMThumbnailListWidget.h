@@ -47,6 +47,13 @@ private:
 
 public Q_SLOTS:
   void addThumbnails(const QModelIndex& index);
+
+  /// Show the thumbnail of the instance if it was missing from the list,
+  /// e.g. connected to ctkDICOMDatabase::thumbnailReady(QString)
+  void onThumbnailReady(const QString& sopInstanceUID);
+
+protected Q_SLOTS:
+  void refreshThumbnails();
 };
 
 #endif
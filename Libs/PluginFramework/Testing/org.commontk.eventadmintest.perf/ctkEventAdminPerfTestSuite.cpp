@@ -30,6 +30,7 @@
 
 #include <QTest>
 #include <QDebug>
+#include <QMutexLocker>
 
 
 //----------------------------------------------------------------------------
@@ -43,14 +44,70 @@ void TestEventHandler::handleEvent(const ctkEvent& )
   counter++;
 }
 
+//----------------------------------------------------------------------------
+OrderedEventHandler::OrderedEventHandler()
+  : counter(0), outOfOrder(0)
+{}
+
+//----------------------------------------------------------------------------
+void OrderedEventHandler::handleEvent(const ctkEvent& event)
+{
+  QMutexLocker lock(&mutex);
+  int seq = event.getProperty("seq").toInt();
+  QHash<QString, int>::iterator last = lastSeq.find(event.getTopic());
+  if (last == lastSeq.end())
+  {
+    lastSeq.insert(event.getTopic(), seq);
+  }
+  else
+  {
+    if (seq <= last.value()) ++outOfOrder;
+    last.value() = seq;
+  }
+  ++counter;
+}
+
+//----------------------------------------------------------------------------
+int OrderedEventHandler::handled()
+{
+  QMutexLocker lock(&mutex);
+  return counter;
+}
+
+//----------------------------------------------------------------------------
+int OrderedEventHandler::outOfOrderEvents()
+{
+  QMutexLocker lock(&mutex);
+  return outOfOrder;
+}
+
+//----------------------------------------------------------------------------
+EventPostThread::EventPostThread(ctkEventAdmin* eventAdmin, const QString& topic, int nEvents)
+  : eventAdmin(eventAdmin), topic(topic), nEvents(nEvents)
+{}
+
+//----------------------------------------------------------------------------
+void EventPostThread::run()
+{
+  for (int i = 0; i < nEvents; ++i)
+  {
+    ctkDictionary props;
+    props.insert("seq", i);
+    eventAdmin->postEvent(ctkEvent(topic, props));
+  }
+}
+
 //----------------------------------------------------------------------------
 ctkEventAdminPerfTestSuite::ctkEventAdminPerfTestSuite(ctkPluginContext *context, int pluginId)
   : pc(context)
   , pluginId(pluginId)
   , nSendEvents(400)
   , nHandlers(40)
+  , nTopics(1000)
+  , nPostThreads(8)
   , nEvent1Handled(0)
   , nEvent2Handled(0)
+  , nTopicEventsHandled(0)
   , eventAdmin(0)
 {
 }
@@ -172,6 +229,91 @@ void ctkEventAdminPerfTestSuite::testPostEvents()
   QTest::qWait(10000);
 }
 
+//----------------------------------------------------------------------------
+void ctkEventAdminPerfTestSuite::testTopicThroughput()
+{
+  // one handler per topic, so that resolving the handlers of an event
+  // must not depend on the number of registered handlers
+  qDebug() << "Adding" << nTopics << "event handlers for distinct topics";
+  QString topic("org/perf/%1/*");
+  for (int i = 0; i < nTopics; ++i)
+  {
+    TestEventHandler* h = new TestEventHandler(nTopicEventsHandled);
+    handlers.push_back(h);
+    ctkDictionary props;
+    props.insert(ctkEventConstants::EVENT_TOPIC, topic.arg(i));
+    handlerRegistrations.push_back(pc->registerService<ctkEventHandler>(h, props));
+  }
+
+  const int nEvents = 10 * nSendEvents;
+  QList<ctkEvent> events;
+  for (int i = 0; i < nTopics; ++i)
+  {
+    events.push_back(ctkEvent(QString("org/perf/%1/event").arg(i)));
+  }
+
+  nTopicEventsHandled = 0;
+  QTime t;
+  t.start();
+  for (int i = 0; i < nEvents; ++i)
+  {
+    eventAdmin->sendEvent(events[i % nTopics]);
+  }
+  int ms = t.elapsed();
+  QCOMPARE(nTopicEventsHandled, nEvents);
+  qDebug() << "Sending" << nEvents << "synchronous events over" << nTopics
+           << "topics took" << ms << "ms (" << (nEvents * 1000.0 / qMax(ms, 1))
+           << "events/s)";
+}
+
+//----------------------------------------------------------------------------
+void ctkEventAdminPerfTestSuite::testConcurrentPostEvents()
+{
+  // several threads posting concurrently contend on the asynchronous
+  // thread pool, the events of each thread must keep their order
+  OrderedEventHandler handler;
+  ctkDictionary props;
+  props.insert(ctkEventConstants::EVENT_TOPIC, "org/perf/contention/*");
+  ctkServiceRegistration reg = pc->registerService<ctkEventHandler>(&handler, props);
+
+  const int nEvents = 10 * nSendEvents;
+  QList<EventPostThread*> threads;
+  for (int i = 0; i < nPostThreads; ++i)
+  {
+    threads.push_back(new EventPostThread(eventAdmin,
+                                          QString("org/perf/contention/%1").arg(i),
+                                          nEvents));
+  }
+
+  QTime t;
+  t.start();
+  foreach(EventPostThread* thread, threads)
+  {
+    thread->start();
+  }
+  foreach(EventPostThread* thread, threads)
+  {
+    thread->wait();
+  }
+  int postMs = t.elapsed();
+
+  const int nTotal = nPostThreads * nEvents;
+  while (handler.handled() < nTotal && t.elapsed() < 60000)
+  {
+    QTest::qWait(10);
+  }
+  int ms = t.elapsed();
+
+  reg.unregister();
+  qDeleteAll(threads);
+
+  QCOMPARE(handler.handled(), nTotal);
+  QCOMPARE(handler.outOfOrderEvents(), 0);
+  qDebug() << "Posting" << nTotal << "asynchronous events from" << nPostThreads
+           << "threads took" << postMs << "ms, delivering them took" << ms
+           << "ms (" << (nTotal * 1000.0 / qMax(ms, 1)) << "events/s)";
+}
+
 //----------------------------------------------------------------------------
 void ctkEventAdminPerfTestSuite::cleanupTestCase()
 {
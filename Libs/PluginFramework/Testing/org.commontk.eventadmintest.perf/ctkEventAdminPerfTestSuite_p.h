@@ -29,6 +29,9 @@
 #include <ctkServiceRegistration.h>
 
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
 
 struct ctkEventAdmin;
 
@@ -44,9 +47,12 @@ private:
 
   int nSendEvents;
   int nHandlers;
+  int nTopics;
+  int nPostThreads;
 
   int nEvent1Handled;
   int nEvent2Handled;
+  int nTopicEventsHandled;
 
   ctkEventAdmin* eventAdmin;
 
@@ -70,6 +76,8 @@ private Q_SLOTS:
   void initTestCase();
   void testSendEvents();
   void testPostEvents();
+  void testTopicThroughput();
+  void testConcurrentPostEvents();
   void cleanupTestCase();
 };
 
@@ -84,4 +92,31 @@ public:
   void handleEvent(const ctkEvent& );
 };
 
+class OrderedEventHandler : public QObject, public ctkEventHandler
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkEventHandler)
+private:
+  QMutex mutex;
+  QHash<QString, int> lastSeq;
+  int counter;
+  int outOfOrder;
+public:
+  OrderedEventHandler();
+  void handleEvent(const ctkEvent& event);
+  int handled();
+  int outOfOrderEvents();
+};
+
+class EventPostThread : public QThread
+{
+private:
+  ctkEventAdmin* eventAdmin;
+  const QString topic;
+  const int nEvents;
+public:
+  EventPostThread(ctkEventAdmin* eventAdmin, const QString& topic, int nEvents);
+  void run();
+};
+
 #endif // CTKEAPERFTESTSUITE_P_H
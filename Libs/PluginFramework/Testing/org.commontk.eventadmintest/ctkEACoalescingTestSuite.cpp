@@ -0,0 +1,173 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEACoalescingTestSuite_p.h"
+
+#include <ctkPluginContext.h>
+
+#include <service/event/ctkEventAdmin.h>
+#include <service/event/ctkEventConstants.h>
+
+#include <QTest>
+#include <QHash>
+#include <QTime>
+
+//----------------------------------------------------------------------------
+void ctkEACoalescingTestHelper::handleEvent(const ctkEvent& event)
+{
+  QMutexLocker l(&mutex);
+  events.push_back(event);
+}
+
+//----------------------------------------------------------------------------
+QList<ctkEvent> ctkEACoalescingTestHelper::receivedEvents() const
+{
+  QMutexLocker l(&mutex);
+  return events;
+}
+
+//----------------------------------------------------------------------------
+bool ctkEACoalescingTestHelper::waitForEvents(int count, int timeout) const
+{
+  QTime t;
+  t.start();
+  while (receivedEvents().size() < count)
+  {
+    if (t.elapsed() > timeout) return false;
+    QTest::qWait(10);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+ctkEACoalescingTestSuite::ctkEACoalescingTestSuite(ctkPluginContext* pc, long eventPluginId)
+  : context(pc), eventPluginId(eventPluginId), eventAdmin(0)
+{
+
+}
+
+//----------------------------------------------------------------------------
+void ctkEACoalescingTestSuite::init()
+{
+  context->getPlugin(eventPluginId)->start();
+  reference = context->getServiceReference<ctkEventAdmin>();
+  eventAdmin = context->getService<ctkEventAdmin>(reference);
+}
+
+//----------------------------------------------------------------------------
+void ctkEACoalescingTestSuite::cleanup()
+{
+  context->ungetService(reference);
+  context->getPlugin(eventPluginId)->stop();
+}
+
+//----------------------------------------------------------------------------
+void ctkEACoalescingTestSuite::testPostEvents()
+{
+  ctkDictionary properties;
+  properties.insert(ctkEventConstants::EVENT_TOPIC, "org/commontk/batch/*");
+  ctkEACoalescingTestHelper handler;
+  ctkServiceRegistration handlerRegistration = context->registerService<ctkEventHandler>(&handler, properties);
+
+  const int nEvents = 100;
+  QList<ctkEvent> events;
+  for (int i = 0; i < nEvents; ++i)
+  {
+    ctkDictionary props;
+    props.insert("seq", i);
+    events.push_back(ctkEvent(i % 2 ? "org/commontk/batch/a" : "org/commontk/batch/b", props));
+  }
+  eventAdmin->postEvents(events);
+
+  QVERIFY2(handler.waitForEvents(nEvents), "Did not receive all posted events");
+  QList<ctkEvent> received = handler.receivedEvents();
+  QCOMPARE(received.size(), nEvents);
+  for (int i = 0; i < nEvents; ++i)
+  {
+    QCOMPARE(received[i].getProperty("seq").toInt(), i);
+    QCOMPARE(received[i].getTopic(), events[i].getTopic());
+  }
+  handlerRegistration.unregister();
+}
+
+//----------------------------------------------------------------------------
+void ctkEACoalescingTestSuite::testCoalescing()
+{
+  ctkDictionary properties;
+  properties.insert(ctkEventConstants::EVENT_TOPIC, "org/commontk/coalesce/*");
+  ctkEACoalescingTestHelper handler;
+  ctkServiceRegistration handlerRegistration = context->registerService<ctkEventHandler>(&handler, properties);
+
+  const int nEvents = 1000;
+  for (int i = 0; i < nEvents; ++i)
+  {
+    for (int id = 0; id < 2; ++id)
+    {
+      ctkDictionary props;
+      props.insert("id", id);
+      props.insert("value", i);
+      eventAdmin->postEvent(ctkEvent("org/commontk/coalesce/progress", props));
+    }
+  }
+
+  // wait until the last event of both keys was delivered
+  QTime t;
+  t.start();
+  QHash<int, int> lastValue;
+  while ((lastValue.value(0) != nEvents - 1 || lastValue.value(1) != nEvents - 1) &&
+         t.elapsed() < 10000)
+  {
+    QTest::qWait(10);
+    lastValue.clear();
+    foreach (const ctkEvent& event, handler.receivedEvents())
+    {
+      lastValue.insert(event.getProperty("id").toInt(), event.getProperty("value").toInt());
+    }
+  }
+
+  QCOMPARE(lastValue.value(0), nEvents - 1);
+  QCOMPARE(lastValue.value(1), nEvents - 1);
+  QVERIFY2(handler.receivedEvents().size() < 2 * nEvents, "Posted events were not coalesced");
+  handlerRegistration.unregister();
+}
+
+//----------------------------------------------------------------------------
+void ctkEACoalescingTestSuite::testNoCoalescing()
+{
+  ctkDictionary properties;
+  properties.insert(ctkEventConstants::EVENT_TOPIC, "org/commontk/nocoalesce");
+  ctkEACoalescingTestHelper handler;
+  ctkServiceRegistration handlerRegistration = context->registerService<ctkEventHandler>(&handler, properties);
+
+  const int nEvents = 100;
+  for (int i = 0; i < nEvents; ++i)
+  {
+    ctkDictionary props;
+    props.insert("id", 0);
+    eventAdmin->postEvent(ctkEvent("org/commontk/nocoalesce", props));
+  }
+
+  QVERIFY2(handler.waitForEvents(nEvents), "Did not receive all posted events");
+  QTest::qWait(100);
+  QCOMPARE(handler.receivedEvents().size(), nEvents);
+  handlerRegistration.unregister();
+}
@@ -0,0 +1,105 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEACOALESCINGTESTSUITE_P_H
+#define CTKEACOALESCINGTESTSUITE_P_H
+
+#include <QObject>
+#include <QMutex>
+
+#include <ctkServiceReference.h>
+#include <ctkTestSuiteInterface.h>
+
+#include <service/event/ctkEventHandler.h>
+
+class ctkPluginContext;
+struct ctkEventAdmin;
+
+class ctkEACoalescingTestHelper : public QObject, public ctkEventHandler
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkEventHandler)
+
+private:
+
+  mutable QMutex mutex;
+  QList<ctkEvent> events;
+
+public:
+
+  void handleEvent(const ctkEvent& event);
+
+  QList<ctkEvent> receivedEvents() const;
+
+  /*
+   * Wait until the given number of events was received
+   * or the timeout expired.
+   */
+  bool waitForEvents(int count, int timeout = 10000) const;
+};
+
+
+class ctkEACoalescingTestSuite : public QObject,
+    public ctkTestSuiteInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkTestSuiteInterface)
+
+public:
+
+  /*
+   * The EventAdmin must be configured to coalesce
+   * the topic org/commontk/coalesce/&#42; by the key "id".
+   */
+  ctkEACoalescingTestSuite(ctkPluginContext* pc, long eventPluginId);
+
+private Q_SLOTS:
+
+  void init();
+  void cleanup();
+
+  /*
+   * Ensures a list of events posted over several topics is delivered
+   * completely and in order.
+   */
+  void testPostEvents();
+
+  /*
+   * Ensures posted events of a coalesced topic are merged by key and
+   * the last event of each key is delivered.
+   */
+  void testCoalescing();
+
+  /*
+   * Ensures events of other topics are not coalesced.
+   */
+  void testNoCoalescing();
+
+private:
+
+  ctkPluginContext* context;
+  long eventPluginId;
+  ctkEventAdmin* eventAdmin;
+  ctkServiceReference reference;
+};
+
+#endif // CTKEACOALESCINGTESTSUITE_P_H
@@ -49,6 +49,7 @@ private:
   QObject* scenario2TestSuite;
   QObject* scenario3TestSuite;
   QObject* scenario4TestSuite;
+  QObject* coalescingTestSuite;
 };
 
 #endif // CTKEVENTADMINTESTACTIVATOR_H
@@ -37,6 +37,8 @@ ctkPluginFrameworkPerfRegistryTestSuite::ctkPluginFrameworkPerfRegistryTestSuite
   , pc(context)
   , nListeners(100)
   , nServices(1000)
+  , nLookupServices(10000)
+  , nLookups(100)
   , nRegistered(0)
   , nUnregistering(0)
   , nModified(0)
@@ -74,6 +76,47 @@ void ctkPluginFrameworkPerfRegistryTestSuite::cleanupTestCase()
   listeners.clear();
 }
 
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfRegistryTestSuite::testFilteredLookups()
+{
+  qDebug() << "Look up" << nLookupServices << "services" << nLookups
+           << "times with the same filter";
+
+  // registered before the listeners are added, so no events are counted
+  QString pid("my.lookup.%1");
+  QList<ctkServiceRegistration> lookupRegs;
+  QList<QObject*> lookupServices;
+  for(int i = 0; i < nLookupServices; i++)
+  {
+    ctkDictionary props;
+    props.insert("service.pid", pid.arg(i));
+    props.insert("perf.lookup.value", i);
+
+    QObject* service = new PerfTestService();
+    lookupServices.push_back(service);
+    lookupRegs.push_back(pc->registerService<IPerfTestService>(service, props));
+  }
+
+  const QString filter("(&(service.pid=my.lookup.*)(perf.lookup.value=7))");
+  ctkHighPrecisionTimer t;
+  t.start();
+  int nFound = 0;
+  for(int i = 0; i < nLookups; i++)
+  {
+    nFound += pc->getServiceReferences<IPerfTestService>(filter).size();
+  }
+  int ms = t.elapsedMilli();
+  log() << nLookups << "lookups over" << nLookupServices << "services took" << ms << "ms";
+
+  for(int i = 0; i < lookupRegs.size(); i++)
+  {
+    lookupRegs[i].unregister();
+  }
+  qDeleteAll(lookupServices);
+
+  QVERIFY2(nFound == nLookups, "Each lookup must find exactly one service");
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkPerfRegistryTestSuite::testAddListeners()
 {
@@ -44,6 +44,8 @@ private:
 
   int nListeners;
   int nServices;
+  int nLookupServices;
+  int nLookups;
 
   int nRegistered;
   int nUnregistering;
@@ -76,6 +78,7 @@ private Q_SLOTS:
   void initTestCase();
   void cleanupTestCase();
 
+  void testFilteredLookups();
   void testAddListeners();
   void testRegisterServices();
 
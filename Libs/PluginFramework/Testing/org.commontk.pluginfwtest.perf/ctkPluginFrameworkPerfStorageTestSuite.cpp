@@ -0,0 +1,274 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkPluginFrameworkPerfStorageTestSuite_p.h"
+
+#include <ctkPlugin.h>
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkPluginException.h>
+#include <ctkPluginFramework.h>
+#include <ctkPluginFrameworkFactory.h>
+#include <ctkHighPrecisionTimer.h>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QPluginLoader>
+#include <QTest>
+#include <QUrl>
+
+//----------------------------------------------------------------------------
+ctkPluginFrameworkPerfStorageTestSuite::ctkPluginFrameworkPerfStorageTestSuite(ctkPluginContext* context)
+  : QObject(0)
+  , pc(context)
+{
+  this->setObjectName("ctkPluginFrameworkPerfStorageTestSuite");
+}
+
+//----------------------------------------------------------------------------
+ctkProperties ctkPluginFrameworkPerfStorageTestSuite::frameworkProperties(const QString& storageDir,
+                                                                          const QString& resourceStorage) const
+{
+  ctkProperties fwProps;
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE, storageDir);
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES, resourceStorage);
+  // per-plugin install, resolve and start timings
+  fwProps.insert("org.commontk.pluginfw.debug.startup", true);
+  QVariant loadHints = pc->getProperty(ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS);
+  if (loadHints.isValid())
+  {
+    fwProps.insert(ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS, loadHints);
+  }
+  return fwProps;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfStorageTestSuite::initTestCase()
+{
+  QString testPluginDir = pc->getProperty("pluginfw.testDir").toString();
+
+  QStringList libFilter;
+  libFilter << "*.dll" << "*.so" << "*.dylib";
+  QDirIterator dirIter(testPluginDir, libFilter, QDir::Files);
+  while (dirIter.hasNext())
+  {
+    QString lib = dirIter.next();
+    // the framework test plugins, see FrameworkTestPlugins
+    if (dirIter.fileName().contains("plugin") && dirIter.fileName().contains("_test"))
+    {
+      pluginLibs << lib;
+    }
+  }
+
+  QVERIFY2(!pluginLibs.isEmpty(), qPrintable(QString("No test plugins in %1").arg(testPluginDir)));
+  log() << "installing" << pluginLibs.size() << "plugins from" << testPluginDir;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfStorageTestSuite::testStartup_data()
+{
+  QTest::addColumn<QString>("resourceStorage");
+
+  QTest::newRow("database") << ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_DATABASE;
+  QTest::newRow("index") << ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfStorageTestSuite::testStartup()
+{
+  QFETCH(QString, resourceStorage);
+
+  QString storageDir = QDir::temp().absoluteFilePath(QString("ctkpluginfw_storage_perf_") + resourceStorage);
+
+  // First start: a clean framework storage, all plugins are installed
+  ctkProperties fwProps = frameworkProperties(storageDir, resourceStorage);
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  {
+    ctkPluginFrameworkFactory fwFactory(fwProps);
+    QSharedPointer<ctkPluginFramework> framework = fwFactory.getFramework();
+    framework->init();
+    foreach(QString lib, pluginLibs)
+    {
+      framework->getPluginContext()->installPlugin(QUrl::fromLocalFile(lib));
+    }
+    framework->stop();
+    framework->waitForStop(10000);
+  }
+  int installMs = t.elapsedMilli();
+
+  // Second start: the plugins are restored from the storage and their resources read
+  t.start();
+  {
+    ctkPluginFrameworkFactory fwFactory(frameworkProperties(storageDir, resourceStorage));
+    QSharedPointer<ctkPluginFramework> framework = fwFactory.getFramework();
+    framework->init();
+
+    QList<QSharedPointer<ctkPlugin> > plugins = framework->getPluginContext()->getPlugins();
+    QCOMPARE(plugins.size(), pluginLibs.size() + 1);
+    foreach(QSharedPointer<ctkPlugin> plugin, plugins)
+    {
+      if (plugin->getPluginId() == 0) continue;
+
+      QByteArray manifest = plugin->getResource("/META-INF/MANIFEST.MF");
+      QVERIFY2(!manifest.isEmpty(), qPrintable(plugin->getSymbolicName()));
+
+      // both storage modes give the same resources
+      QString location = plugin->getLocation();
+      if (manifests.contains(location))
+      {
+        QCOMPARE(manifest, manifests[location]);
+      }
+      else
+      {
+        manifests.insert(location, manifest);
+      }
+    }
+
+    framework->stop();
+    framework->waitForStop(10000);
+  }
+  int restartMs = t.elapsedMilli();
+
+  qint64 dbSize = QFileInfo(QDir(storageDir).absoluteFilePath("plugins.db")).size();
+  log() << resourceStorage << ": first start" << installMs << "ms, restart" << restartMs
+        << "ms, plugins.db" << dbSize << "bytes";
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfStorageTestSuite::testResourceCacheMiss()
+{
+  // the storage installed by testStartup in the index mode
+  QString storageDir = QDir::temp().absoluteFilePath(QString("ctkpluginfw_storage_perf_")
+                                                     + ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX);
+  QDir cacheDir(QDir(storageDir).absoluteFilePath("resources"));
+  QStringList cachedFiles = cacheDir.entryList(QDir::Files);
+  QVERIFY2(!cachedFiles.isEmpty(), qPrintable(QString("No cached resources in %1").arg(cacheDir.path())));
+  foreach(QString cachedFile, cachedFiles)
+  {
+    QVERIFY(cacheDir.remove(cachedFile));
+  }
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  {
+    ctkPluginFrameworkFactory fwFactory(frameworkProperties(storageDir, ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX));
+    QSharedPointer<ctkPluginFramework> framework = fwFactory.getFramework();
+    framework->init();
+
+    foreach(QSharedPointer<ctkPlugin> plugin, framework->getPluginContext()->getPlugins())
+    {
+      if (plugin->getPluginId() == 0) continue;
+
+      // read from the library, and identical to the copy of the database mode
+      QByteArray manifest = plugin->getResource("/META-INF/MANIFEST.MF");
+      QVERIFY2(!manifest.isEmpty(), qPrintable(plugin->getSymbolicName()));
+      QCOMPARE(manifest, manifests.value(plugin->getLocation()));
+    }
+
+    framework->stop();
+    framework->waitForStop(10000);
+  }
+  int missMs = t.elapsedMilli();
+
+  // the resources read from the libraries are cached again
+  QStringList recachedFiles = cacheDir.entryList(QDir::Files);
+  qSort(cachedFiles);
+  qSort(recachedFiles);
+  QCOMPARE(recachedFiles, cachedFiles);
+
+  log() << ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX << ": restart with an empty resource cache"
+        << missMs << "ms";
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfStorageTestSuite::testManifestFileInstall()
+{
+  QString pluginLib;
+  foreach(QString lib, pluginLibs)
+  {
+    if (QFileInfo(lib).fileName().contains("pluginA_test"))
+    {
+      pluginLib = lib;
+    }
+  }
+  QVERIFY2(!pluginLib.isEmpty(), "pluginA_test not found");
+  QVERIFY2(QFile::exists(pluginLib + ".MF"), qPrintable(QString("No manifest file next to %1").arg(pluginLib)));
+
+  // the library is copied, so that it can be modified. The copy is not in
+  // the storage directory, which is cleaned.
+  QString storageDir = QDir::temp().absoluteFilePath("ctkpluginfw_storage_perf_manifest");
+  QDir libDir(QDir::temp().absoluteFilePath("ctkpluginfw_storage_perf_manifest_libs"));
+  QVERIFY(QDir().mkpath(libDir.path()));
+  QString libCopy = libDir.absoluteFilePath(QFileInfo(pluginLib).fileName());
+  QFile::remove(libCopy);
+  QFile::remove(libCopy + ".MF");
+  QVERIFY(QFile::copy(pluginLib, libCopy));
+  QVERIFY(QFile::copy(pluginLib + ".MF", libCopy + ".MF"));
+
+  ctkProperties fwProps = frameworkProperties(storageDir, ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX);
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  long pluginId = 0;
+  {
+    ctkPluginFrameworkFactory fwFactory(fwProps);
+    QSharedPointer<ctkPluginFramework> framework = fwFactory.getFramework();
+    framework->init();
+
+    QSharedPointer<ctkPlugin> plugin = framework->getPluginContext()->installPlugin(QUrl::fromLocalFile(libCopy));
+    pluginId = plugin->getPluginId();
+    QCOMPARE(plugin->getSymbolicName(), QString("pluginA.test"));
+    QVERIFY2(!QPluginLoader(libCopy).isLoaded(), "the library was loaded to install the plugin");
+
+    // the resources besides the manifest are indexed on first access
+    QStringList resources = plugin->findResources("/", "*.txt", true);
+    QCOMPARE(resources.size(), 1);
+    QVERIFY(resources.front().endsWith("pluginA_test.txt"));
+    QCOMPARE(plugin->getResource("/resources/pluginA_test.txt").trimmed(), QByteArray("pluginA_test resource"));
+
+    framework->stop();
+    framework->waitForStop(10000);
+  }
+
+  // A newer library, the timestamps of the storage have a one second accuracy
+  QTest::qSleep(1100);
+  QVERIFY(QFile::remove(libCopy));
+  QVERIFY(QFile::copy(pluginLib, libCopy));
+
+  // the modified plugin is installed again at restart
+  {
+    ctkPluginFrameworkFactory fwFactory(frameworkProperties(storageDir, ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX));
+    QSharedPointer<ctkPluginFramework> framework = fwFactory.getFramework();
+    framework->init();
+
+    QSharedPointer<ctkPlugin> plugin = framework->getPluginContext()->getPlugin(pluginId);
+    QVERIFY(!plugin.isNull());
+    QCOMPARE(plugin->getSymbolicName(), QString("pluginA.test"));
+    QCOMPARE(plugin->getResource("/resources/pluginA_test.txt").trimmed(), QByteArray("pluginA_test resource"));
+
+    framework->stop();
+    framework->waitForStop(10000);
+  }
+}
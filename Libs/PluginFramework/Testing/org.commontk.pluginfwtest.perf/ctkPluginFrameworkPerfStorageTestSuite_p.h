@@ -0,0 +1,89 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKPLUGINFRAMEWORKPERFSTORAGETESTSUITE_P_H
+#define CTKPLUGINFRAMEWORKPERFSTORAGETESTSUITE_P_H
+
+#include "ctkTestSuiteInterface.h"
+
+#include <ctkPluginFramework_global.h>
+
+#include <QDebug>
+#include <QHash>
+#include <QStringList>
+
+class ctkPluginContext;
+
+/**
+ * Measures the start-up time of a framework installing the test plugins,
+ * with the plugin resources copied into the database or only indexed.
+ */
+class ctkPluginFrameworkPerfStorageTestSuite : public QObject, public ctkTestSuiteInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkTestSuiteInterface)
+
+private:
+
+  ctkPluginContext* pc;
+
+  QStringList pluginLibs;
+
+  /**
+   * Manifest resources read in the first storage mode, by plugin library
+   */
+  QHash<QString, QByteArray> manifests;
+
+public:
+
+  ctkPluginFrameworkPerfStorageTestSuite(ctkPluginContext* context);
+
+  QDebug log()
+  {
+    return qDebug() << "storage_perf:";
+  }
+
+private:
+
+  ctkProperties frameworkProperties(const QString& storageDir, const QString& resourceStorage) const;
+
+private Q_SLOTS:
+
+  void initTestCase();
+
+  void testStartup_data();
+  void testStartup();
+
+  /**
+   * Resources missing from the cache of the index mode are read from
+   * the plugin libraries
+   */
+  void testResourceCacheMiss();
+
+  /**
+   * A plugin installed from its manifest file indexes its resources on
+   * first access, and is installed again when its library changes
+   */
+  void testManifestFileInstall();
+};
+
+#endif // CTKPLUGINFRAMEWORKPERFSTORAGETESTSUITE_P_H
@@ -22,13 +22,14 @@
 #include "ctkPluginFrameworkTestPerfActivator_p.h"
 
 #include "ctkPluginFrameworkPerfRegistryTestSuite_p.h"
+#include "ctkPluginFrameworkPerfStorageTestSuite_p.h"
 
 #include <QtPlugin>
 
 
 //----------------------------------------------------------------------------
 ctkPluginFrameworkTestPerfActivator::ctkPluginFrameworkTestPerfActivator()
-  : perfTestSuite(0)
+  : perfTestSuite(0), storageTestSuite(0)
 {
 
 }
@@ -37,6 +38,7 @@ ctkPluginFrameworkTestPerfActivator::ctkPluginFrameworkTestPerfActivator()
 ctkPluginFrameworkTestPerfActivator::~ctkPluginFrameworkTestPerfActivator()
 {
   delete perfTestSuite;
+  delete storageTestSuite;
 }
 
 //----------------------------------------------------------------------------
@@ -44,6 +46,9 @@ void ctkPluginFrameworkTestPerfActivator::start(ctkPluginContext* context)
 {
   perfTestSuite = new ctkPluginFrameworkPerfRegistryTestSuite(context);
   context->registerService<ctkTestSuiteInterface>(perfTestSuite);
+
+  storageTestSuite = new ctkPluginFrameworkPerfStorageTestSuite(context);
+  context->registerService<ctkTestSuiteInterface>(storageTestSuite);
 }
 
 //----------------------------------------------------------------------------
@@ -53,6 +58,8 @@ void ctkPluginFrameworkTestPerfActivator::stop(ctkPluginContext* context)
 
   delete perfTestSuite;
   perfTestSuite = 0;
+  delete storageTestSuite;
+  storageTestSuite = 0;
 }
 
 Q_EXPORT_PLUGIN2(org_commontk_pluginfwtest_perf, ctkPluginFrameworkTestPerfActivator)
@@ -43,6 +43,7 @@ public:
 private:
 
   QObject* perfTestSuite;
+  QObject* storageTestSuite;
 };
 
 #endif // CTKPLUGINFRAMEWORKTESTPERFACTIVATOR_H
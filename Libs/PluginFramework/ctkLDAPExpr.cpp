@@ -106,15 +106,36 @@ public:
   ctkLDAPExprData( int op, QString attrName, QString attrValue )
     : m_operator(op), m_attrName(attrName), m_attrValue(attrValue)
   {
+    compile();
   }
 
   ctkLDAPExprData( const ctkLDAPExprData& other )
     : QSharedData(other), m_operator(other.m_operator),
     m_args(other.m_args), m_attrName(other.m_attrName),
-    m_attrValue(other.m_attrValue)
+    m_attrValue(other.m_attrValue), m_foldedAttrName(other.m_foldedAttrName),
+    m_matchAll(other.m_matchAll), m_hasWildcard(other.m_hasWildcard),
+    m_approxValue(other.m_approxValue), m_intValue(other.m_intValue),
+    m_longValue(other.m_longValue), m_floatValue(other.m_floatValue),
+    m_doubleValue(other.m_doubleValue)
   {
   }
 
+  //! Convert the attribute name and value once, instead of for each evaluation
+  void compile()
+  {
+    m_foldedAttrName = m_attrName.toCaseFolded();
+    m_matchAll = m_attrValue == ctkLDAPExpr::WILDCARD_QString;
+    m_hasWildcard = m_attrValue.indexOf(ctkLDAPExpr::WILDCARD) >= 0;
+    if (m_operator == ctkLDAPExpr::APPROX)
+    {
+      m_approxValue = ctkLDAPExpr::fixupString(m_attrValue);
+    }
+    m_intValue = m_attrValue.toInt();
+    m_longValue = m_attrValue.toLongLong();
+    m_floatValue = m_attrValue.toFloat();
+    m_doubleValue = m_attrValue.toDouble();
+  }
+
   //!
   int m_operator;
   //!
@@ -123,6 +144,21 @@ public:
   QString m_attrName;
   //!
   QString m_attrValue;
+
+  // Compiled operands of simple expressions
+  //! case folded m_attrName, for case insensitive lookups
+  QString m_foldedAttrName;
+  //! m_attrValue is a single wildcard
+  bool m_matchAll;
+  //! m_attrValue contains a wildcard
+  bool m_hasWildcard;
+  //! m_attrValue as compared by APPROX
+  QString m_approxValue;
+  //! m_attrValue converted for the numeric comparisons
+  int m_intValue;
+  qlonglong m_longValue;
+  float m_floatValue;
+  double m_doubleValue;
 };
 
 //----------------------------------------------------------------------------
@@ -286,8 +322,8 @@ bool ctkLDAPExpr::evaluate( const ctkServiceProperties &p, bool matchCase ) cons
   if ((d->m_operator & SIMPLE) != 0) {
     // try case sensitive match first
     int index = p.findCaseSensitive(d->m_attrName);
-    if (index < 0 && !matchCase) index = p.find(d->m_attrName);
-    return index < 0 ? false : compare(p.value(index), d->m_operator, d->m_attrValue);
+    if (index < 0 && !matchCase) index = p.findCaseFolded(d->m_foldedAttrName);
+    return index < 0 ? false : compare(p.value(index));
   } else { // (d->m_operator & COMPLEX) != 0
     switch (d->m_operator) {
     case AND:
@@ -311,69 +347,70 @@ bool ctkLDAPExpr::evaluate( const ctkServiceProperties &p, bool matchCase ) cons
 }
 
 //----------------------------------------------------------------------------
-bool ctkLDAPExpr::compare( const QVariant &obj, int op, const QString &s ) const
+bool ctkLDAPExpr::compare( const QVariant &obj ) const
 {
   if (obj.isNull())
     return false;
-  if (op == EQ && s == WILDCARD_QString )
+  const int op = d->m_operator;
+  if (op == EQ && d->m_matchAll)
     return true;
   try {
     if ( obj.canConvert<QString>( ) ) {
-      return compareString(obj.toString(), op, s);
+      return compareString(obj.toString());
     } else if (obj.canConvert<char>( ) ) {
-      return compareString(obj.toString(), op, s);
+      return compareString(obj.toString());
     } else if (obj.canConvert<bool>( ) ) {
       if (op==LE || op==GE)
         return false;
       if ( obj.toBool() ) {
-        return s.compare("true", Qt::CaseInsensitive);
+        return d->m_attrValue.compare("true", Qt::CaseInsensitive);
       } else {
-        return s.compare("false", Qt::CaseInsensitive);
+        return d->m_attrValue.compare("false", Qt::CaseInsensitive);
       }
     } 
     else if ( obj.canConvert<Byte>( ) || obj.canConvert<int>( ) ) 
     {
       switch(op) {
       case LE:
-        return obj.toInt() <= s.toInt();
+        return obj.toInt() <= d->m_intValue;
       case GE:
-        return obj.toInt() >= s.toInt();
+        return obj.toInt() >= d->m_intValue;
       default: /*APPROX and EQ*/
-        return s.toInt( ) == obj.toInt();
+        return d->m_intValue == obj.toInt();
       }
     } else if ( obj.canConvert<float>( ) ) {
       switch(op) {
       case LE:
-        return obj.toFloat() <= s.toFloat();
+        return obj.toFloat() <= d->m_floatValue;
       case GE:
-        return obj.toFloat() >= s.toFloat();
+        return obj.toFloat() >= d->m_floatValue;
       default: /*APPROX and EQ*/
-        return s.toFloat() == obj.toFloat();
+        return d->m_floatValue == obj.toFloat();
       }
     } else if (obj.canConvert<double>()) {
       switch(op) {
       case LE:
-        return obj.toDouble() <= s.toDouble();
+        return obj.toDouble() <= d->m_doubleValue;
       case GE:
-        return obj.toDouble() >= s.toDouble();
+        return obj.toDouble() >= d->m_doubleValue;
       default: /*APPROX and EQ*/
-        return s.toDouble( ) == obj.toDouble( );
+        return d->m_doubleValue == obj.toDouble( );
       }
     } else if (obj.canConvert<qlonglong>( )) {
       switch(op) {
       case LE:
-        return obj.toLongLong() <= s.toLongLong( );
+        return obj.toLongLong() <= d->m_longValue;
       case GE:
-        return obj.toLongLong() >= s.toLongLong( );
+        return obj.toLongLong() >= d->m_longValue;
       default: /*APPROX and EQ*/
-        return obj.toLongLong() == s.toLongLong( );
+        return obj.toLongLong() == d->m_longValue;
       }
     } 
     else if (obj.canConvert< QList<QVariant> >()) {
       QList<QVariant> list = obj.toList();
       QList<QVariant>::Iterator it;
       for (it=list.begin(); it != list.end( ); it++)
-         if (compare(*it, op, s))
+         if (compare(*it))
            return true;
     } 
   } catch (...) {
@@ -384,17 +421,20 @@ bool ctkLDAPExpr::compare( const QVariant &obj, int op, const QString &s ) const
 }
 
 //----------------------------------------------------------------------------
-bool ctkLDAPExpr::compareString( const QString &s1, int op, const QString &s2 )
+bool ctkLDAPExpr::compareString( const QString &s1 ) const
 {
-  switch(op) {
+  switch(d->m_operator) {
   case LE:
-    return s1.compare(s2) <= 0;
+    return s1.compare(d->m_attrValue) <= 0;
   case GE:
-    return s1.compare(s2) >= 0;
+    return s1.compare(d->m_attrValue) >= 0;
   case EQ:
-    return patSubstr(s1,s2);
+    // without wildcard, the pattern matches only itself
+    if (!d->m_hasWildcard)
+      return !s1.isNull() && s1 == d->m_attrValue;
+    return patSubstr(s1,d->m_attrValue);
   case APPROX:
-    return fixupString(s2) == fixupString(s1);
+    return d->m_approxValue == fixupString(s1);
   default:
     return false;
   }
@@ -133,6 +133,7 @@ public:
 private:
 
   class ParseState;
+  friend class ctkLDAPExprData;
 
   //!
   ctkLDAPExpr(int op, const QList<ctkLDAPExpr> &args);
@@ -146,11 +147,11 @@ private:
   //!
   static ctkLDAPExpr parseSimple(ParseState &ps);
 
-  //!
-  bool compare(const QVariant &obj, int op, const QString &s) const;
+  //! Compare \a obj to the compiled attribute value
+  bool compare(const QVariant &obj) const;
 
   //!
-  static bool compareString(const QString &s1, int op, const QString &s2);
+  bool compareString(const QString &s1) const;
 
   //!
   static QString fixupString(const QString &s);
@@ -29,6 +29,9 @@ const QString ctkPluginConstants::FRAMEWORK_VENDOR = "org.commontk.pluginfw.vend
 const QString ctkPluginConstants::FRAMEWORK_STORAGE = "org.commontk.pluginfw.storage";
 const QString ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN = "org.commontk.pluginfw.storage.clean";
 const QString ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT = "onFirstInit";
+const QString ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES = "org.commontk.pluginfw.storage.resources";
+const QString ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_DATABASE = "database";
+const QString ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX = "index";
 const QString ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS = "org.commontk.pluginfw.loadhints";
 const QString ctkPluginConstants::FRAMEWORK_PRELOAD_LIBRARIES = "org.commontk.pluginfw.preloadlibs";
 
@@ -95,6 +95,36 @@ struct CTK_PLUGINFW_EXPORT ctkPluginConstants {
    */
   static const QString FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT; // = "onFirstInit";
 
+  /**
+   * Specifies how the Qt resources of installed plugins are stored. If this
+   * property is not set, the framework uses
+   * #FRAMEWORK_STORAGE_RESOURCES_DATABASE.
+   *
+   * @see #FRAMEWORK_STORAGE_RESOURCES_DATABASE
+   * @see #FRAMEWORK_STORAGE_RESOURCES_INDEX
+   */
+  static const QString FRAMEWORK_STORAGE_RESOURCES; // = "org.commontk.pluginfw.storage.resources";
+
+  /**
+   * Specifies that the contents of all plugin resources are copied into the
+   * plugin database when a plugin is installed.
+   */
+  static const QString FRAMEWORK_STORAGE_RESOURCES_DATABASE; // = "database";
+
+  /**
+   * Specifies that only the resource paths are stored in the plugin database
+   * when a plugin is installed. The contents of a resource are read from the
+   * plugin library when the resource is first requested and kept in a
+   * memory-mapped cache in the framework storage area for later requests.
+   *
+   * This reduces the time needed to install plugins with many resources and
+   * the size of the plugin database. If a copy of the plugin manifest is
+   * found next to the plugin library, named like the library with a ".MF"
+   * suffix, the library is not even loaded when the plugin is installed.
+   * Its resources are then indexed on first access.
+   */
+  static const QString FRAMEWORK_STORAGE_RESOURCES_INDEX; // = "index";
+
   /**
    * Specifies the hints on how symbols in dynamic shared objects (plug-ins) are
    * resolved. The value of this property must be of type
@@ -31,6 +31,7 @@ QString ctkPluginFrameworkDebug::SERVICE_REFERENCE_PROP = "org.commontk.pluginfw
 QString ctkPluginFrameworkDebug::STARTLEVEL_PROP = "org.commontk.pluginfw.debug.startlevel";
 QString ctkPluginFrameworkDebug::URL_PROP = "org.commontk.pluginfw.debug.url";
 QString ctkPluginFrameworkDebug::RESOLVE_PROP = "org.commontk.pluginfw.debug.resolve";
+QString ctkPluginFrameworkDebug::STARTUP_PROP = "org.commontk.pluginfw.debug.startup";
 
 //----------------------------------------------------------------------------
 ctkPluginFrameworkDebug::ctkPluginFrameworkDebug(ctkProperties& props)
@@ -44,6 +45,7 @@ ctkPluginFrameworkDebug::ctkPluginFrameworkDebug(ctkProperties& props)
   setPropertyIfNotSet(props, STARTLEVEL_PROP, false);
   setPropertyIfNotSet(props, URL_PROP, false);
   setPropertyIfNotSet(props, RESOLVE_PROP, false);
+  setPropertyIfNotSet(props, STARTUP_PROP, false);
   errors = props.value(ERRORS_PROP).toBool();
   framework = props.value(FRAMEWORK_PROP).toBool();
   hooks = props.value(HOOKS_PROP).toBool();
@@ -53,6 +55,7 @@ ctkPluginFrameworkDebug::ctkPluginFrameworkDebug(ctkProperties& props)
   startlevel = props.value(STARTLEVEL_PROP).toBool();
   url = props.value(URL_PROP).toBool();
   resolve = props.value(RESOLVE_PROP).toBool();
+  startup = props.value(STARTUP_PROP).toBool();
 }
 
 //----------------------------------------------------------------------------
@@ -90,6 +90,12 @@ public:
   static QString RESOLVE_PROP; // = "org.commontk.pluginfw.debug.resolve";
   bool resolve;
 
+  /**
+   * Report the time spent installing, resolving and starting each plug-in
+   */
+  static QString STARTUP_PROP; // = "org.commontk.pluginfw.debug.startup";
+  bool startup;
+
 private:
 
   void setPropertyIfNotSet(ctkProperties& props, const QString& key, const QVariant& val);
@@ -30,9 +30,15 @@
 #include "ctkPluginFrameworkContext_p.h"
 #include "ctkServiceException.h"
 
+#include <ctkHighPrecisionTimer.h>
+
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QFileInfo>
+#include <QResource>
+#include <QTemporaryFile>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 //database table names
 #define PLUGINS_TABLE "Plugins"
@@ -51,15 +57,33 @@ enum TBindIndexes
   EBindIndex7
 };
 
+//----------------------------------------------------------------------------
+static QString getResourcePrefix(const QString& libLocation)
+{
+  QString resourcePrefix = QFileInfo(libLocation).baseName();
+  if (resourcePrefix.startsWith("lib"))
+  {
+    resourcePrefix = resourcePrefix.mid(3);
+  }
+  resourcePrefix.replace("_", ".");
+  return QString(":/") + resourcePrefix + "/";
+}
+
 //----------------------------------------------------------------------------
 ctkPluginStorageSQL::ctkPluginStorageSQL(ctkPluginFrameworkContext *framework)
   : m_isDatabaseOpen(false)
   , m_inTransaction(false)
+  , m_indexResources(false)
   , m_framework(framework)
   , m_nextFreeId(-1)
 {
   // See if we have a storage database
-  m_databasePath = ctkPluginFrameworkUtil::getFileStorage(framework, "").absoluteFilePath("plugins.db");
+  QDir storageDir = ctkPluginFrameworkUtil::getFileStorage(framework, "");
+  m_databasePath = storageDir.absoluteFilePath("plugins.db");
+  m_resourceCachePath = storageDir.absoluteFilePath("resources");
+
+  m_indexResources = framework->props.value(ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES).toString()
+      == ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX;
 
   this->open();
   restorePluginArchives();
@@ -69,6 +93,10 @@ ctkPluginStorageSQL::ctkPluginStorageSQL(ctkPluginFrameworkContext *framework)
 ctkPluginStorageSQL::~ctkPluginStorageSQL()
 {
   close();
+
+  // unmaps the resource cache files
+  m_mappedResources.clear();
+  qDeleteAll(m_mappedResourceFiles);
 }
 
 //----------------------------------------------------------------------------
@@ -95,7 +123,8 @@ void ctkPluginStorageSQL::open()
     }
   }
 
-  m_connectionName = dbFileInfo.completeBaseName();
+  // the database path identifies the connection, several frameworks may run in one process
+  m_connectionName = dbFileInfo.absoluteFilePath();
   QSqlDatabase database;
   if (QSqlDatabase::contains(m_connectionName))
   {
@@ -327,18 +356,38 @@ void ctkPluginStorageSQL::updateDB()
     query.finish();
     query.clear();
 
+    // The plug-in libraries are independent, read them in parallel. Only the
+    // database is written from this thread.
+    ctkHighPrecisionTimer timer;
+    timer.start();
+    QList<QFuture<PluginLibraryData> > libraryData;
+    foreach (QSharedPointer<ctkPluginArchiveSQL> updatedPA, updatedPluginArchives)
+    {
+      libraryData << QtConcurrent::run(this, &ctkPluginStorageSQL::readPluginLibrary, updatedPA->getLibLocation());
+    }
+
     try
     {
-      foreach (QSharedPointer<ctkPluginArchiveSQL> updatedPA, updatedPluginArchives)
+      for (int i = 0; i < updatedPluginArchives.size(); ++i)
       {
-        insertArchive(updatedPA, &query);
+        insertArchive(updatedPluginArchives[i], libraryData[i].result(), &query);
       }
     }
     catch (...)
     {
+      foreach (QFuture<PluginLibraryData> data, libraryData)
+      {
+        data.waitForFinished();
+      }
       rollbackTransaction(&query);
       throw;
     }
+
+    if (m_framework->debug.startup)
+    {
+      qDebug() << "startup: re-installed" << updatedPluginArchives.size() << "outdated plugins in"
+               << timer.elapsedMilli() << "ms";
+    }
   }
 
   commitTransaction(&query);
@@ -412,45 +461,31 @@ void ctkPluginStorageSQL::insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa)
 //----------------------------------------------------------------------------
 void ctkPluginStorageSQL::insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa, QSqlQuery* query)
 {
+  insertArchive(pa, readPluginLibrary(pa->getLibLocation()), query);
+}
 
-  QFileInfo fileInfo(pa->getLibLocation());
-  QString libTimestamp = getStringFromQDateTime(fileInfo.lastModified());
-
-  QString resourcePrefix = fileInfo.baseName();
-  if (resourcePrefix.startsWith("lib"))
-  {
-    resourcePrefix = resourcePrefix.mid(3);
-  }
-  resourcePrefix.replace("_", ".");
-  resourcePrefix = QString(":/") + resourcePrefix + "/";
-
-  // Load the plugin and cache the resources
-
-  QPluginLoader pluginLoader;
-  pluginLoader.setLoadHints(getPluginLoadHints());
-  pluginLoader.setFileName(pa->getLibLocation());
-  if (!pluginLoader.load())
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa, const PluginLibraryData& data,
+                                        QSqlQuery* query)
+{
+  if (!data.error.isEmpty())
   {
-    ctkPluginException exc(QString("The plugin \"%1\" could not be loaded: %2").arg(pa->getLibLocation())
-                           .arg(pluginLoader.errorString()));
-    throw exc;
+    throw ctkPluginException(data.error);
   }
 
-  QFile manifestResource(resourcePrefix + "META-INF/MANIFEST.MF");
-  manifestResource.open(QIODevice::ReadOnly);
-  QByteArray manifest = manifestResource.readAll();
-  manifestResource.close();
+  QFileInfo fileInfo(pa->getLibLocation());
+  QString libTimestamp = getStringFromQDateTime(fileInfo.lastModified());
 
   // Finally, complete the ctkPluginArchive information by reading the MANIFEST.MF resource
-  pa->readManifest(manifest);
+  pa->readManifest(data.manifest);
 
   // Assemble the data for the sql records
 
   QString version = pa->getAttribute(ctkPluginConstants::PLUGIN_VERSION);
   if (version.isEmpty()) version = "na";
 
-  QString statement = "INSERT INTO " PLUGINS_TABLE " (ID,Generation,Location,LocalPath,SymbolicName,Version,LastModified,Timestamp,StartLevel,AutoStart) "
-                      "VALUES (?,?,?,?,?,?,?,?,?,?)";
+  QString statement = "INSERT INTO " PLUGINS_TABLE " (ID,Generation,Location,LocalPath,SymbolicName,Version,LastModified,Timestamp,StartLevel,AutoStart,ResourcesIndexed) "
+                      "VALUES (?,?,?,?,?,?,?,?,?,?,?)";
 
   QList<QVariant> bindValues;
   bindValues << pa->getPluginId();
@@ -463,33 +498,221 @@ void ctkPluginStorageSQL::insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa,
   bindValues << libTimestamp;
   bindValues << pa->getStartLevel();
   bindValues << pa->getAutostartSetting();
+  bindValues << (data.resourcesIndexed ? 1 : 0);
 
   executeQuery(query, statement, bindValues);
 
   pa->key = query->lastInsertId().toInt();
 
-  // Write the plug-in resource data into the database
+  insertResources(pa->key, data.resources, query);
+
+  if (!data.resourcesIndexed)
+  {
+    QMutexLocker lock(&m_resourceCacheLock);
+    m_unindexedKeys.insert(pa->key);
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::insertResources(int key, const QList<PluginResource>& resources, QSqlQuery* query) const
+{
+  QString statement = "INSERT INTO " PLUGIN_RESOURCES_TABLE " (K,ResourcePath,Resource,Checksum) VALUES(?,?,?,?)";
+  foreach(const PluginResource& resource, resources)
+  {
+    QList<QVariant> bindValues;
+    bindValues << key;
+    bindValues << resource.path;
+    bindValues << (resource.checksum.isEmpty() ? QVariant(resource.data) : QVariant(QVariant::ByteArray));
+    bindValues << (resource.checksum.isEmpty() ? QVariant(QVariant::String) : QVariant(resource.checksum));
+
+    executeQuery(query, statement, bindValues);
+  }
+}
+
+//----------------------------------------------------------------------------
+ctkPluginStorageSQL::PluginLibraryData ctkPluginStorageSQL::readPluginLibrary(const QString& libLocation) const
+{
+  PluginLibraryData data;
+  data.resourcesIndexed = true;
+
+  if (m_indexResources)
+  {
+    // A manifest next to the library spares loading it, which also loads
+    // all its dependencies. The resources are indexed on first access.
+    QFile manifestFile(libLocation + ".MF");
+    if (manifestFile.open(QIODevice::ReadOnly))
+    {
+      data.manifest = manifestFile.readAll();
+      manifestFile.close();
+
+      PluginResource manifestResource;
+      manifestResource.path = "/META-INF/MANIFEST.MF";
+      manifestResource.checksum = QString(QCryptographicHash::hash(data.manifest, QCryptographicHash::Sha1).toHex());
+      writeResourceCache(manifestResource.checksum, data.manifest);
+
+      data.resources << manifestResource;
+      data.resourcesIndexed = false;
+      return data;
+    }
+  }
+
+  QString resourcePrefix = getResourcePrefix(libLocation);
+
+  // Load the plugin and cache the resources
+
+  QPluginLoader pluginLoader;
+  pluginLoader.setLoadHints(getPluginLoadHints());
+  pluginLoader.setFileName(libLocation);
+  if (!pluginLoader.load())
+  {
+    data.error = QString("The plugin \"%1\" could not be loaded: %2").arg(libLocation)
+        .arg(pluginLoader.errorString());
+    return data;
+  }
+
+  QFile manifestResource(resourcePrefix + "META-INF/MANIFEST.MF");
+  manifestResource.open(QIODevice::ReadOnly);
+  data.manifest = manifestResource.readAll();
+  manifestResource.close();
+
+  data.resources = readPluginResources(resourcePrefix);
+
+  pluginLoader.unload();
+  return data;
+}
+
+//----------------------------------------------------------------------------
+QList<ctkPluginStorageSQL::PluginResource> ctkPluginStorageSQL::readPluginResources(const QString& resourcePrefix) const
+{
+  // Read the plug-in resource data for the database. When only indexing the
+  // resources, the checksum of the data is stored instead. It names the file of
+  // the resource cache, which is filled on first access.
+  QList<PluginResource> resources;
   QDirIterator dirIter(resourcePrefix, QDirIterator::Subdirectories);
   while (dirIter.hasNext())
   {
     QString resourcePath = dirIter.next();
     if (QFileInfo(resourcePath).isDir()) continue;
 
-    QFile resourceFile(resourcePath);
-    resourceFile.open(QIODevice::ReadOnly);
-    QByteArray resourceData = resourceFile.readAll();
-    resourceFile.close();
+    PluginResource resource;
+    resource.path = resourcePath.mid(resourcePrefix.size()-1);
+
+    if (m_indexResources)
+    {
+      // uncompressed resources are hashed in place, without copying them
+      QResource qresource(resourcePath);
+      QByteArray resourceData;
+      if (qresource.isCompressed())
+      {
+        QFile resourceFile(resourcePath);
+        resourceFile.open(QIODevice::ReadOnly);
+        resourceData = resourceFile.readAll();
+        resourceFile.close();
+      }
+      else
+      {
+        resourceData = QByteArray::fromRawData(reinterpret_cast<const char*>(qresource.data()), qresource.size());
+      }
+      resource.checksum = QString(QCryptographicHash::hash(resourceData, QCryptographicHash::Sha1).toHex());
 
-    statement = "INSERT INTO " PLUGIN_RESOURCES_TABLE " (K,ResourcePath,Resource) VALUES(?,?,?)";
-    bindValues.clear();
-    bindValues << pa->key;
-    bindValues << resourcePath.mid(resourcePrefix.size()-1);
-    bindValues << resourceData;
+      // the manifest is read at each framework start, cache it right away
+      if (resourcePath == resourcePrefix + "META-INF/MANIFEST.MF")
+      {
+        writeResourceCache(resource.checksum, resourceData);
+      }
+    }
+    else
+    {
+      QFile resourceFile(resourcePath);
+      resourceFile.open(QIODevice::ReadOnly);
+      resource.data = resourceFile.readAll();
+      resourceFile.close();
+    }
 
-    executeQuery(query, statement, bindValues);
+    resources << resource;
+  }
+  return resources;
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginStorageSQL::indexPluginResources(int key) const
+{
+  QMutexLocker lock(&m_resourceCacheLock);
+  if (!m_unindexedKeys.contains(key))
+  {
+    return false;
+  }
+
+  QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+  QSqlQuery query(database);
+
+  QList<QVariant> bindValues;
+  bindValues.append(key);
+  QString libLocation;
+  try
+  {
+    executeQuery(&query, "SELECT LocalPath FROM " PLUGINS_TABLE " WHERE K=?", bindValues);
+  }
+  catch (const ctkPluginDatabaseException& exc)
+  {
+    qWarning() << "Indexing the resources of plugin" << key << "failed:" << exc.what();
+    return false;
+  }
+  if (!query.next())
+  {
+    m_unindexedKeys.remove(key);
+    return false;
   }
+  libLocation = query.value(EBindIndex).toString();
+  query.finish();
+  query.clear();
 
+  // the plugin stays unindexed, the indexing is tried again on the next access
+  QPluginLoader pluginLoader;
+  pluginLoader.setLoadHints(getPluginLoadHints());
+  pluginLoader.setFileName(libLocation);
+  if (!pluginLoader.load())
+  {
+    qWarning() << "Indexing the resources of" << libLocation << "failed, the plugin could not be loaded:"
+               << pluginLoader.errorString();
+    return false;
+  }
+
+  // the manifest has been indexed at installation
+  QList<PluginResource> resources = readPluginResources(getResourcePrefix(libLocation));
   pluginLoader.unload();
+  for (int i = 0; i < resources.size(); ++i)
+  {
+    if (resources[i].path == "/META-INF/MANIFEST.MF")
+    {
+      resources.removeAt(i);
+      break;
+    }
+  }
+
+  try
+  {
+    beginTransaction(&query, Write);
+    try
+    {
+      insertResources(key, resources, &query);
+      executeQuery(&query, "UPDATE " PLUGINS_TABLE " SET ResourcesIndexed=1 WHERE K=?", bindValues);
+    }
+    catch (...)
+    {
+      rollbackTransaction(&query);
+      throw;
+    }
+    commitTransaction(&query);
+  }
+  catch (const ctkPluginDatabaseException& exc)
+  {
+    qWarning() << "Indexing the resources of" << libLocation << "failed:" << exc.what();
+    return false;
+  }
+
+  m_unindexedKeys.remove(key);
+  return true;
 }
 
 //----------------------------------------------------------------------------
@@ -596,6 +819,9 @@ void ctkPluginStorageSQL::removeArchiveFromDB(ctkPluginArchiveSQL* pa, QSqlQuery
   bindValues.append(pa->key);
 
   executeQuery(query, statement, bindValues);
+
+  QMutexLocker lock(&m_resourceCacheLock);
+  m_unindexedKeys.remove(pa->key);
 }
 
 QList<QSharedPointer<ctkPluginArchive> > ctkPluginStorageSQL::getAllPluginArchives() const
@@ -669,6 +895,8 @@ QStringList ctkPluginStorageSQL::findResourcesPath(int archiveKey, const QString
 {
   checkConnection();
 
+  indexPluginResources(archiveKey);
+
   QString statement = "SELECT SUBSTR(ResourcePath,?) FROM PluginResources WHERE K=? AND SUBSTR(ResourcePath,1,?)=?";
 
   QString resourcePath = path.startsWith('/') ? path : QString("/") + path;
@@ -815,7 +1043,8 @@ QByteArray ctkPluginStorageSQL::getPluginResource(int key, const QString& res) c
   QSqlDatabase database = QSqlDatabase::database(m_connectionName);
   QSqlQuery query(database);
 
-  QString statement = "SELECT Resource FROM PluginResources WHERE K=? AND ResourcePath=?";
+  QString statement = "SELECT r.Resource,r.Checksum,p.LocalPath FROM " PLUGIN_RESOURCES_TABLE " r"
+                      " JOIN " PLUGINS_TABLE " p ON r.K=p.K WHERE r.K=? AND r.ResourcePath=?";
 
   QString resourcePath = res.startsWith('/') ? res : QString("/") + res;
   QList<QVariant> bindValues;
@@ -824,14 +1053,128 @@ QByteArray ctkPluginStorageSQL::getPluginResource(int key, const QString& res) c
 
   executeQuery(&query, statement, bindValues);
 
-  if (query.next())
+  bool found = query.next();
+  if (!found)
+  {
+    query.finish();
+    if (indexPluginResources(key))
+    {
+      executeQuery(&query, statement, bindValues);
+      found = query.next();
+    }
+  }
+
+  if (found)
   {
-    return query.value(EBindIndex).toByteArray();
+    const QString checksum = query.value(EBindIndex1).toString();
+    if (checksum.isEmpty())
+    {
+      return query.value(EBindIndex).toByteArray();
+    }
+
+    const QString libLocation = query.value(EBindIndex2).toString();
+    query.finish();
+    return getCachedPluginResource(libLocation, resourcePath, checksum);
   }
 
   return QByteArray();
 }
 
+//----------------------------------------------------------------------------
+QByteArray ctkPluginStorageSQL::getCachedPluginResource(const QString& libLocation, const QString& resourcePath,
+                                                        const QString& checksum) const
+{
+  QMutexLocker lock(&m_resourceCacheLock);
+
+  QHash<QString, QByteArray>::const_iterator mapped = m_mappedResources.find(checksum);
+  if (mapped != m_mappedResources.end())
+  {
+    return mapped.value();
+  }
+
+  QFile* cacheFile = new QFile(QDir(m_resourceCachePath).absoluteFilePath(checksum));
+  if (!cacheFile->exists())
+  {
+    // First access, read the resource from the plug-in library
+    QPluginLoader pluginLoader;
+    pluginLoader.setLoadHints(getPluginLoadHints());
+    pluginLoader.setFileName(libLocation);
+    if (!pluginLoader.load())
+    {
+      delete cacheFile;
+      qWarning() << "Reading resource" << resourcePath << "failed, the plugin" << libLocation
+                 << "could not be loaded:" << pluginLoader.errorString();
+      return QByteArray();
+    }
+
+    QFile resourceFile(getResourcePrefix(libLocation) + resourcePath.mid(1));
+    resourceFile.open(QIODevice::ReadOnly);
+    QByteArray resourceData = resourceFile.readAll();
+    resourceFile.close();
+    pluginLoader.unload();
+
+    // The library may have changed since the resources were indexed, its
+    // content must not be cached under the checksum of another content
+    if (QString(QCryptographicHash::hash(resourceData, QCryptographicHash::Sha1).toHex()) != checksum)
+    {
+      delete cacheFile;
+      qWarning() << "Resource" << resourcePath << "of" << libLocation
+                 << "does not match its checksum, it is not cached";
+      return resourceData;
+    }
+
+    writeResourceCache(checksum, resourceData);
+    if (!cacheFile->exists())
+    {
+      delete cacheFile;
+      return resourceData;
+    }
+  }
+
+  QByteArray resourceData;
+  if (cacheFile->open(QIODevice::ReadOnly))
+  {
+    uchar* data = cacheFile->size() > 0 ? cacheFile->map(0, cacheFile->size()) : 0;
+    if (data)
+    {
+      // the file is never modified, so the mapped data can be shared without copying it
+      resourceData = QByteArray::fromRawData(reinterpret_cast<const char*>(data), cacheFile->size());
+      m_mappedResources.insert(checksum, resourceData);
+      m_mappedResourceFiles.push_back(cacheFile);
+      return resourceData;
+    }
+    resourceData = cacheFile->readAll();
+  }
+  delete cacheFile;
+  return resourceData;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStorageSQL::writeResourceCache(const QString& checksum, const QByteArray& data) const
+{
+  QDir cacheDir(m_resourceCachePath);
+  if (cacheDir.exists(checksum) || !QDir::root().mkpath(m_resourceCachePath))
+  {
+    return;
+  }
+
+  // The file is renamed once complete, readers never see a partially written
+  // file. Plugin libraries are read in parallel, so the temporary name is unique.
+  QTemporaryFile tmpFile(cacheDir.absoluteFilePath(checksum + ".XXXXXX"));
+  tmpFile.setAutoRemove(false);
+  if (!tmpFile.open() || tmpFile.write(data) != data.size())
+  {
+    qWarning() << "Could not write the resource cache file" << tmpFile.fileName() << ":" << tmpFile.errorString();
+    tmpFile.remove();
+    return;
+  }
+  tmpFile.close();
+  if (!QFile::rename(tmpFile.fileName(), cacheDir.absoluteFilePath(checksum)))
+  {
+    tmpFile.remove();
+  }
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginStorageSQL::createTables()
 {
@@ -852,7 +1195,8 @@ void ctkPluginStorageSQL::createTables()
                       "LastModified TEXT NOT NULL,"
                       "Timestamp TEXT NOT NULL,"
                       "StartLevel INTEGER NOT NULL,"
-                      "AutoStart INTEGER NOT NULL)");
+                      "AutoStart INTEGER NOT NULL,"
+                      "ResourcesIndexed INTEGER NOT NULL DEFAULT 1)");
     try
     {
       executeQuery(&query, statement);
@@ -866,7 +1210,8 @@ void ctkPluginStorageSQL::createTables()
     statement = "CREATE TABLE " PLUGIN_RESOURCES_TABLE " ("
                 "K INTEGER NOT NULL,"
                 "ResourcePath TEXT NOT NULL,"
-                "Resource BLOB NOT NULL,"
+                "Resource BLOB,"
+                "Checksum TEXT,"
                 "FOREIGN KEY(K) REFERENCES " PLUGINS_TABLE "(K) ON DELETE CASCADE)";
     try
     {
@@ -896,7 +1241,9 @@ bool ctkPluginStorageSQL::checkTables() const
   bool bTables(false);
   QStringList tables = QSqlDatabase::database(m_connectionName).tables();
   if (tables.contains(PLUGINS_TABLE) &&
-      tables.contains(PLUGIN_RESOURCES_TABLE))
+      tables.contains(PLUGIN_RESOURCES_TABLE) &&
+      QSqlDatabase::database(m_connectionName).record(PLUGINS_TABLE).contains("ResourcesIndexed") &&
+      QSqlDatabase::database(m_connectionName).record(PLUGIN_RESOURCES_TABLE).contains("Checksum"))
   {
     bTables = true;
   }
@@ -1006,7 +1353,7 @@ void ctkPluginStorageSQL::checkConnection() const
 }
 
 //----------------------------------------------------------------------------
-void ctkPluginStorageSQL::beginTransaction(QSqlQuery *query, TransactionType type)
+void ctkPluginStorageSQL::beginTransaction(QSqlQuery *query, TransactionType type) const
 {
   bool success;
   if (type == Read)
@@ -1034,7 +1381,7 @@ void ctkPluginStorageSQL::beginTransaction(QSqlQuery *query, TransactionType typ
 }
 
 //----------------------------------------------------------------------------
-void ctkPluginStorageSQL::commitTransaction(QSqlQuery *query)
+void ctkPluginStorageSQL::commitTransaction(QSqlQuery *query) const
 {
   Q_ASSERT(query != 0);
   query->finish();
@@ -1047,7 +1394,7 @@ void ctkPluginStorageSQL::commitTransaction(QSqlQuery *query)
 }
 
 //----------------------------------------------------------------------------
-void ctkPluginStorageSQL::rollbackTransaction(QSqlQuery *query)
+void ctkPluginStorageSQL::rollbackTransaction(QSqlQuery *query) const
 {
   Q_ASSERT(query !=0);
   query->finish();
@@ -1066,10 +1413,12 @@ void ctkPluginStorageSQL::restorePluginArchives()
   checkConnection();
 
   QSqlQuery query(QSqlDatabase::database(m_connectionName));
-  QString statement = "SELECT ID, Location, LocalPath, StartLevel, LastModified, AutoStart, K, MAX(Generation)"
+  QString statement = "SELECT ID, Location, LocalPath, StartLevel, LastModified, AutoStart, K, ResourcesIndexed, MAX(Generation)"
                       " FROM " PLUGINS_TABLE " WHERE StartLevel != -2 GROUP BY ID"
                       " ORDER BY ID";
 
+  ctkHighPrecisionTimer timer;
+  timer.start();
   executeQuery(&query, statement);
 
   while (query.next())
@@ -1093,6 +1442,11 @@ void ctkPluginStorageSQL::restorePluginArchives()
       QSharedPointer<ctkPluginArchiveSQL> pa(new ctkPluginArchiveSQL(this, location, localPath, id,
                                                                      startLevel, lastModified, autoStart));
       pa->key = query.value(EBindIndex6).toInt();
+      if (!query.value(EBindIndex7).toBool())
+      {
+        QMutexLocker lock(&m_resourceCacheLock);
+        m_unindexedKeys.insert(pa->key);
+      }
       pa->readManifest();
       m_archives.append(pa);
     }
@@ -1101,6 +1455,11 @@ void ctkPluginStorageSQL::restorePluginArchives()
       qWarning() << exc;
     }
   }
+
+  if (m_framework->debug.startup)
+  {
+    qDebug() << "startup: restored" << m_archives.size() << "plugin archives in" << timer.elapsedMilli() << "ms";
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -132,6 +132,11 @@ public:
    * must be relative to the plugin specific resource prefix, but may
    * start with a '/'.
    *
+   * If the plugin was installed with the resource storage mode
+   * ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX, the returned
+   * byte array refers to a memory-mapped file of the resource cache which
+   * stays valid as long as this storage exists.
+   *
    * @param pluginId The id of the plugin from which to get the resource
    * @param res The path to the resource in the plugin
    * @return The byte array of the cached resource
@@ -276,6 +281,74 @@ private:
 
   void insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa, QSqlQuery* query);
 
+  /**
+   * A resource of a plugin library as stored in the PluginResources table:
+   * either its data or the checksum naming its resource cache file.
+   */
+  struct PluginResource
+  {
+    QString path;
+    QByteArray data;
+    QString checksum;
+  };
+
+  /**
+   * The data of a plugin library which is written to the database by insertArchive().
+   */
+  struct PluginLibraryData
+  {
+    QByteArray manifest;
+    QList<PluginResource> resources;
+    bool resourcesIndexed;
+    QString error;
+  };
+
+  /**
+   * Read the manifest and the resources of the plugin library at \a libLocation.
+   *
+   * If only the resources are indexed and a manifest file named like the
+   * library with a ".MF" suffix exists, the library is not loaded. Its
+   * resources are then indexed on first access, see indexPluginResources().
+   *
+   * This method does not access the database and can be called from any
+   * thread. Errors are reported in PluginLibraryData::error.
+   */
+  PluginLibraryData readPluginLibrary(const QString& libLocation) const;
+
+  /**
+   * Read the resources under \a resourcePrefix of a loaded plugin library.
+   */
+  QList<PluginResource> readPluginResources(const QString& resourcePrefix) const;
+
+  void insertArchive(QSharedPointer<ctkPluginArchiveSQL> pa, const PluginLibraryData& data, QSqlQuery* query);
+
+  void insertResources(int key, const QList<PluginResource>& resources, QSqlQuery* query) const;
+
+  /**
+   * Index the resources of the plugin with the given \a key if it was
+   * installed without loading its library.
+   *
+   * Errors are logged as warnings, the plugin then stays unindexed and
+   * its resources are not found.
+   *
+   * @return \c true if resources were added to the index
+   */
+  bool indexPluginResources(int key) const;
+
+  /**
+   * Get a resource from the memory-mapped resource cache. On first access, the
+   * resource is read from the plugin library at \a libLocation and written
+   * to the cache file named after its \a checksum, if its SHA-1 checksum
+   * still matches.
+   */
+  QByteArray getCachedPluginResource(const QString& libLocation, const QString& resourcePath,
+                                     const QString& checksum) const;
+
+  /**
+   * Write \a data to the resource cache file named after its \a checksum.
+   */
+  void writeResourceCache(const QString& checksum, const QByteArray& data) const;
+
   void removeArchiveFromDB(ctkPluginArchiveSQL *pa, QSqlQuery *query);
 
   /**
@@ -296,21 +369,21 @@ private:
    *
    * @throws ctkPluginDatabaseException
    */
-  void beginTransaction(QSqlQuery* query, TransactionType);
+  void beginTransaction(QSqlQuery* query, TransactionType) const;
 
   /**
    * Commits a transaction
    *
    * @throws ctkPluginDatabaseException
    */
-  void commitTransaction(QSqlQuery* query);
+  void commitTransaction(QSqlQuery* query) const;
 
   /**
    * Rolls back a transaction
    *
    * @throws ctkPluginDatabaseException
    */
-  void rollbackTransaction(QSqlQuery* query);
+  void rollbackTransaction(QSqlQuery* query) const;
 
   /**
    * Returns a string representation of a QDateTime instance.
@@ -324,12 +397,31 @@ private:
 
 
   QString m_databasePath;
+  QString m_resourceCachePath;
   QString m_connectionName;
   bool m_isDatabaseOpen;
   bool m_inTransaction;
 
+  /**
+   * Only index the resource paths of installed plugins, see
+   * ctkPluginConstants::FRAMEWORK_STORAGE_RESOURCES_INDEX
+   */
+  bool m_indexResources;
+
   QMutex m_archivesLock;
 
+  /**
+   * Memory-mapped resource cache files, by checksum
+   */
+  mutable QMutex m_resourceCacheLock;
+  mutable QHash<QString, QByteArray> m_mappedResources;
+  mutable QList<QFile*> m_mappedResourceFiles;
+
+  /**
+   * Keys of the plugins whose resources are not indexed yet
+   */
+  mutable QSet<int> m_unindexedKeys;
+
   /**
    * Plugin id sorted list of all active plugin archives.
    */
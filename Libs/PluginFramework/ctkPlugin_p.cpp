@@ -34,6 +34,7 @@
 
 // for ctk::msecsTo() - remove after switching to Qt 4.7
 #include <ctkUtils.h>
+#include <ctkHighPrecisionTimer.h>
 
 #include <typeinfo>
 
@@ -190,9 +191,15 @@ ctkPlugin::State ctkPluginPrivate::getUpdatedState_unlocked()
     {
       if (state == ctkPlugin::INSTALLED)
       {
+        ctkHighPrecisionTimer timer;
+        timer.start();
         operation.fetchAndStoreOrdered(RESOLVING);
         fwCtx->resolvePlugin(this);
         state = ctkPlugin::RESOLVED;
+        if (fwCtx->debug.startup)
+        {
+          qDebug() << "startup: resolved" << symbolicName << "[" << id << "] in" << timer.elapsedMilli() << "ms";
+        }
         // TODO plugin threading
         //bundleThread().bundleChanged(new BundleEvent(BundleEvent.RESOLVED, this));
         fwCtx->listeners.emitPluginChanged(ctkPluginEvent(ctkPluginEvent::RESOLVED, this->q_func()));
@@ -724,8 +731,12 @@ ctkPluginException* ctkPluginPrivate::start0()
   fwCtx->listeners.emitPluginChanged(ctkPluginEvent(ctkPluginEvent::STARTING, this->q_func()));
 
   ctkPluginException::Type error_type = ctkPluginException::MANIFEST_ERROR;
+  ctkHighPrecisionTimer timer;
+  timer.start();
+  qint64 loadTime = 0;
   try {
     pluginLoader.load();
+    loadTime = timer.elapsedMilli();
     if (!pluginLoader.isLoaded())
     {
       error_type = ctkPluginException::ACTIVATOR_ERROR;
@@ -770,6 +781,12 @@ ctkPluginException* ctkPluginPrivate::start0()
     qDebug() << "activating #" << id << "completed.";
   }
 
+  if (fwCtx->debug.startup)
+  {
+    qDebug() << "startup: started" << symbolicName << "[" << id << "] in" << timer.elapsedMilli()
+             << "ms, loading the library took" << loadTime << "ms";
+  }
+
   if (res == 0)
   {
     //10:
@@ -28,6 +28,8 @@
 #include "ctkPlugins_p.h"
 #include "ctkVersionRange_p.h"
 
+#include <ctkHighPrecisionTimer.h>
+
 #include <stdexcept>
 #include <iostream>
 
@@ -60,6 +62,9 @@ QSharedPointer<ctkPlugin> ctkPlugins::install(const QUrl& location, QIODevice* i
 {
   checkIllegalState();
 
+  ctkHighPrecisionTimer timer;
+  timer.start();
+
   QSharedPointer<ctkPlugin> res;
   {
     QMutexLocker lock(&objectLock);
@@ -143,6 +148,12 @@ QSharedPointer<ctkPlugin> ctkPlugins::install(const QUrl& location, QIODevice* i
     }
   }
 
+  if (fwCtx->debug.startup)
+  {
+    qDebug() << "startup: installed" << res->getSymbolicName() << "[" << res->getPluginId() << "] in"
+             << timer.elapsedMilli() << "ms";
+  }
+
   fwCtx->listeners.emitPluginChanged(ctkPluginEvent(ctkPluginEvent::INSTALLED, res));
   return res;
 }
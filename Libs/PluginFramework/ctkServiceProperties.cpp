@@ -29,7 +29,8 @@ ctkServiceProperties::ctkServiceProperties(const ctkProperties& props)
   for(ctkProperties::ConstIterator i = props.begin(), end = props.end();
       i != end; ++i)
   {
-    if (find(i.key()) != -1)
+    QString foldedKey = i.key().toCaseFolded();
+    if (findCaseFolded(foldedKey) != -1)
     {
       QString msg("ctkProperties object contains case variants of the key: ");
       msg += i.key();
@@ -37,6 +38,7 @@ ctkServiceProperties::ctkServiceProperties(const ctkProperties& props)
     }
     ks.append(i.key());
     vs.append(i.value());
+    fks.append(foldedKey);
   }
 }
 
@@ -68,9 +70,15 @@ QStringList ctkServiceProperties::keys() const
 //----------------------------------------------------------------------------
 int ctkServiceProperties::find(const QString &key) const
 {
-  for (int i = 0; i < ks.size(); ++i)
+  return findCaseFolded(key.toCaseFolded());
+}
+
+//----------------------------------------------------------------------------
+int ctkServiceProperties::findCaseFolded(const QString &foldedKey) const
+{
+  for (int i = 0; i < fks.size(); ++i)
   {
-    if (ks[i].compare(key, Qt::CaseInsensitive) == 0)
+    if (fks[i] == foldedKey)
       return i;
   }
   return -1;
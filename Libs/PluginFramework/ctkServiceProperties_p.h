@@ -34,6 +34,8 @@ private:
 
   QVarLengthArray<QString,10> ks;
   QVarLengthArray<QVariant,10> vs;
+  // case folded keys, for case insensitive lookups
+  QVarLengthArray<QString,10> fks;
 
   QMap<QString, QVariant> map;
 
@@ -46,6 +48,11 @@ public:
 
   int find(const QString& key) const;
   int findCaseSensitive(const QString& key) const;
+  /**
+   * Same as find(), \a foldedKey must already be case folded
+   * (see QString::toCaseFolded()).
+   */
+  int findCaseFolded(const QString& foldedKey) const;
 
   QStringList keys() const;
 
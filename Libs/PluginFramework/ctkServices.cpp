@@ -63,7 +63,7 @@ ctkDictionary ctkServices::createServiceProperties(const ctkDictionary& in,
 
 //----------------------------------------------------------------------------
 ctkServices::ctkServices(ctkPluginFrameworkContext* fwCtx)
-  : mutex(), framework(fwCtx)
+  : mutex(), filterCache(128), framework(fwCtx)
 {
 
 }
@@ -79,6 +79,7 @@ void ctkServices::clear()
 {
   services.clear();
   classServices.clear();
+  filterCache.clear();
   framework = 0;
 }
 
@@ -196,76 +197,74 @@ QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const
 {
   Q_UNUSED(plugin)
 
-  QListIterator<ctkServiceRegistration>* s = 0;
   QList<ctkServiceRegistration> v;
   ctkLDAPExpr ldap;
   if (clazz.isEmpty())
   {
     if (!filter.isEmpty())
     {
-      ldap = ctkLDAPExpr(filter);
+      ldap = getLDAPExpr_unlocked(filter);
       QSet<QString> matched;
       if (ldap.getMatchedObjectClasses(matched))
       {
-        v.clear();
         foreach (QString className, matched)
         {
-          const QList<ctkServiceRegistration>& cl = classServices[className];
-          v += cl;
+          v += classServices.value(className);
         }
-        if (!v.isEmpty())
-        {
-          s = new QListIterator<ctkServiceRegistration>(v);
-        }
-        else
+        if (v.isEmpty())
         {
           return QList<ctkServiceReference>();
         }
       }
       else
       {
-        s = new QListIterator<ctkServiceRegistration>(services.keys());
+        v = services.keys();
       }
     }
     else
     {
-      s = new QListIterator<ctkServiceRegistration>(services.keys());
+      v = services.keys();
     }
   }
   else
   {
-    QList<ctkServiceRegistration> v = classServices.value(clazz);
-    if (!v.isEmpty())
-    {
-      s = new QListIterator<ctkServiceRegistration>(v);
-    }
-    else
+    v = classServices.value(clazz);
+    if (v.isEmpty())
     {
       return QList<ctkServiceReference>();
     }
     if (!filter.isEmpty())
     {
-      ldap = ctkLDAPExpr(filter);
+      ldap = getLDAPExpr_unlocked(filter);
     }
   }
 
   QList<ctkServiceReference> res;
-  while (s->hasNext())
+  for (QList<ctkServiceRegistration>::const_iterator sr = v.constBegin(), end = v.constEnd();
+       sr != end; ++sr)
   {
-    ctkServiceRegistration sr = s->next();
-    ctkServiceReference sri = sr.getReference();
-
-    if (filter.isEmpty() || ldap.evaluate(sr.d_func()->properties, false))
+    if (filter.isEmpty() || ldap.evaluate(sr->d_func()->properties, false))
     {
-      res.push_back(sri);
+      res.push_back(sr->getReference());
     }
   }
 
-  delete s;
-
   return res;
 }
 
+//----------------------------------------------------------------------------
+ctkLDAPExpr ctkServices::getLDAPExpr_unlocked(const QString& filter) const
+{
+  if (ctkLDAPExpr* cached = filterCache.object(filter))
+  {
+    return *cached;
+  }
+  // throws on malformed filters, which are not cached
+  ctkLDAPExpr ldap(filter);
+  filterCache.insert(filter, new ctkLDAPExpr(ldap));
+  return ldap;
+}
+
 //----------------------------------------------------------------------------
 void ctkServices::removeServiceRegistration(const ctkServiceRegistration& sr)
 {
@@ -23,6 +23,7 @@
 #ifndef CTKSERVICES_P_H
 #define CTKSERVICES_P_H
 
+#include <QCache>
 #include <QHash>
 #include <QObject>
 #include <QMutex>
@@ -30,6 +31,7 @@
 
 #include "ctkPlugin_p.h"
 #include "ctkServiceRegistration.h"
+#include "ctkLDAPExpr_p.h"
 
 
 /**
@@ -181,9 +183,23 @@ public:
 
 private:
 
+  /**
+   * Parsed filters of the last lookups, keyed by filter string.
+   * Guarded by mutex.
+   */
+  mutable QCache<QString, ctkLDAPExpr> filterCache;
+
   QList<ctkServiceReference> get_unlocked(const QString& clazz, const QString& filter,
                                           ctkPluginPrivate* plugin) const;
 
+  /**
+   * Get the parsed expression of <code>filter</code> from the filter
+   * cache, parsing it if it is not cached yet.
+   *
+   * @exception ctkInvalidArgumentException If the filter is malformed.
+   */
+  ctkLDAPExpr getLDAPExpr_unlocked(const QString& filter) const;
+
 };
 
 
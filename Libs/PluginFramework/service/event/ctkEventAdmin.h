@@ -48,6 +48,18 @@ struct ctkEventAdmin
    */
   virtual void postEvent(const ctkEvent& event) = 0;
 
+  /**
+   * Initiate asynchronous, ordered delivery of a list of events. This has the
+   * same effect as calling postEvent() for each event in the list, but allows
+   * the implementation to determine the event handlers only once per topic.
+   *
+   * @param events The events to send to all listeners which subscribe to the
+   *        topics of the events.
+   *
+   * @see postEvent()
+   */
+  virtual void postEvents(const QList<ctkEvent>& events) = 0;
+
   /**
    * Initiate synchronous delivery of an event. This method does not return to
    * the caller until delivery of the event is completed.
@@ -30,6 +30,22 @@
 
 int main(int argc, char** argv)
 {
+  // --work-stealing runs the tests with the work-stealing asynchronous pool
+  bool workStealing = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (qstrcmp(argv[i], "--work-stealing") == 0)
+    {
+      workStealing = true;
+      for (int j = i; j < argc - 1; ++j)
+      {
+        argv[j] = argv[j+1];
+      }
+      --argc;
+      break;
+    }
+  }
+
   QCoreApplication app(argc, argv);
 
   ctkPluginFrameworkTestRunner testRunner;
@@ -64,6 +80,7 @@ int main(int argc, char** argv)
   fwProps.insert("event.impl", "org.commontk.eventadmin");
 
   fwProps.insert("org.commontk.eventadmin.ThreadPoolSize", 10);
+  fwProps.insert("org.commontk.eventadmin.WorkStealing", workStealing);
 
   testRunner.init(fwProps);
   return testRunner.run(argc, argv);
@@ -64,6 +64,7 @@ int main(int argc, char** argv)
   fwProps.insert("event.impl", "org.commontk.eventadmin");
 
   fwProps.insert("org.commontk.eventadmin.ThreadPoolSize", 10);
+  fwProps.insert("org.commontk.eventadmin.CoalesceTopics", "org/commontk/coalesce/*:id");
 
   testRunner.init(fwProps);
   return testRunner.run(argc, argv);
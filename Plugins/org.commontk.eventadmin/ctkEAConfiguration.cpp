@@ -28,6 +28,7 @@
 #include "adapter/ctkEALogEventAdapter_p.h"
 #include "adapter/ctkEAPluginEventAdapter_p.h"
 #include "adapter/ctkEAServiceEventAdapter_p.h"
+#include "dispatch/ctkEAWorkStealingThreadPool_p.h"
 
 #include <ctkPluginContext.h>
 #include <ctkPluginConstants.h>
@@ -42,6 +43,9 @@ const QString ctkEAConfiguration::PROP_TIMEOUT = "org.commontk.eventadmin.Timeou
 const QString ctkEAConfiguration::PROP_REQUIRE_TOPIC = "org.commontk.eventadmin.RequireTopic";
 const QString ctkEAConfiguration::PROP_IGNORE_TIMEOUT = "org.commontk.eventadmin.IgnoreTimeout";
 const QString ctkEAConfiguration::PROP_LOG_LEVEL = "org.commontk.eventadmin.LogLevel";
+const QString ctkEAConfiguration::PROP_WORK_STEALING = "org.commontk.eventadmin.WorkStealing";
+const QString ctkEAConfiguration::PROP_COALESCE_TOPICS = "org.commontk.eventadmin.CoalesceTopics";
+const QString ctkEAConfiguration::PROP_COALESCE_WINDOW = "org.commontk.eventadmin.CoalesceWindow";
 
 
 ctkEAConfiguration::ctkEAConfiguration(ctkPluginContext* pluginContext )
@@ -137,6 +141,16 @@ void ctkEAConfiguration::configure(const ctkDictionary& config )
                               pluginContext->getProperty(PROP_LOG_LEVEL),
                               ctkLogService::LOG_WARNING, // default log level is WARNING
                               ctkLogService::LOG_ERROR);
+
+    // Use lock-free per-thread queues for the asynchronous event delivery
+    // instead of the shared queue of the default thread pool.
+    workStealing = getBoolProperty(pluginContext->getProperty(PROP_WORK_STEALING), false);
+
+    // Posted events of these topics are merged within the coalescing window
+    // (in milliseconds) and only the last event of each key is delivered.
+    coalesceTopics = pluginContext->getProperty(PROP_COALESCE_TOPICS).toStringList();
+    coalesceWindow = getIntProperty(PROP_COALESCE_WINDOW,
+                                    pluginContext->getProperty(PROP_COALESCE_WINDOW), 50, 1);
   }
   else
   {
@@ -159,6 +173,9 @@ void ctkEAConfiguration::configure(const ctkDictionary& config )
                               config.value(PROP_LOG_LEVEL),
                               ctkLogService::LOG_WARNING, // default log level is WARNING
                               ctkLogService::LOG_ERROR);
+    workStealing = getBoolProperty(config.value(PROP_WORK_STEALING), false);
+    coalesceTopics = config.value(PROP_COALESCE_TOPICS).toStringList();
+    coalesceWindow = getIntProperty(PROP_COALESCE_WINDOW, config.value(PROP_COALESCE_WINDOW), 50, 1);
   }
   // a timeout less or equals to 100 means : disable timeout
   if (timeout <= 100)
@@ -222,10 +239,15 @@ void ctkEAConfiguration::startOrUpdate()
       << PROP_TIMEOUT << "=" << timeout;
   CTK_DEBUG(ctkEventAdminActivator::getLogService())
       << PROP_REQUIRE_TOPIC << "=" << requireTopic;
+  CTK_DEBUG(ctkEventAdminActivator::getLogService())
+      << PROP_WORK_STEALING << "=" << workStealing;
+  CTK_DEBUG(ctkEventAdminActivator::getLogService())
+      << PROP_COALESCE_TOPICS << "=" << coalesceTopics.join(",");
+  CTK_DEBUG(ctkEventAdminActivator::getLogService())
+      << PROP_COALESCE_WINDOW << "=" << coalesceWindow;
 
-  ctkEventAdminService::TopicHandlerFiltersInterface* topicHandlerFilters =
-      new ctkEventAdminService::TopicHandlerFilters(
-        new ctkEventAdminService::TopicCacheMap(cacheSize), requireTopic);
+  ctkEATopicHandlerIndex* topicHandlerIndex =
+      new ctkEATopicHandlerIndex(pluginContext, requireTopic);
 
   ctkEventAdminService::FiltersInterface* filters =
       new ctkEventAdminService::Filters(
@@ -247,7 +269,16 @@ void ctkEAConfiguration::startOrUpdate()
   int asyncThreadPoolSize = threadPoolSize > 5 ? threadPoolSize / 2 : 2;
   if (async_pool == 0)
   {
-    async_pool = new ctkEADefaultThreadPool(asyncThreadPoolSize, false);
+    // The kind of pool is chosen once, pending tasks cannot be moved
+    // to another pool
+    if (workStealing)
+    {
+      async_pool = new ctkEAWorkStealingThreadPool(asyncThreadPoolSize);
+    }
+    else
+    {
+      async_pool = new ctkEADefaultThreadPool(asyncThreadPoolSize, false);
+    }
   }
   else
   {
@@ -260,12 +291,12 @@ void ctkEAConfiguration::startOrUpdate()
   // below (and not in this HandlerTasks object!)
   ctkEventAdminService::HandlerTasksInterface* handlerTasks =
       new ctkEventAdminService::BlacklistingHandlerTasks(
-        pluginContext, new ctkEventAdminService::BlackList(), topicHandlerFilters, filters);
+        pluginContext, new ctkEventAdminService::BlackList(), topicHandlerIndex, filters);
 
   if (admin == 0)
   {
     admin = new ctkEventAdminService(pluginContext, handlerTasks, sync_pool, async_pool,
-                                     timeout, ignoreTimeout);
+                                     timeout, ignoreTimeout, coalesceTopics, coalesceWindow);
 
     // Finally, adapt the outside events to our kind of events as per spec
     adaptEvents(admin);
@@ -280,7 +311,7 @@ void ctkEAConfiguration::startOrUpdate()
   }
   else
   {
-    admin->update(handlerTasks, timeout, ignoreTimeout);
+    admin->update(handlerTasks, timeout, ignoreTimeout, coalesceTopics, coalesceWindow);
   }
 
 }
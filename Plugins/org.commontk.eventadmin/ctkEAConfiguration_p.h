@@ -26,6 +26,7 @@
 #include <QString>
 
 #include "dispatch/ctkEADefaultThreadPool_p.h"
+#include "dispatch/ctkEAThreadPool_p.h"
 #include "ctkEventAdminService_p.h"
 
 #include <service/cm/ctkManagedService.h>
@@ -89,6 +90,36 @@ class ctkEAAbstractAdapter;
  * pure optimization!
  * The value is a list of strings (separated by comma) which is assumed to define
  * exact class names.
+ * </p>
+ * <p>
+ * <p>
+ *      <tt>org.commontk.eventadmin.WorkStealing</tt> - Use a work-stealing thread
+ *          pool for the asynchronous event delivery.
+ * </p>
+ * The default is <tt>false</tt>. If set to <tt>true</tt>, posted events are queued
+ * in lock-free per-thread queues instead of a single shared queue, which scales
+ * better with many threads posting events concurrently. Events posted by the same
+ * thread are still delivered in order. This property is only read when the
+ * asynchronous thread pool is created.
+ * </p>
+ * <p>
+ * <p>
+ *      <tt>org.commontk.eventadmin.CoalesceTopics</tt> - Topics of posted events
+ *          which are merged before delivery.
+ * </p>
+ * The value is a list of strings (separated by comma) of the form <tt>topic</tt> or
+ * <tt>topic:key</tt>, where <tt>topic</tt> may end with <tt>/&#42;</tt>. Posted events
+ * of these topics with the same value of the <tt>key</tt> property are merged within
+ * the coalescing window and only the last one is delivered. The default is an empty
+ * list, which disables coalescing.
+ * </p>
+ * <p>
+ * <p>
+ *      <tt>org.commontk.eventadmin.CoalesceWindow</tt> - The coalescing window in
+ *          milliseconds.
+ * </p>
+ * The default value is 50. A value of less then 1 triggers the default value.
+ * </p>
  *
  * These properties are read at startup and serve as a default configuration.
  * If a configuration admin is configured, the event admin can be configured
@@ -110,6 +141,9 @@ public:
   static const QString PROP_REQUIRE_TOPIC; // = "org.commontk.eventadmin.RequireTopic"
   static const QString PROP_IGNORE_TIMEOUT; // = "org.commontk.eventadmin.IgnoreTimeout"
   static const QString PROP_LOG_LEVEL; // = "org.commontk.eventadmin.LogLevel"
+  static const QString PROP_WORK_STEALING; // = "org.commontk.eventadmin.WorkStealing"
+  static const QString PROP_COALESCE_TOPICS; // = "org.commontk.eventadmin.CoalesceTopics"
+  static const QString PROP_COALESCE_WINDOW; // = "org.commontk.eventadmin.CoalesceWindow"
 
 private:
 
@@ -130,9 +164,15 @@ private:
 
   int logLevel;
 
+  bool workStealing;
+
+  QStringList coalesceTopics;
+
+  int coalesceWindow;
+
   // The thread pool used - this is a member because we need to close it on stop
   ctkEADefaultThreadPool* sync_pool;
-  ctkEADefaultThreadPool* async_pool;
+  ctkEAThreadPool* async_pool;
 
   // The actual implementation of the service - this is a member because we need to
   // close it on stop. Note, security is not part of this implementation but is
@@ -26,7 +26,7 @@
 template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
 ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::ctkEventAdminImpl(
   HandlerTasksInterface* managers, ctkEADefaultThreadPool* syncPool,
-  ctkEADefaultThreadPool* asyncPool, int timeout,
+  ctkEAThreadPool* asyncPool, int timeout,
   const QStringList& ignoreTimeout)
   : managers(managers)
 {
@@ -54,6 +54,12 @@ void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::postEve
   handleEvent(managers.fetchAndAddOrdered(0)->createHandlerTasks(event), postManager);
 }
 
+template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
+void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::postEvents(const QList<ctkEvent>& events)
+{
+  handleEvent(managers.fetchAndAddOrdered(0)->createHandlerTasks(events), postManager);
+}
+
 template<class HandlerTasks, class SyncDeliverTasks, class AsyncDeliverTasks>
 void ctkEventAdminImpl<HandlerTasks,SyncDeliverTasks,AsyncDeliverTasks>::sendEvent(const ctkEvent& event)
 {
@@ -28,6 +28,7 @@
 #include "dispatch/ctkEASyncMasterThread_p.h"
 
 class ctkEADefaultThreadPool;
+struct ctkEAThreadPool;
 
 /**
  * This is the actual implementation of the OSGi R4 Event Admin Service (see the
@@ -83,6 +84,11 @@ private:
     {
       throw ctkIllegalStateException("The EventAdmin is stopped");
     }
+
+    QList<ctkEAHandlerTask<HandlerTasks> > createHandlerTasks(const QList<ctkEvent>&)
+    {
+      throw ctkIllegalStateException("The EventAdmin is stopped");
+    }
   };
 
   StoppedHandlerTasks stoppedHandlerTasks;
@@ -101,7 +107,7 @@ public:
    */
   ctkEventAdminImpl(HandlerTasksInterface* managers,
                     ctkEADefaultThreadPool* syncPool,
-                    ctkEADefaultThreadPool* asyncPool,
+                    ctkEAThreadPool* asyncPool,
                     int timeout,
                     const QStringList& ignoreTimeout);
 
@@ -118,6 +124,18 @@ public:
    */
   void postEvent(const ctkEvent& event);
 
+  /**
+   * Post a list of asynchronous events. The event handlers are determined
+   * once per topic and the events are delivered in the order of the list.
+   *
+   * @param events The events to be posted by this service
+   *
+   * @throws ctkIllegalStateException - In case we are stopped
+   *
+   * @see ctkEventAdmin#postEvents(const QList<ctkEvent>&)
+   */
+  void postEvents(const QList<ctkEvent>& events);
+
   /**
    * Send a synchronous event.
    *
@@ -23,23 +23,27 @@
 #include "ctkEventAdminService_p.h"
 
 #include "handler/ctkEASlotHandler_p.h"
+#include "dispatch/ctkEAEventCoalescer_p.h"
 
 #include <ctkPluginConstants.h>
 
 ctkEventAdminService::ctkEventAdminService(ctkPluginContext* context,
                                            HandlerTasksInterface* managers,
                                            ctkEADefaultThreadPool* syncPool,
-                                           ctkEADefaultThreadPool* asyncPool,
+                                           ctkEAThreadPool* asyncPool,
                                            int timeout,
-                                           const QStringList& ignoreTimeout)
+                                           const QStringList& ignoreTimeout,
+                                           const QStringList& coalesceTopics,
+                                           int coalesceWindow)
   : impl(managers, syncPool, asyncPool, timeout, ignoreTimeout),
-    context(context)
+    context(context), coalescer(new ctkEAEventCoalescer(this))
 {
-
+  coalescer->configure(coalesceTopics, coalesceWindow);
 }
 
 ctkEventAdminService::~ctkEventAdminService()
 {
+  delete coalescer;
   qDeleteAll(slotHandler);
   foreach(QList<ctkEASignalPublisher*> l, signalPublisher.values())
   {
@@ -49,7 +53,31 @@ ctkEventAdminService::~ctkEventAdminService()
 
 void ctkEventAdminService::postEvent(const ctkEvent& event)
 {
-  impl.postEvent(event);
+  if (!coalescer->coalesce(event))
+  {
+    impl.postEvent(event);
+  }
+}
+
+void ctkEventAdminService::postEvents(const QList<ctkEvent>& events)
+{
+  QList<ctkEvent> remaining;
+  foreach (const ctkEvent& event, events)
+  {
+    if (!coalescer->coalesce(event))
+    {
+      remaining.push_back(event);
+    }
+  }
+  if (!remaining.isEmpty())
+  {
+    impl.postEvents(remaining);
+  }
+}
+
+void ctkEventAdminService::deliverCoalescedEvents(const QList<ctkEvent>& events)
+{
+  impl.postEvents(events);
 }
 
 void ctkEventAdminService::sendEvent(const ctkEvent& event)
@@ -193,12 +221,16 @@ bool ctkEventAdminService::updateProperties(qlonglong subscriptionId, const ctkD
 
 void ctkEventAdminService::stop()
 {
+  // deliver the pending coalesced events first
+  coalescer->stop();
   impl.stop();
 }
 
 void ctkEventAdminService::update(HandlerTasksInterface* managers, int timeout,
-                                  const QStringList& ignoreTimeout)
+                                  const QStringList& ignoreTimeout,
+                                  const QStringList& coalesceTopics, int coalesceWindow)
 {
   impl.update(managers, timeout, ignoreTimeout);
+  coalescer->configure(coalesceTopics, coalesceWindow);
 }
 
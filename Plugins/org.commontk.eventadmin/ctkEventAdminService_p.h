@@ -31,13 +31,13 @@
 
 #include "handler/ctkEACleanBlackList_p.h"
 #include "util/ctkEALeastRecentlyUsedCacheMap_p.h"
-#include "handler/ctkEACacheTopicHandlerFilters_p.h"
 #include "handler/ctkEACacheFilters_p.h"
 #include "tasks/ctkEASyncDeliverTasks_p.h"
 #include "tasks/ctkEAAsyncDeliverTasks_p.h"
 #include "dispatch/ctkEASignalPublisher_p.h"
 
 class ctkEASlotHandler;
+class ctkEAEventCoalescer;
 
 class ctkEventAdminService : public QObject, public ctkEventAdmin
 {
@@ -49,14 +49,11 @@ public:
   typedef ctkEACleanBlackList BlackList;
   typedef ctkEABlackList<BlackList> BlackListInterface;
 
-  typedef ctkEALeastRecentlyUsedCacheMap<QString, QString> TopicCacheMap;
-  typedef ctkEACacheTopicHandlerFilters<TopicCacheMap> TopicHandlerFilters;
-  typedef ctkEATopicHandlerFilters<TopicHandlerFilters> TopicHandlerFiltersInterface;
   typedef ctkEALeastRecentlyUsedCacheMap<QString, ctkLDAPSearchFilter> LDAPCacheMap;
   typedef ctkEACacheFilters<LDAPCacheMap> Filters;
   typedef ctkEAFilters<Filters> FiltersInterface;
 
-  typedef ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> BlacklistingHandlerTasks;
+  typedef ctkEABlacklistingHandlerTasks<BlackList, Filters> BlacklistingHandlerTasks;
   typedef ctkEAHandlerTasks<BlacklistingHandlerTasks> HandlerTasksInterface;
 
   typedef ctkEAHandlerTask<BlacklistingHandlerTasks> HandlerTask;
@@ -74,18 +71,31 @@ private:
   QHash<const QObject*, QList<ctkEASignalPublisher*> > signalPublisher;
   QHash<qlonglong, ctkEASlotHandler*> slotHandler;
 
+  ctkEAEventCoalescer* coalescer;
+
+  friend class ctkEAEventCoalescer;
+
+  /**
+   * Post the events merged by the coalescer.
+   */
+  void deliverCoalescedEvents(const QList<ctkEvent>& events);
+
 public:
   ctkEventAdminService(ctkPluginContext* context,
                        HandlerTasksInterface* managers,
                        ctkEADefaultThreadPool* syncPool,
-                       ctkEADefaultThreadPool* asyncPool,
+                       ctkEAThreadPool* asyncPool,
                        int timeout,
-                       const QStringList& ignoreTimeout);
+                       const QStringList& ignoreTimeout,
+                       const QStringList& coalesceTopics,
+                       int coalesceWindow);
 
   ~ctkEventAdminService();
 
   void postEvent(const ctkEvent& event);
 
+  void postEvents(const QList<ctkEvent>& events);
+
   void sendEvent(const ctkEvent& event);
 
   void publishSignal(const QObject* publisher, const char* signal,
@@ -113,7 +123,8 @@ public:
    * Update the event admin with new configuration.
    */
   void update(HandlerTasksInterface* managers, int timeout,
-              const QStringList& ignoreTimeout);
+              const QStringList& ignoreTimeout,
+              const QStringList& coalesceTopics, int coalesceWindow);
 
 };
 
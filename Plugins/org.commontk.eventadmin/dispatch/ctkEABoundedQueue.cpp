@@ -0,0 +1,140 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEABoundedQueue_p.h"
+
+namespace {
+
+// The positions wrap around, avoid signed overflows
+inline int advance(int pos, int n)
+{
+  return static_cast<int>(static_cast<unsigned>(pos) + static_cast<unsigned>(n));
+}
+
+inline int distance(int pos1, int pos2)
+{
+  return static_cast<int>(static_cast<unsigned>(pos1) - static_cast<unsigned>(pos2));
+}
+
+}
+
+int ctkEABoundedQueue::roundUpToPowerOfTwo(int capacity)
+{
+  int result = 2;
+  while (result < capacity && result < (1 << 30))
+  {
+    result <<= 1;
+  }
+  return result;
+}
+
+ctkEABoundedQueue::ctkEABoundedQueue(int capacity)
+  : buffer_(new Cell[roundUpToPowerOfTwo(capacity)]),
+    mask_(roundUpToPowerOfTwo(capacity) - 1),
+    enqueuePos_(0), dequeuePos_(0)
+{
+  for (int i = 0; i <= mask_; ++i)
+  {
+    buffer_[i].sequence.fetchAndStoreRelaxed(i);
+    buffer_[i].item = 0;
+  }
+}
+
+ctkEABoundedQueue::~ctkEABoundedQueue()
+{
+  delete[] buffer_;
+}
+
+bool ctkEABoundedQueue::offer(ctkEARunnable* item)
+{
+  Cell* cell = 0;
+  int pos = enqueuePos_.fetchAndAddRelaxed(0);
+  forever
+  {
+    cell = &buffer_[pos & mask_];
+    int seq = cell->sequence.fetchAndAddAcquire(0);
+    // the positions wrap around, compare them as distances
+    int diff = distance(seq, pos);
+    if (diff == 0)
+    {
+      // the cell is free for this round, try to claim it
+      if (enqueuePos_.testAndSetRelaxed(pos, advance(pos, 1)))
+        break;
+      pos = enqueuePos_.fetchAndAddRelaxed(0);
+    }
+    else if (diff < 0)
+    {
+      // the cell still holds the item of the previous round
+      return false;
+    }
+    else
+    {
+      // another producer claimed the cell
+      pos = enqueuePos_.fetchAndAddRelaxed(0);
+    }
+  }
+
+  cell->item = item;
+  // publish the item to the consumers
+  cell->sequence.fetchAndStoreRelease(advance(pos, 1));
+  return true;
+}
+
+ctkEARunnable* ctkEABoundedQueue::poll()
+{
+  Cell* cell = 0;
+  int pos = dequeuePos_.fetchAndAddRelaxed(0);
+  forever
+  {
+    cell = &buffer_[pos & mask_];
+    int seq = cell->sequence.fetchAndAddAcquire(0);
+    int diff = distance(seq, advance(pos, 1));
+    if (diff == 0)
+    {
+      // the cell holds an item for this round, try to claim it
+      if (dequeuePos_.testAndSetRelaxed(pos, advance(pos, 1)))
+        break;
+      pos = dequeuePos_.fetchAndAddRelaxed(0);
+    }
+    else if (diff < 0)
+    {
+      // no item was published in the cell yet
+      return 0;
+    }
+    else
+    {
+      // another consumer claimed the cell
+      pos = dequeuePos_.fetchAndAddRelaxed(0);
+    }
+  }
+
+  ctkEARunnable* item = cell->item;
+  cell->item = 0;
+  // free the cell for the next round of the producers
+  cell->sequence.fetchAndStoreRelease(advance(pos, mask_ + 1));
+  return item;
+}
+
+int ctkEABoundedQueue::capacity() const
+{
+  return mask_ + 1;
+}
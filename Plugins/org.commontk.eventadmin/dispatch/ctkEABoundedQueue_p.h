@@ -0,0 +1,107 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEABOUNDEDQUEUE_P_H
+#define CTKEABOUNDEDQUEUE_P_H
+
+#include <QAtomicInt>
+
+class ctkEARunnable;
+
+/**
+ * A bounded, lock-free queue of runnables which allows multiple
+ * producers and multiple consumers.
+ *
+ * <p>
+ * Each slot of the ring buffer carries a sequence number telling whether
+ * it can be written (for the current round of the producers) or read (for
+ * the current round of the consumers). Producers and consumers claim a slot
+ * by a compare-and-swap on the enqueue respectively dequeue position only,
+ * so a put and a take never contend with each other and no thread ever
+ * blocks another one.
+ *
+ * <p>
+ * Unlike a ctkEAChannel, this queue never waits: offer() fails if the queue
+ * is full and poll() returns null if it is empty. The queue does not touch
+ * the reference count of the runnables.
+ *
+ * The algorithm was inspired from:
+ * http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ */
+class ctkEABoundedQueue
+{
+
+public:
+
+  /**
+   * Create a queue holding at least <code>capacity</code> items. The capacity
+   * is rounded up to the next power of two.
+   */
+  ctkEABoundedQueue(int capacity);
+  ~ctkEABoundedQueue();
+
+  /**
+   * Insert an item at the tail of the queue.
+   *
+   * @param item The item to insert. Should be non-null.
+   * @return <code>true</code> if the item was inserted, <code>false</code>
+   *         if the queue is full.
+   */
+  bool offer(ctkEARunnable* item);
+
+  /**
+   * Remove the item at the head of the queue.
+   *
+   * @return The removed item or null if the queue is empty.
+   */
+  ctkEARunnable* poll();
+
+  /**
+   * The number of items this queue can hold.
+   */
+  int capacity() const;
+
+private:
+
+  struct Cell
+  {
+    QAtomicInt sequence;
+    ctkEARunnable* item;
+  };
+
+  // Keep the positions in distinct cache lines, producers
+  // and consumers do not invalidate each other's cache then
+  char pad0_[64];
+  Cell* const buffer_;
+  const int mask_;
+  char pad1_[64];
+  QAtomicInt enqueuePos_;
+  char pad2_[64];
+  QAtomicInt dequeuePos_;
+  char pad3_[64];
+
+  Q_DISABLE_COPY(ctkEABoundedQueue)
+
+  static int roundUpToPowerOfTwo(int capacity);
+};
+
+#endif // CTKEABOUNDEDQUEUE_P_H
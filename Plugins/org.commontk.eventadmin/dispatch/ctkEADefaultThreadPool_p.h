@@ -24,12 +24,13 @@
 #define CTKEADEFAULTTHREADPOOL_P_H
 
 #include "ctkEAPooledExecutor_p.h"
+#include "ctkEAThreadPool_p.h"
 
 /**
  * A thread pool that allows to execute tasks using pooled threads in order
  * to ease the thread creation overhead.
  */
-class ctkEADefaultThreadPool : public ctkEAPooledExecutor
+class ctkEADefaultThreadPool : public ctkEAPooledExecutor, public ctkEAThreadPool
 {
 
 public:
@@ -0,0 +1,178 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEAEventCoalescer_p.h"
+
+#include <ctkEventAdminService_p.h>
+#include <ctkEventAdminActivator_p.h>
+
+#include <QMutexLocker>
+
+ctkEAEventCoalescer::ctkEAEventCoalescer(ctkEventAdminService* admin)
+  : admin(admin), enabled(0), stopped(false), started(false), window(50), thread(0)
+{
+  setAutoDelete(false);
+}
+
+ctkEAEventCoalescer::~ctkEAEventCoalescer()
+{
+  stop();
+  delete thread;
+}
+
+void ctkEAEventCoalescer::configure(const QStringList& topics, int window)
+{
+  QMutexLocker lock(&mutex);
+  this->topics.clear();
+  wildcardTopics.clear();
+  foreach (const QString& entry, topics)
+  {
+    QString topic = entry.section(':', 0, 0).trimmed();
+    QString key = entry.section(':', 1).trimmed();
+    if (topic == "*")
+    {
+      wildcardTopics.push_back(qMakePair(QString(), key));
+    }
+    else if (topic.endsWith("/*"))
+    {
+      wildcardTopics.push_back(qMakePair(topic.left(topic.size() - 1), key));
+    }
+    else if (!topic.isEmpty())
+    {
+      this->topics.insert(topic, key);
+    }
+  }
+  this->window = window;
+  enabled.fetchAndStoreOrdered(!stopped && (!this->topics.isEmpty() || !wildcardTopics.isEmpty()));
+}
+
+bool ctkEAEventCoalescer::coalesce(const ctkEvent& event)
+{
+  if (!enabled.fetchAndAddOrdered(0))
+  {
+    return false;
+  }
+
+  QMutexLocker lock(&mutex);
+  QString key;
+  if (stopped || !keyProperty(event.getTopic(), key))
+  {
+    return false;
+  }
+
+  Key pendingKey(event.getTopic(), key.isEmpty() ? QString() : event.getProperty(key).toString());
+  QHash<Key, int>::const_iterator index = pendingIndex.find(pendingKey);
+  if (index != pendingIndex.end())
+  {
+    // keep the last event at the position of the first one
+    pending[index.value()] = event;
+    return true;
+  }
+
+  pendingIndex.insert(pendingKey, pending.size());
+  pending.push_back(event);
+  if (!started)
+  {
+    thread = new ctkEAInterruptibleThread(this);
+    thread->setObjectName("ctkEAEventCoalescer");
+    thread->start();
+    started = true;
+  }
+  else if (pending.size() == 1)
+  {
+    // start a new window
+    waitCond.wakeAll();
+  }
+  return true;
+}
+
+void ctkEAEventCoalescer::stop()
+{
+  {
+    QMutexLocker lock(&mutex);
+    if (stopped) return;
+    stopped = true;
+    enabled.fetchAndStoreOrdered(0);
+    waitCond.wakeAll();
+  }
+  if (thread)
+  {
+    thread->join();
+  }
+}
+
+void ctkEAEventCoalescer::run()
+{
+  forever
+  {
+    QList<ctkEvent> events;
+    {
+      QMutexLocker lock(&mutex);
+      while (!stopped && pending.isEmpty())
+      {
+        waitCond.wait(&mutex);
+      }
+      if (!stopped)
+      {
+        // the window starts with the first pending event
+        waitCond.wait(&mutex, window);
+      }
+      if (stopped && pending.isEmpty())
+      {
+        return;
+      }
+      events = pending;
+      pending.clear();
+      pendingIndex.clear();
+    }
+
+    try
+    {
+      admin->deliverCoalescedEvents(events);
+    }
+    catch (const std::exception& e)
+    {
+      CTK_WARN_EXC(ctkEventAdminActivator::getLogService(), &e)
+          << "Exception: " << e.what();
+    }
+  }
+}
+
+bool ctkEAEventCoalescer::keyProperty(const QString& topic, QString& key) const
+{
+  QHash<QString, QString>::const_iterator iter = topics.find(topic);
+  if (iter != topics.end())
+  {
+    key = iter.value();
+    return true;
+  }
+
+  for (int i = 0; i < wildcardTopics.size(); ++i)
+  {
+    if (topic.startsWith(wildcardTopics[i].first))
+    {
+      key = wildcardTopics[i].second;
+      return true;
+    }
+  }
+  return false;
+}
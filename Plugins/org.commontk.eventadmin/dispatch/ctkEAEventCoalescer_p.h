@@ -0,0 +1,116 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEAEVENTCOALESCER_P_H
+#define CTKEAEVENTCOALESCER_P_H
+
+#include "ctkEAInterruptibleThread_p.h"
+
+#include <service/event/ctkEvent.h>
+
+#include <QHash>
+#include <QPair>
+
+class ctkEventAdminService;
+
+/**
+ * Merges posted events of configured topics before delivering them.
+ *
+ * <p>
+ * A topic is configured as <tt>topic</tt> or <tt>topic:key</tt>, where
+ * <tt>topic</tt> may end with <tt>/&#42;</tt> to match all topics below it.
+ * Posted events of a configured topic are held back for the coalescing
+ * window which starts with the first held back event. Within the window, an
+ * event replaces the pending event with the same topic and the same value of
+ * the <tt>key</tt> property (or just the same topic if no key is
+ * configured). At the end of the window, the pending events are posted as
+ * one batch in the order in which their first event arrived.
+ *
+ * <p>
+ * Coalesced events are delivered from the thread of the coalescer, hence they
+ * are not ordered with respect to the other events of the posting thread.
+ */
+class ctkEAEventCoalescer : public ctkEARunnable
+{
+
+public:
+
+  ctkEAEventCoalescer(ctkEventAdminService* admin);
+  ~ctkEAEventCoalescer();
+
+  /**
+   * Configure the coalesced topics and the coalescing window.
+   *
+   * @param topics The coalesced topics, optionally followed by <tt>:key</tt>
+   * @param window The coalescing window in milliseconds
+   */
+  void configure(const QStringList& topics, int window);
+
+  /**
+   * Hold back the event if its topic is coalesced.
+   *
+   * @param event The posted event
+   * @return <code>true</code> if the event will be delivered by the
+   *         coalescer, <code>false</code> if it must be posted by the caller.
+   */
+  bool coalesce(const ctkEvent& event);
+
+  /**
+   * Post the pending events and stop the thread of the coalescer.
+   * Subsequently, no events are held back anymore.
+   */
+  void stop();
+
+  void run();
+
+private:
+
+  typedef QPair<QString, QString> Key;
+
+  ctkEventAdminService* const admin;
+
+  QMutex mutex;
+  QWaitCondition waitCond;
+
+  // Fast path for posters if no topic is coalesced
+  QAtomicInt enabled;
+
+  bool stopped;
+  bool started;
+  int window;
+
+  // The key property of the coalesced topics and topic prefixes
+  QHash<QString, QString> topics;
+  QList<QPair<QString, QString> > wildcardTopics;
+
+  // The pending events and the index of each key in the list
+  QList<ctkEvent> pending;
+  QHash<Key, int> pendingIndex;
+
+  ctkEAInterruptibleThread* thread;
+
+  Q_DISABLE_COPY(ctkEAEventCoalescer)
+
+  bool keyProperty(const QString& topic, QString& key) const;
+};
+
+#endif // CTKEAEVENTCOALESCER_P_H
@@ -20,32 +20,39 @@
 =============================================================================*/
 
 
-#ifndef CTKEATOPICHANDLERFILTERS_P_H
-#define CTKEATOPICHANDLERFILTERS_P_H
+#ifndef CTKEATHREADPOOL_P_H
+#define CTKEATHREADPOOL_P_H
 
-#include <QString>
+class ctkEARunnable;
 
 /**
- * The factory for <tt>ctkEventHandler</tt> filters based on a certain topic.
+ * Interface of the thread pools used to dispatch events.
+ *
+ * @see ctkEADefaultThreadPool
+ * @see ctkEAWorkStealingThreadPool
  */
-template<class Impl>
-struct ctkEATopicHandlerFilters
+struct ctkEAThreadPool
 {
+  virtual ~ctkEAThreadPool() {}
+
   /**
-   * Create a filter that will match all <tt>ctkEventHandler</tt> services that match
-   * the given topic.
-   *
-   * @param topic The topic to match
-   *
-   * @return A filter that will match all <tt>ctkEventHandler</tt> services for
-   *      the given topic.
+   * Configure a new pool size.
    */
-  QString createFilterForTopic(const QString& topic)
-  {
-    return static_cast<Impl*>(this)->createFilterForTopic(topic);
-  }
+  virtual void configure(int poolSize) = 0;
 
-  virtual ~ctkEATopicHandlerFilters() {}
+  /**
+   * Close the pool i.e, stop pooling threads. Note that subsequently, task will
+   * still be executed but no pooling is taking place anymore.
+   */
+  virtual void close() = 0;
+
+  /**
+   * Execute the task in a pooled thread. Auto-deleted tasks are deleted
+   * after they ran, unless they are still referenced.
+   *
+   * @param task The task to execute
+   */
+  virtual void executeTask(ctkEARunnable* task) = 0;
 };
 
-#endif // CTKEATOPICHANDLERFILTERS_P_H
+#endif // CTKEATHREADPOOL_P_H
@@ -0,0 +1,204 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEAWorkStealingThreadPool_p.h"
+
+#include "ctkEABoundedQueue_p.h"
+#include "ctkEAInterruptibleThread_p.h"
+
+#include <ctkEventAdminActivator_p.h>
+
+#include <QHash>
+#include <QMutexLocker>
+
+class ctkEAWorkStealingThreadPool::Worker : public ctkEARunnable
+{
+
+public:
+
+  Worker(ctkEAWorkStealingThreadPool* pool, int index)
+    : pool(pool), index(index)
+  {}
+
+  void run()
+  {
+    pool->runWorker(index);
+  }
+
+private:
+
+  ctkEAWorkStealingThreadPool* const pool;
+  const int index;
+};
+
+ctkEAWorkStealingThreadPool::ctkEAWorkStealingThreadPool(int poolSize)
+  : closed_(0), sleepers_(0)
+{
+  const int size = qMax(poolSize, 1);
+  for (int i = 0; i < size; ++i)
+  {
+    queues_.push_back(new ctkEABoundedQueue(QUEUE_CAPACITY));
+  }
+  for (int i = 0; i < size; ++i)
+  {
+    // The thread deletes the worker when it finishes
+    Worker* worker = new Worker(this, i);
+    ++worker->ref;
+    ctkEAInterruptibleThread* thread = new ctkEAInterruptibleThread(worker);
+    thread->setObjectName(QString("ctkEAWorkStealingThreadPool") + QString::number(i));
+    threads_.push_back(thread);
+    thread->start();
+  }
+}
+
+ctkEAWorkStealingThreadPool::~ctkEAWorkStealingThreadPool()
+{
+  close();
+  qDeleteAll(queues_);
+}
+
+void ctkEAWorkStealingThreadPool::configure(int poolSize)
+{
+  if (poolSize != threads_.size())
+  {
+    CTK_DEBUG(ctkEventAdminActivator::getLogService())
+        << "The work-stealing pool keeps its " << threads_.size()
+        << " workers, the new size " << poolSize << " applies after a restart";
+  }
+}
+
+void ctkEAWorkStealingThreadPool::close()
+{
+  if (!closed_.testAndSetOrdered(0, 1))
+  {
+    return;
+  }
+
+  {
+    QMutexLocker lock(&mutex_);
+    taskAvailable_.wakeAll();
+  }
+
+  foreach (ctkEAInterruptibleThread* thread, threads_)
+  {
+    thread->join();
+    delete thread;
+  }
+  threads_.clear();
+
+  drain();
+}
+
+void ctkEAWorkStealingThreadPool::executeTask(ctkEARunnable* task)
+{
+  if (task->autoDelete()) ++task->ref;
+
+  if (!closed_.fetchAndAddOrdered(0))
+  {
+    // Tasks of the same thread go to the same queue first
+    const int size = queues_.size();
+    const int first = static_cast<int>(qHash(QThread::currentThread()) % size);
+    for (int i = 0; i < size; ++i)
+    {
+      if (queues_[(first + i) % size]->offer(task))
+      {
+        if (closed_.fetchAndAddOrdered(0))
+        {
+          // close() may have drained the queues before the offer
+          drain();
+        }
+        else if (sleepers_.fetchAndAddOrdered(0) > 0)
+        {
+          QMutexLocker lock(&mutex_);
+          taskAvailable_.wakeOne();
+        }
+        return;
+      }
+    }
+  }
+
+  // Closed or all queues are full -- run the task in the calling thread
+  runTask(task);
+}
+
+ctkEARunnable* ctkEAWorkStealingThreadPool::takeTask(int index)
+{
+  const int size = queues_.size();
+  for (int i = 0; i < size; ++i)
+  {
+    if (ctkEARunnable* task = queues_[(index + i) % size]->poll())
+    {
+      return task;
+    }
+  }
+  return 0;
+}
+
+void ctkEAWorkStealingThreadPool::runWorker(int index)
+{
+  while (!closed_.fetchAndAddOrdered(0))
+  {
+    ctkEARunnable* task = takeTask(index);
+    if (task == 0)
+    {
+      QMutexLocker lock(&mutex_);
+      sleepers_.fetchAndAddOrdered(1);
+      // A producer may have queued a task without seeing this sleeper
+      task = takeTask(index);
+      if (task == 0 && !closed_.fetchAndAddOrdered(0))
+      {
+        taskAvailable_.wait(&mutex_, IDLE_WAIT);
+      }
+      sleepers_.fetchAndAddOrdered(-1);
+    }
+
+    if (task != 0)
+    {
+      runTask(task);
+    }
+  }
+}
+
+void ctkEAWorkStealingThreadPool::runTask(ctkEARunnable* task)
+{
+  const bool autoDelete = task->autoDelete();
+  try
+  {
+    task->run();
+  }
+  catch (const std::exception& e)
+  {
+    CTK_WARN_EXC(ctkEventAdminActivator::getLogService(), &e)
+        << "Exception: " << e.what();
+    // ignore this
+  }
+  if (autoDelete && !--task->ref) delete task;
+}
+
+void ctkEAWorkStealingThreadPool::drain()
+{
+  ctkEARunnable* task = 0;
+  while ((task = takeTask(0)) != 0)
+  {
+    runTask(task);
+  }
+}
@@ -0,0 +1,117 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEAWORKSTEALINGTHREADPOOL_P_H
+#define CTKEAWORKSTEALINGTHREADPOOL_P_H
+
+#include "ctkEAThreadPool_p.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+class ctkEABoundedQueue;
+class ctkEAInterruptibleThread;
+
+/**
+ * A thread pool where each worker thread owns a lock-free queue.
+ *
+ * <p>
+ * A task is offered to the queue of the worker chosen from the calling
+ * thread, hence tasks of the same sender usually stay on the same worker.
+ * Idle workers steal tasks from the queues of the other workers. Posting a
+ * task does not acquire a lock, unless a worker is sleeping and needs to
+ * be woken up. If all the queues are full, the task is executed in the
+ * calling thread.
+ *
+ * <p>
+ * The queues are polled in FIFO order, but tasks taken from different
+ * queues may run concurrently. Callers which need ordering must serialize
+ * their tasks themselves (see ctkEAAsyncDeliverTasks).
+ */
+class ctkEAWorkStealingThreadPool : public ctkEAThreadPool
+{
+
+public:
+
+  /**
+   * Create a new pool and start its worker threads.
+   */
+  ctkEAWorkStealingThreadPool(int poolSize);
+  ~ctkEAWorkStealingThreadPool();
+
+  /**
+   * Configure a new pool size. The workers are only started once, the
+   * number of workers (and queues) stays the one given to the constructor
+   * so that the producers never need to synchronize with a resize.
+   */
+  void configure(int poolSize);
+
+  /**
+   * Close the pool i.e, stop the worker threads. Queued tasks and tasks
+   * executed subsequently are run in the calling thread.
+   */
+  void close();
+
+  /**
+   * Queue the task for a worker thread.
+   * @param task The task to execute
+   */
+  void executeTask(ctkEARunnable* task);
+
+private:
+
+  class Worker;
+  friend class Worker;
+
+  static const int QUEUE_CAPACITY = 1024;
+  static const unsigned long IDLE_WAIT = 100;
+
+  QVector<ctkEABoundedQueue*> queues_;
+  QVector<ctkEAInterruptibleThread*> threads_;
+
+  QAtomicInt closed_;
+  QAtomicInt sleepers_;
+
+  QMutex mutex_;
+  QWaitCondition taskAvailable_;
+
+  Q_DISABLE_COPY(ctkEAWorkStealingThreadPool)
+
+  /*
+   * Take a task from the queue with the given index, or steal one from
+   * the other queues. Returns null if all queues are empty.
+   */
+  ctkEARunnable* takeTask(int index);
+
+  void runWorker(int index);
+
+  static void runTask(ctkEARunnable* task);
+
+  /*
+   * Run the queued tasks in the calling thread.
+   */
+  void drain();
+};
+
+#endif // CTKEAWORKSTEALINGTHREADPOOL_P_H
@@ -20,49 +20,70 @@
 =============================================================================*/
 
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+template<class BlackList, class Filters>
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 ctkEABlacklistingHandlerTasks(ctkPluginContext* context,
                               ctkEABlackList<BlackList>* blackList,
-                              ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters,
+                              ctkEATopicHandlerIndex* topicHandlerIndex,
                               ctkEAFilters<Filters>* filters)
   : blackList(blackList), context(context),
-    topicHandlerFilters(topicHandlerFilters), filters(filters)
+    topicHandlerIndex(topicHandlerIndex), filters(filters)
 {
   checkNull(context, "Context");
   checkNull(blackList, "BlackList");
-  checkNull(topicHandlerFilters, "TopicHandlerFilters");
+  checkNull(topicHandlerIndex, "TopicHandlerIndex");
   checkNull(filters, "Filters");
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+template<class BlackList, class Filters>
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 ~ctkEABlacklistingHandlerTasks()
 {
   delete filters;
-  delete topicHandlerFilters;
+  delete topicHandlerIndex;
   delete blackList;
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
-QList<ctkEAHandlerTask<ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> > >
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+template<class BlackList, class Filters>
+QList<ctkEAHandlerTask<ctkEABlacklistingHandlerTasks<BlackList, Filters> > >
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 createHandlerTasks(const ctkEvent& event)
 {
   QList<ctkEAHandlerTask<Self> > result;
-  QList<ctkServiceReference> handlerRefs;
+  addHandlerTasks(topicHandlerIndex->getHandlers(event.getTopic()), event, result);
+  return result;
+}
 
-  try
-  {
-    handlerRefs = context->getServiceReferences<ctkEventHandler>(
-          topicHandlerFilters->createFilterForTopic(event.getTopic()));
-  }
-  catch (const ctkInvalidArgumentException& e)
+template<class BlackList, class Filters>
+QList<ctkEAHandlerTask<ctkEABlacklistingHandlerTasks<BlackList, Filters> > >
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
+createHandlerTasks(const QList<ctkEvent>& events)
+{
+  QList<ctkEAHandlerTask<Self> > result;
+  QHash<QString, QList<ctkServiceReference> > topicHandlers;
+
+  foreach (const ctkEvent& event, events)
   {
-    CTK_WARN_EXC(ctkEventAdminActivator::getLogService(), &e)
-        << "Invalid EVENT_TOPIC [" << event.getTopic() << "]";
+    QHash<QString, QList<ctkServiceReference> >::iterator handlerRefs =
+        topicHandlers.find(event.getTopic());
+    if (handlerRefs == topicHandlers.end())
+    {
+      handlerRefs = topicHandlers.insert(event.getTopic(),
+                                         topicHandlerIndex->getHandlers(event.getTopic()));
+    }
+    addHandlerTasks(handlerRefs.value(), event, result);
   }
 
+  return result;
+}
+
+template<class BlackList, class Filters>
+void
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
+addHandlerTasks(const QList<ctkServiceReference>& handlerRefs,
+                const ctkEvent& event,
+                QList<ctkEAHandlerTask<Self> >& result)
+{
   for (int i = 0; i < handlerRefs.size(); ++i)
   {
     const ctkServiceReference& ref = handlerRefs.at(i);
@@ -90,13 +111,11 @@ createHandlerTasks(const ctkEvent& event)
       }
     }
   }
-
-  return result;
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 void
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 blackListRef(const ctkServiceReference& handlerRef)
 {
   blackList->add(handlerRef);
@@ -106,9 +125,9 @@ blackListRef(const ctkServiceReference& handlerRef)
       << handlerRef.getPlugin() << ")] due to timeout!";
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 ctkEventHandler*
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 getEventHandler(const ctkServiceReference& handlerRef)
 {
   ctkEventHandler* result = (blackList->contains(handlerRef)) ? 0
@@ -117,9 +136,9 @@ getEventHandler(const ctkServiceReference& handlerRef)
   return (result ? result : &nullEventHandler);
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 void
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 ungetEventHandler(ctkEventHandler* handler,
                        const ctkServiceReference& handlerRef)
 {
@@ -134,9 +153,9 @@ ungetEventHandler(ctkEventHandler* handler,
   }
 }
 
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 void
-ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters>::
+ctkEABlacklistingHandlerTasks<BlackList, Filters>::
 checkNull(void* object, const QString& name)
 {
   if(object == 0)
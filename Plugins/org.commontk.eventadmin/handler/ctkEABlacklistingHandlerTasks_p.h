@@ -30,28 +30,26 @@
 #include <service/event/ctkEventConstants.h>
 #include <service/event/ctkEventHandler.h>
 
-#include "ctkEATopicHandlerFilters_p.h"
+#include "ctkEATopicHandlerIndex_p.h"
 #include "ctkEAFilters_p.h"
 #include "ctkEABlackList_p.h"
 
 /**
  * This class is an implementation of the ctkEAHandlerTasks interface that does provide
- * blacklisting of event handlers. Furthermore, handlers are determined from the
- * framework on any call to <tt>createHandlerTasks()</tt> hence, there is no
- * book-keeping of <tt>ctkEventHandler</tt> services while they come and go but a
- * query for each sent event. In order to do this, an ldap-filter is created that
- * will match applicable <tt>ctkEventHandler</tt> references. In order to ease some of
- * the overhead pains of this approach some light caching is going on.
+ * blacklisting of event handlers. Furthermore, handlers are determined by a
+ * <tt>ctkEATopicHandlerIndex</tt> that keeps track of the <tt>ctkEventHandler</tt>
+ * services while they come and go, hence there is no query of the framework for
+ * each sent event.
  */
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 class ctkEABlacklistingHandlerTasks :
     public ctkEAHandlerTasks<
-    ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> >
+    ctkEABlacklistingHandlerTasks<BlackList, Filters> >
 {
 
 private:
 
-  typedef ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> Self;
+  typedef ctkEABlacklistingHandlerTasks<BlackList, Filters> Self;
 
   // The blacklist that holds blacklisted event handler service references
   ctkEABlackList<BlackList>* const blackList;
@@ -59,9 +57,8 @@ private:
   // The context of the plugin used to get the actual event handler services
   ctkPluginContext* const context;
 
-  // Used to create the filters that can determine applicable event handlers for
-  // a given event
-  ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters;
+  // Used to determine applicable event handlers for a given event
+  ctkEATopicHandlerIndex* topicHandlerIndex;
 
   // Used to create the filters that are used to determine whether an applicable
   // event handler is interested in a particular event
@@ -74,12 +71,12 @@ public:
    *
    * @param context The context of the plugin
    * @param blackList The set to use for keeping track of blacklisted references
-   * @param topicHandlerFilters The factory for topic handler filters
+   * @param topicHandlerIndex The index of the event handlers by topic
    * @param filters The factory for <tt>ctkLDAPSearchFilter</tt> objects
    */
   ctkEABlacklistingHandlerTasks(ctkPluginContext* context,
                                 ctkEABlackList<BlackList>* blackList,
-                                ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters,
+                                ctkEATopicHandlerIndex* topicHandlerIndex,
                                 ctkEAFilters<Filters>* filters);
 
   ~ctkEABlacklistingHandlerTasks();
@@ -96,6 +93,18 @@ public:
    */
   QList<ctkEAHandlerTask<Self> > createHandlerTasks(const ctkEvent& event);
 
+  /**
+   * Create the handler tasks for a list of events. The handlers of each topic
+   * are determined only once.
+   *
+   * @param events The events for which' handlers delivery tasks must be created
+   *
+   * @return A delivery task for each event and each handler that matches it
+   *
+   * @see ctkHandlerTasks#createHandlerTasks(const QList<ctkEvent>&)
+   */
+  QList<ctkEAHandlerTask<Self> > createHandlerTasks(const QList<ctkEvent>& events);
+
   /**
    * Blacklist the given service reference. This is a private method and only
    * public due to its usage in a friend class.
@@ -152,6 +161,14 @@ private:
 
   NullEventHandler nullEventHandler;
 
+  /*
+   * Append a delivery task for each of the given handlers that is not
+   * blacklisted and whose filter matches the event.
+   */
+  void addHandlerTasks(const QList<ctkServiceReference>& handlerRefs,
+                       const ctkEvent& event,
+                       QList<ctkEAHandlerTask<Self> >& result);
+
   /*
    * This is a utility method that will throw a <tt>ctkInvalidArgumentException</tt>
    * in case that the given object is null. The message will be of the form name +
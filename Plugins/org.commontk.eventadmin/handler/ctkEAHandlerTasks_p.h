@@ -49,6 +49,20 @@ struct ctkEAHandlerTasks
     return static_cast<Impl*>(this)->createHandlerTasks(event);
   }
 
+  /**
+   * Create the handler tasks for a list of events. The matching event handlers
+   * are determined once per topic and the delivery tasks are returned in the
+   * order of the events.
+   *
+   * @param events The events for which' handlers delivery tasks must be created
+   *
+   * @return A delivery task for each event and each handler that matches it
+   */
+  QList<ctkEAHandlerTask<Impl> > createHandlerTasks(const QList<ctkEvent>& events)
+  {
+    return static_cast<Impl*>(this)->createHandlerTasks(events);
+  }
+
   virtual ~ctkEAHandlerTasks() {}
 
 };
@@ -0,0 +1,216 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkEATopicHandlerIndex_p.h"
+
+#include <ctkException.h>
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkServiceEvent.h>
+#include <service/event/ctkEventConstants.h>
+#include <service/event/ctkEventHandler.h>
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace {
+
+// Highest ranking first, like the lists of the service registry
+struct HigherRanking
+{
+  bool operator()(const ctkServiceReference& a, const ctkServiceReference& b) const
+  {
+    return b < a;
+  }
+};
+
+}
+
+ctkEATopicHandlerIndex::Node::~Node()
+{
+  qDeleteAll(children);
+}
+
+ctkEATopicHandlerIndex::ctkEATopicHandlerIndex(ctkPluginContext* context, bool requireTopic)
+  : context(context), requireTopic(requireTopic)
+{
+  // Connect first, handlers registered meanwhile are indexed only once
+  context->connectServiceListener(this, "serviceChanged",
+                                  QString("(") + ctkPluginConstants::OBJECTCLASS + "="
+                                  + qobject_interface_iid<ctkEventHandler*>() + ")");
+
+  QList<ctkServiceReference> refs = context->getServiceReferences<ctkEventHandler>();
+  QMutexLocker lock(&mutex);
+  foreach (ctkServiceReference ref, refs)
+  {
+    addHandler(ref);
+  }
+}
+
+ctkEATopicHandlerIndex::~ctkEATopicHandlerIndex()
+{
+  try
+  {
+    context->disconnectServiceListener(this, "serviceChanged");
+  }
+  catch (const ctkIllegalStateException&)
+  {
+    // The plugin context is no longer valid
+  }
+}
+
+QList<ctkServiceReference> ctkEATopicHandlerIndex::getHandlers(const QString& topic) const
+{
+  QSet<ctkServiceReference> result;
+  {
+    QMutexLocker lock(&mutex);
+
+    if (!requireTopic)
+    {
+      result += noTopicHandlers;
+    }
+
+    // topic=org/commontk/TEST is matched by *, org/*, org/commontk/*
+    // and org/commontk/TEST
+    result += root.wildcardHandlers;
+    const QStringList segments = topic.split('/');
+    const Node* node = &root;
+    for (int i = 0; i < segments.size(); ++i)
+    {
+      node = node->children.value(segments[i]);
+      if (node == 0)
+      {
+        break;
+      }
+      result += (i == segments.size() - 1) ? node->handlers : node->wildcardHandlers;
+    }
+  }
+
+  QList<ctkServiceReference> handlers = result.toList();
+  std::sort(handlers.begin(), handlers.end(), HigherRanking());
+  return handlers;
+}
+
+void ctkEATopicHandlerIndex::serviceChanged(const ctkServiceEvent& event)
+{
+  QMutexLocker lock(&mutex);
+  switch (event.getType())
+  {
+  case ctkServiceEvent::REGISTERED:
+    addHandler(event.getServiceReference());
+    break;
+  case ctkServiceEvent::MODIFIED:
+    // the topics may have changed
+    removeHandler(event.getServiceReference());
+    addHandler(event.getServiceReference());
+    break;
+  case ctkServiceEvent::UNREGISTERING:
+    removeHandler(event.getServiceReference());
+    break;
+  default:
+    break;
+  }
+}
+
+void ctkEATopicHandlerIndex::addHandler(const ctkServiceReference& ref)
+{
+  if (handlerTopics.contains(ref) || noTopicHandlers.contains(ref))
+  {
+    return;
+  }
+
+  QVariant topicProperty = ref.getProperty(ctkEventConstants::EVENT_TOPIC);
+  if (!topicProperty.isValid())
+  {
+    noTopicHandlers.insert(ref);
+    return;
+  }
+
+  QStringList topics = topicProperty.toStringList();
+  foreach (const QString& topic, topics)
+  {
+    bool wildcard = false;
+    Node* node = &root;
+    foreach (const QString& segment, topicSegments(topic, wildcard))
+    {
+      Node*& child = node->children[segment];
+      if (child == 0)
+      {
+        child = new Node();
+      }
+      node = child;
+    }
+    (wildcard ? node->wildcardHandlers : node->handlers).insert(ref);
+  }
+  handlerTopics.insert(ref, topics);
+}
+
+void ctkEATopicHandlerIndex::removeHandler(const ctkServiceReference& ref)
+{
+  noTopicHandlers.remove(ref);
+
+  foreach (const QString& topic, handlerTopics.take(ref))
+  {
+    bool wildcard = false;
+    QStringList segments = topicSegments(topic, wildcard);
+    removeTopic(&root, segments, 0, wildcard, ref);
+  }
+}
+
+QStringList ctkEATopicHandlerIndex::topicSegments(const QString& topic, bool& wildcard)
+{
+  // org/commontk/* is indexed in the wildcard set of org/commontk
+  // and * in the wildcard set of the root
+  wildcard = false;
+  if (topic == "*")
+  {
+    wildcard = true;
+    return QStringList();
+  }
+  if (topic.endsWith("/*"))
+  {
+    wildcard = true;
+    return topic.left(topic.size() - 2).split('/');
+  }
+  return topic.isEmpty() ? QStringList() : topic.split('/');
+}
+
+bool ctkEATopicHandlerIndex::removeTopic(Node* node, const QStringList& segments, int index,
+                                         bool wildcard, const ctkServiceReference& ref)
+{
+  if (index == segments.size())
+  {
+    (wildcard ? node->wildcardHandlers : node->handlers).remove(ref);
+  }
+  else
+  {
+    Node* child = node->children.value(segments[index]);
+    if (child && removeTopic(child, segments, index + 1, wildcard, ref))
+    {
+      node->children.remove(segments[index]);
+      delete child;
+    }
+  }
+  return node->children.isEmpty() && node->handlers.isEmpty() &&
+      node->wildcardHandlers.isEmpty();
+}
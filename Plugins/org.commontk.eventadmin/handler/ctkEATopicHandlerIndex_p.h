@@ -0,0 +1,126 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKEATOPICHANDLERINDEX_P_H
+#define CTKEATOPICHANDLERINDEX_P_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+#include <ctkServiceReference.h>
+
+class ctkPluginContext;
+class ctkServiceEvent;
+
+/**
+ * This class keeps track of the registered <tt>ctkEventHandler</tt> services
+ * (including the handlers of subscribed slots) in a trie of topic segments.
+ * The trie is updated from service events, hence looking up the handlers
+ * of a topic does not query the service registry and only takes a number of
+ * steps proportional to the number of segments of the topic.
+ *
+ * A handler registered for <tt>org/commontk/TEST</tt> is stored in the
+ * <tt>TEST</tt> node, a handler registered for <tt>org/commontk/&#42;</tt> in
+ * the wildcard set of the <tt>commontk</tt> node and a handler registered for
+ * <tt>&#42;</tt> in the wildcard set of the root node.
+ */
+class ctkEATopicHandlerIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  /**
+   * The constructor of the index. It registers a service listener with the
+   * given context and indexes the already registered event handlers.
+   *
+   * @param context The context of the plugin
+   * @param requireTopic Do not include handlers that do not provide a topic
+   */
+  ctkEATopicHandlerIndex(ctkPluginContext* context, bool requireTopic);
+
+  ~ctkEATopicHandlerIndex();
+
+  /**
+   * Get the references of the event handlers registered for the given topic,
+   * ordered as returned by the service registry (highest ranking first).
+   *
+   * @param topic The topic to match
+   *
+   * @return The references of all <tt>ctkEventHandler</tt> services for the
+   *         given topic.
+   */
+  QList<ctkServiceReference> getHandlers(const QString& topic) const;
+
+protected Q_SLOTS:
+
+  void serviceChanged(const ctkServiceEvent& event);
+
+private:
+
+  struct Node
+  {
+    ~Node();
+
+    QHash<QString, Node*> children;
+
+    // Handlers registered for the topic ending at this node
+    QSet<ctkServiceReference> handlers;
+
+    // Handlers registered for the topics below this node
+    QSet<ctkServiceReference> wildcardHandlers;
+  };
+
+  ctkPluginContext* const context;
+  const bool requireTopic;
+
+  mutable QMutex mutex;
+
+  Node root;
+
+  // Handlers without a topic
+  QSet<ctkServiceReference> noTopicHandlers;
+
+  // The topics under which each handler is indexed
+  QHash<ctkServiceReference, QStringList> handlerTopics;
+
+  void addHandler(const ctkServiceReference& ref);
+  void removeHandler(const ctkServiceReference& ref);
+
+  /*
+   * Split a handler topic into the segments of its trie node. The wildcard
+   * flag tells whether the handler belongs to the wildcard set of the node.
+   */
+  static QStringList topicSegments(const QString& topic, bool& wildcard);
+
+  /*
+   * Remove the handler from the node of the given topic and prune the nodes
+   * that became empty. Returns true if the node must be deleted by its parent.
+   */
+  static bool removeTopic(Node* node, const QStringList& segments, int index,
+                          bool wildcard, const ctkServiceReference& ref);
+};
+
+#endif // CTKEATOPICHANDLERINDEX_P_H
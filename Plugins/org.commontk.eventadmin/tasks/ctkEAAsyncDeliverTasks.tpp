@@ -73,7 +73,7 @@ public:
 };
 
 template<class SyncDeliverTasks, class HandlerTask>
-ctkEAAsyncDeliverTasks<SyncDeliverTasks, HandlerTask>::ctkEAAsyncDeliverTasks(ctkEADefaultThreadPool* pool, DeliverTask* deliverTask)
+ctkEAAsyncDeliverTasks<SyncDeliverTasks, HandlerTask>::ctkEAAsyncDeliverTasks(ctkEAThreadPool* pool, DeliverTask* deliverTask)
  : pool(pool), deliver_task(deliverTask)
 {
 }
@@ -24,7 +24,7 @@
 #define CTKEAASYNCDELIVERTASKS_P_H
 
 #include "ctkEADeliverTask_p.h"
-#include <dispatch/ctkEADefaultThreadPool_p.h>
+#include <dispatch/ctkEAThreadPool_p.h>
 
 class ctkEARunnable;
 
@@ -38,7 +38,7 @@ class ctkEAAsyncDeliverTasks : public ctkEADeliverTask<ctkEAAsyncDeliverTasks<Sy
 private:
 
   /** The thread pool to use to spin-off new threads. */
-  ctkEADefaultThreadPool* pool;
+  ctkEAThreadPool* pool;
 
   /**
    * The deliver task for actually delivering the events. This
@@ -62,7 +62,7 @@ public:
    *        dispatching thread is used to send a synchronous event
    * @param deliverTask The deliver tasks for dispatching the event.
    */
-  ctkEAAsyncDeliverTasks(ctkEADefaultThreadPool* pool, DeliverTask* deliverTask);
+  ctkEAAsyncDeliverTasks(ctkEAThreadPool* pool, DeliverTask* deliverTask);
 
   /**
    * This does not block an unrelated thread used to send a synchronous event.
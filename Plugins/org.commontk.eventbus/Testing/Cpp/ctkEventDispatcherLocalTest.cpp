@@ -30,6 +30,9 @@ public:
     /// Return the var's value.
     int var() {return m_Var;}
 
+    /// Emit the benchmark signal directly, to compare with the dispatch through the event bus.
+    void emitSignalBenchmark(int v) {emit signalBenchmark(v);}
+
 public Q_SLOTS:
     /// Test slot that will increment the value of m_Var when an UPDATE_OBJECT event is raised.
     // no return value
@@ -58,6 +61,9 @@ public Q_SLOTS:
     int setObjectValue9WithReturnValue(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8, int v9){return v1 + v2 + v3 + v4 +v5 + v6 + v7 + v8 + v9;};
     int setObjectValue10WithReturnValue(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8, int v9, int v10){return v1 + v2 + v3 + v4 +v5 + v6 + v7 + v8 + v9 + v10;};
 
+    // benchmark
+    void benchmark(int v){m_Var += v;};
+
 Q_SIGNALS:
     void signalSetObjectValue0();
     void signalSetObjectValue1(int v1);
@@ -83,6 +89,8 @@ Q_SIGNALS:
     int signalSetObjectValue9WithReturnValue(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8, int v9);
     int signalSetObjectValue10WithReturnValue(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8, int v9, int v10);
 
+    void signalBenchmark(int v);
+
 private:
     int m_Var; ///< Test var.
 };
@@ -132,6 +140,12 @@ private Q_SLOTS:
     /// notify event test which cover all the possibilities in terms of arguments with returned value
     void notifyEventWitReturnValueTest();
 
+    /// benchmark of the notification of an event with one argument through the dispatcher.
+    void notifyEventBenchmarkTest();
+
+    /// benchmark of the direct emission of the same signal, as reference for notifyEventBenchmarkTest.
+    void directSignalBenchmarkTest();
+
 private:
     testObjectCustomForDispatcherLocal *m_ObjTest; ///< Test Object var
     ctkEventDispatcherLocal *m_EventDispatcherLocal; ///< Test var.
@@ -419,5 +433,39 @@ void ctkEventDispatcherLocalTest::notifyEventWitReturnValueTest() {
     delete propCallback10;
 }
 
+void ctkEventDispatcherLocalTest::notifyEventBenchmarkTest() {
+    QString topic = "ctk/local/benchmark";
+
+    ctkBusEvent *propSignal = new ctkBusEvent(topic, ctkEventTypeLocal, ctkSignatureTypeSignal, m_ObjTest, "signalBenchmark(int)");
+    m_EventDispatcherLocal->registerSignal(*propSignal);
+    ctkBusEvent *propCallback = new ctkBusEvent(topic, ctkEventTypeLocal, ctkSignatureTypeCallback, m_ObjTest, "benchmark(int)");
+    m_EventDispatcherLocal->addObserver(*propCallback);
+
+    int value = 1;
+    ctkEventArgumentsList list;
+    list.append(ctkEventArgument(int, value));
+    ctkBusEvent event(topic, ctkEventTypeLocal, ctkSignatureTypeSignal, NULL, "");
+
+    int start = m_ObjTest->var();
+    m_EventDispatcherLocal->notifyEvent(event, &list);
+    QCOMPARE(m_ObjTest->var(), start + 1);
+
+    QBENCHMARK {
+        m_EventDispatcherLocal->notifyEvent(event, &list);
+    }
+
+    m_EventDispatcherLocal->removeSignal(m_ObjTest, topic);
+}
+
+void ctkEventDispatcherLocalTest::directSignalBenchmarkTest() {
+    connect(m_ObjTest, SIGNAL(signalBenchmark(int)), m_ObjTest, SLOT(benchmark(int)));
+
+    QBENCHMARK {
+        m_ObjTest->emitSignalBenchmark(1);
+    }
+
+    disconnect(m_ObjTest, SIGNAL(signalBenchmark(int)), m_ObjTest, SLOT(benchmark(int)));
+}
+
 CTK_REGISTER_TEST(ctkEventDispatcherLocalTest);
 #include "ctkEventDispatcherLocalTest.moc"
@@ -14,6 +14,7 @@
 #include <ctkEventBusManager.h>
 
 #include <QApplication>
+#include <QPoint>
 
 using namespace ctkEventBus;
 
@@ -32,10 +33,15 @@ public:
     /// Return tha var's value.
     int var() {return m_Var;}
 
+    /// Return the number of failed remote communications.
+    int failures() {return m_Failures;}
+
 public Q_SLOTS:
     /// Test slot that will increment the value of m_Var when an UPDATE_OBJECT event is raised.
     void updateObject();
     void setObjectValue(int v);
+    /// Test slot called when a remote communication fails.
+    void communicationFailed();
 
 Q_SIGNALS:
     void valueModified(int v);
@@ -43,9 +49,10 @@ Q_SIGNALS:
 
 private:
     int m_Var; ///< Test var.
+    int m_Failures; ///< number of failed remote communications.
 };
 
-testObjectCustomForNetworkConnectorZeroMQ::testObjectCustomForNetworkConnectorZeroMQ() : m_Var(0) {
+testObjectCustomForNetworkConnectorZeroMQ::testObjectCustomForNetworkConnectorZeroMQ() : m_Var(0), m_Failures(0) {
 }
 
 void testObjectCustomForNetworkConnectorZeroMQ::updateObject() {
@@ -56,6 +63,10 @@ void testObjectCustomForNetworkConnectorZeroMQ::setObjectValue(int v) {
     m_Var = v;
 }
 
+void testObjectCustomForNetworkConnectorZeroMQ::communicationFailed() {
+    m_Failures++;
+}
+
 
 /**
  Class name: ctkNetworkConnectorZeroMQTest
@@ -67,7 +78,7 @@ void testObjectCustomForNetworkConnectorZeroMQ::setObjectValue(int v) {
 //! </title>
 //! <description>
 //ctkNetworkConnectorZeroMQ provides the connection with 0MQ library.
-//It has been used qxmlrpc library.
+//The communication is tested over an inproc endpoint.
 //! </description>
 
 class ctkNetworkConnectorZeroMQTest : public QObject {
@@ -79,6 +90,15 @@ private Q_SLOTS:
         m_EventBus = ctkEventBusManager::instance();
         m_NetWorkConnectorZeroMQ = new ctkEventBus::ctkNetworkConnectorZeroMQ();
         m_ObjectTest = new testObjectCustomForNetworkConnectorZeroMQ();
+
+        // the server must be bound before the client connects to an inproc endpoint.
+        m_NetWorkConnectorZeroMQ->createServer(QString("inproc://ctkNetworkConnectorZeroMQTest"));
+        m_NetWorkConnectorZeroMQ->startListen();
+        m_NetWorkConnectorZeroMQ->createClient("inproc://ctkNetworkConnectorZeroMQTest", 0);
+
+        // Register callbacks (done by the remote object).
+        ctkRegisterLocalCallback("ctk/local/eventBus/globalUpdate", m_ObjectTest, "updateObject()");
+        ctkRegisterLocalCallback("ctk/local/eventBus/remoteCommunicationFailed", m_ObjectTest, "communicationFailed()");
     }
 
     /// Cleanup tes variables memory allocation.
@@ -94,9 +114,22 @@ private Q_SLOTS:
     /// Check the existence of the ctkNetworkConnectorZeroMQe singletone creation.
     void ctkNetworkConnectorZeroMQConstructorTest();
 
-    /// Check the existence of the ctkNetworkConnectorZeroMQe singletone creation.
+    /// Check that the binary serialization gives back the encoded arguments.
+    void ctkNetworkConnectorZeroMQEncodingTest();
+
+    /// Check the request/reply communication between client and server.
     void ctkNetworkConnectorZeroMQCommunictionTest();
 
+    /// Check the publish/subscribe communication of a broadcast topic.
+    void ctkNetworkConnectorZeroMQBroadcastTest();
+
+    /// Check that unanswered requests are sent again and then fail, without blocking the next ones.
+    void ctkNetworkConnectorZeroMQTimeoutTest();
+
+private:
+    /// Send the updateObject() event with the given connector.
+    void sendUpdate(ctkNetworkConnectorZeroMQ *connector);
+
 private:
     ctkEventBusManager *m_EventBus; ///< event bus instance
     ctkNetworkConnectorZeroMQ *m_NetWorkConnectorZeroMQ; ///< EventBus test variable instance.
@@ -108,11 +141,86 @@ void ctkNetworkConnectorZeroMQTest::ctkNetworkConnectorZeroMQConstructorTest() {
 }
 
 
+void ctkNetworkConnectorZeroMQTest::ctkNetworkConnectorZeroMQEncodingTest() {
+    QVariantMap map;
+    map.insert("key", 3.5);
+    QVariantList nested;
+    nested << QString::fromUtf8("\xc3\xa8vent") << QByteArray("\0raw", 4) << QStringList("item");
+
+    QVariantList arguments;
+    arguments << QVariant() << true << -7 << 7u << Q_INT64_C(-12345678901) << 0.25 << QVariant(nested) << QVariant(map) << QVariant(QPoint(1, 2));
+
+    QByteArray data = ctkNetworkConnectorZeroMQ::encodeArguments(arguments);
+    QVariantList decoded;
+    QVERIFY(ctkNetworkConnectorZeroMQ::decodeArguments(data, decoded));
+    QCOMPARE(decoded, arguments);
+
+    // truncated data must be rejected.
+    QVERIFY(!ctkNetworkConnectorZeroMQ::decodeArguments(data.left(data.size() - 1), decoded));
+}
+
+void ctkNetworkConnectorZeroMQTest::sendUpdate(ctkNetworkConnectorZeroMQ *connector) {
+    //create list to send from the client
+    //first parameter is a list which contains event prperties
+    QVariantList eventParameters;
+    eventParameters.append("ctk/local/eventBus/globalUpdate");
+    eventParameters.append(ctkEventTypeLocal);
+    eventParameters.append(ctkSignatureTypeCallback);
+    eventParameters.append("updateObject()");
+
+    QVariantList dataParameters;
+
+    ctkEventArgumentsList listToSend;
+    listToSend.append(ctkEventArgument(QVariantList, eventParameters));
+    listToSend.append(ctkEventArgument(QVariantList, dataParameters));
+
+    connector->send("ctk/remote/eventBus/comunication/send/zmq", &listToSend);
+}
+
 void ctkNetworkConnectorZeroMQTest::ctkNetworkConnectorZeroMQCommunictionTest() {
+    int expected = m_ObjectTest->var() + 1;
+    sendUpdate(m_NetWorkConnectorZeroMQ);
+
+    QTime dieTime = QTime::currentTime().addSecs(3);
+    while(m_ObjectTest->var() < expected && QTime::currentTime() < dieTime) {
+       QCoreApplication::processEvents(QEventLoop::AllEvents, 3);
+    }
+    QCOMPARE(m_ObjectTest->var(), expected);
+}
+
+void ctkNetworkConnectorZeroMQTest::ctkNetworkConnectorZeroMQBroadcastTest() {
+    m_NetWorkConnectorZeroMQ->setBroadcastTopic("ctk/local/eventBus/globalUpdate");
+
+    int expected = m_ObjectTest->var() + 1;
+    sendUpdate(m_NetWorkConnectorZeroMQ);
+
+    QTime dieTime = QTime::currentTime().addSecs(3);
+    while(m_ObjectTest->var() < expected && QTime::currentTime() < dieTime) {
+       QCoreApplication::processEvents(QEventLoop::AllEvents, 3);
+    }
+    m_NetWorkConnectorZeroMQ->setBroadcastTopic("ctk/local/eventBus/globalUpdate", false);
+    QCOMPARE(m_ObjectTest->var(), expected);
+}
+
+void ctkNetworkConnectorZeroMQTest::ctkNetworkConnectorZeroMQTimeoutTest() {
+    // the server is bound but doesn't listen, the requests are never answered.
+    ctkNetworkConnectorZeroMQ deafServer;
+    deafServer.createServer(QString("inproc://ctkNetworkConnectorZeroMQTestDeaf"));
+
+    ctkNetworkConnectorZeroMQ client;
+    client.createClient("inproc://ctkNetworkConnectorZeroMQTestDeaf", 0);
+    client.setReplyTimeout(100);
+    client.setRequestRetries(1);
+
+    int expected = m_ObjectTest->failures() + 2;
+    sendUpdate(&client);
+    sendUpdate(&client);
+
     QTime dieTime = QTime::currentTime().addSecs(3);
-    while(QTime::currentTime() < dieTime) {
+    while(m_ObjectTest->failures() < expected && QTime::currentTime() < dieTime) {
        QCoreApplication::processEvents(QEventLoop::AllEvents, 3);
     }
+    QCOMPARE(m_ObjectTest->failures(), expected);
 }
 
 CTK_REGISTER_TEST(ctkNetworkConnectorZeroMQTest);
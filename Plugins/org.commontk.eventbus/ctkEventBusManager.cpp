@@ -12,6 +12,7 @@
 #include "ctkTopicRegistry.h"
 #include "ctkNetworkConnectorQtSoap.h"
 #include "ctkNetworkConnectorQXMLRPC.h"
+#include "ctkNetworkConnectorZeroMQ.h"
 
 using namespace ctkEventBus;
 
@@ -67,6 +68,7 @@ void ctkEventBusManager::shutdown() {
 void ctkEventBusManager::initializeNetworkConnectors() {
     plugNetworkConnector("SOAP", new ctkNetworkConnectorQtSoap());
     plugNetworkConnector("XMLRPC", new ctkNetworkConnectorQXMLRPC());
+    plugNetworkConnector("ZMQ", new ctkNetworkConnectorZeroMQ());
 }
 
 bool ctkEventBusManager::addEventProperty(ctkBusEvent &props) const {
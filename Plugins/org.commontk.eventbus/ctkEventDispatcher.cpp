@@ -42,6 +42,7 @@ void ctkEventDispatcher::resetHashes() {
         delete i.value();
     }
     m_SignalsHash.clear();
+    m_SignalMethodsHash.clear();
 }
 
 void ctkEventDispatcher::initializeGlobalEvents() {
@@ -144,6 +145,7 @@ bool ctkEventDispatcher::removeEventItem(ctkBusEvent &props) {
                 i++;
             }
             m_SignalsHash.remove(props[TOPIC].toString()); //in signal hash the id is unique
+            m_SignalMethodsHash.remove(props[TOPIC].toString());
             m_CallbacksHash.remove(props[TOPIC].toString()); //remove also all the id associated in callback
         }
 
@@ -236,6 +238,9 @@ bool ctkEventDispatcher::removeFromHash(ctkEventsHashType *hash, const QObject *
                 }
                 disconnectItem = disconnectItem && currentDisconnetFlag;
                 if(currentDisconnetFlag) {
+                    if(hash == &m_SignalsHash) {
+                        m_SignalMethodsHash.remove(i.key());
+                    }
                     delete i.value();
                     i = hash->erase(i);
                 } else {
@@ -267,6 +272,9 @@ bool ctkEventDispatcher::removeFromHash(ctkEventsHashType *hash, const QObject *
                 }
                 disconnectItem = disconnectItem && currentDisconnetFlag;
                 if(currentDisconnetFlag) {
+                    if(hash == &m_SignalsHash) {
+                        m_SignalMethodsHash.remove(i.key());
+                    }
                     delete i.value();
                     i = hash->erase(i);
                 } else {
@@ -318,7 +326,7 @@ bool ctkEventDispatcher::registerSignal(ctkBusEvent &props) {
 
         // Add the new signal to the Hash.
         ctkBusEvent *dict = const_cast<ctkBusEvent *>(&props);
-        this->m_SignalsHash.insert(topic, dict);
+        this->insertSignal(topic, dict);
         return true;
     }
 
@@ -341,12 +349,30 @@ bool ctkEventDispatcher::registerSignal(ctkBusEvent &props) {
              cumulativeConnect = cumulativeConnect && connect(objSignal, event_sig.toAscii(), objSlot, observer_sig.toAscii());
          }
          ctkBusEvent *dict = const_cast<ctkBusEvent *>(&props);
-         this->m_SignalsHash.insert(topic, dict);
+         this->insertSignal(topic, dict);
     }
 
     return cumulativeConnect;
 }
 
+void ctkEventDispatcher::insertSignal(const QString &topic, ctkBusEvent *props) {
+    this->m_SignalsHash.insert(topic, props);
+
+    ctkEventSignalMethod signalMethod;
+    signalMethod.m_Object = (*props)[OBJECT].value<QObject *>();
+    QByteArray sig = (*props)[SIGNATURE].toString().toAscii();
+    signalMethod.m_Name = sig.left(sig.indexOf('('));
+    if(signalMethod.m_Object != NULL) {
+        const QMetaObject *metaObject = signalMethod.m_Object->metaObject();
+        int index = metaObject->indexOfMethod(QMetaObject::normalizedSignature(sig.constData()));
+        if(index != -1) {
+            signalMethod.m_Method = metaObject->method(index);
+            signalMethod.m_ParameterTypes = signalMethod.m_Method.parameterTypes();
+        }
+    }
+    m_SignalMethodsHash.insert(topic, signalMethod);
+}
+
 bool ctkEventDispatcher::removeSignal(ctkBusEvent &props) {
     return removeEventItem(props);
 }
@@ -14,8 +14,22 @@
 
 #include "ctkEventDefinitions.h"
 
+#include <QMetaMethod>
+
 namespace ctkEventBus {
 
+/**
+ Class name: ctkEventSignalMethod
+ Signal registered for a topic, resolved when it is registered so that notifying the topic
+ doesn't need to look up the signal by name.
+ */
+struct ctkEventSignalMethod {
+    QObject *m_Object; ///< object which emits the signal.
+    QMetaMethod m_Method; ///< resolved signal, invalid if the signature didn't match any method.
+    QList<QByteArray> m_ParameterTypes; ///< normalized types of the signal's parameters.
+    QByteArray m_Name; ///< signal's name, used when the arguments don't match the parameter types.
+};
+
 /**
  Class name: ctkEventDispatcher
  This allows dispatching events coming from local application to attached observers.
@@ -82,6 +96,9 @@ protected:
     /// Return the signal item property associated to the given ID.
     ctkEventItemListType signalItemProperty(const QString topic) const;
 
+    /// Return the resolved signal associated to the given ID, NULL if no signal has been registered.
+    const ctkEventSignalMethod *signalMethod(const QString &topic) const;
+
 private:
     /// method used to check if the given object has been already registered for the given id and signature.
     bool isSignaturePresent(ctkBusEvent &props) const;
@@ -96,8 +113,12 @@ private:
     /// Remove the given object from the has passed as argument
     bool removeFromHash(ctkEventsHashType *hash, const QObject *obj, const QString topic, bool qt_disconnect = true);
 
+    /// Add the signal to the signal's hash and resolve its method.
+    void insertSignal(const QString &topic, ctkBusEvent *props);
+
     ctkEventsHashType m_CallbacksHash; ///< Callbacks' hash for receiving events like updates or refreshes.
     ctkEventsHashType m_SignalsHash; ///< Signals' hash for sending events.
+    QHash<QString, ctkEventSignalMethod> m_SignalMethodsHash; ///< Signals resolved at registration, one for each topic of the signals' hash.
 };
 
 /////////////////////////////////////////////////////////////
@@ -108,6 +129,11 @@ inline ctkEventItemListType ctkEventDispatcher::signalItemProperty(const QString
     return m_SignalsHash.values(topic);
 }
 
+inline const ctkEventSignalMethod *ctkEventDispatcher::signalMethod(const QString &topic) const {
+    QHash<QString, ctkEventSignalMethod>::const_iterator it = m_SignalMethodsHash.constFind(topic);
+    return it == m_SignalMethodsHash.constEnd() ? NULL : &it.value();
+}
+
 } // namespace ctkEventBus
 
 #endif // CTKEVENTDISPATCHER_H
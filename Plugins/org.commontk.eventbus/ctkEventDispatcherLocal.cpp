@@ -35,127 +35,40 @@ void ctkEventDispatcherLocal::initializeGlobalEvents() {
 
 void ctkEventDispatcherLocal::notifyEvent(ctkBusEvent &event_dictionary, ctkEventArgumentsList *argList, ctkGenericReturnArgument *returnArg) const {
     QString topic = event_dictionary[TOPIC].toString();
-    ctkEventItemListType items = signalItemProperty(topic);
-    ctkBusEvent *itemEventProp;
-    foreach(itemEventProp, items) {
-        if((*itemEventProp)[SIGNATURE].toString().length() != 0) {
-            QString signal_to_emit = (*itemEventProp)[SIGNATURE].toString().split("(")[0];
-            QObject *obj = (*itemEventProp)[OBJECT].value<QObject *>();
-            if(argList != NULL) {
-                if (returnArg == NULL || returnArg->data() == NULL) { //don't use return value
-                    switch (argList->count()) {
-                        case 0:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii());
-                            break;
-                        case 1:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                            argList->at(0));
-                            break;
-                        case 2:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1));
-                            break;
-                        case 3:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2));
-                            break;
-                        case 4:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3));
-                            break;
-                        case 5:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4));
-                            break;
-                        case 6:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), argList->at(5));
-                            break;
-                        case 7:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6));
-                            break;
-                        case 8:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6), argList->at(7));
-                            break;
-                        case 9:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6), argList->at(7), argList->at(8));
-                            break;
-                        case 10:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6), argList->at(7), argList->at(8), argList->at(9));
-                            break;
-                        default:
-                            qWarning("%s", tr("Number of arguments not supported. Max 10 arguments").toAscii().data());
-                    } //switch
-                 } else { //use return value
-                    switch (argList->count()) {
-                        case 0:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg);
-                            break;
-                        case 1:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg,\
-                            argList->at(0));
-                            break;
-                        case 2:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1));
-                            break;
-                        case 3:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2));
-                            break;
-                        case 4:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3));
-                            break;
-                        case 5:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4));
-                            break;
-                        case 6:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), argList->at(5));
-                            break;
-                        case 7:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6));
-                            break;
-                        case 8:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6), argList->at(7));
-                            break;
-                        case 9:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6), argList->at(7), argList->at(8));
-                            break;
-                        case 10:
-                            this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg, \
-                             argList->at(0), argList->at(1), argList->at(2), argList->at(3), argList->at(4), \
-                             argList->at(5), argList->at(6), argList->at(7), argList->at(8), argList->at(9));
-                            break;
-                        default:
-                            qWarning("%s", tr("Number of arguments not supported. Max 10 arguments").toAscii().data());
-                    } //switch
-                 }
-            } else {
-                if (returnArg == NULL || returnArg->data() == NULL) { //don't use return value
-                    this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii());
-                } else {
-                    this->metaObject()->invokeMethod(obj, signal_to_emit.toAscii(), *returnArg);
-                }
+    const ctkEventSignalMethod *signalMethod = this->signalMethod(topic);
+    if(signalMethod == NULL || signalMethod->m_Name.isEmpty()) {
+        return;
+    }
 
-            }
-        }
+    int argCount = argList != NULL ? argList->count() : 0;
+    if(argCount > 10) {
+        qWarning("%s", tr("Number of arguments not supported. Max 10 arguments").toAscii().data());
+        return;
+    }
+
+    // unused arguments are empty, as the default ones of invokeMethod.
+    QGenericArgument args[10];
+    for(int i = 0; i < argCount; ++i) {
+        args[i] = argList->at(i);
+    }
+
+    ctkGenericReturnArgument ret;
+    if(returnArg != NULL && returnArg->data() != NULL) { //use return value
+        ret = *returnArg;
+    }
+
+    // the signal has been resolved at registration, invoke it directly when the arguments match its parameters.
+    bool matching = signalMethod->m_Method.methodIndex() != -1 && argCount == signalMethod->m_ParameterTypes.count();
+    for(int i = 0; matching && i < argCount; ++i) {
+        matching = qstrcmp(args[i].name(), signalMethod->m_ParameterTypes.at(i).constData()) == 0;
     }
-}
 
+    QObject *obj = signalMethod->m_Object;
+    if(matching) {
+        signalMethod->m_Method.invoke(obj, Qt::AutoConnection, ret, \
+         args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7], args[8], args[9]);
+    } else {
+        this->metaObject()->invokeMethod(obj, signalMethod->m_Name.constData(), Qt::AutoConnection, ret, \
+         args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7], args[8], args[9]);
+    }
+}
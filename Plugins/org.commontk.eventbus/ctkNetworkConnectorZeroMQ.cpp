@@ -14,20 +14,387 @@
 
 #include <service/event/ctkEvent.h>
 
+#include <QDataStream>
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+#include <zmq.h>
+
+#include <cstring>
+
 using namespace ctkEventBus;
 
-ctkNetworkConnectorZeroMQ::ctkNetworkConnectorZeroMQ() : ctkNetworkConnector() {
+namespace {
+
+/// type tags of the binary serialization, one byte before each value.
+enum {
+    TagInvalid,
+    TagFalse,
+    TagTrue,
+    TagInt,
+    TagUInt,
+    TagLongLong,
+    TagULongLong,
+    TagDouble,
+    TagString,
+    TagByteArray,
+    TagStringList,
+    TagList,
+    TagMap,
+    TagHash,
+    TagVariant ///< any other type, streamed with QDataStream
+};
+
+/// maximum nesting of lists and maps accepted when decoding.
+const int MaxDepth = 64;
+
+/// the context is shared by all the connectors, inproc:// endpoints work only inside the same context.
+void *zmqContext() {
+    static void *context = zmq_init(1);
+    return context;
+}
+
+void writeBytes(QDataStream &stream, const QByteArray &bytes) {
+    stream << quint32(bytes.size());
+    stream.writeRawData(bytes.constData(), bytes.size());
+}
+
+bool readBytes(QDataStream &stream, QByteArray &bytes) {
+    quint32 size = 0;
+    stream >> size;
+    if(stream.status() != QDataStream::Ok || size > quint32(stream.device()->bytesAvailable())) {
+        return false;
+    }
+    bytes.resize(size);
+    return stream.readRawData(bytes.data(), size) == int(size);
+}
+
+void encodeValue(QDataStream &stream, const QVariant &value) {
+    switch(value.type()) {
+    case QVariant::Invalid:
+        stream << quint8(TagInvalid);
+        break;
+    case QVariant::Bool:
+        stream << quint8(value.toBool() ? TagTrue : TagFalse);
+        break;
+    case QVariant::Int:
+        stream << quint8(TagInt) << qint32(value.toInt());
+        break;
+    case QVariant::UInt:
+        stream << quint8(TagUInt) << quint32(value.toUInt());
+        break;
+    case QVariant::LongLong:
+        stream << quint8(TagLongLong) << qint64(value.toLongLong());
+        break;
+    case QVariant::ULongLong:
+        stream << quint8(TagULongLong) << quint64(value.toULongLong());
+        break;
+    case QVariant::Double:
+        stream << quint8(TagDouble) << value.toDouble();
+        break;
+    case QVariant::String:
+        stream << quint8(TagString);
+        writeBytes(stream, value.toString().toUtf8());
+        break;
+    case QVariant::ByteArray:
+        stream << quint8(TagByteArray);
+        writeBytes(stream, value.toByteArray());
+        break;
+    case QVariant::StringList: {
+        const QStringList list = value.toStringList();
+        stream << quint8(TagStringList) << quint32(list.count());
+        foreach(const QString &item, list) {
+            writeBytes(stream, item.toUtf8());
+        }
+        break;
+    }
+    case QVariant::List: {
+        const QVariantList list = value.toList();
+        stream << quint8(TagList) << quint32(list.count());
+        foreach(const QVariant &item, list) {
+            encodeValue(stream, item);
+        }
+        break;
+    }
+    case QVariant::Map: {
+        const QVariantMap map = value.toMap();
+        stream << quint8(TagMap) << quint32(map.count());
+        QVariantMap::const_iterator it = map.constBegin();
+        for(; it != map.constEnd(); ++it) {
+            writeBytes(stream, it.key().toUtf8());
+            encodeValue(stream, it.value());
+        }
+        break;
+    }
+    case QVariant::Hash: {
+        const QVariantHash hash = value.toHash();
+        stream << quint8(TagHash) << quint32(hash.count());
+        QVariantHash::const_iterator it = hash.constBegin();
+        for(; it != hash.constEnd(); ++it) {
+            writeBytes(stream, it.key().toUtf8());
+            encodeValue(stream, it.value());
+        }
+        break;
+    }
+    default: {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_4_6);
+        out << value;
+        stream << quint8(TagVariant);
+        writeBytes(stream, data);
+        break;
+    }
+    }
+}
+
+bool decodeValue(QDataStream &stream, QVariant &value, int depth) {
+    if(depth > MaxDepth) {
+        return false;
+    }
 
-    m_Protocol = "SOCKET";
+    quint8 tag = TagInvalid;
+    stream >> tag;
+    if(stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    // every element of a container takes at least one byte, don't trust larger counts.
+    quint32 count = 0;
+    switch(tag) {
+    case TagInvalid:
+        value = QVariant();
+        break;
+    case TagFalse:
+    case TagTrue:
+        value = QVariant(tag == TagTrue);
+        break;
+    case TagInt: {
+        qint32 v;
+        stream >> v;
+        value = QVariant(int(v));
+        break;
+    }
+    case TagUInt: {
+        quint32 v;
+        stream >> v;
+        value = QVariant(uint(v));
+        break;
+    }
+    case TagLongLong: {
+        qint64 v;
+        stream >> v;
+        value = QVariant(qlonglong(v));
+        break;
+    }
+    case TagULongLong: {
+        quint64 v;
+        stream >> v;
+        value = QVariant(qulonglong(v));
+        break;
+    }
+    case TagDouble: {
+        double v;
+        stream >> v;
+        value = QVariant(v);
+        break;
+    }
+    case TagString:
+    case TagByteArray: {
+        QByteArray bytes;
+        if(!readBytes(stream, bytes)) {
+            return false;
+        }
+        value = tag == TagString ? QVariant(QString::fromUtf8(bytes.constData(), bytes.size())) : QVariant(bytes);
+        break;
+    }
+    case TagStringList: {
+        stream >> count;
+        if(count > quint32(stream.device()->bytesAvailable())) {
+            return false;
+        }
+        QStringList list;
+        for(quint32 i = 0; i < count; ++i) {
+            QByteArray bytes;
+            if(!readBytes(stream, bytes)) {
+                return false;
+            }
+            list.append(QString::fromUtf8(bytes.constData(), bytes.size()));
+        }
+        value = list;
+        break;
+    }
+    case TagList: {
+        stream >> count;
+        if(count > quint32(stream.device()->bytesAvailable())) {
+            return false;
+        }
+        QVariantList list;
+        for(quint32 i = 0; i < count; ++i) {
+            QVariant item;
+            if(!decodeValue(stream, item, depth + 1)) {
+                return false;
+            }
+            list.append(item);
+        }
+        value = list;
+        break;
+    }
+    case TagMap:
+    case TagHash: {
+        stream >> count;
+        if(count > quint32(stream.device()->bytesAvailable())) {
+            return false;
+        }
+        QVariantMap map;
+        QVariantHash hash;
+        for(quint32 i = 0; i < count; ++i) {
+            QByteArray key;
+            QVariant item;
+            if(!readBytes(stream, key) || !decodeValue(stream, item, depth + 1)) {
+                return false;
+            }
+            if(tag == TagMap) {
+                map.insert(QString::fromUtf8(key.constData(), key.size()), item);
+            } else {
+                hash.insert(QString::fromUtf8(key.constData(), key.size()), item);
+            }
+        }
+        value = tag == TagMap ? QVariant(map) : QVariant(hash);
+        break;
+    }
+    case TagVariant: {
+        QByteArray data;
+        if(!readBytes(stream, data)) {
+            return false;
+        }
+        QDataStream in(data);
+        in.setVersion(QDataStream::Qt_4_6);
+        in >> value;
+        if(in.status() != QDataStream::Ok) {
+            return false;
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+/// send the frames as one multipart message.
+bool sendFrames(void *socket, const QList<QByteArray> &frames) {
+    for(int i = 0; i < frames.count(); ++i) {
+        const QByteArray &frame = frames.at(i);
+        zmq_msg_t message;
+        if(zmq_msg_init_size(&message, frame.size()) != 0) {
+            return false;
+        }
+        memcpy(zmq_msg_data(&message), frame.constData(), frame.size());
+        int flags = (i < frames.count() - 1) ? ZMQ_SNDMORE : 0;
+#if ZMQ_VERSION_MAJOR >= 3
+        int rc = zmq_sendmsg(socket, &message, flags);
+#else
+        int rc = zmq_send(socket, &message, flags);
+#endif
+        zmq_msg_close(&message);
+        if(rc < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// receive a multipart message without blocking, return false if no message is waiting.
+bool receiveFrames(void *socket, QList<QByteArray> &frames) {
+#if ZMQ_VERSION_MAJOR >= 3
+    int flags = ZMQ_DONTWAIT;
+    int more = 0;
+#else
+    int flags = ZMQ_NOBLOCK;
+    int64_t more = 0;
+#endif
+    do {
+        zmq_msg_t message;
+        zmq_msg_init(&message);
+#if ZMQ_VERSION_MAJOR >= 3
+        int rc = zmq_recvmsg(socket, &message, flags);
+#else
+        int rc = zmq_recv(socket, &message, flags);
+#endif
+        if(rc < 0) {
+            zmq_msg_close(&message);
+            return false;
+        }
+        frames.append(QByteArray(static_cast<const char *>(zmq_msg_data(&message)), int(zmq_msg_size(&message))));
+        zmq_msg_close(&message);
+
+        // the parts of a multipart message are delivered all together.
+        size_t size = sizeof(more);
+        more = 0;
+        zmq_getsockopt(socket, ZMQ_RCVMORE, &more, &size);
+        flags = 0;
+    } while(more);
+    return true;
+}
+
+/// the notifiers of the 0MQ file descriptors are edge triggered, the socket must be drained while this is true.
+bool hasInput(void *socket) {
+#if ZMQ_VERSION_MAJOR >= 3
+    int events = 0;
+#else
+    uint32_t events = 0;
+#endif
+    size_t size = sizeof(events);
+    if(zmq_getsockopt(socket, ZMQ_EVENTS, &events, &size) != 0) {
+        return false;
+    }
+    return (events & ZMQ_POLLIN) != 0;
+}
+
+/// the events on broadcast topics go to the port next to the one of the requests, or to a sibling endpoint.
+QString publishEndpoint(const QString &endpoint) {
+    if(endpoint.startsWith("tcp://")) {
+        int separator = endpoint.lastIndexOf(':');
+        bool ok = false;
+        int port = endpoint.mid(separator + 1).toInt(&ok);
+        if(ok) {
+            return endpoint.left(separator + 1) + QString::number(port + 1);
+        }
+    }
+    return endpoint + ".pub";
+}
+
+void closeSocket(void *&socket) {
+    if(socket) {
+        int linger = 0;
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_close(socket);
+        socket = NULL;
+    }
+}
+
+}
+
+ctkNetworkConnectorZeroMQ::ctkNetworkConnectorZeroMQ() : ctkNetworkConnector(), m_RequestSocket(NULL), m_PublishSocket(NULL), m_ReplySocket(NULL), m_SubscribeSocket(NULL), m_ServerNotifier(NULL), m_SubscribeNotifier(NULL), m_ClientNotifier(NULL), m_RequestInFlight(-1), m_RequestInFlightRetries(0), m_ReplyTimer(NULL), m_ReplyTimeout(3000), m_RequestRetries(3), m_RequestId(0) {
+    m_Protocol = "ZMQ";
+
+    m_ReplyTimer = new QTimer(this);
+    m_ReplyTimer->setSingleShot(true);
+    connect(m_ReplyTimer, SIGNAL(timeout()), this, SLOT(processReplyTimeout()));
 }
 
 void ctkNetworkConnectorZeroMQ::initializeForEventBus() {
-    //ctkRegisterRemoteSignal("ctk/remote/eventBus/comunication/??????????", this, "remoteCommunication(const QString, ctkEventArgumentsList *)");
-    //ctkRegisterRemoteCallback("ctk/remote/eventBus/comunication/????????????", this, "send(const QString, ctkEventArgumentsList *)");
+    ctkRegisterRemoteSignal("ctk/remote/eventBus/comunication/send/zmq", this, "remoteCommunication(const QString, ctkEventArgumentsList *)");
+    ctkRegisterRemoteCallback("ctk/remote/eventBus/comunication/send/zmq", this, "send(const QString, ctkEventArgumentsList *)");
 }
 
 ctkNetworkConnectorZeroMQ::~ctkNetworkConnectorZeroMQ() {
-    }
+    stopClient();
+    stopServer();
+}
 
 //retrieve an instance of the object
 ctkNetworkConnector *ctkNetworkConnectorZeroMQ::clone() {
@@ -36,34 +403,355 @@ ctkNetworkConnector *ctkNetworkConnectorZeroMQ::clone() {
 }
 
 void ctkNetworkConnectorZeroMQ::createClient(const QString hostName, const unsigned int port) {
-    Q_UNUSED(hostName);
-    Q_UNUSED(port);
-    //@@ TODO
+    stopClient();
+
+    QString endpoint = hostName;
+    if(!hostName.contains("://")) {
+        endpoint = QString("tcp://%1:%2").arg(hostName).arg(port);
+    }
+
+    m_ClientEndpoint = endpoint;
+    m_PublishSocket = zmq_socket(zmqContext(), ZMQ_PUB);
+    if(m_PublishSocket == NULL ||
+       zmq_connect(m_PublishSocket, publishEndpoint(endpoint).toUtf8().constData()) != 0 ||
+       !openRequestSocket()) {
+        qWarning("%s", tr("Unable to connect to %1: %2").arg(endpoint, QString(zmq_strerror(zmq_errno()))).toAscii().data());
+        stopClient();
+        return;
+    }
+}
+
+bool ctkNetworkConnectorZeroMQ::openRequestSocket() {
+    m_RequestSocket = zmq_socket(zmqContext(), ZMQ_REQ);
+    if(m_RequestSocket == NULL || zmq_connect(m_RequestSocket, m_ClientEndpoint.toUtf8().constData()) != 0) {
+        closeSocket(m_RequestSocket);
+        return false;
+    }
+    m_ClientNotifier = createNotifier(m_RequestSocket, SLOT(processReplies()));
+    return true;
+}
+
+void ctkNetworkConnectorZeroMQ::closeRequestSocket() {
+    delete m_ClientNotifier;
+    m_ClientNotifier = NULL;
+    closeSocket(m_RequestSocket);
 }
 
 void ctkNetworkConnectorZeroMQ::createServer(const unsigned int port) {
-   Q_UNUSED(port);
-   //@@ TODO
+    createServer(QString("tcp://*:%1").arg(port));
+}
+
+void ctkNetworkConnectorZeroMQ::createServer(const QString endpoint) {
+    if(m_ReplySocket != NULL) {
+        if(m_ServerEndpoint == endpoint) {
+            return;
+        }
+        stopServer();
+    }
+
+    m_ReplySocket = zmq_socket(zmqContext(), ZMQ_REP);
+    m_SubscribeSocket = zmq_socket(zmqContext(), ZMQ_SUB);
+    if(m_ReplySocket == NULL || m_SubscribeSocket == NULL ||
+       zmq_setsockopt(m_SubscribeSocket, ZMQ_SUBSCRIBE, "", 0) != 0 ||
+       zmq_bind(m_ReplySocket, endpoint.toUtf8().constData()) != 0 ||
+       zmq_bind(m_SubscribeSocket, publishEndpoint(endpoint).toUtf8().constData()) != 0) {
+        qWarning("%s", tr("Unable to bind %1: %2").arg(endpoint, QString(zmq_strerror(zmq_errno()))).toAscii().data());
+        stopServer();
+        return;
+    }
+    m_ServerEndpoint = endpoint;
 }
 
 void ctkNetworkConnectorZeroMQ::stopServer() {
-    //@@ TODO
+    delete m_ServerNotifier;
+    m_ServerNotifier = NULL;
+    delete m_SubscribeNotifier;
+    m_SubscribeNotifier = NULL;
+
+    closeSocket(m_ReplySocket);
+    closeSocket(m_SubscribeSocket);
+    m_ServerEndpoint.clear();
 }
 
+void ctkNetworkConnectorZeroMQ::stopClient() {
+    closeRequestSocket();
+    closeSocket(m_PublishSocket);
+    m_ClientEndpoint.clear();
+    m_PendingRequests.clear();
+    m_RequestInFlight = -1;
+    m_RequestInFlightFrames.clear();
+    m_ReplyTimer->stop();
+}
 
 void ctkNetworkConnectorZeroMQ::startListen() {
-    //@@ TODO
+    if(m_ReplySocket == NULL) {
+        qWarning("%s", tr("Server must be created before listening").toAscii().data());
+        return;
+    }
+    if(m_ServerNotifier != NULL) {
+        return;
+    }
+
+    m_ServerNotifier = createNotifier(m_ReplySocket, SLOT(processIncoming()));
+    m_SubscribeNotifier = createNotifier(m_SubscribeSocket, SLOT(processIncoming()));
+    qDebug() << "Listening for 0MQ requests on" << m_ServerEndpoint;
+
+    // messages received before the notifiers existed don't trigger them.
+    QMetaObject::invokeMethod(this, "processIncoming", Qt::QueuedConnection);
+}
+
+QSocketNotifier *ctkNetworkConnectorZeroMQ::createNotifier(void *socket, const char *member) {
+#ifdef Q_OS_WIN
+    SOCKET fd;
+#else
+    int fd;
+#endif
+    size_t size = sizeof(fd);
+    zmq_getsockopt(socket, ZMQ_FD, &fd, &size);
+
+    QSocketNotifier *notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), this, member);
+    return notifier;
 }
 
 void ctkNetworkConnectorZeroMQ::send(const QString event_id, ctkEventArgumentsList *argList) {
-	Q_UNUSED(event_id);
-	Q_UNUSED(argList);
-    //@@ TODO
+    if(argList == NULL || argList->count() == 0) {
+        qWarning("%s", tr("Remote Dispatcher need to have at least one argument that is a QVariantList").toAscii().data());
+        return;
+    }
+
+    QVariantList arguments;
+    int i=0, size = argList->count();
+    for(;i<size;i++) {
+        QString typeArgument;
+        typeArgument = argList->at(i).name();
+        if(typeArgument != "QVariantList") {
+            qDebug() << typeArgument;
+            qWarning("%s", tr("Remote Dispatcher need to have arguments that are QVariantList").toAscii().data());
+            return;
+        }
+        arguments.append(QVariant(*static_cast<QVariantList *>(argList->at(i).data())));
+    }
+
+    QList<QByteArray> frames;
+    frames << event_id.toUtf8() << encodeArguments(arguments);
+
+    // the first argument holds the properties of the event, starting with its local id.
+    QString topic = arguments.at(0).toList().value(0).toString();
+    if(m_BroadcastTopics.contains(event_id) || m_BroadcastTopics.contains(topic)) {
+        if(m_PublishSocket == NULL || !sendFrames(m_PublishSocket, frames)) {
+            qWarning("%s", tr("Unable to publish %1").arg(topic).toAscii().data());
+        }
+        return;
+    }
+
+    if(m_ClientEndpoint.isEmpty()) {
+        qWarning("%s", tr("Client must be created before sending %1").arg(topic).toAscii().data());
+        return;
+    }
+    m_PendingRequests.enqueue(qMakePair(++m_RequestId, frames));
+    sendNextRequest();
+}
+
+void ctkNetworkConnectorZeroMQ::setBroadcastTopic(const QString &event_id, bool broadcast) {
+    if(broadcast) {
+        m_BroadcastTopics.insert(event_id);
+    } else {
+        m_BroadcastTopics.remove(event_id);
+    }
+}
+
+void ctkNetworkConnectorZeroMQ::setReplyTimeout(int msecs) {
+    m_ReplyTimeout = qMax(0, msecs);
+}
+
+int ctkNetworkConnectorZeroMQ::replyTimeout() const {
+    return m_ReplyTimeout;
+}
+
+void ctkNetworkConnectorZeroMQ::setRequestRetries(int retries) {
+    m_RequestRetries = qMax(0, retries);
+}
+
+int ctkNetworkConnectorZeroMQ::requestRetries() const {
+    return m_RequestRetries;
+}
+
+void ctkNetworkConnectorZeroMQ::sendNextRequest() {
+    // a REQ socket accepts a new request only after the answer of the previous one.
+    while(m_RequestInFlight == -1 && !m_PendingRequests.isEmpty()) {
+        QPair<int, QList<QByteArray> > request = m_PendingRequests.dequeue();
+        // the socket is missing if it couldn't be recreated after a timeout.
+        if((m_RequestSocket == NULL && !openRequestSocket()) || !sendFrames(m_RequestSocket, request.second)) {
+            // the following requests are still sent.
+            processReturnValue(request.first, QVariant());
+            continue;
+        }
+        m_RequestInFlight = request.first;
+        m_RequestInFlightFrames = request.second;
+        m_RequestInFlightRetries = m_RequestRetries;
+        m_ReplyTimer->start(m_ReplyTimeout);
+
+        // the answer may already be there, in which case the notifier won't fire.
+        QMetaObject::invokeMethod(this, "processReplies", Qt::QueuedConnection);
+    }
+}
+
+void ctkNetworkConnectorZeroMQ::processReplyTimeout() {
+    if(m_RequestInFlight == -1) {
+        return;
+    }
+
+    // the REQ socket waits for the lost answer forever, it is replaced by a new one.
+    closeRequestSocket();
+    if(m_RequestInFlightRetries > 0 && openRequestSocket() && sendFrames(m_RequestSocket, m_RequestInFlightFrames)) {
+        --m_RequestInFlightRetries;
+        m_ReplyTimer->start(m_ReplyTimeout);
+        return;
+    }
+
+    qWarning("%s", tr("No answer from %1 to request %2").arg(m_ClientEndpoint, QString::number(m_RequestInFlight)).toAscii().data());
+    int requestId = m_RequestInFlight;
+    m_RequestInFlight = -1;
+    m_RequestInFlightFrames.clear();
+    processReturnValue(requestId, QVariant());
+    sendNextRequest();
+}
+
+void ctkNetworkConnectorZeroMQ::processReplies() {
+    while(m_RequestSocket != NULL && m_RequestInFlight != -1 && hasInput(m_RequestSocket)) {
+        QList<QByteArray> frames;
+        if(!receiveFrames(m_RequestSocket, frames)) {
+            break;
+        }
+
+        int requestId = m_RequestInFlight;
+        m_RequestInFlight = -1;
+        m_RequestInFlightFrames.clear();
+        m_ReplyTimer->stop();
+
+        QVariantList answer;
+        QVariant value;
+        if(frames.count() == 1 && decodeArguments(frames.at(0), answer)) {
+            value = answer.value(0);
+        }
+        processReturnValue(requestId, value);
+        sendNextRequest();
+    }
+}
+
+void ctkNetworkConnectorZeroMQ::processIncoming() {
+    while(m_ReplySocket != NULL && hasInput(m_ReplySocket)) {
+        QList<QByteArray> frames;
+        if(!receiveFrames(m_ReplySocket, frames)) {
+            break;
+        }
+
+        // a REP socket must answer every request before receiving the next one.
+        QString reply("FAIL");
+        QVariantList parameters;
+        if(frames.count() == 2 && decodeArguments(frames.at(1), parameters)) {
+            if(dispatchLocally(QString::fromUtf8(frames.at(0)), parameters)) {
+                reply = "OK";
+            }
+        } else {
+            qWarning("%s", tr("Discarding a malformed 0MQ request").toAscii().data());
+        }
+        sendFrames(m_ReplySocket, QList<QByteArray>() << encodeArguments(QVariantList() << reply));
+    }
+
+    while(m_SubscribeSocket != NULL && hasInput(m_SubscribeSocket)) {
+        QList<QByteArray> frames;
+        if(!receiveFrames(m_SubscribeSocket, frames)) {
+            break;
+        }
+
+        QVariantList parameters;
+        if(frames.count() == 2 && decodeArguments(frames.at(1), parameters)) {
+            dispatchLocally(QString::fromUtf8(frames.at(0)), parameters);
+        } else {
+            qWarning("%s", tr("Discarding a malformed 0MQ broadcast event").toAscii().data());
+        }
+    }
 }
 
+bool ctkNetworkConnectorZeroMQ::dispatchLocally(const QString &event_id, const QVariantList &parameters) {
+    //first parameter is ctkEventBus message
+    enum {
+      EVENT_PARAMETERS,
+      DATA_PARAMETERS,
+    };
+
+    enum {
+      EVENT_ID,
+      EVENT_ITEM_TYPE,
+      EVENT_SIGNATURE_TYPE,
+      EVENT_METHOD_SIGNATURE,
+    };
+
+    if(parameters.value(EVENT_PARAMETERS).toList().count() == 0) {
+        qWarning("%s", tr("No Command to Execute for %1, command list is empty").arg(event_id).toAscii().data());
+        return false;
+    }
+
+    //first argument regards local signal to be called.
+    QString id_name = parameters.at(EVENT_PARAMETERS).toList().at(EVENT_ID).toString();
+    if(!ctkEventBusManager::instance()->isLocalSignalPresent(id_name)) {
+        return false;
+    }
+
+    ctkEventArgumentsList argList;
+    QVariantList p = parameters.value(DATA_PARAMETERS).toList();
+    if(p.count() != 0) {
+        argList.push_back(Q_ARG(QVariantList, p));
+    }
+
+    ctkBusEvent dictionary(id_name,ctkEventTypeLocal,0,NULL,"");
+    ctkEventBusManager::instance()->notifyEvent(dictionary, argList.isEmpty() ? NULL : &argList);
+    return true;
+}
 
 void ctkNetworkConnectorZeroMQ::processReturnValue( int requestId, QVariant value ) {
-	Q_UNUSED(requestId);
-	Q_UNUSED(value);
-    //@@ TODO
+    if(value.toString() == "OK") {
+        ctkEventBusManager::instance()->notifyEvent("ctk/local/eventBus/remoteCommunicationDone", ctkEventTypeLocal);
+    } else {
+        qDebug("%s", tr("Process Fault for requestID %1 - %2").arg(QString::number(requestId), value.toString()).toAscii().data());
+        ctkEventBusManager::instance()->notifyEvent("ctk/local/eventBus/remoteCommunicationFailed", ctkEventTypeLocal);
+    }
+}
+
+QByteArray ctkNetworkConnectorZeroMQ::encodeArguments(const QVariantList &arguments) {
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << quint32(arguments.count());
+    foreach(const QVariant &argument, arguments) {
+        encodeValue(stream, argument);
+    }
+    return data;
+}
+
+bool ctkNetworkConnectorZeroMQ::decodeArguments(const QByteArray &data, QVariantList &arguments) {
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 count = 0;
+    stream >> count;
+    if(stream.status() != QDataStream::Ok || count > quint32(data.size())) {
+        return false;
+    }
+
+    QVariantList result;
+    for(quint32 i = 0; i < count; ++i) {
+        QVariant argument;
+        if(!decodeValue(stream, argument, 0)) {
+            return false;
+        }
+        result.append(argument);
+    }
+    if(!stream.atEnd()) {
+        return false;
+    }
+    arguments = result;
+    return true;
 }
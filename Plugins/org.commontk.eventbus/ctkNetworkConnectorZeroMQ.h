@@ -15,14 +15,26 @@
 // include list
 #include "ctkNetworkConnector.h"
 
+#include <QQueue>
+#include <QSet>
+
+class QSocketNotifier;
+class QTimer;
+
 namespace ctkEventBus {
 
 /**
  Class name: ctkNetworkConnectorZeroMQ
  This class is the implementation class for client/server objects that works over network
- with xml-rpc protocol. The server side part also create a new ID named REGISTER_SERVER_METHODS_XXX
- (where the XXX is the port on which run the server) that allows you to register your own remote
- callbacks. The library used is qxmlrpc.
+ with the 0MQ library. Events are sent as multipart messages made of the event id and of the
+ arguments encoded with a compact binary QVariant serialization (see encodeArguments()).
+ Events sent on a broadcast topic (see setBroadcastTopic()) are published to the server
+ through a PUB/SUB pair of sockets and do not wait for an answer; all other events are
+ sent through a REQ/REP pair of sockets and the answer of the server is given to processReturnValue().
+ A request not answered within replyTimeout() is sent again on a new REQ socket (lazy pirate pattern),
+ up to requestRetries() times, and then fails.
+ Besides tcp, the endpoints can be any 0MQ endpoint (e.g. inproc:// or ipc://) by passing
+ it as host name to createClient() and to createServer(const QString).
  */
 class org_commontk_eventbus_EXPORT ctkNetworkConnectorZeroMQ : public ctkNetworkConnector {
     Q_OBJECT
@@ -35,12 +47,15 @@ public:
     /// object destructor.
     /*virtual*/ ~ctkNetworkConnectorZeroMQ();
 
-    /// create the unique instance of the client.
+    /// create the unique instance of the client. If hostName is a 0MQ endpoint (e.g. inproc://name) the port is ignored.
     /*virtual*/ void createClient(const QString hostName, const unsigned int port);
 
-    /// create the unique instance of the server.
+    /// create the unique instance of the server listening on the given tcp port.
     /*virtual*/ void createServer(const unsigned int port);
 
+    /// create the unique instance of the server listening on the given 0MQ endpoint (e.g. ipc:///tmp/ctk).
+    void createServer(const QString endpoint);
+
     /// Start the server.
     /*virtual*/ void startListen();
 
@@ -50,8 +65,27 @@ public:
     /// register all the signals and slots
     /*virtual*/ void initializeForEventBus();
 
+    /// Send the events with the given id over PUB/SUB (fire and forget) instead of REQ/REP.
+    /** The id can be the one given to send() or the local id carried in the event parameters. */
+    void setBroadcastTopic(const QString &event_id, bool broadcast = true);
+
+    /// Time in milliseconds to wait for the answer of a request before sending it again (3000 by default).
+    void setReplyTimeout(int msecs);
+    int replyTimeout() const;
+
+    /// Number of times an unanswered request is sent again before it fails (3 by default).
+    void setRequestRetries(int retries);
+    int requestRetries() const;
+
+    /// Encode the arguments of an event in the binary format of the connector.
+    static QByteArray encodeArguments(const QVariantList &arguments);
+
+    /// Decode arguments encoded by encodeArguments(), return false if the data is corrupted.
+    static bool decodeArguments(const QByteArray &data, QVariantList &arguments);
+
+public Q_SLOTS:
     /// Allow to send a network request.
-    /** Contains the conversion between maf datatypes and qxmlrpc datatype based both on QVariant. */
+    /** The arguments must be QVariantList as for the other connectors. */
     /*virtual*/ void send(const QString event_id, ctkEventArgumentsList *argList);
 
 private Q_SLOTS:
@@ -60,17 +94,58 @@ private Q_SLOTS:
 
     //// here goes slots which handle the connection
 
-    
+    /// read the requests and broadcast events received by the server.
+    void processIncoming();
+
+    /// read the answers received by the client.
+    void processReplies();
+
+    /// replace the REQ socket and send the request again, or fail it, when its answer doesn't come.
+    void processReplyTimeout();
+
 protected:
-    //here goes zeromq vars
-    
+    void *m_RequestSocket; ///< REQ socket of the client
+    void *m_PublishSocket; ///< PUB socket of the client
+    void *m_ReplySocket; ///< REP socket of the server
+    void *m_SubscribeSocket; ///< SUB socket of the server
+
 private:
-    //here ges function for zeromq connection
-    
     /// stop and destroy the server instance.
     void stopServer();
 
-    
+    /// close the client sockets.
+    void stopClient();
+
+    /// create and connect the REQ socket of the client, the one of a lost request can't be reused.
+    bool openRequestSocket();
+
+    /// close the REQ socket of the client.
+    void closeRequestSocket();
+
+    /// send the next queued requests until one waits for its answer.
+    void sendNextRequest();
+
+    /// dispatch an event received by the server to the local event bus.
+    bool dispatchLocally(const QString &event_id, const QVariantList &parameters);
+
+    /// create a socket notifier on the file descriptor of the given socket.
+    QSocketNotifier *createNotifier(void *socket, const char *member);
+
+    QString m_ServerEndpoint; ///< endpoint of the REP socket of the server
+    QSocketNotifier *m_ServerNotifier; ///< notifier of the REP socket
+    QSocketNotifier *m_SubscribeNotifier; ///< notifier of the SUB socket
+    QSocketNotifier *m_ClientNotifier; ///< notifier of the REQ socket
+
+    QString m_ClientEndpoint; ///< endpoint the REQ socket connects to
+    QQueue<QPair<int, QList<QByteArray> > > m_PendingRequests; ///< requests waiting for the answer to the previous one
+    int m_RequestInFlight; ///< id of the request waiting for an answer, -1 if none
+    QList<QByteArray> m_RequestInFlightFrames; ///< request waiting for an answer, sent again on timeout
+    int m_RequestInFlightRetries; ///< number of times the request in flight can still be sent again
+    QTimer *m_ReplyTimer; ///< fires when the answer of the request in flight is late
+    int m_ReplyTimeout; ///< time in milliseconds to wait for an answer
+    int m_RequestRetries; ///< number of times a request is sent again
+    int m_RequestId; ///< id of the last request
+    QSet<QString> m_BroadcastTopics; ///< event ids sent over PUB/SUB
 };
 
 } //namespace ctkEventBus
@@ -9,5 +9,6 @@ set(target_libraries
   CTKPluginFramework
   QtSOAP_LIBRARIES
   qxmlrpc_LIBRARIES
+  ZMQ_LIBRARIES
   QT_LIBRARIES
   )